@@ -113,6 +113,30 @@ void HelloApp::OnKeyPressed(WPARAM key, LPARAM lParam)
 		LOG_INFO("Reload shaders.");
 		m_Renderer->RecompileShaders();
 		break;
+	case 'B':
+	{
+		LOG_INFO("Switched bindless rendering.");
+		m_Renderer->ToggleBindless();
+		break;
+	}
+	case 'O':
+	{
+		LOG_INFO("Switched occlusion culling.");
+		m_Renderer->ToggleOcclusionCulling();
+		break;
+	}
+	case 'I':
+	{
+		LOG_INFO("Switched indirect draws.");
+		m_Renderer->ToggleIndirect();
+		break;
+	}
+	case 'C':
+	{
+		const ToyDX::CommandListStats& stats = m_Renderer->GetCommandStats();
+		LOG_INFO("Last frame : {0} draws, {1} state calls issued, {2} redundant ones elided.", stats.NumDraws, stats.NumIssued, stats.NumElided);
+		break;
+	}
 	case 'X':
 	{
 		LOG_INFO("Switched render mode.");
@@ -0,0 +1,36 @@
+// Resources of the bindless pipeline (shaders compiled with BINDLESS defined)
+// Everything is bound once per frame, a draw only sets the indices of its first instance and material
+// Draws are instanced : the object of an instance is gInstances[FirstInstance + SV_InstanceID]
+
+struct DrawConstants
+{
+    uint FirstInstance;
+    uint MaterialIndex;
+};
+
+struct ObjectConstants
+{
+    float4x4 World;
+    float4x4 WorldInvTranspose;
+};
+
+struct MaterialConstants
+{
+    float4 BaseColor;
+    float Metallic;
+    float Roughness;
+
+    // Indices in gTextures
+    uint BaseColorTexture;
+    uint MetallicRoughnessTexture;
+    uint NormalTexture;
+};
+
+ConstantBuffer<DrawConstants> gDraw : register(b3);
+
+StructuredBuffer<ObjectConstants> gObjects : register(t0, space1);
+StructuredBuffer<MaterialConstants> gMaterials : register(t1, space1);
+StructuredBuffer<uint> gInstances : register(t2, space1);
+
+// Every texture of the scene
+Texture2D gTextures[] : register(t0, space2);
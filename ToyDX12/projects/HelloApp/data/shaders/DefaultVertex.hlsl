@@ -1,9 +1,13 @@
+#ifdef BINDLESS
+#include "Bindless.hlsl"
+#else
 // Padding to 256 bytes is implicit 
 cbuffer cbPerObject : register(b0)
 {
     float4x4 gWorld;
     float4x4 gWorldInvTranspose;
 };
+#endif
 
 
 cbuffer cbPerPass : register(b2)
@@ -48,17 +52,27 @@ struct VSOutput
     float2 TexCoord : TEXCOORD;
 };
 
-VSOutput main(VSInput vsInput)
+VSOutput main(VSInput vsInput, uint instanceID : SV_InstanceID)
 {
-    float4x4 wvp = mul(mul(gWorld, gView), gProj);
+#ifdef BINDLESS
+    // SV_InstanceID starts at 0 whatever the start instance of the draw
+    ObjectConstants object = gObjects[gInstances[gDraw.FirstInstance + instanceID]];
+    float4x4 world = object.World;
+    float4x4 worldInvTranspose = object.WorldInvTranspose;
+#else
+    float4x4 world = gWorld;
+    float4x4 worldInvTranspose = gWorldInvTranspose;
+#endif
+
+    float4x4 wvp = mul(mul(world, gView), gProj);
 
     VSOutput output;
 
     output.PosCS = mul(float4(vsInput.PosOS, 1.0), wvp);
-    output.PosWS = mul(float4(vsInput.PosOS, 1.0), gWorld);
+    output.PosWS = mul(float4(vsInput.PosOS, 1.0), world);
 
     output.NormalOS = vsInput.NormalOS;
-    output.NormalWS = mul(float4(vsInput.NormalOS, 0.0), gWorldInvTranspose).xyz;
+    output.NormalWS = mul(float4(vsInput.NormalOS, 0.0), worldInvTranspose).xyz;
 
     output.Tangent = vsInput.Tangent;
     output.TexCoord = float2(vsInput.TexCoord.x, vsInput.TexCoord.y);
@@ -36,3 +36,10 @@ float SmithGeometricOcclusion(float NdotL, float NdotV, float r)
 
     return G1_NdotV * G1_NdotL;
 }
+
+float3 UnpackNormalXY(float2 xy)
+{
+    // Normal maps are stored as two channels (BC5 or R8G8) : Z is rebuilt from the unit length of the normal
+    float2 n = xy * 2.0 - 1.0;
+    return float3(n, sqrt(saturate(1.0 - dot(n, n))));
+}
@@ -5,12 +5,16 @@
 //#define USE_TBN
 #define GAMMA_CORRECT
 
+#ifdef BINDLESS
+#include "Bindless.hlsl"
+#else
 cbuffer cbMaterial : register(b1)
 {
     float4 gBaseColor;
     float gMetallic;
     float gRoughness;
 };
+#endif
 
 cbuffer cbPerPass : register(b2)
 {
@@ -37,9 +41,11 @@ struct VSOutput
     float2 TexCoord : TEXCOORD;
 };
 
+#ifndef BINDLESS
 Texture2D gBaseColorMap : register(t0);
 Texture2D gMetallicRoughnessMap : register(t1);
 Texture2D gNormalMap : register(t2);
+#endif
 
 SamplerState gsamPointWrap : register(s0);
 SamplerState gsamPointClamp : register(s1);
@@ -71,6 +77,26 @@ float4 main(VSOutput psInput) : SV_TARGET
     float2 uv = psInput.TexCoord;
     float3 posWS = psInput.PosWS.xyz;
 
+#ifdef BINDLESS
+    MaterialConstants material = gMaterials[gDraw.MaterialIndex];
+    float4 baseColorFactor = material.BaseColor;
+    float metallicFactor = material.Metallic;
+    float roughnessFactor = material.Roughness;
+
+    // Same index for every pixel of the draw : no NonUniformResourceIndex needed
+    Texture2D baseColorMap = gTextures[material.BaseColorTexture];
+    Texture2D metallicRoughnessMap = gTextures[material.MetallicRoughnessTexture];
+    Texture2D normalMap = gTextures[material.NormalTexture];
+#else
+    float4 baseColorFactor = gBaseColor;
+    float metallicFactor = gMetallic;
+    float roughnessFactor = gRoughness;
+
+    Texture2D baseColorMap = gBaseColorMap;
+    Texture2D metallicRoughnessMap = gMetallicRoughnessMap;
+    Texture2D normalMap = gNormalMap;
+#endif
+
     float3 E = gEyePosWS;//mul(float4(0,0,0,1.0), gInvView).xyz;
     
     float3 N = normalize(psInput.NormalWS);
@@ -79,18 +105,18 @@ float4 main(VSOutput psInput) : SV_TARGET
     
     
 #ifdef USE_TBN
-    float3 N_NormalMap = normalize(gNormalMap.Sample(gsamLinearWrap, uv).xyz) * 2.0 - 1.0;
+    float3 N_NormalMap = UnpackNormalXY(normalMap.Sample(gsamLinearWrap, uv).xy);
     N = normalize(ComputeNormalWS(T, N, N_NormalMap));
 #endif
 
-    float4 baseColor = saturate(gBaseColorMap.Sample(gsamLinearWrap, uv) * gBaseColor);
+    float4 baseColor = saturate(baseColorMap.Sample(gsamLinearWrap, uv) * baseColorFactor);
 
 #ifdef GAMMA_CORRECT
     baseColor = pow(baseColor, 2.2);
 #endif
-    float4 metalRough = gMetallicRoughnessMap.Sample(gsamLinearWrap, uv);
-    float metallic = metalRough.b * gMetallic;
-    float perceptualRoughness = metalRough.g * gRoughness;
+    float4 metalRough = metallicRoughnessMap.Sample(gsamLinearWrap, uv);
+    float metallic = metalRough.b * metallicFactor;
+    float perceptualRoughness = metalRough.g * roughnessFactor;
 
     PointLight light;
     light.dirWS = float3(0, 1, 0);
@@ -87,7 +87,9 @@ float4 main(VSOutput psInput) : SV_TARGET
     ////////////////////////////////////////////
     float3x3 TBN = float3x3(T, cross(T, psInput.NormalOS), normalize(psInput.NormalOS));
 
-    float3 N_Map = gNormalMap.Sample(gsamLinearWrap, psInput.TexCoord).rgb;
+    // Normal maps only store XY
+    float2 N_XY = gNormalMap.Sample(gsamLinearWrap, psInput.TexCoord).xy * 2.0 - 1.0;
+    float3 N_Map = float3(N_XY, sqrt(saturate(1.0 - dot(N_XY, N_XY))));
     N = normalize(mul(N_Map, TBN));
     float NdotL = max(0, dot(N, L));
     float NdotH = max(0, dot(N, H));
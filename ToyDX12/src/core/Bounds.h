@@ -0,0 +1,78 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+// Axis aligned bounding box
+struct AABB
+{
+	DirectX::XMFLOAT3 Min = {  FLT_MAX,  FLT_MAX,  FLT_MAX };
+	DirectX::XMFLOAT3 Max = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+	bool IsValid() const { return Min.x <= Max.x && Min.y <= Max.y && Min.z <= Max.z; }
+
+	DirectX::XMFLOAT3 Center() const { return { 0.5f * (Min.x + Max.x), 0.5f * (Min.y + Max.y), 0.5f * (Min.z + Max.z) }; }
+	DirectX::XMFLOAT3 Extents() const { return { 0.5f * (Max.x - Min.x), 0.5f * (Max.y - Min.y), 0.5f * (Max.z - Min.z) }; }
+
+	// Radius of the sphere centered on the box that encloses it
+	float Radius() const
+	{
+		const DirectX::XMFLOAT3 e = Extents();
+		return sqrtf(e.x * e.x + e.y * e.y + e.z * e.z);
+	}
+
+	float SurfaceArea() const
+	{
+		if (!IsValid())
+		{
+			return 0.0f;
+		}
+
+		const DirectX::XMFLOAT3 e = Extents();
+		return 8.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+	}
+
+	// (std::min) and (std::max) are parenthesized to dodge the macros defined by windows.h
+	void Expand(const DirectX::XMFLOAT3& p)
+	{
+		Min = { (std::min)(Min.x, p.x), (std::min)(Min.y, p.y), (std::min)(Min.z, p.z) };
+		Max = { (std::max)(Max.x, p.x), (std::max)(Max.y, p.y), (std::max)(Max.z, p.z) };
+	}
+
+	void Merge(const AABB& other)
+	{
+		Expand(other.Min);
+		Expand(other.Max);
+	}
+
+	// Box enclosing this box once transformed by an affine matrix (row vectors)
+	// Graphics Gems, "Transforming Axis-Aligned Bounding Boxes", J. Arvo
+	AABB Transform(const DirectX::XMMATRIX& m) const
+	{
+		DirectX::XMFLOAT4X4 mat;
+		DirectX::XMStoreFloat4x4(&mat, m);
+
+		const float min[3] = { Min.x, Min.y, Min.z };
+		const float max[3] = { Max.x, Max.y, Max.z };
+		float outMin[3] = { mat._41, mat._42, mat._43 };
+		float outMax[3] = { mat._41, mat._42, mat._43 };
+
+		for (int col = 0; col < 3; ++col)
+		{
+			for (int row = 0; row < 3; ++row)
+			{
+				const float a = mat.m[row][col] * min[row];
+				const float b = mat.m[row][col] * max[row];
+				outMin[col] += (std::min)(a, b);
+				outMax[col] += (std::max)(a, b);
+			}
+		}
+
+		AABB result;
+		result.Min = { outMin[0], outMin[1], outMin[2] };
+		result.Max = { outMax[0], outMax[1], outMax[2] };
+		return result;
+	}
+};
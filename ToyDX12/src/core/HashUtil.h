@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+class HashUtil
+{
+public:
+	HashUtil() = delete;
+	~HashUtil() = delete;
+	HashUtil(HashUtil&) = delete;
+	HashUtil operator=(HashUtil&) = delete;
+
+	static constexpr uint64_t FnvOffsetBasis = 0xcbf29ce484222325ull;
+	static constexpr uint64_t FnvPrime       = 0x100000001b3ull;
+
+	// 64 bits FNV-1a hash of a block of memory
+	// https://en.wikipedia.org/wiki/Fowler%E2%80%93Noll%E2%80%93Vo_hash_function
+	static uint64_t Fnv1a(const void* p_Data, size_t sz_SizeInBytes, uint64_t seed = FnvOffsetBasis)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(p_Data);
+		uint64_t hash = seed;
+
+		for (size_t i = 0; i < sz_SizeInBytes; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= FnvPrime;
+		}
+
+		return hash;
+	}
+
+	template<typename T>
+	static uint64_t Fnv1a(const T& value, uint64_t seed = FnvOffsetBasis)
+	{
+		return Fnv1a(&value, sizeof(T), seed);
+	}
+
+	// Mixes a value into an existing hash (boost::hash_combine, 64 bits version)
+	static constexpr uint64_t Combine(uint64_t seed, uint64_t value)
+	{
+		return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 12) + (seed >> 4));
+	}
+};
@@ -0,0 +1,65 @@
+#include "pch.h"
+
+#include "MappedFile.h"
+
+bool MappedFile::Open(const std::string& sz_Path)
+{
+	Close();
+
+	HANDLE file = CreateFileA(sz_Path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize = {};
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	m_View = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (m_View == nullptr)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	m_File = file;
+	m_Mapping = mapping;
+	m_Size = static_cast<size_t>(fileSize.QuadPart);
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_View)
+	{
+		UnmapViewOfFile(m_View);
+		m_View = nullptr;
+	}
+
+	if (m_Mapping)
+	{
+		CloseHandle(m_Mapping);
+		m_Mapping = nullptr;
+	}
+
+	if (m_File)
+	{
+		CloseHandle(m_File);
+		m_File = nullptr;
+	}
+
+	m_Size = 0;
+}
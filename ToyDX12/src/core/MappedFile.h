@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+
+// Read-only view of a whole file mapped in the address space of the process
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const std::string& sz_Path);
+	void Close();
+
+	bool IsOpen() const { return m_View != nullptr; }
+	const void* Data() const { return m_View; }
+	size_t Size() const { return m_Size; }
+
+	~MappedFile() { Close(); }
+protected:
+	void* m_File    = nullptr;
+	void* m_Mapping = nullptr;
+	const void* m_View = nullptr;
+	size_t m_Size = 0;
+};
@@ -0,0 +1,42 @@
+#include "pch.h"
+
+#include "NameTable.h"
+
+#include <deque>
+#include <unordered_map>
+
+// A deque never moves its elements : the views used as keys stay valid while strings are added
+static std::deque<std::string> s_Strings;
+static std::unordered_map<std::string_view, NameId> s_Ids;
+
+NameId NameTable::Intern(std::string_view sz_String)
+{
+	auto it = s_Ids.find(sz_String);
+	if (it != s_Ids.end())
+	{
+		return it->second;
+	}
+
+	const NameId id = (NameId)s_Strings.size();
+	const std::string& stored = s_Strings.emplace_back(sz_String);
+	s_Ids.emplace(std::string_view(stored), id);
+
+	return id;
+}
+
+NameId NameTable::Find(std::string_view sz_String)
+{
+	auto it = s_Ids.find(sz_String);
+	return it != s_Ids.end() ? it->second : InvalidNameId;
+}
+
+const std::string& NameTable::GetString(NameId id)
+{
+	static const std::string empty;
+	return id < s_Strings.size() ? s_Strings[id] : empty;
+}
+
+uint32_t NameTable::GetCount()
+{
+	return (uint32_t)s_Strings.size();
+}
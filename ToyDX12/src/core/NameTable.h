@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Handle to an interned string : two names are equal when their ids are equal
+using NameId = uint32_t;
+static constexpr NameId InvalidNameId = UINT32_MAX;
+
+// Interned strings, each distinct string is stored once and identified by a dense id
+// Strings are hashed when they are interned, comparing and storing names is then done on ids
+// Not thread safe : names are interned while loading
+class NameTable
+{
+public:
+	NameTable() = delete;
+	~NameTable() = delete;
+
+	// Id of the string, added to the table if it isn't already
+	static NameId Intern(std::string_view sz_String);
+
+	// InvalidNameId if the string was never interned
+	static NameId Find(std::string_view sz_String);
+
+	// Empty string for InvalidNameId
+	static const std::string& GetString(NameId id);
+
+	static uint32_t GetCount();
+};
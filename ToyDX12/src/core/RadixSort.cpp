@@ -0,0 +1,105 @@
+#include "pch.h"
+
+#include "RadixSort.h"
+
+#include <algorithm>
+#include <execution>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+// 11 bits digits : 6 passes, with histograms that still fit in the L1 cache
+static const int DigitBits = 11;
+static const int NumDigits = (64 + DigitBits - 1) / DigitBits;
+static const uint32_t NumBuckets = 1u << DigitBits;
+static const uint64_t DigitMask = NumBuckets - 1;
+
+void RadixSort::Sort(SortEntry* p_Entries, SortEntry* p_Scratch, size_t ui_Count)
+{
+	if (ui_Count < 2)
+	{
+		return;
+	}
+
+	const size_t numThreads = (std::max)(std::thread::hardware_concurrency(), 1u);
+	const size_t numBlocks = (std::min)(numThreads, (ui_Count + MinEntriesPerBlock - 1) / MinEntriesPerBlock);
+	const size_t blockSize = (ui_Count + numBlocks - 1) / numBlocks;
+
+	std::vector<size_t> blocks(numBlocks);
+	std::iota(blocks.begin(), blocks.end(), size_t(0));
+
+	// Histograms of every digit of the keys, per block. They don't depend on the order of the entries, so they are all built in one pass
+	std::vector<uint32_t> histograms(numBlocks * NumDigits * NumBuckets, 0);
+
+	std::for_each(std::execution::par, blocks.begin(), blocks.end(), [&](size_t block)
+	{
+		uint32_t* histogram = &histograms[block * NumDigits * NumBuckets];
+		const size_t end = (std::min)((block + 1) * blockSize, ui_Count);
+
+		for (size_t i = block * blockSize; i < end; ++i)
+		{
+			const uint64_t key = p_Entries[i].Key;
+			for (int digit = 0; digit < NumDigits; ++digit)
+			{
+				histogram[digit * NumBuckets + ((key >> (digit * DigitBits)) & DigitMask)]++;
+			}
+		}
+	});
+
+	SortEntry* source = p_Entries;
+	SortEntry* destination = p_Scratch;
+
+	std::vector<size_t> offsets(numBlocks * NumBuckets);
+
+	for (int digit = 0; digit < NumDigits; ++digit)
+	{
+		// Skip the pass when every key has the same digit
+		bool bSingleBucket = false;
+		for (uint32_t bucket = 0; bucket < NumBuckets && !bSingleBucket; ++bucket)
+		{
+			size_t count = 0;
+			for (size_t block = 0; block < numBlocks; ++block)
+			{
+				count += histograms[(block * NumDigits + digit) * NumBuckets + bucket];
+			}
+
+			bSingleBucket = count == ui_Count;
+		}
+
+		if (bSingleBucket)
+		{
+			continue;
+		}
+
+		// Entries of a bucket are written block after block, which keeps the sort stable
+		size_t offset = 0;
+		for (uint32_t bucket = 0; bucket < NumBuckets; ++bucket)
+		{
+			for (size_t block = 0; block < numBlocks; ++block)
+			{
+				offsets[block * NumBuckets + bucket] = offset;
+				offset += histograms[(block * NumDigits + digit) * NumBuckets + bucket];
+			}
+		}
+
+		std::for_each(std::execution::par, blocks.begin(), blocks.end(), [&](size_t block)
+		{
+			size_t* blockOffsets = &offsets[block * NumBuckets];
+			const size_t end = (std::min)((block + 1) * blockSize, ui_Count);
+			const int shift = digit * DigitBits;
+
+			for (size_t i = block * blockSize; i < end; ++i)
+			{
+				destination[blockOffsets[(source[i].Key >> shift) & DigitMask]++] = source[i];
+			}
+		});
+
+		std::swap(source, destination);
+	}
+
+	// An odd number of passes leaves the result in the scratch buffer
+	if (source != p_Entries)
+	{
+		std::copy(source, source + ui_Count, p_Entries);
+	}
+}
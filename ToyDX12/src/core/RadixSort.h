@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// 64 bits key and the 32 bits value sorted along with it
+struct SortEntry
+{
+	uint64_t Key;
+	uint32_t Value;
+};
+
+// Least significant digit radix sort on 64 bits keys, 11 bits per pass
+// Each pass is parallel : the entries are split in blocks, every block builds its histogram, then scatters its entries
+// to the offsets given by the prefix sums of all the histograms. Entries with equal keys keep their order (stable)
+// Passes over a digit that is the same for every key (e.g. unused high bits) are skipped
+class RadixSort
+{
+public:
+	RadixSort() = delete;
+	~RadixSort() = delete;
+
+	// p_Scratch must hold ui_Count entries. The result is written back to p_Entries
+	static void Sort(SortEntry* p_Entries, SortEntry* p_Scratch, size_t ui_Count);
+
+	// Below this number of entries a single block is used
+	static const size_t MinEntriesPerBlock = 16384;
+};
@@ -0,0 +1,217 @@
+#include "pch.h"
+
+#include "TaskGraph.h"
+
+#include <algorithm>
+#include <thread>
+
+TaskGraph::TaskId TaskGraph::AddTask(const std::string& sz_Name, std::function<void()> work, const std::vector<TaskId>& a_Dependencies)
+{
+	const TaskId id = static_cast<TaskId>(m_Tasks.size());
+
+	Task task;
+	task.Name = sz_Name;
+	task.Work = std::move(work);
+
+	for (TaskId dependency : a_Dependencies)
+	{
+		if (dependency == InvalidTask)
+		{
+			continue;
+		}
+
+		assert(dependency < id);
+		task.Dependencies.push_back(dependency);
+		m_Tasks[dependency].Successors.push_back(id);
+	}
+
+	m_Tasks.push_back(std::move(task));
+
+	return id;
+}
+
+void TaskGraph::Run(uint32_t ui_NumWorkers)
+{
+	if (m_Tasks.empty())
+	{
+		return;
+	}
+
+	m_ReadyTasks.clear();
+	m_NumFinished = 0;
+	m_Error = nullptr;
+
+	for (TaskId id = 0; id < m_Tasks.size(); ++id)
+	{
+		Task& task = m_Tasks[id];
+		task.NumPendingDependencies = static_cast<uint32_t>(task.Dependencies.size());
+		task.bSkipped = false;
+		task.StartTime = task.EndTime = 0.0;
+
+		if (task.NumPendingDependencies == 0)
+		{
+			m_ReadyTasks.push_back(id);
+		}
+	}
+
+	// No more workers than tasks
+	const uint32_t numWorkers = ui_NumWorkers != 0 ? ui_NumWorkers : (std::max)(std::thread::hardware_concurrency(), 1u);
+	m_NumWorkers = (std::min)(numWorkers, static_cast<uint32_t>(m_Tasks.size()));
+
+	m_RunStart = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> workers;
+	for (uint32_t i = 1; i < m_NumWorkers; ++i)
+	{
+		workers.emplace_back(&TaskGraph::WorkerLoop, this);
+	}
+
+	WorkerLoop();
+
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+
+	m_RunDuration = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_RunStart).count();
+
+	if (m_Error)
+	{
+		std::rethrow_exception(m_Error);
+	}
+}
+
+void TaskGraph::WorkerLoop()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	for (;;)
+	{
+		m_TaskReady.wait(lock, [this]() { return !m_ReadyTasks.empty() || m_NumFinished == m_Tasks.size(); });
+
+		if (m_ReadyTasks.empty())
+		{
+			return;
+		}
+
+		// Oldest first : tasks become ready roughly in the order they were added
+		const TaskId id = m_ReadyTasks.front();
+		m_ReadyTasks.pop_front();
+
+		Task& task = m_Tasks[id];
+		std::exception_ptr error;
+
+		lock.unlock();
+		{
+			task.StartTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_RunStart).count();
+
+			if (!task.bSkipped)
+			{
+				try
+				{
+					task.Work();
+				}
+				catch (...)
+				{
+					error = std::current_exception();
+				}
+			}
+
+			task.EndTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_RunStart).count();
+		}
+		lock.lock();
+
+		if (error && !m_Error)
+		{
+			m_Error = error;
+		}
+
+		for (TaskId successorId : task.Successors)
+		{
+			Task& successor = m_Tasks[successorId];
+			successor.bSkipped |= task.bSkipped || error != nullptr;
+
+			if (--successor.NumPendingDependencies == 0)
+			{
+				m_ReadyTasks.push_back(successorId);
+			}
+		}
+
+		m_NumFinished++;
+
+		// Wakes the workers for the new ready tasks, or for them to leave once every task is done
+		m_TaskReady.notify_all();
+	}
+}
+
+double TaskGraph::GetTotalWork() const
+{
+	double totalWork = 0.0;
+	for (TaskId id = 0; id < m_Tasks.size(); ++id)
+	{
+		totalWork += GetTaskDuration(id);
+	}
+
+	return totalWork;
+}
+
+std::vector<TaskGraph::TaskId> TaskGraph::GetCriticalPath(double* p_Duration) const
+{
+	// Tasks only depend on tasks added before them : ids are already in topological order
+	std::vector<double> pathDurations(m_Tasks.size(), 0.0);
+	std::vector<TaskId> previousTasks(m_Tasks.size(), InvalidTask);
+
+	TaskId lastTask = InvalidTask;
+	double longestPath = 0.0;
+
+	for (TaskId id = 0; id < m_Tasks.size(); ++id)
+	{
+		for (TaskId dependency : m_Tasks[id].Dependencies)
+		{
+			if (previousTasks[id] == InvalidTask || pathDurations[dependency] > pathDurations[previousTasks[id]])
+			{
+				previousTasks[id] = dependency;
+			}
+		}
+
+		pathDurations[id] = GetTaskDuration(id) + (previousTasks[id] != InvalidTask ? pathDurations[previousTasks[id]] : 0.0);
+
+		if (lastTask == InvalidTask || pathDurations[id] > longestPath)
+		{
+			lastTask = id;
+			longestPath = pathDurations[id];
+		}
+	}
+
+	std::vector<TaskId> path;
+	for (TaskId id = lastTask; id != InvalidTask; id = previousTasks[id])
+	{
+		path.push_back(id);
+	}
+	std::reverse(path.begin(), path.end());
+
+	if (p_Duration != nullptr)
+	{
+		*p_Duration = longestPath;
+	}
+
+	return path;
+}
+
+void TaskGraph::LogStats(const char* sz_Name) const
+{
+	double criticalPathDuration = 0.0;
+	const std::vector<TaskId> criticalPath = GetCriticalPath(&criticalPathDuration);
+
+	std::string pathDescription;
+	for (TaskId id : criticalPath)
+	{
+		char duration[32];
+		snprintf(duration, sizeof(duration), " (%.2f ms)", GetTaskDuration(id));
+
+		pathDescription += (pathDescription.empty() ? "" : " > ") + m_Tasks[id].Name + duration;
+	}
+
+	LOG_INFO("TaskGraph: {0} - {1} tasks on {2} workers in {3:.2f} ms, {4:.2f} ms of work.", sz_Name, m_Tasks.size(), m_NumWorkers, m_RunDuration, GetTotalWork());
+	LOG_INFO("TaskGraph: {0} - Critical path of {1:.2f} ms : {2}", sz_Name, criticalPathDuration, pathDescription);
+}
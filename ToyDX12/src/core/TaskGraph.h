@@ -0,0 +1,76 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Tasks run by a pool of worker threads, each one as soon as the tasks it depends on are done
+// Dependencies are given when a task is added and can only be tasks added before it : the graph has no cycle
+// Once run, the measured durations give the critical path : the chain of dependent tasks with the longest total duration,
+// a lower bound of the run time whatever the number of workers
+class TaskGraph
+{
+public:
+	using TaskId = uint32_t;
+	static constexpr TaskId InvalidTask = UINT32_MAX;
+
+	TaskGraph() = default;
+	TaskGraph(const TaskGraph&) = delete;
+	TaskGraph& operator=(const TaskGraph&) = delete;
+
+	// Invalid dependencies are ignored, e.g. a task that depends on an optional one
+	TaskId AddTask(const std::string& sz_Name, std::function<void()> work, const std::vector<TaskId>& a_Dependencies = {});
+
+	// Returns once every task is done, the calling thread is one of the workers. 0 : one worker per hardware thread
+	// The first exception thrown by a task is rethrown here, the tasks depending on the failed one are skipped
+	void Run(uint32_t ui_NumWorkers = 0);
+
+	size_t GetNumTasks() const { return m_Tasks.size(); }
+	const std::string& GetTaskName(TaskId id) const { return m_Tasks[id].Name; }
+
+	// In milliseconds, once run
+	double GetTaskDuration(TaskId id) const { return m_Tasks[id].EndTime - m_Tasks[id].StartTime; }
+	double GetRunDuration() const { return m_RunDuration; }
+	double GetTotalWork() const;
+
+	// Tasks of the critical path in execution order, and its duration in milliseconds
+	std::vector<TaskId> GetCriticalPath(double* p_Duration = nullptr) const;
+
+	void LogStats(const char* sz_Name) const;
+
+protected:
+	struct Task
+	{
+		std::string Name;
+		std::function<void()> Work;
+		std::vector<TaskId> Dependencies;
+		std::vector<TaskId> Successors;
+
+		uint32_t NumPendingDependencies = 0;
+		bool bSkipped = false;	// A dependency failed
+
+		double StartTime = 0.0;
+		double EndTime = 0.0;
+	};
+
+	void WorkerLoop();
+
+	std::vector<Task> m_Tasks;
+
+	// Shared by the workers during Run
+	std::mutex m_Mutex;
+	std::condition_variable m_TaskReady;
+	std::deque<TaskId> m_ReadyTasks;
+	size_t m_NumFinished = 0;
+	std::exception_ptr m_Error;
+
+	std::chrono::steady_clock::time_point m_RunStart;
+	uint32_t m_NumWorkers = 0;
+	double m_RunDuration = 0.0;
+};
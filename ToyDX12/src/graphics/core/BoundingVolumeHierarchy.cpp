@@ -0,0 +1,418 @@
+#include "pch.h"
+
+#include "BoundingVolumeHierarchy.h"
+
+#include <algorithm>
+#include <cfloat>
+
+using namespace DirectX;
+
+static const uint32_t MaxBins = 64;
+
+static float GetAxis(const XMFLOAT3& v, int axis)
+{
+	return axis == 0 ? v.x : axis == 1 ? v.y : v.z;
+}
+
+// Items that lost their bounds since the last build are given an infinite box so that every query returns them
+static AABB GetItemBox(const AABB& bounds)
+{
+	if (bounds.IsValid())
+	{
+		return bounds;
+	}
+
+	AABB infinite;
+	infinite.Min = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	infinite.Max = {  FLT_MAX,  FLT_MAX,  FLT_MAX };
+	return infinite;
+}
+
+void BoundingVolumeHierarchy::Build(const std::vector<AABB>& a_Bounds, const BvhBuildSettings& settings)
+{
+	m_Nodes.clear();
+	m_Items.clear();
+	m_UnboundedItems.clear();
+	m_ItemBounds = a_Bounds;
+
+	std::vector<XMFLOAT3> centroids(a_Bounds.size());
+	for (uint32_t i = 0; i < a_Bounds.size(); ++i)
+	{
+		if (a_Bounds[i].IsValid())
+		{
+			m_Items.push_back(i);
+			centroids[i] = a_Bounds[i].Center();
+		}
+		else
+		{
+			// An infinite box would make every node above it infinite too
+			m_UnboundedItems.push_back(i);
+		}
+	}
+
+	if (m_Items.empty())
+	{
+		return;
+	}
+
+	// A binary tree with leaves of at least one item has less than 2n nodes
+	m_Nodes.reserve(2 * m_Items.size());
+
+	Node root;
+	root.First = 0;
+	root.Count = (uint32_t)m_Items.size();
+	m_Nodes.push_back(root);
+
+	Subdivide(0, centroids, settings);
+}
+
+void BoundingVolumeHierarchy::Subdivide(uint32_t nodeIndex, const std::vector<XMFLOAT3>& a_Centroids, const BvhBuildSettings& settings)
+{
+	// Nodes are pushed while subdividing : access them by index only
+	const uint32_t first = m_Nodes[nodeIndex].First;
+	const uint32_t count = m_Nodes[nodeIndex].Count;
+
+	AABB bounds;
+	AABB centroidBounds;
+	for (uint32_t i = first; i < first + count; ++i)
+	{
+		bounds.Merge(m_ItemBounds[m_Items[i]]);
+		centroidBounds.Expand(a_Centroids[m_Items[i]]);
+	}
+
+	m_Nodes[nodeIndex].Bounds = bounds;
+
+	if (count <= settings.MaxLeafSize)
+	{
+		return;
+	}
+
+	// Binned SAH : the centroids are sorted into buckets along each axis, and the cost of splitting between each pair of buckets is evaluated
+	// "On fast Construction of SAH-based Bounding Volume Hierarchies", I. Wald
+	struct Bin
+	{
+		AABB Bounds;
+		uint32_t Count = 0;
+	};
+
+	const uint32_t numBins = (std::clamp)(settings.NumBins, 2u, MaxBins);
+	Bin bins[MaxBins];
+	float rightAreas[MaxBins];
+	uint32_t rightCounts[MaxBins];
+
+	int bestAxis = -1;
+	uint32_t bestSplit = 0;
+	float bestCost = FLT_MAX;
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		const float axisMin = GetAxis(centroidBounds.Min, axis);
+		const float axisMax = GetAxis(centroidBounds.Max, axis);
+
+		if (axisMax <= axisMin)
+		{
+			continue;
+		}
+
+		const float scale = numBins / (axisMax - axisMin);
+
+		std::fill(bins, bins + numBins, Bin());
+		for (uint32_t i = first; i < first + count; ++i)
+		{
+			const uint32_t item = m_Items[i];
+			const uint32_t bin = (std::min)(uint32_t((GetAxis(a_Centroids[item], axis) - axisMin) * scale), numBins - 1);
+
+			bins[bin].Bounds.Merge(m_ItemBounds[item]);
+			bins[bin].Count++;
+		}
+
+		// Sweep from the right, then from the left : the cost of each split is known in linear time
+		AABB rightBounds;
+		uint32_t rightCount = 0;
+		for (uint32_t split = numBins - 1; split > 0; --split)
+		{
+			rightBounds.Merge(bins[split].Bounds);
+			rightCount += bins[split].Count;
+			rightAreas[split] = rightBounds.SurfaceArea();
+			rightCounts[split] = rightCount;
+		}
+
+		AABB leftBounds;
+		uint32_t leftCount = 0;
+		for (uint32_t split = 1; split < numBins; ++split)
+		{
+			leftBounds.Merge(bins[split - 1].Bounds);
+			leftCount += bins[split - 1].Count;
+
+			const float cost = leftCount * leftBounds.SurfaceArea() + rightCounts[split] * rightAreas[split];
+			if (leftCount > 0 && rightCounts[split] > 0 && cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = split;
+			}
+		}
+	}
+
+	// Splitting is only worth it when it is cheaper than testing every item of the node
+	const float leafCost = count * bounds.SurfaceArea();
+	uint32_t middle = first;
+
+	if (bestAxis >= 0 && bestCost < leafCost)
+	{
+		const float axisMin = GetAxis(centroidBounds.Min, bestAxis);
+		const float scale = numBins / (GetAxis(centroidBounds.Max, bestAxis) - axisMin);
+
+		auto splitIte = std::partition(m_Items.begin() + first, m_Items.begin() + first + count, [&](uint32_t item)
+		{
+			return (std::min)(uint32_t((GetAxis(a_Centroids[item], bestAxis) - axisMin) * scale), numBins - 1) < bestSplit;
+		});
+
+		middle = uint32_t(splitIte - m_Items.begin());
+	}
+	else if (count > 4 * settings.MaxLeafSize)
+	{
+		// Large nodes are still split in the middle (e.g. all centroids at the same position), to bound the cost of the leaves
+		middle = first + count / 2;
+	}
+	else
+	{
+		return;
+	}
+
+	const uint32_t left = (uint32_t)m_Nodes.size();
+	m_Nodes[nodeIndex].Left = left;
+
+	Node leftChild;
+	leftChild.First = first;
+	leftChild.Count = middle - first;
+
+	Node rightChild;
+	rightChild.First = middle;
+	rightChild.Count = first + count - middle;
+
+	m_Nodes.push_back(leftChild);
+	m_Nodes.push_back(rightChild);
+
+	Subdivide(left, a_Centroids, settings);
+	Subdivide(left + 1, a_Centroids, settings);
+}
+
+void BoundingVolumeHierarchy::Refit(const std::vector<AABB>& a_Bounds)
+{
+	if (a_Bounds.size() != m_ItemBounds.size())
+	{
+		LOG_ERROR("BoundingVolumeHierarchy: Cannot refit {0} items in a tree built with {1} items.", a_Bounds.size(), m_ItemBounds.size());
+		return;
+	}
+
+	for (uint32_t i = 0; i < a_Bounds.size(); ++i)
+	{
+		m_ItemBounds[i] = GetItemBox(a_Bounds[i]);
+	}
+
+	// Children are always stored after their parent : a reverse walk updates them first
+	for (size_t n = m_Nodes.size(); n-- > 0;)
+	{
+		Node& node = m_Nodes[n];
+		node.Bounds = AABB();
+
+		if (node.IsLeaf())
+		{
+			for (uint32_t i = node.First; i < node.First + node.Count; ++i)
+			{
+				node.Bounds.Merge(m_ItemBounds[m_Items[i]]);
+			}
+		}
+		else
+		{
+			node.Bounds.Merge(m_Nodes[node.Left].Bounds);
+			node.Bounds.Merge(m_Nodes[node.Left + 1].Bounds);
+		}
+	}
+}
+
+float BoundingVolumeHierarchy::GetSahCost() const
+{
+	if (m_Nodes.empty())
+	{
+		return 0.0f;
+	}
+
+	// Traversal cost of 1 per node, 1 per item, weighted by the probability of hitting the node
+	const float rootArea = m_Nodes[0].Bounds.SurfaceArea();
+	if (rootArea <= 0.0f)
+	{
+		return 0.0f;
+	}
+
+	float cost = 0.0f;
+	for (const Node& node : m_Nodes)
+	{
+		cost += node.Bounds.SurfaceArea() * (node.IsLeaf() ? node.Count : 1.0f);
+	}
+
+	return cost / rootArea;
+}
+
+void BoundingVolumeHierarchy::AppendItems(const Node& node, std::vector<uint32_t>& r_Items) const
+{
+	r_Items.insert(r_Items.end(), m_Items.begin() + node.First, m_Items.begin() + node.First + node.Count);
+}
+
+// Returns -1 when the box is outside the plane, 1 when it is inside and 0 when it intersects it
+static int ClassifyBox(const XMFLOAT4& plane, const XMFLOAT3& center, const XMFLOAT3& extents)
+{
+	const float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+	const float radius = extents.x * fabsf(plane.x) + extents.y * fabsf(plane.y) + extents.z * fabsf(plane.z);
+
+	if (distance + radius < 0.0f)
+	{
+		return -1;
+	}
+
+	return distance - radius >= 0.0f ? 1 : 0;
+}
+
+void BoundingVolumeHierarchy::QueryFrustum(const FrustumPlanes& frustum, std::vector<uint32_t>& r_Items) const
+{
+	r_Items.insert(r_Items.end(), m_UnboundedItems.begin(), m_UnboundedItems.end());
+
+	if (!m_Nodes.empty())
+	{
+		QueryFrustum(0, frustum, 0x3F, r_Items);
+	}
+}
+
+void BoundingVolumeHierarchy::QueryFrustum(uint32_t nodeIndex, const FrustumPlanes& frustum, uint32_t planeMask, std::vector<uint32_t>& r_Items) const
+{
+	const Node& node = m_Nodes[nodeIndex];
+
+	// Planes the parent box is entirely inside of are not tested again (plane masking)
+	const XMFLOAT3 center = node.Bounds.Center();
+	const XMFLOAT3 extents = node.Bounds.Extents();
+
+	for (int p = 0; p < 6; ++p)
+	{
+		if ((planeMask & (1u << p)) == 0)
+		{
+			continue;
+		}
+
+		const int side = ClassifyBox(frustum.Planes[p], center, extents);
+		if (side < 0)
+		{
+			return;
+		}
+
+		if (side > 0)
+		{
+			planeMask &= ~(1u << p);
+		}
+	}
+
+	if (planeMask == 0)
+	{
+		AppendItems(node, r_Items);
+		return;
+	}
+
+	if (!node.IsLeaf())
+	{
+		QueryFrustum(node.Left, frustum, planeMask, r_Items);
+		QueryFrustum(node.Left + 1, frustum, planeMask, r_Items);
+		return;
+	}
+
+	for (uint32_t i = node.First; i < node.First + node.Count; ++i)
+	{
+		const AABB& box = m_ItemBounds[m_Items[i]];
+		const XMFLOAT3 itemCenter = box.Center();
+		const XMFLOAT3 itemExtents = box.Extents();
+
+		bool bOutside = false;
+		for (int p = 0; p < 6 && !bOutside; ++p)
+		{
+			bOutside = (planeMask & (1u << p)) != 0 && ClassifyBox(frustum.Planes[p], itemCenter, itemExtents) < 0;
+		}
+
+		if (!bOutside)
+		{
+			r_Items.push_back(m_Items[i]);
+		}
+	}
+}
+
+void BoundingVolumeHierarchy::QueryDistance(const XMFLOAT3& point, float distance, std::vector<uint32_t>& r_Items) const
+{
+	r_Items.insert(r_Items.end(), m_UnboundedItems.begin(), m_UnboundedItems.end());
+
+	if (m_Nodes.empty())
+	{
+		return;
+	}
+
+	const float distanceSq = distance * distance;
+
+	// Squared distances from the point to the closest and to the farthest point of a box
+	auto GetDistancesSq = [&point](const AABB& box, float& r_MinSq, float& r_MaxSq)
+	{
+		const float p[3] = { point.x, point.y, point.z };
+		const float boxMin[3] = { box.Min.x, box.Min.y, box.Min.z };
+		const float boxMax[3] = { box.Max.x, box.Max.y, box.Max.z };
+
+		r_MinSq = 0.0f;
+		r_MaxSq = 0.0f;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const float below = boxMin[axis] - p[axis];
+			const float above = p[axis] - boxMax[axis];
+			const float outside = (std::max)((std::max)(below, above), 0.0f);
+			const float farthest = (std::max)(fabsf(p[axis] - boxMin[axis]), fabsf(p[axis] - boxMax[axis]));
+
+			r_MinSq += outside * outside;
+			r_MaxSq += farthest * farthest;
+		}
+	};
+
+	std::vector<uint32_t> stack;
+	stack.reserve(64);
+	stack.push_back(0);
+
+	while (!stack.empty())
+	{
+		const Node& node = m_Nodes[stack.back()];
+		stack.pop_back();
+
+		float minSq, maxSq;
+		GetDistancesSq(node.Bounds, minSq, maxSq);
+
+		if (minSq > distanceSq)
+		{
+			continue;
+		}
+
+		// The whole box is within the distance
+		if (maxSq <= distanceSq)
+		{
+			AppendItems(node, r_Items);
+			continue;
+		}
+
+		if (!node.IsLeaf())
+		{
+			stack.push_back(node.Left + 1);
+			stack.push_back(node.Left);
+			continue;
+		}
+
+		for (uint32_t i = node.First; i < node.First + node.Count; ++i)
+		{
+			GetDistancesSq(m_ItemBounds[m_Items[i]], minSq, maxSq);
+			if (minSq <= distanceSq)
+			{
+				r_Items.push_back(m_Items[i]);
+			}
+		}
+	}
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "Bounds.h"
+#include "FrustumCuller.h"
+
+struct BvhBuildSettings
+{
+	// Leaves are not split further below this number of items
+	uint32_t MaxLeafSize = 4;
+
+	// Number of buckets the centroids are binned into along each axis to evaluate the split costs (at most 64)
+	uint32_t NumBins = 16;
+};
+
+// Binary tree of bounding boxes over a set of items (identified by their index in the bounds given to Build)
+// - Build : full top-down rebuild, splits chosen with the surface area heuristic over binned centroids
+// - Refit : updates the boxes of the tree after items moved, keeping its topology. Cheap, but the tree quality
+//   degrades when items move a lot : compare GetSahCost() to its value after the last build to decide when to rebuild
+// - Items without valid bounds are kept out of the tree and returned by every query
+// - Queries walk the tree and accept or reject whole subtrees when their box is entirely inside or outside the volume,
+//   and give the same items as testing every box individually
+class BoundingVolumeHierarchy
+{
+public:
+	BoundingVolumeHierarchy() = default;
+
+	void Build(const std::vector<AABB>& a_Bounds, const BvhBuildSettings& settings = {});
+
+	// a_Bounds must have as many items as when the tree was built
+	void Refit(const std::vector<AABB>& a_Bounds);
+
+	// Appends the items whose box intersects the frustum (same conservative test as FrustumCuller)
+	void QueryFrustum(const FrustumPlanes& frustum, std::vector<uint32_t>& r_Items) const;
+
+	// Appends the items whose box is within a distance of a point
+	void QueryDistance(const DirectX::XMFLOAT3& point, float distance, std::vector<uint32_t>& r_Items) const;
+
+	// Expected cost of a ray traversal, relative to the cost of testing one item
+	float GetSahCost() const;
+
+	uint32_t GetNumItems() const { return (uint32_t)m_ItemBounds.size(); }
+	uint32_t GetNumNodes() const { return (uint32_t)m_Nodes.size(); }
+	bool IsEmpty() const { return m_Nodes.empty(); }
+
+protected:
+	struct Node
+	{
+		AABB Bounds;
+
+		// Items of the subtree : m_Items[First, First + Count)
+		uint32_t First = 0;
+		uint32_t Count = 0;
+
+		// Index of the left child, the right child follows it. 0 for leaves (the root is never a child)
+		uint32_t Left = 0;
+
+		bool IsLeaf() const { return Left == 0; }
+	};
+
+	void Subdivide(uint32_t nodeIndex, const std::vector<DirectX::XMFLOAT3>& a_Centroids, const BvhBuildSettings& settings);
+	void QueryFrustum(uint32_t nodeIndex, const FrustumPlanes& frustum, uint32_t planeMask, std::vector<uint32_t>& r_Items) const;
+	void AppendItems(const Node& node, std::vector<uint32_t>& r_Items) const;
+
+	std::vector<Node> m_Nodes;
+	std::vector<uint32_t> m_Items;
+	std::vector<AABB> m_ItemBounds;
+	std::vector<uint32_t> m_UnboundedItems;
+};
@@ -0,0 +1,55 @@
+#include "pch.h"
+
+#include "DirtySet.h"
+
+void DirtySet::Resize(uint32_t ui_Count)
+{
+	const uint32_t previousCount = (uint32_t)m_FramesLeft.size();
+
+	if (ui_Count < previousCount)
+	{
+		// Drop the items that don't exist anymore
+		size_t numKept = 0;
+		for (uint32_t index : m_Dirty)
+		{
+			if (index < ui_Count)
+			{
+				m_Dirty[numKept++] = index;
+			}
+		}
+
+		m_Dirty.resize(numKept);
+	}
+
+	m_FramesLeft.resize(ui_Count, 0);
+
+	for (uint32_t index = previousCount; index < ui_Count; ++index)
+	{
+		MarkDirty(index);
+	}
+}
+
+void DirtySet::MarkDirty(uint32_t index)
+{
+	if (m_FramesLeft[index] == 0)
+	{
+		m_Dirty.push_back(index);
+	}
+
+	m_FramesLeft[index] = (uint8_t)m_NumCopies;
+}
+
+void DirtySet::Advance()
+{
+	// Keeps the order in which the items were listed
+	size_t numKept = 0;
+	for (uint32_t index : m_Dirty)
+	{
+		if (--m_FramesLeft[index] > 0)
+		{
+			m_Dirty[numKept++] = index;
+		}
+	}
+
+	m_Dirty.resize(numKept);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Items changed on the CPU whose GPU data has one copy per frame resource
+// A changed item stays listed for as many frames as there are copies, each frame writing the copy of its frame resource
+// The cost of a frame is proportional to the number of listed items, not to the number of items
+class DirtySet
+{
+public:
+	explicit DirtySet(uint32_t ui_NumCopies) : m_NumCopies(ui_NumCopies) {}
+
+	// New items are dirty : none of their copies has been written yet
+	void Resize(uint32_t ui_Count);
+	uint32_t GetCount() const { return (uint32_t)m_FramesLeft.size(); }
+
+	// Every copy must be written again, even if the item was already listed
+	void MarkDirty(uint32_t index);
+
+	// Items whose copy of the current frame resource must be written
+	const std::vector<uint32_t>& GetDirty() const { return m_Dirty; }
+
+	// Once the copy of the current frame resource is written : items written to every copy are not listed anymore
+	void Advance();
+
+protected:
+	uint32_t m_NumCopies;
+
+	std::vector<uint8_t> m_FramesLeft;	// Per item, 0 when not listed
+	std::vector<uint32_t> m_Dirty;
+};
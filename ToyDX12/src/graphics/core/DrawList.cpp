@@ -0,0 +1,64 @@
+#include "pch.h"
+
+#include "DrawList.h"
+
+#include <algorithm>
+#include <cmath>
+
+static_assert(DrawList::PassBits + DrawList::PsoBits + DrawList::MaterialBits + DrawList::DepthBits + DrawList::MeshBits == 64, "Draw keys must use 64 bits");
+
+static uint64_t Field(uint32_t value, int bits)
+{
+	return uint64_t(value) & ((uint64_t(1) << bits) - 1);
+}
+
+void DrawList::Reserve(size_t ui_Count)
+{
+	m_Entries.reserve(ui_Count);
+	m_Scratch.reserve(ui_Count);
+}
+
+void DrawList::Sort()
+{
+	m_Scratch.resize(m_Entries.size());
+	RadixSort::Sort(m_Entries.data(), m_Scratch.data(), m_Entries.size());
+}
+
+uint32_t DrawList::QuantizeDepth(float viewDepth, float nearZ, float farZ)
+{
+	const float maxDepth = float((1u << DepthBits) - 1);
+
+	if (viewDepth <= nearZ || farZ <= nearZ)
+	{
+		return 0;
+	}
+
+	const float t = logf(viewDepth / nearZ) / logf(farZ / nearZ);
+
+	return (uint32_t)((std::min)(t, 1.0f) * maxDepth);
+}
+
+uint64_t DrawList::MakeKey(const DrawKeyFields& fields) const
+{
+	const uint32_t depth = QuantizeDepth(fields.ViewDepth, m_NearZ, m_FarZ);
+
+	uint64_t key = Field((uint32_t)fields.Pass, PassBits);
+
+	if (fields.Pass == DrawPass::Transparent)
+	{
+		// Farthest first
+		const uint32_t backToFront = ((1u << DepthBits) - 1) - depth;
+
+		key = (key << DepthBits) | Field(backToFront, DepthBits);
+		key = (key << PsoBits) | Field(fields.Pso, PsoBits);
+		key = (key << MaterialBits) | Field(fields.Material, MaterialBits);
+	}
+	else
+	{
+		key = (key << PsoBits) | Field(fields.Pso, PsoBits);
+		key = (key << MaterialBits) | Field(fields.Material, MaterialBits);
+		key = (key << DepthBits) | Field(depth, DepthBits);
+	}
+
+	return (key << MeshBits) | Field(fields.Mesh, MeshBits);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "RadixSort.h"
+
+enum class DrawPass : uint32_t
+{
+	Opaque = 0,
+	Transparent = 1,
+};
+
+// What a draw binds, packed into its sort key
+struct DrawKeyFields
+{
+	DrawPass Pass = DrawPass::Opaque;
+	uint32_t Pso = 0;
+	uint32_t Material = 0;
+	uint32_t Mesh = 0;
+
+	// View space depth of the draw (e.g. of its bounds center)
+	float ViewDepth = 0.0f;
+};
+
+// Draws of a frame, sorted by a 64 bits key so that consecutive draws share as many bindings as possible
+// Key layout, most significant bits first :
+//	- Opaque      : pass (2) | PSO (8) | material (16) | depth (16), front to back | mesh (22)
+//	- Transparent : pass (2) | depth (16), back to front | PSO (8) | material (16) | mesh (22)
+// Transparent draws must blend in depth order, so depth comes before any binding for them
+// Fields larger than their bits are truncated, which only costs some state changes
+class DrawList
+{
+public:
+	DrawList() = default;
+
+	void Clear() { m_Entries.clear(); }
+	void Reserve(size_t ui_Count);
+
+	// ui_Item is what the caller draws, e.g. an index in its drawables
+	void Add(uint64_t key, uint32_t ui_Item) { m_Entries.push_back({ key, ui_Item }); }
+
+	// Parallel radix sort on the keys
+	void Sort();
+
+	size_t Size() const { return m_Entries.size(); }
+	uint32_t GetItem(size_t i) const { return m_Entries[i].Value; }
+	uint64_t GetKey(size_t i) const { return m_Entries[i].Key; }
+
+	// Depth range the draws are quantized in, depths outside of it are clamped
+	void SetDepthRange(float nearZ, float farZ) { m_NearZ = nearZ; m_FarZ = farZ; }
+
+	uint64_t MakeKey(const DrawKeyFields& fields) const;
+
+	// Logarithmic quantization : closer draws get more precision
+	static uint32_t QuantizeDepth(float viewDepth, float nearZ, float farZ);
+
+	static const int PassBits = 2;
+	static const int PsoBits = 8;
+	static const int MaterialBits = 16;
+	static const int DepthBits = 16;
+	static const int MeshBits = 22;
+
+protected:
+	std::vector<SortEntry> m_Entries;
+	std::vector<SortEntry> m_Scratch;
+
+	float m_NearZ = 1.0f;
+	float m_FarZ = 1000.0f;
+};
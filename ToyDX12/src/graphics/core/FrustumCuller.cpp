@@ -0,0 +1,144 @@
+#include "pch.h"
+
+#include "FrustumCuller.h"
+
+#include <cfloat>
+
+using namespace DirectX;
+
+FrustumPlanes FrustumPlanes::FromViewProj(FXMMATRIX viewProj)
+{
+	// Clip space position is v * viewProj : each plane is a combination of the columns of the matrix
+	const XMMATRIX columns = XMMatrixTranspose(viewProj);
+
+	const XMVECTOR planes[6] =
+	{
+		XMVectorAdd(columns.r[3], columns.r[0]),		// Left   : -w <= x
+		XMVectorSubtract(columns.r[3], columns.r[0]),	// Right  :  x <= w
+		XMVectorAdd(columns.r[3], columns.r[1]),		// Bottom : -w <= y
+		XMVectorSubtract(columns.r[3], columns.r[1]),	// Top    :  y <= w
+		columns.r[2],									// Near   :  0 <= z
+		XMVectorSubtract(columns.r[3], columns.r[2])	// Far    :  z <= w
+	};
+
+	FrustumPlanes result;
+	for (int p = 0; p < 6; ++p)
+	{
+		XMStoreFloat4(&result.Planes[p], XMPlaneNormalize(planes[p]));
+	}
+
+	return result;
+}
+
+void FrustumCuller::Resize(uint32_t ui_Count)
+{
+	const size_t paddedCount = (size_t(ui_Count) + 3) & ~size_t(3);
+
+	m_CenterX.resize(paddedCount, 0.0f);
+	m_CenterY.resize(paddedCount, 0.0f);
+	m_CenterZ.resize(paddedCount, 0.0f);
+	m_ExtentX.resize(paddedCount, FLT_MAX);
+	m_ExtentY.resize(paddedCount, FLT_MAX);
+	m_ExtentZ.resize(paddedCount, FLT_MAX);
+
+	m_Visible.reserve(paddedCount);
+
+	m_Count = ui_Count;
+}
+
+void FrustumCuller::SetBounds(uint32_t index, const AABB& worldBounds)
+{
+	if (!worldBounds.IsValid())
+	{
+		m_CenterX[index] = m_CenterY[index] = m_CenterZ[index] = 0.0f;
+		m_ExtentX[index] = m_ExtentY[index] = m_ExtentZ[index] = FLT_MAX;
+		return;
+	}
+
+	const XMFLOAT3 center = worldBounds.Center();
+	const XMFLOAT3 extents = worldBounds.Extents();
+
+	m_CenterX[index] = center.x;
+	m_CenterY[index] = center.y;
+	m_CenterZ[index] = center.z;
+	m_ExtentX[index] = extents.x;
+	m_ExtentY[index] = extents.y;
+	m_ExtentZ[index] = extents.z;
+}
+
+// One bit per lane, set when the lane of the comparison result is true
+static uint32_t MoveMask(FXMVECTOR comparison)
+{
+#if defined(_XM_SSE_INTRINSICS_)
+	return (uint32_t)_mm_movemask_ps(comparison);
+#else
+	uint32_t lanes[4];
+	XMStoreInt4(lanes, comparison);
+	return (lanes[0] >> 31) | ((lanes[1] >> 31) << 1) | ((lanes[2] >> 31) << 2) | ((lanes[3] >> 31) << 3);
+#endif
+}
+
+const std::vector<uint32_t>& FrustumCuller::Cull(const FrustumPlanes& frustum)
+{
+	// Plane components are broadcast once, absolute values of the normals project the extents on them
+	XMVECTOR planeX[6], planeY[6], planeZ[6], planeW[6];
+	XMVECTOR absPlaneX[6], absPlaneY[6], absPlaneZ[6];
+
+	for (int p = 0; p < 6; ++p)
+	{
+		const XMVECTOR plane = XMLoadFloat4(&frustum.Planes[p]);
+
+		planeX[p] = XMVectorSplatX(plane);
+		planeY[p] = XMVectorSplatY(plane);
+		planeZ[p] = XMVectorSplatZ(plane);
+		planeW[p] = XMVectorSplatW(plane);
+
+		absPlaneX[p] = XMVectorAbs(planeX[p]);
+		absPlaneY[p] = XMVectorAbs(planeY[p]);
+		absPlaneZ[p] = XMVectorAbs(planeZ[p]);
+	}
+
+	// Indices are written for every lane and only kept when visible, which avoids a branch per box
+	m_Visible.resize(m_CenterX.size());
+	uint32_t* visible = m_Visible.data();
+	uint32_t numVisible = 0;
+
+	for (uint32_t first = 0; first < m_Count; first += 4)
+	{
+		const XMVECTOR centerX = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&m_CenterX[first]));
+		const XMVECTOR centerY = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&m_CenterY[first]));
+		const XMVECTOR centerZ = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&m_CenterZ[first]));
+		const XMVECTOR extentX = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&m_ExtentX[first]));
+		const XMVECTOR extentY = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&m_ExtentY[first]));
+		const XMVECTOR extentZ = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&m_ExtentZ[first]));
+
+		XMVECTOR outside = XMVectorFalseInt();
+
+		for (int p = 0; p < 6; ++p)
+		{
+			// A box is outside when its center is further behind the plane than its extents projected on the normal
+			const XMVECTOR distance = XMVectorMultiplyAdd(centerZ, planeZ[p], XMVectorMultiplyAdd(centerY, planeY[p], XMVectorMultiplyAdd(centerX, planeX[p], planeW[p])));
+			const XMVECTOR radius = XMVectorMultiplyAdd(extentZ, absPlaneZ[p], XMVectorMultiplyAdd(extentY, absPlaneY[p], XMVectorMultiply(extentX, absPlaneX[p])));
+
+			outside = XMVectorOrInt(outside, XMVectorLess(XMVectorAdd(distance, radius), XMVectorZero()));
+		}
+
+		uint32_t visibleLanes = ~MoveMask(outside) & 0xF;
+
+		// Padding lanes of the last group
+		if (first + 4 > m_Count)
+		{
+			visibleLanes &= (1u << (m_Count - first)) - 1;
+		}
+
+		for (uint32_t lane = 0; lane < 4; ++lane)
+		{
+			visible[numVisible] = first + lane;
+			numVisible += (visibleLanes >> lane) & 1;
+		}
+	}
+
+	m_Visible.resize(numVisible);
+
+	return m_Visible;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "Bounds.h"
+
+// Planes of a view frustum with their normals pointing inside : a point p is inside a plane when dot(plane.xyz, p) + plane.w >= 0
+struct FrustumPlanes
+{
+	DirectX::XMFLOAT4 Planes[6];
+
+	// Extracts the planes from a view * projection matrix (row vectors, D3D clip space : 0 <= z <= w)
+	// "Fast Extraction of Viewing Frustum Planes from the World-View-Projection Matrix", G. Gribb, K. Hartmann
+	static FrustumPlanes FromViewProj(DirectX::FXMMATRIX viewProj);
+};
+
+// Tests world space bounding boxes against a view frustum, 4 boxes at a time
+// Boxes are stored as centers and extents in structure of arrays : each SIMD lane holds one box and each plane is tested with a few multiply-adds
+// The test is conservative : boxes near the corners of the frustum may be kept visible while being outside of it
+// Indices are the ones given to SetBounds, so they can map to any array of the caller (drawables, instances...)
+class FrustumCuller
+{
+public:
+	FrustumCuller() = default;
+
+	// New boxes are infinite, and never culled until their bounds are set
+	void Resize(uint32_t ui_Count);
+	uint32_t GetCount() const { return m_Count; }
+
+	// Invalid bounds are treated as infinite
+	void SetBounds(uint32_t index, const AABB& worldBounds);
+
+	// Returns the indices of the boxes intersecting the frustum, in increasing order
+	// The list stays valid until the next call
+	const std::vector<uint32_t>& Cull(const FrustumPlanes& frustum);
+	const std::vector<uint32_t>& GetVisible() const { return m_Visible; }
+
+protected:
+	uint32_t m_Count = 0;
+
+	// Padded to a multiple of 4 boxes
+	std::vector<float> m_CenterX;
+	std::vector<float> m_CenterY;
+	std::vector<float> m_CenterZ;
+	std::vector<float> m_ExtentX;
+	std::vector<float> m_ExtentY;
+	std::vector<float> m_ExtentZ;
+
+	std::vector<uint32_t> m_Visible;
+};
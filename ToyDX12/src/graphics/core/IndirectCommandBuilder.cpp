@@ -0,0 +1,31 @@
+#include "pch.h"
+
+#include "IndirectCommandBuilder.h"
+
+// Arguments of a command signature are read back to back : no padding between them
+static_assert(sizeof(IndirectVertexBufferView) == 16 && sizeof(IndirectIndexBufferView) == 16 && sizeof(IndirectDrawIndexedArguments) == 20, "Arguments must match the D3D12 structures");
+static_assert(IndirectCommandBuilder::VertexBufferOffset == IndirectCommandBuilder::RootConstantsOffset + IndirectDrawCommand::NumRootConstants * sizeof(uint32_t), "Vertex buffer view must follow the root constants");
+static_assert(IndirectCommandBuilder::IndexBufferOffset == IndirectCommandBuilder::VertexBufferOffset + sizeof(IndirectVertexBufferView), "Index buffer view must follow the vertex buffer view");
+static_assert(IndirectCommandBuilder::DrawOffset == IndirectCommandBuilder::IndexBufferOffset + sizeof(IndirectIndexBufferView), "Draw arguments must follow the index buffer view");
+static_assert(IndirectCommandBuilder::ByteStride % 8 == 0, "Buffer addresses must stay 8 bytes aligned");
+
+void IndirectCommandBuilder::AddDrawIndexed(const uint32_t a_RootConstants[IndirectDrawCommand::NumRootConstants], const IndirectVertexBufferView& vertexBuffer, const IndirectIndexBufferView& indexBuffer,
+	uint32_t ui_IndexCount, uint32_t ui_InstanceCount, uint32_t ui_StartIndex, int32_t i_BaseVertex)
+{
+	IndirectDrawCommand& command = m_Commands.emplace_back();
+
+	for (uint32_t i = 0; i < IndirectDrawCommand::NumRootConstants; ++i)
+	{
+		command.RootConstants[i] = a_RootConstants[i];
+	}
+
+	command.VertexBuffer = vertexBuffer;
+	command.IndexBuffer = indexBuffer;
+
+	// Instances are found from the root constants : SV_InstanceID starts at 0 whatever the start instance
+	command.Draw.IndexCountPerInstance = ui_IndexCount;
+	command.Draw.InstanceCount = ui_InstanceCount;
+	command.Draw.StartIndexLocation = ui_StartIndex;
+	command.Draw.BaseVertexLocation = i_BaseVertex;
+	command.Draw.StartInstanceLocation = 0;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Mirrors of the D3D12 argument structures, so that commands can be built (and checked) without the D3D12 headers
+
+// D3D12_VERTEX_BUFFER_VIEW
+struct IndirectVertexBufferView
+{
+	uint64_t BufferLocation = 0;
+	uint32_t SizeInBytes = 0;
+	uint32_t StrideInBytes = 0;
+};
+
+// D3D12_INDEX_BUFFER_VIEW
+struct IndirectIndexBufferView
+{
+	uint64_t BufferLocation = 0;
+	uint32_t SizeInBytes = 0;
+	uint32_t Format = 0;	// DXGI_FORMAT
+};
+
+// D3D12_DRAW_INDEXED_ARGUMENTS
+struct IndirectDrawIndexedArguments
+{
+	uint32_t IndexCountPerInstance = 0;
+	uint32_t InstanceCount = 0;
+	uint32_t StartIndexLocation = 0;
+	int32_t  BaseVertexLocation = 0;
+	uint32_t StartInstanceLocation = 0;
+};
+
+// One command of an ExecuteIndirect draw, in the order of the arguments of the command signature :
+// root constants | vertex buffer view | index buffer view | draw indexed arguments
+// Buffer addresses stay 8 bytes aligned from one command to the next
+struct alignas(8) IndirectDrawCommand
+{
+	static const uint32_t NumRootConstants = 2;
+
+	uint32_t RootConstants[NumRootConstants] = {};
+	IndirectVertexBufferView VertexBuffer;
+	IndirectIndexBufferView IndexBuffer;
+	IndirectDrawIndexedArguments Draw;
+};
+
+// Builds the argument buffer of an ExecuteIndirect call, one command per draw
+// Each command sets the vertex/index buffers again : the GPU doesn't skip redundant ones, but the draws
+// of the whole pass don't have to share their geometry buffers
+class IndirectCommandBuilder
+{
+public:
+	IndirectCommandBuilder() = default;
+
+	void Clear() { m_Commands.clear(); }
+	void Reserve(size_t ui_Count) { m_Commands.reserve(ui_Count); }
+
+	void AddDrawIndexed(const uint32_t a_RootConstants[IndirectDrawCommand::NumRootConstants], const IndirectVertexBufferView& vertexBuffer, const IndirectIndexBufferView& indexBuffer,
+		uint32_t ui_IndexCount, uint32_t ui_InstanceCount, uint32_t ui_StartIndex, int32_t i_BaseVertex);
+
+	size_t GetCount() const { return m_Commands.size(); }
+	const IndirectDrawCommand* GetData() const { return m_Commands.data(); }
+	size_t GetSizeInBytes() const { return m_Commands.size() * ByteStride; }
+
+	// Stride and offsets of the arguments in a command, as described to the command signature
+	static const uint32_t ByteStride = sizeof(IndirectDrawCommand);
+	static const uint32_t RootConstantsOffset = offsetof(IndirectDrawCommand, RootConstants);
+	static const uint32_t VertexBufferOffset = offsetof(IndirectDrawCommand, VertexBuffer);
+	static const uint32_t IndexBufferOffset = offsetof(IndirectDrawCommand, IndexBuffer);
+	static const uint32_t DrawOffset = offsetof(IndirectDrawCommand, Draw);
+
+protected:
+	std::vector<IndirectDrawCommand> m_Commands;
+};
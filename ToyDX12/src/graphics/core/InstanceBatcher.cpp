@@ -0,0 +1,63 @@
+#include "pch.h"
+
+#include "InstanceBatcher.h"
+
+void InstanceBatcher::Clear()
+{
+	m_Entries.clear();
+	m_Batches.clear();
+	m_Instances.clear();
+	m_BatchOfKey.clear();
+}
+
+void InstanceBatcher::Reserve(size_t ui_Count)
+{
+	m_Entries.reserve(ui_Count);
+	m_Batches.reserve(ui_Count);
+	m_Instances.reserve(ui_Count);
+	m_BatchOfKey.reserve(ui_Count);
+}
+
+void InstanceBatcher::Add(uint64_t batchKey, uint32_t ui_Item, bool bMergeable)
+{
+	uint32_t batch = (uint32_t)m_Batches.size();
+
+	if (bMergeable)
+	{
+		auto [it, bInserted] = m_BatchOfKey.try_emplace(batchKey, batch);
+		batch = it->second;
+	}
+
+	if (batch == m_Batches.size())
+	{
+		InstanceBatch newBatch;
+		newBatch.FirstItem = ui_Item;
+		m_Batches.push_back(newBatch);
+	}
+
+	m_Batches[batch].NumInstances++;
+	m_Entries.push_back({ ui_Item, batch });
+}
+
+void InstanceBatcher::Build()
+{
+	uint32_t firstInstance = 0;
+	for (InstanceBatch& batch : m_Batches)
+	{
+		batch.FirstInstance = firstInstance;
+		firstInstance += batch.NumInstances;
+	}
+
+	// Scatter the items to their batch, NumInstances counts the instances already placed meanwhile
+	m_Instances.resize(m_Entries.size());
+	for (InstanceBatch& batch : m_Batches)
+	{
+		batch.NumInstances = 0;
+	}
+
+	for (const Entry& entry : m_Entries)
+	{
+		InstanceBatch& batch = m_Batches[entry.Batch];
+		m_Instances[batch.FirstInstance + batch.NumInstances++] = entry.Item;
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Draws of the same geometry with the same material, merged into a single instanced draw
+struct InstanceBatch
+{
+	uint32_t FirstInstance = 0;	// In the instance list
+	uint32_t NumInstances = 0;
+	uint32_t FirstItem = 0;		// Item of the first instance, what every instance of the batch draws
+};
+
+// Groups the items of a sorted draw list sharing the same batch key (e.g. geometry and material)
+// - Batches are in the order of their first item, instances of a batch in the order they were added
+// - Items that must keep their own place in the list (e.g. transparent draws) are never merged
+class InstanceBatcher
+{
+public:
+	InstanceBatcher() = default;
+
+	void Clear();
+	void Reserve(size_t ui_Count);
+
+	// ui_Item is what the caller draws, e.g. an index in its drawables
+	void Add(uint64_t batchKey, uint32_t ui_Item, bool bMergeable = true);
+
+	// Lays out the instances of each batch contiguously
+	void Build();
+
+	const std::vector<InstanceBatch>& GetBatches() const { return m_Batches; }
+
+	// Items of every batch, batch after batch
+	const std::vector<uint32_t>& GetInstances() const { return m_Instances; }
+
+protected:
+	struct Entry
+	{
+		uint32_t Item;
+		uint32_t Batch;
+	};
+
+	std::vector<Entry> m_Entries;
+	std::vector<InstanceBatch> m_Batches;
+	std::vector<uint32_t> m_Instances;
+
+	// Batch of each key added since the last Clear()
+	std::unordered_map<uint64_t, uint32_t> m_BatchOfKey;
+};
@@ -6,10 +6,16 @@
 #include "Logger.h"
 #include "MeshLoader.h"
 #include "TDXMesh.h"
+#include "TextureCooker.h"
+#include "TextureCache.h"
+#include "MappedFile.h"
+#include "HashUtil.h"
+#include "NameTable.h"
 
 using namespace DirectX;
 
 std::string MeshLoader::m_MeshRootPath;
+TextureCookSettings MeshLoader::m_TextureCookSettings;
 
 void MeshLoader::LoadGltf(const char* sz_Filename, MeshData* mesh)
 {
@@ -35,10 +41,12 @@ void MeshLoader::LoadGltf(const char* sz_Filename, MeshData* mesh)
 
 				ProcessGltfNode(false, &currNode, mesh);
 			}
+
+			TextureCooker::CookTextures(mesh->textures, m_TextureCookSettings);
 		}
 
 		LOG_INFO("Loaded : {0}", sz_Filename);
-		LOG_INFO("# Materials : {0}", mesh->materials.size());
+		LOG_INFO("# Materials : {0} ({1} duplicates removed)", mesh->materials.size(), mesh->numDuplicateMaterials);
 		LOG_INFO("# Textures : {0}", mesh->textures.size());
 
 		cgltf_free(data);
@@ -147,32 +155,53 @@ static void LoadIndices(cgltf_primitive* rawPrimitive, Primitive* primitive, Mes
 
 void SetMaterial(MeshData* data, Primitive* primitive, cgltf_material* rawMaterial, MaterialProperties& material)
 {
-	auto materialIte = data->materialTable.find(rawMaterial->name);
+	// Primitives using the same glTF material share it. Unnamed materials are only shared by content
+	const NameId rawName = rawMaterial->name != nullptr ? NameTable::Intern(rawMaterial->name) : InvalidNameId;
+
+	auto materialIte = data->materialTable.find(rawName);
 
-	if (rawMaterial->name != nullptr && materialIte != data->materialTable.end()) 
+	if (rawName != InvalidNameId && materialIte != data->materialTable.end())
 	{
-		primitive->MaterialName = materialIte->first;
-		primitive->MaterialId   = materialIte->second;
+		primitive->MaterialId = materialIte->second;
 	}
 	else
 	{
+		// A material with the same parameters and textures is used instead of a copy
+		const MaterialContentKey contentKey = MaterialContentKey::FromProperties(material);
+		auto contentIte = data->materialContentTable.find(contentKey);
+
+		if (contentIte != data->materialContentTable.end())
+		{
+			primitive->MaterialId = contentIte->second;
+			data->numDuplicateMaterials++;
+
+			if (rawName != InvalidNameId)
+			{
+				data->materialTable.insert({ rawName, contentIte->second });
+			}
+
+			return;
+		}
+
 		// Insert new material
 		int materialId = data->materials.size();
 
-		std::string name = std::string("Material ").append(std::to_string(materialId));
-
 		material.Id = materialId;
-		material.name = name;
+		material.name = rawName != InvalidNameId ? rawName : NameTable::Intern(std::string("Material ").append(std::to_string(materialId)));
 
-		primitive->MaterialName = material.name;
 		primitive->MaterialId = materialId;
 
-		data->materialTable.insert({ name.c_str(), materialId});
+		if (rawName != InvalidNameId)
+		{
+			data->materialTable.insert({ rawName, materialId });
+		}
+
+		data->materialContentTable.insert({ contentKey, materialId });
 		data->materials.push_back(material);
 	}
 }
 
-int LoadImageFile(MeshData* data, const std::string& rootPath, cgltf_image* image)
+int LoadImageFile(MeshData* data, const std::string& rootPath, cgltf_image* image, TextureRole e_Role)
 {
 	char* uri = image->uri;
 
@@ -191,22 +220,40 @@ int LoadImageFile(MeshData* data, const std::string& rootPath, cgltf_image* imag
 	}
 	else
 	{
-		unsigned char* imgData = stbi_load(path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
-		if (imgData == NULL)
+		MappedFile source;
+		if (!source.Open(path))
 		{
 			//LOG_ERROR("MeshLoader::LoadImageFile : Could not load image at {0}.", path);
 			return -1;
 		}
 
-		// Load and store new texture
-		Texture texture { 
+		Texture texture {
 			.Name = image->name ? image->name : path.c_str(),
-			.Id = (int)data->textures.size(), 
-			.Width = width, 
-			.Height = height, 
-			.Channels = STBI_rgb_alpha,
-			.data = imgData
+			.Id = (int)data->textures.size(),
+			.Role = e_Role
 		};
+
+		// Processed texels are cached on disk, keyed by the content of the image
+		uint64_t cacheKey = TextureCache::ComputeKey(HashUtil::Fnv1a(source.Data(), source.Size()), e_Role, MeshLoader::m_TextureCookSettings);
+
+		if (!TextureCache::Load(cacheKey, texture))
+		{
+			// Images are decoded with their own channel count, the TextureCooker packs them per role
+			unsigned char* imgData = stbi_load_from_memory((const stbi_uc*)source.Data(), (int)source.Size(), &width, &height, &channels, 0);
+			if (imgData == NULL)
+			{
+				//LOG_ERROR("MeshLoader::LoadImageFile : Could not load image at {0}.", path);
+				return -1;
+			}
+
+			texture.Width = width;
+			texture.Height = height;
+			texture.Channels = channels;
+			texture.data = imgData;
+			texture.CacheKey = cacheKey;
+		}
+
+		// Load and store new texture
 		handle = texture.Id;
 		// Update texture list
 		data->textures.push_back(texture);
@@ -230,6 +277,7 @@ void LoadMaterial(cgltf_primitive* rawPrimitive, Primitive* primitive, MeshData*
 	SpecularGlossiness specularGlossiness;
 
 	MaterialProperties materialProperties;
+	materialProperties.bTransparent = material->alpha_mode == cgltf_alpha_mode_blend;
 
 	// Load additional textures : emissive, normal maps ...
 	cgltf_texture* emissiveTexture = material->emissive_texture.texture;
@@ -237,13 +285,13 @@ void LoadMaterial(cgltf_primitive* rawPrimitive, Primitive* primitive, MeshData*
 
 	if (emissiveTexture)
 	{
-		materialProperties.hEmissiveTexture = LoadImageFile(data, MeshLoader::m_MeshRootPath, emissiveTexture->image);
+		materialProperties.hEmissiveTexture = LoadImageFile(data, MeshLoader::m_MeshRootPath, emissiveTexture->image, TextureRole::Emissive);
 		materialProperties.hasEmissive = true;
 	}
 
 	if (normalTexture)
 	{
-		materialProperties.hNormalTexture = LoadImageFile(data, MeshLoader::m_MeshRootPath, normalTexture->image);
+		materialProperties.hNormalTexture = LoadImageFile(data, MeshLoader::m_MeshRootPath, normalTexture->image, TextureRole::Normal);
 		materialProperties.hasNormalMap = true;
 	}
 
@@ -265,14 +313,14 @@ void LoadMaterial(cgltf_primitive* rawPrimitive, Primitive* primitive, MeshData*
 
 		if (diffuseTexture != nullptr)
 		{
-			materialProperties.specularGlossiness.hDiffuseTexture = LoadImageFile(data, MeshLoader::m_MeshRootPath, diffuseTexture->image);
+			materialProperties.specularGlossiness.hDiffuseTexture = LoadImageFile(data, MeshLoader::m_MeshRootPath, diffuseTexture->image, TextureRole::BaseColor);
 			materialProperties.specularGlossiness.hasDiffuse = true;
 
 		}
 		
 		if (specularGlossinessTexture != nullptr)
 		{
-			materialProperties.specularGlossiness.hSpecularGlossinessTexture = LoadImageFile(data, MeshLoader::m_MeshRootPath, specularGlossinessTexture->image);
+			materialProperties.specularGlossiness.hSpecularGlossinessTexture = LoadImageFile(data, MeshLoader::m_MeshRootPath, specularGlossinessTexture->image, TextureRole::SpecularGlossiness);
 			materialProperties.specularGlossiness.hasSpecularGlossiness = true;
 
 		}
@@ -298,14 +346,14 @@ void LoadMaterial(cgltf_primitive* rawPrimitive, Primitive* primitive, MeshData*
 		
 		if (baseColorTexture != nullptr)
 		{
-			materialProperties.metallicRoughness.hBaseColorTexture = LoadImageFile(data, MeshLoader::m_MeshRootPath, baseColorTexture->image);
+			materialProperties.metallicRoughness.hBaseColorTexture = LoadImageFile(data, MeshLoader::m_MeshRootPath, baseColorTexture->image, TextureRole::BaseColor);
 			materialProperties.metallicRoughness.hasBaseColorTex = true;
 		}
 	
 
 		if (metallicRoughnessTexture != nullptr)
 		{
-			materialProperties.metallicRoughness.hMetallicRoughnessTexture = LoadImageFile(data, MeshLoader::m_MeshRootPath, metallicRoughnessTexture->image);
+			materialProperties.metallicRoughness.hMetallicRoughnessTexture = LoadImageFile(data, MeshLoader::m_MeshRootPath, metallicRoughnessTexture->image, TextureRole::MetallicRoughness);
 			materialProperties.metallicRoughness.hasMetallicRoughnessTex = true;
 		}
 
@@ -315,6 +363,35 @@ void LoadMaterial(cgltf_primitive* rawPrimitive, Primitive* primitive, MeshData*
 
 }
 
+static void ComputeBoundsAndUvDensity(Primitive* primitive, const MeshData* st_Mesh)
+{
+	double surfaceArea = 0.0;
+	double uvArea = 0.0;
+
+	for (size_t i = 0; i + 2 < primitive->NumIndices; i += 3)
+	{
+		const uint16_t* indices = &st_Mesh->Indices[primitive->StartIndexLocation + i];
+
+		const Vertex& v0 = st_Mesh->Vertices[primitive->BaseVertexLocation + indices[0]];
+		const Vertex& v1 = st_Mesh->Vertices[primitive->BaseVertexLocation + indices[1]];
+		const Vertex& v2 = st_Mesh->Vertices[primitive->BaseVertexLocation + indices[2]];
+
+		primitive->Bounds.Expand(v0.Pos);
+		primitive->Bounds.Expand(v1.Pos);
+		primitive->Bounds.Expand(v2.Pos);
+
+		DirectX::XMVECTOR e1 = DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&v1.Pos), DirectX::XMLoadFloat3(&v0.Pos));
+		DirectX::XMVECTOR e2 = DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&v2.Pos), DirectX::XMLoadFloat3(&v0.Pos));
+		surfaceArea += 0.5 * DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMVector3Cross(e1, e2)));
+
+		const float du1 = v1.TexCoord0.x - v0.TexCoord0.x, dv1 = v1.TexCoord0.y - v0.TexCoord0.y;
+		const float du2 = v2.TexCoord0.x - v0.TexCoord0.x, dv2 = v2.TexCoord0.y - v0.TexCoord0.y;
+		uvArea += 0.5 * fabs(du1 * dv2 - du2 * dv1);
+	}
+
+	primitive->UvDensity = surfaceArea > 0.0 ? float(sqrt(uvArea / surfaceArea)) : 0.0f;
+}
+
 static void LoadPrimitive(cgltf_primitive* primitive, MeshData* st_Mesh, const DirectX::XMMATRIX& currWorldMat)
 {
 	////LOG_DEBUG("      Primitive : {0} attributes, {1} indices", primitive->attributes_count, primitive->indices->count);
@@ -324,6 +401,7 @@ static void LoadPrimitive(cgltf_primitive* primitive, MeshData* st_Mesh, const D
 	LoadIndices(primitive, &p, st_Mesh);
 	LoadVertices(primitive, st_Mesh, currWorldMat);
 	LoadMaterial(primitive, &p, st_Mesh);
+	ComputeBoundsAndUvDensity(&p, st_Mesh);
 
 	st_Mesh->Primitives.push_back(p);
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "DX12Geometry.h"
+#include "TextureCooker.h"
 
 struct cgltf_node;
 struct MeshData;
@@ -13,6 +14,7 @@ public:
 
 	static void LoadGltf(const char* sz_Filename, MeshData* mesh);
 	static std::string m_MeshRootPath;
+	static TextureCookSettings m_TextureCookSettings;
 
 protected:
 	static void ProcessGltfNode(bool bIsChild, cgltf_node* p_Node, MeshData* mesh);
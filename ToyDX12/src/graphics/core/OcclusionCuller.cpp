@@ -0,0 +1,311 @@
+#include "pch.h"
+
+#include "OcclusionCuller.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+
+OcclusionCuller::OcclusionCuller(const OcclusionCullingSettings& settings)
+	: m_Settings(settings)
+{
+	XMStoreFloat4x4(&m_ViewProj, XMMatrixIdentity());
+	Resize(settings.Width, settings.Height);
+}
+
+void OcclusionCuller::Resize(uint32_t ui_Width, uint32_t ui_Height)
+{
+	// Rows are processed 4 pixels at a time
+	m_Width = ((std::max)(ui_Width, 4u) + 3) & ~3u;
+	m_Height = (std::max)(ui_Height, 1u);
+
+	m_Settings.Width = m_Width;
+	m_Settings.Height = m_Height;
+
+	m_Depth.assign(size_t(m_Width) * m_Height, 1.0f);
+}
+
+void OcclusionCuller::BeginFrame(FXMMATRIX viewProj)
+{
+	XMStoreFloat4x4(&m_ViewProj, viewProj);
+	std::fill(m_Depth.begin(), m_Depth.end(), 1.0f);
+	m_NumRasterizedTriangles = 0;
+}
+
+// Clip space position to (screen x, screen y, depth, w), screen y going down
+static XMVECTOR ToScreen(FXMVECTOR clip, float width, float height)
+{
+	const XMVECTOR ndc = XMVectorDivide(clip, XMVectorSplatW(clip));
+	const XMVECTOR scale = XMVectorSet(0.5f * width, -0.5f * height, 1.0f, 0.0f);
+	const XMVECTOR offset = XMVectorSet(0.5f * width, 0.5f * height, 0.0f, 0.0f);
+
+	return XMVectorSelect(XMVectorMultiplyAdd(ndc, scale, offset), clip, XMVectorSelectControl(0, 0, 0, 1));
+}
+
+OcclusionCuller::EdgeKey OcclusionCuller::MakeEdgeKey(const XMFLOAT3& a, const XMFLOAT3& b)
+{
+	EdgeKey first = {}, second = {};
+	memcpy(&first[0], &a, sizeof(XMFLOAT3));
+	memcpy(&first[3], &b, sizeof(XMFLOAT3));
+	memcpy(&second[0], &b, sizeof(XMFLOAT3));
+	memcpy(&second[3], &a, sizeof(XMFLOAT3));
+
+	return (std::min)(first, second);
+}
+
+void OcclusionCuller::RasterizeTriangles(const XMFLOAT3* p_Positions, size_t vertexStride, const uint16_t* a_Indices, size_t numIndices, FXMMATRIX world)
+{
+	const XMMATRIX worldViewProj = XMMatrixMultiply(world, XMLoadFloat4x4(&m_ViewProj));
+	const unsigned char* positions = reinterpret_cast<const unsigned char*>(p_Positions);
+
+	auto GetPosition = [&](size_t index) -> const XMFLOAT3&
+	{
+		return *reinterpret_cast<const XMFLOAT3*>(positions + a_Indices[index] * vertexStride);
+	};
+
+	m_ScreenVertices.clear();
+	m_FrontTriangles.clear();
+	m_Edges.clear();
+
+	for (size_t i = 0; i + 2 < numIndices; i += 3)
+	{
+		XMVECTOR clip[3];
+		bool bCrossesNearPlane = false;
+
+		for (int v = 0; v < 3; ++v)
+		{
+			const XMFLOAT3& position = GetPosition(i + v);
+			clip[v] = XMVector4Transform(XMVectorSet(position.x, position.y, position.z, 1.0f), worldViewProj);
+
+			// D3D clip space : the near plane is z = 0
+			bCrossesNearPlane = bCrossesNearPlane || XMVectorGetZ(clip[v]) < 0.0f;
+		}
+
+		if (bCrossesNearPlane)
+		{
+			continue;
+		}
+
+		XMFLOAT4 screen[3];
+		for (int v = 0; v < 3; ++v)
+		{
+			XMStoreFloat4(&screen[v], ToScreen(clip[v], (float)m_Width, (float)m_Height));
+		}
+
+		// Degenerate triangles cover nothing, the edges they share with their neighbours are not covered either
+		const float area = (screen[1].x - screen[0].x) * (screen[2].y - screen[0].y) - (screen[1].y - screen[0].y) * (screen[2].x - screen[0].x);
+		if (fabsf(area) < 1e-6f)
+		{
+			continue;
+		}
+
+		for (int v = 0; v < 3; ++v)
+		{
+			m_ScreenVertices.push_back(screen[v]);
+			m_Edges.push_back(MakeEdgeKey(GetPosition(i + (v + 1) % 3), GetPosition(i + (v + 2) % 3)));
+		}
+
+		m_FrontTriangles.push_back(i);
+	}
+
+	// Skipped triangles don't share their edges : the pixels along them stay inner conservative
+	std::sort(m_Edges.begin(), m_Edges.end());
+
+	for (size_t t = 0; t < m_FrontTriangles.size(); ++t)
+	{
+		const size_t i = m_FrontTriangles[t];
+
+		uint32_t sharedEdgeMask = 0;
+		for (int e = 0; e < 3; ++e)
+		{
+			const auto range = std::equal_range(m_Edges.begin(), m_Edges.end(), MakeEdgeKey(GetPosition(i + (e + 1) % 3), GetPosition(i + (e + 2) % 3)));
+			sharedEdgeMask |= (range.second - range.first) > 1 ? (1u << e) : 0u;
+		}
+
+		const XMFLOAT4* screen = &m_ScreenVertices[3 * t];
+		RasterizeTriangle(XMLoadFloat4(&screen[0]), XMLoadFloat4(&screen[1]), XMLoadFloat4(&screen[2]), sharedEdgeMask);
+	}
+}
+
+void OcclusionCuller::RasterizeTriangle(FXMVECTOR v0, FXMVECTOR v1, FXMVECTOR v2, uint32_t sharedEdgeMask)
+{
+	XMFLOAT4 p[3];
+	XMStoreFloat4(&p[0], v0);
+	XMStoreFloat4(&p[1], v1);
+	XMStoreFloat4(&p[2], v2);
+
+	// Occluders are rasterized whatever their winding : both faces of closed meshes give the same nearest depth
+	float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[1].y - p[0].y) * (p[2].x - p[0].x);
+	if (fabsf(area) < 1e-6f)
+	{
+		return;
+	}
+
+	if (area < 0.0f)
+	{
+		// The edges opposite to vertices 1 and 2 swap as well
+		std::swap(p[1], p[2]);
+		sharedEdgeMask = (sharedEdgeMask & 1u) | ((sharedEdgeMask & 2u) << 1) | ((sharedEdgeMask & 4u) >> 1);
+		area = -area;
+	}
+
+	// Pixels entirely inside the triangle, see below
+	const int minX = (std::max)(int(floorf((std::min)({ p[0].x, p[1].x, p[2].x }))), 0);
+	const int maxX = (std::min)(int(ceilf((std::max)({ p[0].x, p[1].x, p[2].x }))), int(m_Width) - 1);
+	const int minY = (std::max)(int(floorf((std::min)({ p[0].y, p[1].y, p[2].y }))), 0);
+	const int maxY = (std::min)(int(ceilf((std::max)({ p[0].y, p[1].y, p[2].y }))), int(m_Height) - 1);
+
+	if (minX > maxX || minY > maxY)
+	{
+		return;
+	}
+
+	m_NumRasterizedTriangles++;
+
+	// Edge functions e(x, y) = a * x + b * y + c, positive inside. Edge i is opposite to vertex i
+	float a[3], b[3], c[3];
+	for (int e = 0; e < 3; ++e)
+	{
+		const XMFLOAT4& from = p[(e + 1) % 3];
+		const XMFLOAT4& to = p[(e + 2) % 3];
+
+		a[e] = from.y - to.y;
+		b[e] = to.x - from.x;
+		c[e] = from.x * to.y - from.y * to.x;
+	}
+
+	// Depth is linear in screen space : z = zA * x + zB * y + zC
+	const float invArea = 1.0f / area;
+	const float zA = (a[0] * p[0].z + a[1] * p[1].z + a[2] * p[2].z) * invArea;
+	const float zB = (b[0] * p[0].z + b[1] * p[1].z + b[2] * p[2].z) * invArea;
+	float zC = (c[0] * p[0].z + c[1] * p[1].z + c[2] * p[2].z) * invArea;
+
+	// Inner conservative : the edge functions are evaluated at pixel centers, a pixel is entirely inside an edge
+	// when the function is positive at its corner closest to the edge, 0.5 * (|a| + |b|) less than at the center
+	// Shared edges keep the test at the center : the rest of the pixel is covered by the triangle on the other side
+	for (int e = 0; e < 3; ++e)
+	{
+		if ((sharedEdgeMask & (1u << e)) == 0)
+		{
+			c[e] -= 0.5f * (fabsf(a[e]) + fabsf(b[e]));
+		}
+	}
+
+	// Likewise the depth written is the farthest of the triangle over the pixel, not the one at its center
+	zC += 0.5f * (fabsf(zA) + fabsf(zB));
+
+	const XMVECTOR laneOffsets = XMVectorSet(0.5f, 1.5f, 2.5f, 3.5f);
+	const int firstX = minX & ~3;
+
+	for (int y = minY; y <= maxY; ++y)
+	{
+		const float centerY = y + 0.5f;
+
+		const XMVECTOR px = XMVectorAdd(XMVectorReplicate((float)firstX), laneOffsets);
+		XMVECTOR e0 = XMVectorMultiplyAdd(px, XMVectorReplicate(a[0]), XMVectorReplicate(b[0] * centerY + c[0]));
+		XMVECTOR e1 = XMVectorMultiplyAdd(px, XMVectorReplicate(a[1]), XMVectorReplicate(b[1] * centerY + c[1]));
+		XMVECTOR e2 = XMVectorMultiplyAdd(px, XMVectorReplicate(a[2]), XMVectorReplicate(b[2] * centerY + c[2]));
+		XMVECTOR z = XMVectorMultiplyAdd(px, XMVectorReplicate(zA), XMVectorReplicate(zB * centerY + zC));
+
+		// Stepping 4 pixels to the right
+		const XMVECTOR e0Step = XMVectorReplicate(4.0f * a[0]);
+		const XMVECTOR e1Step = XMVectorReplicate(4.0f * a[1]);
+		const XMVECTOR e2Step = XMVectorReplicate(4.0f * a[2]);
+		const XMVECTOR zStep = XMVectorReplicate(4.0f * zA);
+
+		float* row = &m_Depth[size_t(y) * m_Width];
+
+		for (int x = firstX; x <= maxX; x += 4)
+		{
+			const XMVECTOR inside = XMVectorAndInt(XMVectorAndInt(XMVectorGreaterOrEqual(e0, XMVectorZero()), XMVectorGreaterOrEqual(e1, XMVectorZero())), XMVectorGreaterOrEqual(e2, XMVectorZero()));
+
+			XMFLOAT4* depth = reinterpret_cast<XMFLOAT4*>(&row[x]);
+			const XMVECTOR current = XMLoadFloat4(depth);
+			XMStoreFloat4(depth, XMVectorSelect(current, XMVectorMin(current, z), inside));
+
+			e0 = XMVectorAdd(e0, e0Step);
+			e1 = XMVectorAdd(e1, e1Step);
+			e2 = XMVectorAdd(e2, e2Step);
+			z = XMVectorAdd(z, zStep);
+		}
+	}
+}
+
+bool OcclusionCuller::IsVisible(const AABB& worldBounds) const
+{
+	if (!worldBounds.IsValid())
+	{
+		return true;
+	}
+
+	const XMMATRIX viewProj = XMLoadFloat4x4(&m_ViewProj);
+
+	// Screen rectangle and nearest depth of the 8 corners
+	float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+	float nearestDepth = FLT_MAX;
+
+	for (int corner = 0; corner < 8; ++corner)
+	{
+		const XMVECTOR position = XMVectorSet(
+			(corner & 1) ? worldBounds.Max.x : worldBounds.Min.x,
+			(corner & 2) ? worldBounds.Max.y : worldBounds.Min.y,
+			(corner & 4) ? worldBounds.Max.z : worldBounds.Min.z,
+			1.0f);
+
+		const XMVECTOR clip = XMVector4Transform(position, viewProj);
+		if (XMVectorGetZ(clip) < 0.0f)
+		{
+			return true;
+		}
+
+		XMFLOAT4 screen;
+		XMStoreFloat4(&screen, ToScreen(clip, (float)m_Width, (float)m_Height));
+
+		minX = (std::min)(minX, screen.x);
+		maxX = (std::max)(maxX, screen.x);
+		minY = (std::min)(minY, screen.y);
+		maxY = (std::max)(maxY, screen.y);
+		nearestDepth = (std::min)(nearestDepth, screen.z);
+	}
+
+	// Every pixel touched by the rectangle, not only the ones whose center it contains
+	const int firstX = (std::max)(int(floorf(minX)), 0);
+	const int lastX = (std::min)(int(ceilf(maxX)) - 1, int(m_Width) - 1);
+	const int firstY = (std::max)(int(floorf(minY)), 0);
+	const int lastY = (std::min)(int(ceilf(maxY)) - 1, int(m_Height) - 1);
+
+	if (firstX > lastX || firstY > lastY)
+	{
+		// Outside of the screen
+		return false;
+	}
+
+	const XMVECTOR boxDepth = XMVectorReplicate(nearestDepth - m_Settings.DepthBias);
+	const XMVECTOR laneX = XMVectorSet(0.0f, 1.0f, 2.0f, 3.0f);
+	const XMVECTOR lastLaneX = XMVectorReplicate((float)lastX);
+	const XMVECTOR firstLaneX = XMVectorReplicate((float)firstX);
+
+	for (int y = firstY; y <= lastY; ++y)
+	{
+		const float* row = &m_Depth[size_t(y) * m_Width];
+
+		for (int x = firstX & ~3; x <= lastX; x += 4)
+		{
+			// The box is visible where an occluder is farther than its nearest point, or where there is none
+			const XMVECTOR depth = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&row[x]));
+			const XMVECTOR lanes = XMVectorAdd(XMVectorReplicate((float)x), laneX);
+			const XMVECTOR inRect = XMVectorAndInt(XMVectorGreaterOrEqual(lanes, firstLaneX), XMVectorLessOrEqual(lanes, lastLaneX));
+			const XMVECTOR visible = XMVectorAndInt(XMVectorGreaterOrEqual(depth, boxDepth), inRect);
+
+			if (XMVector4NotEqualInt(visible, XMVectorFalseInt()))
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "Bounds.h"
+
+struct OcclusionCullingSettings
+{
+	// Resolution of the depth buffer occluders are rasterized into. Width is rounded up to a multiple of 4
+	uint32_t Width = 256;
+	uint32_t Height = 128;
+
+	// Occluders are picked until this number of triangles is reached
+	uint32_t MaxOccluderTriangles = 4096;
+
+	// A box is only occluded when it is farther than the occluders by more than this post projection depth,
+	// e.g. an occluder tested against the depth it wrote itself is never hidden by rounding errors
+	float DepthBias = 1e-4f;
+};
+
+// Software occlusion culling, entirely on the CPU
+// - A few large occluders are rasterized into a low resolution depth buffer, 4 pixels at a time with SIMD
+// - Bounding boxes are then tested against it : a box is occluded when every pixel its projection covers holds a depth closer than the box
+// Like masked occlusion culling, the depth buffer only holds occluder depths, there is no color and no attribute interpolation
+// Culling is conservative, a visible box is never reported occluded :
+// - Rasterization is inner conservative at the silhouette of the occluders : only pixels entirely inside a triangle are written,
+//   with the farthest depth of the triangle over the pixel. Edges shared by two triangles of the same call are sampled at pixel centers
+//   instead, so that the pixels along them are written by one of the triangles and meshes have no cracks
+// - Triangles crossing the near plane are not clipped but skipped, and boxes crossing it are always visible
+class OcclusionCuller
+{
+public:
+	OcclusionCuller(const OcclusionCullingSettings& settings = {});
+
+	void Resize(uint32_t ui_Width, uint32_t ui_Height);
+
+	// Clears the depth buffer, viewProj is used by every following call until the next frame
+	void BeginFrame(DirectX::FXMMATRIX viewProj);
+
+	// Rasterizes an indexed triangle list. p_Positions is the position of the first vertex, vertexStride the size of a vertex in bytes
+	void RasterizeTriangles(const DirectX::XMFLOAT3* p_Positions, size_t vertexStride, const uint16_t* a_Indices, size_t numIndices, DirectX::FXMMATRIX world);
+
+	// False when the box is entirely hidden by the occluders
+	bool IsVisible(const AABB& worldBounds) const;
+
+	uint32_t GetWidth() const { return m_Width; }
+	uint32_t GetHeight() const { return m_Height; }
+	const std::vector<float>& GetDepthBuffer() const { return m_Depth; }
+
+	uint32_t GetNumRasterizedTriangles() const { return m_NumRasterizedTriangles; }
+	const OcclusionCullingSettings& GetSettings() const { return m_Settings; }
+
+protected:
+	// Bit e of sharedEdgeMask is set when the edge opposite to vertex e is shared with another triangle
+	void RasterizeTriangle(DirectX::FXMVECTOR v0, DirectX::FXMVECTOR v1, DirectX::FXMVECTOR v2, uint32_t sharedEdgeMask);
+
+	// The two end points of an edge, the smallest first : edges are shared when their end points have the same positions,
+	// even if they are different vertices (e.g. split along texture seams)
+	using EdgeKey = std::array<uint32_t, 6>;
+	static EdgeKey MakeEdgeKey(const DirectX::XMFLOAT3& a, const DirectX::XMFLOAT3& b);
+
+	OcclusionCullingSettings m_Settings;
+
+	uint32_t m_Width = 0;
+	uint32_t m_Height = 0;
+
+	// Row major, post projection depth (0 near, 1 far)
+	std::vector<float> m_Depth;
+
+	DirectX::XMFLOAT4X4 m_ViewProj;
+	uint32_t m_NumRasterizedTriangles = 0;
+
+	// Scratch of RasterizeTriangles : screen positions of the triangles in front of the near plane, and their sorted edges
+	std::vector<DirectX::XMFLOAT4> m_ScreenVertices;
+	std::vector<size_t> m_FrontTriangles;
+	std::vector<EdgeKey> m_Edges;
+};
@@ -0,0 +1,46 @@
+#include "pch.h"
+
+#include "PipelineStateKey.h"
+
+#include <cstring>
+#include <cwchar>
+
+void PipelineStateKey::AppendBytes(const void* p_Data, size_t sz_SizeInBytes)
+{
+	if (sz_SizeInBytes == 0)
+	{
+		return;
+	}
+
+	const uint8_t* bytes = static_cast<const uint8_t*>(p_Data);
+	m_Bytes.insert(m_Bytes.end(), bytes, bytes + sz_SizeInBytes);
+
+	// FNV-1a is computed byte after byte : hashing in pieces gives the hash of the whole
+	m_Hash = HashUtil::Fnv1a(p_Data, sz_SizeInBytes, m_Hash);
+}
+
+void PipelineStateKey::AppendBlob(const void* p_Data, size_t sz_SizeInBytes)
+{
+	Append(static_cast<uint64_t>(sz_SizeInBytes));
+	AppendBytes(p_Data, sz_SizeInBytes);
+}
+
+void PipelineStateKey::AppendString(const char* sz_String)
+{
+	// A null string differs from an empty one
+	if (sz_String == nullptr)
+	{
+		Append(UINT64_MAX);
+		return;
+	}
+
+	AppendBlob(sz_String, strlen(sz_String));
+}
+
+std::wstring PipelineStateKey::GetName() const
+{
+	wchar_t name[17];
+	swprintf(name, 17, L"%016llx", static_cast<unsigned long long>(m_Hash));
+
+	return name;
+}
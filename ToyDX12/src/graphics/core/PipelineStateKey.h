@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "HashUtil.h"
+
+// Flattened description of a pipeline state : its fields and the data they point to (shader bytecode, input layout...) appended one after the other.
+// Two keys are equal when their bytes are, the hash is updated as bytes are appended.
+// Structures with padding must be appended field by field : padding bytes are not initialized
+class PipelineStateKey
+{
+public:
+	void AppendBytes(const void* p_Data, size_t sz_SizeInBytes);
+
+	template<typename T>
+	void Append(const T& value)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "Only plain values can be appended");
+		AppendBytes(&value, sizeof(T));
+	}
+
+	// Size prefixed : consecutive blobs or strings can't be confused with one another
+	void AppendBlob(const void* p_Data, size_t sz_SizeInBytes);
+	void AppendString(const char* sz_String);
+
+	uint64_t GetHash() const { return m_Hash; }
+	size_t GetSize() const { return m_Bytes.size(); }
+
+	// Hexadecimal hash, e.g. the name of the pipeline in a pipeline library
+	std::wstring GetName() const;
+
+	bool operator==(const PipelineStateKey& other) const { return m_Hash == other.m_Hash && m_Bytes == other.m_Bytes; }
+	bool operator!=(const PipelineStateKey& other) const { return !(*this == other); }
+
+	struct Hasher
+	{
+		size_t operator()(const PipelineStateKey& key) const { return static_cast<size_t>(key.GetHash()); }
+	};
+
+protected:
+	std::vector<uint8_t> m_Bytes;
+	uint64_t m_Hash = HashUtil::FnvOffsetBasis;
+};
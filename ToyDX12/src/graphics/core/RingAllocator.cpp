@@ -0,0 +1,60 @@
+#include "pch.h"
+
+#include "RingAllocator.h"
+
+uint64_t RingAllocator::Allocate(uint64_t ui64_SizeInBytes, uint64_t ui64_Alignment)
+{
+	if (ui64_SizeInBytes > m_Capacity)
+	{
+		return InvalidOffset;
+	}
+
+	// The free memory is the range that starts at the head, of length capacity - used
+	uint64_t offset = (m_Head + ui64_Alignment - 1) & ~(ui64_Alignment - 1);
+
+	if (offset + ui64_SizeInBytes > m_Capacity)
+	{
+		offset = 0;
+	}
+
+	const uint64_t end = offset + ui64_SizeInBytes;
+	const uint64_t consumed = offset >= m_Head ? end - m_Head : (m_Capacity - m_Head) + end;
+
+	if (m_UsedSize + consumed > m_Capacity)
+	{
+		return InvalidOffset;
+	}
+
+	m_Head = end == m_Capacity ? 0 : end;
+	m_UsedSize += consumed;
+	m_OpenGroupSize += consumed;
+
+	return offset;
+}
+
+void RingAllocator::CloseGroup(uint64_t ui64_FenceValue)
+{
+	if (m_OpenGroupSize == 0)
+	{
+		return;
+	}
+
+	m_Groups.push_back({ ui64_FenceValue, m_OpenGroupSize });
+	m_OpenGroupSize = 0;
+}
+
+void RingAllocator::Reclaim(uint64_t ui64_CompletedFenceValue)
+{
+	while (!m_Groups.empty() && m_Groups.front().FenceValue <= ui64_CompletedFenceValue)
+	{
+		m_UsedSize -= m_Groups.front().Size;
+
+		m_Groups.pop_front();
+	}
+
+	// Nothing in use : start again from the beginning, so that large allocations don't have to wrap
+	if (m_UsedSize == 0)
+	{
+		m_Head = 0;
+	}
+}
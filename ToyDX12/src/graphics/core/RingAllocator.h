@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+// Offsets in a fixed size circular buffer : memory is allocated at the head and freed from the tail, in allocation order
+// Allocations are grouped (e.g. per batch of GPU work) and each group is fenced by a value : a group is freed once its value is reached
+// An allocation never wraps around the end of the buffer, the bytes left at the end are skipped
+class RingAllocator
+{
+public:
+	static const uint64_t InvalidOffset = UINT64_MAX;
+
+	explicit RingAllocator(uint64_t ui64_Capacity) : m_Capacity(ui64_Capacity) {}
+
+	// Aligned offset of the allocation, InvalidOffset if there is not enough free contiguous memory
+	// ui64_Alignment must be a power of two, offset 0 has every alignment
+	uint64_t Allocate(uint64_t ui64_SizeInBytes, uint64_t ui64_Alignment = 1);
+
+	// The allocations made since the last group are freed by Reclaim once ui64_FenceValue is reached
+	// Fence values must increase from one group to the next
+	void CloseGroup(uint64_t ui64_FenceValue);
+	void Reclaim(uint64_t ui64_CompletedFenceValue);
+
+	uint64_t GetCapacity() const { return m_Capacity; }
+	uint64_t GetUsedSize() const { return m_UsedSize; }	// Including the skipped and padding bytes
+	bool HasOpenGroup() const { return m_OpenGroupSize > 0; }
+
+protected:
+	struct Group
+	{
+		uint64_t FenceValue;
+		uint64_t Size;
+	};
+
+	uint64_t m_Capacity = 0;
+	uint64_t m_Head = 0;
+	uint64_t m_UsedSize = 0;
+	uint64_t m_OpenGroupSize = 0;
+
+	std::deque<Group> m_Groups;	// Closed, oldest first
+};
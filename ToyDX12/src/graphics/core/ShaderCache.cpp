@@ -0,0 +1,178 @@
+#include "pch.h"
+
+#include "ShaderCache.h"
+#include "MappedFile.h"
+#include "HashUtil.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+std::string ShaderCache::s_CacheDirectory = "./data/cache/shaders/";
+
+std::atomic<uint32_t> ShaderCache::s_NumHits = 0;
+std::atomic<uint32_t> ShaderCache::s_NumMisses = 0;
+
+bool ShaderCache::HashSources(const std::filesystem::path& sourcePath, uint64_t& r_Hash)
+{
+	std::vector<std::filesystem::path> visited;
+	r_Hash = HashUtil::FnvOffsetBasis;
+
+	return HashFile(sourcePath, sourcePath.parent_path(), visited, r_Hash);
+}
+
+bool ShaderCache::HashFile(const std::filesystem::path& path, const std::filesystem::path& rootDirectory, std::vector<std::filesystem::path>& r_Visited, uint64_t& r_Hash)
+{
+	std::error_code error;
+	const std::filesystem::path canonicalPath = std::filesystem::weakly_canonical(path, error);
+
+	// Include guards : a file included twice is hashed once
+	if (std::find(r_Visited.begin(), r_Visited.end(), canonicalPath) != r_Visited.end())
+	{
+		return true;
+	}
+	r_Visited.push_back(canonicalPath);
+
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+
+	std::stringstream stream;
+	stream << file.rdbuf();
+	const std::string source = stream.str();
+
+	// Size prefixed : the boundary between two files is part of the hash
+	const uint64_t size = source.size();
+	r_Hash = HashUtil::Fnv1a(&size, sizeof(size), r_Hash);
+	r_Hash = HashUtil::Fnv1a(source.data(), source.size(), r_Hash);
+
+	std::vector<std::string> includes;
+	ParseIncludes(source, includes);
+
+	const std::filesystem::path candidateDirectories[] = { path.parent_path(), rootDirectory, std::filesystem::current_path(error) };
+
+	for (const std::string& include : includes)
+	{
+		bool bFound = false;
+		for (const std::filesystem::path& directory : candidateDirectories)
+		{
+			const std::filesystem::path includePath = directory / include;
+			if (std::filesystem::is_regular_file(includePath, error))
+			{
+				if (!HashFile(includePath, rootDirectory, r_Visited, r_Hash))
+				{
+					return false;
+				}
+
+				bFound = true;
+				break;
+			}
+		}
+
+		// Let the compiler report the missing include
+		if (!bFound)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void ShaderCache::ParseIncludes(const std::string& source, std::vector<std::string>& r_Includes)
+{
+	// Preprocessor conditions are not evaluated : includes of every branch are part of the key, which only costs a recompile
+	std::istringstream lines(source);
+	std::string line;
+
+	while (std::getline(lines, line))
+	{
+		size_t cursor = line.find_first_not_of(" \t");
+		if (cursor == std::string::npos || line[cursor] != '#')
+		{
+			continue;
+		}
+
+		cursor = line.find_first_not_of(" \t", cursor + 1);
+		if (cursor == std::string::npos || line.compare(cursor, 7, "include") != 0)
+		{
+			continue;
+		}
+
+		const size_t open = line.find_first_of("\"<", cursor + 7);
+		if (open == std::string::npos)
+		{
+			continue;
+		}
+
+		const size_t close = line.find(line[open] == '"' ? '"' : '>', open + 1);
+		if (close == std::string::npos)
+		{
+			continue;
+		}
+
+		r_Includes.push_back(line.substr(open + 1, close - open - 1));
+	}
+}
+
+std::string ShaderCache::GetEntryPath(uint64_t key)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.cso", static_cast<unsigned long long>(key));
+
+	return s_CacheDirectory + name;
+}
+
+bool ShaderCache::Load(uint64_t key, std::vector<uint8_t>& r_Bytecode)
+{
+	MappedFile file;
+	if (!file.Open(GetEntryPath(key)) || file.Size() == 0)
+	{
+		s_NumMisses++;
+		return false;
+	}
+
+	const uint8_t* bytes = static_cast<const uint8_t*>(file.Data());
+	r_Bytecode.assign(bytes, bytes + file.Size());
+
+	s_NumHits++;
+
+	return true;
+}
+
+void ShaderCache::Store(uint64_t key, const void* p_Bytecode, size_t sz_SizeInBytes)
+{
+	std::error_code error;
+	std::filesystem::create_directories(s_CacheDirectory, error);
+
+	const std::string path = GetEntryPath(key);
+	// One temporary file per thread : the same shader may be compiled by two threads at once
+	const std::string temporaryPath = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+
+	// Written aside then renamed : an interrupted write never leaves a truncated entry
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		file.write(static_cast<const char*>(p_Bytecode), sz_SizeInBytes);
+
+		if (!file)
+		{
+			LOG_WARN("ShaderCache: Could not write {0}.", path);
+			return;
+		}
+	}
+
+	std::filesystem::rename(temporaryPath, path, error);
+	if (error)
+	{
+		LOG_WARN("ShaderCache: Could not write {0}.", path);
+		std::filesystem::remove(temporaryPath, error);
+	}
+}
+
+void ShaderCache::LogStats()
+{
+	LOG_INFO("ShaderCache: {0} shaders read from the cache, {1} compiled.", s_NumHits.load(), s_NumMisses.load());
+}
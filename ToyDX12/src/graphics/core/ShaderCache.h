@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// On-disk cache of compiled shader bytecode
+// Entries are keyed by the text of the source file and of every file it includes, and by everything passed to the compiler
+// (defines, entry point, target, flags), so a warm start reads the bytecode without invoking the compiler.
+// Editing a shader or one of its includes changes the key : the shader is compiled again
+// Thread safe : shaders are compiled in parallel
+class ShaderCache
+{
+public:
+	ShaderCache() = delete;
+	~ShaderCache() = delete;
+
+	// Hash of the source file and of its include closure, returns false if one of the files can't be read
+	// Includes are resolved as D3D_COMPILE_STANDARD_FILE_INCLUDE does : next to the including file, then next to the source file, then from the working directory
+	static bool HashSources(const std::filesystem::path& sourcePath, uint64_t& r_Hash);
+
+	// Fills the bytecode with the cached entry, returns false on a cache miss
+	static bool Load(uint64_t key, std::vector<uint8_t>& r_Bytecode);
+
+	static void Store(uint64_t key, const void* p_Bytecode, size_t sz_SizeInBytes);
+
+	static void LogStats();
+
+	static std::string s_CacheDirectory;
+
+protected:
+	static std::string GetEntryPath(uint64_t key);
+
+	// Names of the #include directives of a source text, in order
+	static void ParseIncludes(const std::string& source, std::vector<std::string>& r_Includes);
+
+	static bool HashFile(const std::filesystem::path& path, const std::filesystem::path& rootDirectory, std::vector<std::filesystem::path>& r_Visited, uint64_t& r_Hash);
+
+	static std::atomic<uint32_t> s_NumHits;
+	static std::atomic<uint32_t> s_NumMisses;
+};
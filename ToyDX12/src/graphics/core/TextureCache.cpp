@@ -0,0 +1,113 @@
+#include "pch.h"
+
+#include "TextureCache.h"
+#include "TextureCooker.h"
+#include "Material.h"
+#include "MappedFile.h"
+#include "HashUtil.h"
+
+#include "DirectXTex.h"
+
+#include <filesystem>
+#include <thread>
+
+// Bump when the way textures are processed changes, to invalidate every existing entry
+static const uint64_t TextureCacheVersion = 3;
+
+std::string TextureCache::s_CacheDirectory = "./data/cache/textures/";
+
+uint64_t TextureCache::ComputeKey(uint64_t sourceHash, TextureRole e_Role, const TextureCookSettings& settings)
+{
+	uint64_t key = HashUtil::Combine(TextureCacheVersion, sourceHash);
+	key = HashUtil::Combine(key, static_cast<uint64_t>(e_Role));
+	key = HashUtil::Combine(key, settings.bCompress);
+	key = HashUtil::Combine(key, settings.bQuickBC7);
+	key = HashUtil::Combine(key, settings.bGenerateMips);
+
+	return key;
+}
+
+std::string TextureCache::GetEntryPath(uint64_t key)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.dds", static_cast<unsigned long long>(key));
+
+	return s_CacheDirectory + name;
+}
+
+bool TextureCache::Load(uint64_t key, Texture& texture)
+{
+	MappedFile file;
+	if (!file.Open(GetEntryPath(key)))
+	{
+		return false;
+	}
+
+	// DDS texels are already laid out per mip level, they are copied as is
+	DirectX::TexMetadata metadata = {};
+	auto cooked = std::make_shared<DirectX::ScratchImage>();
+	if (FAILED(DirectX::LoadFromDDSMemory(file.Data(), file.Size(), DirectX::DDS_FLAGS_NONE, &metadata, *cooked)))
+	{
+		LOG_WARN("TextureCache: Corrupted entry {0}, ignored.", GetEntryPath(key));
+		return false;
+	}
+
+	texture.Width    = static_cast<int>(metadata.width);
+	texture.Height   = static_cast<int>(metadata.height);
+	texture.Channels = TextureCooker::GetChannelCount(metadata.format);
+	texture.Format   = metadata.format;
+	texture.Cooked   = std::move(cooked);
+	texture.CacheKey = key;
+
+	return true;
+}
+
+void TextureCache::Store(const Texture& texture)
+{
+	if (texture.CacheKey == 0)
+	{
+		return;
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories(s_CacheDirectory, error);
+
+	const std::filesystem::path path = GetEntryPath(texture.CacheKey);
+
+	// Textures are cooked in parallel and two of them may share a key : each thread writes its own temporary file,
+	// renamed once complete so that an interrupted write never leaves a truncated entry
+	const std::filesystem::path temporaryPath = path.string() + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+	HRESULT result = E_FAIL;
+
+	if (texture.Cooked)
+	{
+		result = DirectX::SaveToDDSFile(texture.Cooked->GetImages(), texture.Cooked->GetImageCount(), texture.Cooked->GetMetadata(), DirectX::DDS_FLAGS_NONE, temporaryPath.c_str());
+	}
+	else if (texture.data)
+	{
+		// Texture kept uncompressed : cache the decoded texels so they are not decoded again
+		DirectX::Image image = {};
+		image.width      = texture.Width;
+		image.height     = texture.Height;
+		image.format     = texture.Format;
+		image.rowPitch   = size_t(texture.Width) * texture.Channels;
+		image.slicePitch = image.rowPitch * texture.Height;
+		image.pixels     = texture.data;
+
+		result = DirectX::SaveToDDSFile(image, DirectX::DDS_FLAGS_NONE, temporaryPath.c_str());
+	}
+
+	if (FAILED(result))
+	{
+		LOG_WARN("TextureCache: Could not write {0}.", path.string());
+		std::filesystem::remove(temporaryPath, error);
+		return;
+	}
+
+	std::filesystem::rename(temporaryPath, path, error);
+	if (error)
+	{
+		LOG_WARN("TextureCache: Could not write {0}.", path.string());
+		std::filesystem::remove(temporaryPath, error);
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+struct Texture;
+struct TextureCookSettings;
+enum class TextureRole;
+
+// On-disk cache of processed textures, stored as DDS files
+// Entries are keyed by the content of the source image and by everything that changes how it is processed,
+// so a warm start reads GPU ready texels without decoding, compressing or generating anything
+class TextureCache
+{
+public:
+	TextureCache() = delete;
+	~TextureCache() = delete;
+
+	static uint64_t ComputeKey(uint64_t sourceHash, TextureRole e_Role, const TextureCookSettings& settings);
+
+	// Fills the texture with the cached texels, returns false on a cache miss
+	static bool Load(uint64_t key, Texture& texture);
+
+	// Writes the processed texels of the texture to its cache entry
+	static void Store(const Texture& texture);
+
+	static std::string s_CacheDirectory;
+
+protected:
+	static std::string GetEntryPath(uint64_t key);
+};
@@ -0,0 +1,325 @@
+#include "pch.h"
+
+#include "TextureCooker.h"
+#include "Material.h"
+#include "TextureCache.h"
+
+#include "DirectXTex.h"
+
+#include <algorithm>
+#include <atomic>
+#include <execution>
+
+void TextureCooker::CookTextures(std::vector<Texture>& textures, const TextureCookSettings& settings)
+{
+	if (textures.empty())
+	{
+		return;
+	}
+
+	std::atomic<size_t> sizeBefore = 0;
+	std::atomic<size_t> sizeAfter = 0;
+	std::atomic<int> numCompressed = 0;
+	std::atomic<int> numCached = 0;
+
+	// Each texture is cooked independently
+	std::for_each(std::execution::par, textures.begin(), textures.end(), [&](Texture& texture)
+	{
+		// Already processed texels read from the texture cache
+		if (texture.Cooked)
+		{
+			numCached++;
+			return;
+		}
+
+		// Compared to what used to be uploaded : RGBA8 without mips
+		sizeBefore += size_t(texture.Width) * texture.Height * 4;
+
+		if (CookTexture(texture, settings))
+		{
+			sizeAfter += texture.Cooked->GetPixelsSize();
+
+			if (DirectX::IsCompressed(texture.Format))
+			{
+				numCompressed++;
+			}
+		}
+		else
+		{
+			sizeAfter += size_t(texture.Width) * texture.Height * texture.Channels;
+		}
+
+		TextureCache::Store(texture);
+	});
+
+	LOG_INFO("TextureCooker: {0} textures from cache, compressed {1}/{2} others : {3:.2f} MB -> {4:.2f} MB (with mips)", numCached.load(), numCompressed.load(), textures.size() - numCached, sizeBefore / (1024.0 * 1024.0), sizeAfter / (1024.0 * 1024.0));
+}
+
+// Reads a texel of an 8 bits image with 1 to 4 channels as RGBA
+static void ExpandTexel(const unsigned char* texel, int channels, unsigned char rgba[4])
+{
+	switch (channels)
+	{
+	case 1:
+		rgba[0] = rgba[1] = rgba[2] = texel[0];
+		rgba[3] = 0xff;
+		break;
+	case 2:
+		rgba[0] = rgba[1] = rgba[2] = texel[0];
+		rgba[3] = texel[1];
+		break;
+	case 3:
+		rgba[0] = texel[0];
+		rgba[1] = texel[1];
+		rgba[2] = texel[2];
+		rgba[3] = 0xff;
+		break;
+	default:
+		rgba[0] = texel[0];
+		rgba[1] = texel[1];
+		rgba[2] = texel[2];
+		rgba[3] = texel[3];
+		break;
+	}
+}
+
+bool TextureCooker::CookTexture(Texture& texture, const TextureCookSettings& settings)
+{
+	// Only 8 bits images coming from the loader are handled
+	if (texture.data == nullptr || texture.Channels < 1 || texture.Channels > 4)
+	{
+		return false;
+	}
+
+	// Block compressed textures must have dimensions that are multiples of the 4x4 block size
+	bool bCompress = settings.bCompress;
+	if (bCompress && (texture.Width % 4 != 0 || texture.Height % 4 != 0))
+	{
+		LOG_WARN("TextureCooker: {0} ({1}x{2}) is not 4x4 block aligned, kept uncompressed.", texture.Name, texture.Width, texture.Height);
+		bCompress = false;
+	}
+
+	const TextureChannelInfo info = AnalyzeChannels(texture.data, texture.Channels, texture.Width, texture.Height);
+	const DXGI_FORMAT format = SelectFormat(texture.Role, info, bCompress);
+
+	// Texels are packed to the uncompressed layout of the final format
+	const int numChannels = GetChannelCount(format);
+	PackChannels(texture, numChannels == 1 ? DXGI_FORMAT_R8_UNORM : numChannels == 2 ? DXGI_FORMAT_R8G8_UNORM : DXGI_FORMAT_R8G8B8A8_UNORM);
+
+	DirectX::Image source = {};
+	source.width = texture.Width;
+	source.height = texture.Height;
+	source.format = texture.Format;
+	source.rowPitch = size_t(texture.Width) * texture.Channels;
+	source.slicePitch = source.rowPitch * texture.Height;
+	source.pixels = texture.data;
+
+	// Mips are filtered on the CPU, WIC is not needed for 8 bits UNORM sources
+	auto cooked = std::make_shared<DirectX::ScratchImage>();
+	const bool bHasMips = settings.bGenerateMips && (texture.Width > 1 || texture.Height > 1);
+
+	HRESULT result = bHasMips ? DirectX::GenerateMipMaps(source, DirectX::TEX_FILTER_BOX | DirectX::TEX_FILTER_FORCE_NON_WIC, 0, *cooked) : cooked->InitializeFromImage(source);
+	if (FAILED(result))
+	{
+		LOG_ERROR("TextureCooker: Could not build the mip chain of {0}.", texture.Name);
+		return false;
+	}
+
+	if (bCompress)
+	{
+		DirectX::TEX_COMPRESS_FLAGS flags = DirectX::TEX_COMPRESS_DEFAULT;
+		if (settings.bQuickBC7 && format == DXGI_FORMAT_BC7_UNORM)
+		{
+			flags |= DirectX::TEX_COMPRESS_BC7_QUICK;
+		}
+
+		auto compressed = std::make_shared<DirectX::ScratchImage>();
+		if (SUCCEEDED(DirectX::Compress(cooked->GetImages(), cooked->GetImageCount(), cooked->GetMetadata(), format, flags, DirectX::TEX_THRESHOLD_DEFAULT, *compressed)))
+		{
+			cooked = std::move(compressed);
+		}
+		else
+		{
+			LOG_ERROR("TextureCooker: Could not compress {0}, kept uncompressed.", texture.Name);
+		}
+	}
+
+	texture.Format = cooked->GetMetadata().format;
+	texture.Cooked = std::move(cooked);
+
+	// Decoded texels are not needed anymore
+	free(texture.data);
+	texture.data = nullptr;
+
+	return true;
+}
+
+void TextureCooker::PackChannels(Texture& texture, DXGI_FORMAT e_PackedFormat)
+{
+	const int srcChannels = texture.Channels;
+	const int dstChannels = GetChannelCount(e_PackedFormat);
+
+	if (srcChannels == 4 && dstChannels == 4)
+	{
+		texture.Format = e_PackedFormat;
+		return;
+	}
+
+	// RGBA channel written to each packed channel
+	int select[4] = { 0, 1, 2, 3 };
+	if (dstChannels == 2)
+	{
+		if (texture.Role == TextureRole::Normal)
+		{
+			select[0] = 0; select[1] = 1;	// XY
+		}
+		else if (texture.Role == TextureRole::MetallicRoughness)
+		{
+			select[0] = 1; select[1] = 2;	// Roughness, metallic
+		}
+		else
+		{
+			select[0] = 0; select[1] = 3;	// Grey, alpha
+		}
+	}
+
+	const size_t numTexels = size_t(texture.Width) * texture.Height;
+	unsigned char* packed = static_cast<unsigned char*>(malloc(numTexels * dstChannels));
+
+	for (size_t i = 0; i < numTexels; ++i)
+	{
+		unsigned char rgba[4];
+		ExpandTexel(&texture.data[i * srcChannels], srcChannels, rgba);
+
+		for (int c = 0; c < dstChannels; ++c)
+		{
+			packed[i * dstChannels + c] = rgba[select[c]];
+		}
+	}
+
+	free(texture.data);
+	texture.data = packed;
+	texture.Channels = dstChannels;
+	texture.Format = e_PackedFormat;
+}
+
+TextureChannelInfo TextureCooker::AnalyzeChannels(const unsigned char* texels, int channels, int width, int height)
+{
+	TextureChannelInfo info;
+
+	const size_t numTexels = size_t(width) * height;
+	const unsigned char firstRed = texels[0];
+
+	for (size_t i = 0; i < numTexels; ++i)
+	{
+		unsigned char rgba[4];
+		ExpandTexel(&texels[i * channels], channels, rgba);
+
+		info.bGreyscale   = info.bGreyscale && rgba[0] == rgba[1] && rgba[1] == rgba[2];
+		info.bOpaque      = info.bOpaque && rgba[3] == 0xff;
+		info.bConstantRed = info.bConstantRed && rgba[0] == firstRed;
+
+		if (!info.bGreyscale && !info.bOpaque && !info.bConstantRed)
+		{
+			break;
+		}
+	}
+
+	return info;
+}
+
+DXGI_FORMAT TextureCooker::SelectFormat(TextureRole e_Role, const TextureChannelInfo& info, bool bCompressed)
+{
+	if (e_Role == TextureRole::Normal)
+	{
+		return bCompressed ? DXGI_FORMAT_BC5_UNORM : DXGI_FORMAT_R8G8_UNORM;
+	}
+
+	if (info.bGreyscale && info.bOpaque)
+	{
+		return bCompressed ? DXGI_FORMAT_BC4_UNORM : DXGI_FORMAT_R8_UNORM;
+	}
+
+	if (e_Role == TextureRole::MetallicRoughness)
+	{
+		// Roughness and metallic are in G and B. BC5 would be twice the size of BC1, so the packing is only done uncompressed
+		if (!bCompressed && info.bConstantRed && info.bOpaque)
+		{
+			return DXGI_FORMAT_R8G8_UNORM;
+		}
+	}
+	else if (info.bGreyscale)
+	{
+		// Greyscale with a translucent alpha
+		return bCompressed ? DXGI_FORMAT_BC5_UNORM : DXGI_FORMAT_R8G8_UNORM;
+	}
+
+	if (!bCompressed)
+	{
+		// There is no 24 bits format : an opaque alpha channel can't be dropped from uncompressed RGB textures
+		return DXGI_FORMAT_R8G8B8A8_UNORM;
+	}
+
+	if (e_Role == TextureRole::BaseColor)
+	{
+		return DXGI_FORMAT_BC7_UNORM;
+	}
+
+	return info.bOpaque ? DXGI_FORMAT_BC1_UNORM : DXGI_FORMAT_BC3_UNORM;
+}
+
+UINT TextureCooker::GetComponentMapping(TextureRole e_Role, DXGI_FORMAT e_Format)
+{
+	switch (GetChannelCount(e_Format))
+	{
+	case 1:
+		// Greyscale : R is replicated, alpha is opaque
+		return D3D12_ENCODE_SHADER_4_COMPONENT_MAPPING(
+			D3D12_SHADER_COMPONENT_MAPPING_FROM_MEMORY_COMPONENT_0,
+			D3D12_SHADER_COMPONENT_MAPPING_FROM_MEMORY_COMPONENT_0,
+			D3D12_SHADER_COMPONENT_MAPPING_FROM_MEMORY_COMPONENT_0,
+			D3D12_SHADER_COMPONENT_MAPPING_FORCE_VALUE_1);
+
+	case 2:
+		if (e_Role == TextureRole::Normal)
+		{
+			// XY, Z is reconstructed in the shader
+			return D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+		}
+
+		if (e_Role == TextureRole::MetallicRoughness)
+		{
+			// Roughness and metallic back in G and B, R is not sampled by the materials
+			return D3D12_ENCODE_SHADER_4_COMPONENT_MAPPING(
+				D3D12_SHADER_COMPONENT_MAPPING_FORCE_VALUE_1,
+				D3D12_SHADER_COMPONENT_MAPPING_FROM_MEMORY_COMPONENT_0,
+				D3D12_SHADER_COMPONENT_MAPPING_FROM_MEMORY_COMPONENT_1,
+				D3D12_SHADER_COMPONENT_MAPPING_FORCE_VALUE_1);
+		}
+
+		// Greyscale with alpha
+		return D3D12_ENCODE_SHADER_4_COMPONENT_MAPPING(
+			D3D12_SHADER_COMPONENT_MAPPING_FROM_MEMORY_COMPONENT_0,
+			D3D12_SHADER_COMPONENT_MAPPING_FROM_MEMORY_COMPONENT_0,
+			D3D12_SHADER_COMPONENT_MAPPING_FROM_MEMORY_COMPONENT_0,
+			D3D12_SHADER_COMPONENT_MAPPING_FROM_MEMORY_COMPONENT_1);
+
+	default:
+		return D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	}
+}
+
+int TextureCooker::GetChannelCount(DXGI_FORMAT e_Format)
+{
+	switch (e_Format)
+	{
+	case DXGI_FORMAT_R8_UNORM:
+	case DXGI_FORMAT_BC4_UNORM:
+		return 1;
+	case DXGI_FORMAT_R8G8_UNORM:
+	case DXGI_FORMAT_BC5_UNORM:
+		return 2;
+	default:
+		return 4;
+	}
+}
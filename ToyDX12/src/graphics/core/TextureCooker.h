@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+
+struct Texture;
+enum class TextureRole;
+
+struct TextureCookSettings
+{
+	// Block-compress textures whose dimensions allow it (multiples of 4)
+	bool bCompress = true;
+
+	// BC7 mode 6 only : much faster to encode, slightly lower quality
+	bool bQuickBC7 = true;
+
+	// Build the full mip chain, needed by the texture streamer to make low resolution mips resident first
+	bool bGenerateMips = true;
+};
+
+// What the texels of an image actually use
+struct TextureChannelInfo
+{
+	bool bGreyscale = true;		// R == G == B for every texel
+	bool bOpaque = true;		// Alpha is 255 for every texel
+	bool bConstantRed = true;	// R is the same for every texel
+};
+
+// Turns decoded images into GPU ready mip chains
+// Channels are first packed per texture role, from what the texels actually use :
+//	- Normal map							: XY only (R8G8 / BC5), Z is reconstructed in the shader
+//	- Greyscale								: R8 / BC4, or R8G8 / BC5 with a translucent alpha channel
+//	- Metallic/roughness with constant R	: GB only (R8G8), when kept uncompressed
+//	- Other maps							: RGBA8. Base color is compressed to BC7, others to BC1 when opaque and BC3 otherwise
+// The shader sees the packed texture as RGBA again through the component mapping of its SRV (see GetComponentMapping)
+class TextureCooker
+{
+public:
+	TextureCooker() = delete;
+	~TextureCooker() = delete;
+
+	// Cooks the textures in parallel, textures that can't be compressed keep their packed mip chain
+	static void CookTextures(std::vector<Texture>& textures, const TextureCookSettings& settings = {});
+
+	static TextureChannelInfo AnalyzeChannels(const unsigned char* texels, int channels, int width, int height);
+	static DXGI_FORMAT SelectFormat(TextureRole e_Role, const TextureChannelInfo& info, bool bCompressed);
+
+	// Swizzle to use in the SRV of a texture so that shaders sample RGBA whatever the packing
+	static UINT GetComponentMapping(TextureRole e_Role, DXGI_FORMAT e_Format);
+	static int GetChannelCount(DXGI_FORMAT e_Format);
+
+protected:
+	static bool CookTexture(Texture& texture, const TextureCookSettings& settings);
+	static void PackChannels(Texture& texture, DXGI_FORMAT e_PackedFormat);
+};
@@ -0,0 +1,237 @@
+#include "pch.h"
+
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <climits>
+
+using namespace DirectX;
+
+TextureStreamer::TextureStreamer(const TextureStreamingSettings& settings)
+	: m_Settings(settings)
+{
+}
+
+int TextureStreamer::RegisterTexture(uint32_t ui_Width, uint32_t ui_Height, const std::vector<uint64_t>& a_MipSizes)
+{
+	if (a_MipSizes.empty())
+	{
+		LOG_ERROR("TextureStreamer: Cannot register a texture without mips.");
+		return -1;
+	}
+
+	StreamedTexture texture;
+	texture.Width = ui_Width;
+	texture.Height = ui_Height;
+	texture.MipSizes = a_MipSizes;
+
+	// Lowest mips are resident from the start
+	const int numMips = (int)a_MipSizes.size();
+	texture.PinnedMip = numMips - 1;
+
+	for (int mip = 0; mip < numMips; ++mip)
+	{
+		const uint32_t mipWidth  = (std::max)(ui_Width >> mip, 1u);
+		const uint32_t mipHeight = (std::max)(ui_Height >> mip, 1u);
+
+		if ((std::max)(mipWidth, mipHeight) <= m_Settings.MinResidentDimension)
+		{
+			texture.PinnedMip = mip;
+			break;
+		}
+	}
+
+	texture.ResidentMip = texture.PinnedMip;
+	texture.RequiredMip = texture.PinnedMip;
+
+	for (int mip = texture.PinnedMip; mip < numMips; ++mip)
+	{
+		m_ResidentSize += a_MipSizes[mip];
+	}
+
+	m_Textures.push_back(std::move(texture));
+
+	return (int)m_Textures.size() - 1;
+}
+
+void TextureStreamer::AddUsage(int textureHandle, const AABB& worldBounds, float uvDensity)
+{
+	if (textureHandle < 0 || textureHandle >= (int)m_Textures.size() || !worldBounds.IsValid())
+	{
+		return;
+	}
+
+	m_Usages.push_back({ .Texture = textureHandle, .Center = worldBounds.Center(), .Radius = worldBounds.Radius(), .UvDensity = uvDensity });
+}
+
+int TextureStreamer::ComputeRequiredMip(uint32_t ui_TextureSize, float uvDensity, float distance, const StreamingView& view, float mipBias)
+{
+	// Surfaces without texture coordinates sample a single texel
+	if (uvDensity <= 0.0f)
+	{
+		return INT_MAX;
+	}
+
+	const float pixelsPerUnit = view.ViewportHeight / (2.0f * (std::max)(distance, view.NearZ) * tanf(0.5f * view.FovY));
+	const float texelsPerUnit = ui_TextureSize * uvDensity;
+
+	// Each mip halves the texel density
+	const float mip = log2f(texelsPerUnit / pixelsPerUnit) + mipBias;
+
+	return mip <= 0.0f ? 0 : (int)mip;
+}
+
+void TextureStreamer::ComputeRequiredMips(const StreamingView& view)
+{
+	for (StreamedTexture& texture : m_Textures)
+	{
+		texture.RequiredMip = texture.PinnedMip;
+	}
+
+	const XMVECTOR eye = XMLoadFloat3(&view.EyePosWS);
+	const XMVECTOR forward = XMVector3Normalize(XMLoadFloat3(&view.ForwardWS));
+
+	for (const Usage& usage : m_Usages)
+	{
+		StreamedTexture& texture = m_Textures[usage.Texture];
+
+		const XMVECTOR toCenter = XMVectorSubtract(XMLoadFloat3(&usage.Center), eye);
+
+		// Surfaces entirely behind the viewer don't need streamed mips
+		if (XMVectorGetX(XMVector3Dot(toCenter, forward)) < -usage.Radius)
+		{
+			continue;
+		}
+
+		// Screen-space size is estimated from the closest point of the bounding sphere
+		const float distance = XMVectorGetX(XMVector3Length(toCenter)) - usage.Radius;
+		const int mip = ComputeRequiredMip((std::max)(texture.Width, texture.Height), usage.UvDensity, distance, view, m_Settings.MipBias);
+
+		texture.RequiredMip = (std::min)(texture.RequiredMip, mip);
+	}
+
+	for (StreamedTexture& texture : m_Textures)
+	{
+		if (texture.RequiredMip < texture.PinnedMip)
+		{
+			texture.LastUsedUpdate = m_UpdateIndex;
+		}
+	}
+}
+
+const std::vector<int>& TextureStreamer::Update(const StreamingView& view)
+{
+	++m_UpdateIndex;
+
+	for (int handle : m_ChangedTextures)
+	{
+		m_Textures[handle].bChanged = false;
+	}
+	m_ChangedTextures.clear();
+
+	ComputeRequiredMips(view);
+
+	// The budget may have been lowered since the last update, even below what this view requires
+	while (m_ResidentSize > m_Settings.BudgetInBytes && (EvictLeastRecentlyUsed() || EvictLargestMip()))
+	{
+	}
+
+	// Missing mips are made resident one level per texture and per pass,
+	// so that a few close textures can't take the whole budget before the others got their coarser mips
+	bool bProgress = true;
+	while (bProgress)
+	{
+		bProgress = false;
+
+		for (StreamedTexture& texture : m_Textures)
+		{
+			if (texture.ResidentMip <= texture.RequiredMip)
+			{
+				continue;
+			}
+
+			const uint64_t mipSize = texture.MipSizes[texture.ResidentMip - 1];
+
+			while (m_ResidentSize + mipSize > m_Settings.BudgetInBytes && EvictLeastRecentlyUsed())
+			{
+			}
+
+			if (m_ResidentSize + mipSize > m_Settings.BudgetInBytes)
+			{
+				continue;
+			}
+
+			SetResidentMip(texture, texture.ResidentMip - 1);
+			bProgress = true;
+		}
+	}
+
+	return m_ChangedTextures;
+}
+
+bool TextureStreamer::EvictLeastRecentlyUsed()
+{
+	// Only mips more detailed than what the texture currently requires can be evicted
+	StreamedTexture* victim = nullptr;
+
+	for (StreamedTexture& texture : m_Textures)
+	{
+		if (texture.ResidentMip < texture.RequiredMip && (victim == nullptr || texture.LastUsedUpdate < victim->LastUsedUpdate))
+		{
+			victim = &texture;
+		}
+	}
+
+	if (victim == nullptr)
+	{
+		return false;
+	}
+
+	SetResidentMip(*victim, victim->ResidentMip + 1);
+
+	return true;
+}
+
+bool TextureStreamer::EvictLargestMip()
+{
+	// Required mips too : the largest one frees the most memory for the detail it costs
+	StreamedTexture* victim = nullptr;
+
+	for (StreamedTexture& texture : m_Textures)
+	{
+		if (texture.ResidentMip < texture.PinnedMip && (victim == nullptr || texture.MipSizes[texture.ResidentMip] > victim->MipSizes[victim->ResidentMip]))
+		{
+			victim = &texture;
+		}
+	}
+
+	if (victim == nullptr)
+	{
+		return false;
+	}
+
+	SetResidentMip(*victim, victim->ResidentMip + 1);
+
+	return true;
+}
+
+void TextureStreamer::SetResidentMip(StreamedTexture& texture, int mip)
+{
+	for (int i = mip; i < texture.ResidentMip; ++i)
+	{
+		m_ResidentSize += texture.MipSizes[i];
+	}
+
+	for (int i = texture.ResidentMip; i < mip; ++i)
+	{
+		m_ResidentSize -= texture.MipSizes[i];
+	}
+
+	texture.ResidentMip = mip;
+
+	if (!texture.bChanged)
+	{
+		texture.bChanged = true;
+		m_ChangedTextures.push_back(int(&texture - m_Textures.data()));
+	}
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "Bounds.h"
+
+struct TextureStreamingSettings
+{
+	// GPU memory the streamed mips are allowed to use
+	uint64_t BudgetInBytes = 256ull * 1024 * 1024;
+
+	// Mips whose largest dimension is at most this size are resident from the start and never evicted
+	uint32_t MinResidentDimension = 64;
+
+	// Added to the estimated mip, positive values trade sharpness for memory
+	float MipBias = 0.0f;
+};
+
+// Point of view the required mips are estimated from
+// Kept apart from the Camera so that a camera path can be simulated without a window or a device
+struct StreamingView
+{
+	DirectX::XMFLOAT3 EyePosWS = { 0.0f, 0.0f, 0.0f };
+	DirectX::XMFLOAT3 ForwardWS = { 0.0f, 0.0f, 1.0f };
+	float FovY = DirectX::XMConvertToRadians(45.0f);
+	float ViewportHeight = 720.0f;
+	float NearZ = 1.0f;
+};
+
+// Decides which mips of each texture should be resident on the GPU
+// - Textures start with their lowest mips only (up to MinResidentDimension)
+// - Each frame, the required mip of a texture is estimated from the screen-space size and the UV density of the surfaces sampling it
+// - Missing mips are made resident one level at a time across all textures, so the budget is shared fairly
+// - When the budget is exceeded, mips that are not required anymore are evicted from the least recently used textures first
+// - If the budget was lowered below what the view requires, the largest mips of the textures in use are evicted as well
+// The streamer only does bookkeeping : the renderer (re)creates the GPU textures of the handles returned by Update()
+class TextureStreamer
+{
+public:
+	TextureStreamer(const TextureStreamingSettings& settings = {});
+
+	// a_MipSizes : size in bytes of each mip, most detailed first. Returns the handle of the texture in the streamer
+	int RegisterTexture(uint32_t ui_Width, uint32_t ui_Height, const std::vector<uint64_t>& a_MipSizes);
+
+	// Registers a surface sampling the texture
+	void AddUsage(int textureHandle, const AABB& worldBounds, float uvDensity);
+
+	// Estimates the required mips for this view and updates the residency to fit the budget
+	// Returns the handles of the textures whose resident mip changed
+	const std::vector<int>& Update(const StreamingView& view);
+
+	void SetBudget(uint64_t ui_BudgetInBytes) { m_Settings.BudgetInBytes = ui_BudgetInBytes; }
+	uint64_t GetBudget() const { return m_Settings.BudgetInBytes; }
+	uint64_t GetResidentSize() const { return m_ResidentSize; }
+
+	int GetResidentMip(int handle) const { return m_Textures[handle].ResidentMip; }
+	int GetRequiredMip(int handle) const { return m_Textures[handle].RequiredMip; }
+	int GetNumTextures() const { return (int)m_Textures.size(); }
+
+	// Most detailed mip needed to get about one texel per pixel on a surface at this distance
+	static int ComputeRequiredMip(uint32_t ui_TextureSize, float uvDensity, float distance, const StreamingView& view, float mipBias = 0.0f);
+
+protected:
+	struct StreamedTexture
+	{
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+		std::vector<uint64_t> MipSizes;
+
+		// Coarsest streamed mip : this mip and the lower ones are always resident
+		int PinnedMip = 0;
+		int ResidentMip = 0;
+		int RequiredMip = 0;
+
+		// Last update during which the texture needed more than its pinned mips
+		uint64_t LastUsedUpdate = 0;
+		bool bChanged = false;
+	};
+
+	struct Usage
+	{
+		int Texture;
+		DirectX::XMFLOAT3 Center;
+		float Radius;
+		float UvDensity;
+	};
+
+	void ComputeRequiredMips(const StreamingView& view);
+	bool EvictLeastRecentlyUsed();
+	bool EvictLargestMip();
+	void SetResidentMip(StreamedTexture& texture, int mip);
+
+	TextureStreamingSettings m_Settings;
+
+	std::vector<StreamedTexture> m_Textures;
+	std::vector<Usage> m_Usages;
+	std::vector<int> m_ChangedTextures;
+
+	uint64_t m_ResidentSize = 0;
+	uint64_t m_UpdateIndex = 0;
+};
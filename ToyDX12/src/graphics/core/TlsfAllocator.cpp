@@ -0,0 +1,315 @@
+#include "pch.h"
+
+#include "TlsfAllocator.h"
+
+#include <bit>
+
+TlsfAllocator::TlsfAllocator(uint64_t ui64_Size)
+	: m_Size(ui64_Size)
+{
+	for (uint32_t fl = 0; fl < FirstLevelCount; ++fl)
+	{
+		for (uint32_t sl = 0; sl < SecondLevelCount; ++sl)
+		{
+			m_FreeLists[fl][sl] = InvalidHandle;
+		}
+	}
+
+	if (m_Size > 0)
+	{
+		const Handle block = CreateBlock(0, m_Size);
+		m_Blocks[block].bFree = true;
+		InsertFree(block);
+	}
+}
+
+bool TlsfAllocator::Allocate(uint64_t ui64_Size, uint64_t ui64_Alignment, Allocation& r_Allocation)
+{
+	const uint64_t size = (std::max)(ui64_Size, uint64_t(1));
+	const uint64_t alignment = (std::max)(ui64_Alignment, uint64_t(1));
+
+	auto alignedEnd = [&](Handle block)
+	{
+		const uint64_t aligned = (m_Blocks[block].Offset + alignment - 1) & ~(alignment - 1);
+		return aligned + size;
+	};
+
+	// The first block of a bin large enough for the size is used if it can also be aligned,
+	// otherwise any block of a bin large enough for the size and the worst padding.
+	// As a last resort, the blocks of the bin of the size itself are searched one by one (e.g. a range allocated at once)
+	uint32_t fl, sl;
+	Handle block = InvalidHandle;
+
+	if (FindBin(size, fl, sl))
+	{
+		const Handle candidate = m_FreeLists[fl][sl];
+		if (alignedEnd(candidate) <= m_Blocks[candidate].Offset + m_Blocks[candidate].Size)
+		{
+			block = candidate;
+		}
+	}
+
+	if (block == InvalidHandle && alignment > 1 && FindBin(size + alignment - 1, fl, sl))
+	{
+		block = m_FreeLists[fl][sl];
+	}
+
+	if (block == InvalidHandle)
+	{
+		Mapping(size, fl, sl);
+
+		for (Handle candidate = m_FreeLists[fl][sl]; candidate != InvalidHandle; candidate = m_Blocks[candidate].NextFree)
+		{
+			if (alignedEnd(candidate) <= m_Blocks[candidate].Offset + m_Blocks[candidate].Size)
+			{
+				block = candidate;
+				break;
+			}
+		}
+	}
+
+	if (block == InvalidHandle)
+	{
+		return false;
+	}
+
+	RemoveFree(block);
+
+	// Padding in front of the aligned offset stays free
+	const uint64_t padding = alignedEnd(block) - size - m_Blocks[block].Offset;
+	if (padding > 0)
+	{
+		const Handle aligned = Split(block, padding);
+		InsertFree(block);
+
+		block = aligned;
+	}
+
+	if (m_Blocks[block].Size > size)
+	{
+		const Handle rest = Split(block, size);
+		InsertFree(rest);
+	}
+
+	m_Blocks[block].bFree = false;
+	m_AllocatedSize += size;
+	m_NumAllocations++;
+
+	r_Allocation.Offset = m_Blocks[block].Offset;
+	r_Allocation.Block = block;
+
+	return true;
+}
+
+void TlsfAllocator::Free(Handle block)
+{
+	assert(block < m_Blocks.size() && !m_Blocks[block].bFree);
+
+	m_AllocatedSize -= m_Blocks[block].Size;
+	m_NumAllocations--;
+
+	const Handle next = m_Blocks[block].NextPhysical;
+	if (next != InvalidHandle && m_Blocks[next].bFree)
+	{
+		RemoveFree(next);
+		MergeWithNext(block);
+	}
+
+	const Handle prev = m_Blocks[block].PrevPhysical;
+	if (prev != InvalidHandle && m_Blocks[prev].bFree)
+	{
+		RemoveFree(prev);
+		MergeWithNext(prev);
+
+		block = prev;
+	}
+
+	InsertFree(block);
+}
+
+TlsfStats TlsfAllocator::GetStats() const
+{
+	TlsfStats stats;
+	stats.Size = m_Size;
+	stats.AllocatedSize = m_AllocatedSize;
+	stats.NumAllocations = m_NumAllocations;
+	stats.NumFreeBlocks = m_NumFreeBlocks;
+
+	// The largest free block is in the last non empty bin
+	if (m_FirstLevelBitmap != 0)
+	{
+		const uint32_t fl = 63 - std::countl_zero(m_FirstLevelBitmap);
+		const uint32_t sl = 31 - std::countl_zero(m_SecondLevelBitmaps[fl]);
+
+		for (Handle block = m_FreeLists[fl][sl]; block != InvalidHandle; block = m_Blocks[block].NextFree)
+		{
+			stats.LargestFreeBlock = (std::max)(stats.LargestFreeBlock, m_Blocks[block].Size);
+		}
+	}
+
+	return stats;
+}
+
+void TlsfAllocator::Mapping(uint64_t ui64_Size, uint32_t& r_FirstLevel, uint32_t& r_SecondLevel)
+{
+	r_FirstLevel = (uint32_t)std::bit_width(ui64_Size) - 1;
+
+	// Sizes below the number of second level bins are exact
+	r_SecondLevel = r_FirstLevel >= SecondLevelBits
+		? uint32_t(ui64_Size >> (r_FirstLevel - SecondLevelBits)) & (SecondLevelCount - 1)
+		: uint32_t(ui64_Size << (SecondLevelBits - r_FirstLevel)) & (SecondLevelCount - 1);
+}
+
+bool TlsfAllocator::FindBin(uint64_t ui64_Size, uint32_t& r_FirstLevel, uint32_t& r_SecondLevel) const
+{
+	// Rounded up to the next bin : every block of the bins from there on is large enough
+	uint64_t size = ui64_Size;
+	const uint32_t msb = (uint32_t)std::bit_width(size) - 1;
+	if (msb >= SecondLevelBits)
+	{
+		size += (uint64_t(1) << (msb - SecondLevelBits)) - 1;
+	}
+
+	uint32_t fl, sl;
+	Mapping(size, fl, sl);
+
+	uint32_t secondLevelMap = m_SecondLevelBitmaps[fl] & (~0u << sl);
+
+	if (secondLevelMap == 0)
+	{
+		const uint64_t firstLevelMap = fl + 1 < FirstLevelCount ? m_FirstLevelBitmap & (~0ull << (fl + 1)) : 0;
+		if (firstLevelMap == 0)
+		{
+			return false;
+		}
+
+		fl = (uint32_t)std::countr_zero(firstLevelMap);
+		secondLevelMap = m_SecondLevelBitmaps[fl];
+	}
+
+	r_FirstLevel = fl;
+	r_SecondLevel = (uint32_t)std::countr_zero(secondLevelMap);
+
+	return true;
+}
+
+TlsfAllocator::Handle TlsfAllocator::CreateBlock(uint64_t ui64_Offset, uint64_t ui64_Size)
+{
+	Handle block;
+	if (m_UnusedBlocks.empty())
+	{
+		block = (Handle)m_Blocks.size();
+		m_Blocks.emplace_back();
+	}
+	else
+	{
+		block = m_UnusedBlocks.back();
+		m_UnusedBlocks.pop_back();
+		m_Blocks[block] = Block();
+	}
+
+	m_Blocks[block].Offset = ui64_Offset;
+	m_Blocks[block].Size = ui64_Size;
+
+	return block;
+}
+
+void TlsfAllocator::DestroyBlock(Handle block)
+{
+	m_UnusedBlocks.push_back(block);
+}
+
+void TlsfAllocator::InsertFree(Handle block)
+{
+	uint32_t fl, sl;
+	Mapping(m_Blocks[block].Size, fl, sl);
+
+	const Handle head = m_FreeLists[fl][sl];
+
+	m_Blocks[block].bFree = true;
+	m_Blocks[block].PrevFree = InvalidHandle;
+	m_Blocks[block].NextFree = head;
+
+	if (head != InvalidHandle)
+	{
+		m_Blocks[head].PrevFree = block;
+	}
+
+	m_FreeLists[fl][sl] = block;
+	m_FirstLevelBitmap |= uint64_t(1) << fl;
+	m_SecondLevelBitmaps[fl] |= 1u << sl;
+	m_NumFreeBlocks++;
+}
+
+void TlsfAllocator::RemoveFree(Handle block)
+{
+	uint32_t fl, sl;
+	Mapping(m_Blocks[block].Size, fl, sl);
+
+	const Handle prev = m_Blocks[block].PrevFree;
+	const Handle next = m_Blocks[block].NextFree;
+
+	if (prev != InvalidHandle)
+	{
+		m_Blocks[prev].NextFree = next;
+	}
+	else
+	{
+		m_FreeLists[fl][sl] = next;
+	}
+
+	if (next != InvalidHandle)
+	{
+		m_Blocks[next].PrevFree = prev;
+	}
+
+	if (m_FreeLists[fl][sl] == InvalidHandle)
+	{
+		m_SecondLevelBitmaps[fl] &= ~(1u << sl);
+		if (m_SecondLevelBitmaps[fl] == 0)
+		{
+			m_FirstLevelBitmap &= ~(uint64_t(1) << fl);
+		}
+	}
+
+	m_Blocks[block].bFree = false;
+	m_Blocks[block].PrevFree = InvalidHandle;
+	m_Blocks[block].NextFree = InvalidHandle;
+	m_NumFreeBlocks--;
+}
+
+TlsfAllocator::Handle TlsfAllocator::Split(Handle block, uint64_t ui64_Size)
+{
+	// m_Blocks may grow : no reference is kept across CreateBlock
+	const Handle rest = CreateBlock(m_Blocks[block].Offset + ui64_Size, m_Blocks[block].Size - ui64_Size);
+	const Handle next = m_Blocks[block].NextPhysical;
+
+	m_Blocks[rest].PrevPhysical = block;
+	m_Blocks[rest].NextPhysical = next;
+
+	if (next != InvalidHandle)
+	{
+		m_Blocks[next].PrevPhysical = rest;
+	}
+
+	m_Blocks[block].NextPhysical = rest;
+	m_Blocks[block].Size = ui64_Size;
+
+	return rest;
+}
+
+void TlsfAllocator::MergeWithNext(Handle block)
+{
+	const Handle next = m_Blocks[block].NextPhysical;
+	const Handle nextNext = m_Blocks[next].NextPhysical;
+
+	m_Blocks[block].Size += m_Blocks[next].Size;
+	m_Blocks[block].NextPhysical = nextNext;
+
+	if (nextNext != InvalidHandle)
+	{
+		m_Blocks[nextNext].PrevPhysical = block;
+	}
+
+	DestroyBlock(next);
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Usage of a range handled by a TlsfAllocator
+struct TlsfStats
+{
+	uint64_t Size = 0;
+	uint64_t AllocatedSize = 0;	// Alignment padding in front of the allocations stays free
+	uint32_t NumAllocations = 0;
+	uint32_t NumFreeBlocks = 0;
+	uint64_t LargestFreeBlock = 0;
+
+	// 0 when all the free memory is in one block, close to 1 when it is scattered in small blocks
+	float GetFragmentation() const
+	{
+		const uint64_t freeSize = Size - AllocatedSize;
+		return freeSize > 0 ? 1.0f - float(double(LargestFreeBlock) / double(freeSize)) : 0.0f;
+	}
+};
+
+// Two-Level Segregated Fit allocator of offsets in a range of fixed size (e.g. a GPU heap), no memory is touched
+// Free blocks are binned by size : the first level is the power of two of the size, the second level splits it in 16 linear bins.
+// Bitmaps of the non empty bins find a free block that is large enough in constant time. Freed blocks merge with their free neighbours
+// http://www.gii.upv.es/tlsf/files/papers/ecrts04_tlsf.pdf
+class TlsfAllocator
+{
+public:
+	using Handle = uint32_t;
+	static const Handle InvalidHandle = UINT32_MAX;
+
+	struct Allocation
+	{
+		uint64_t Offset = 0;
+		Handle Block = InvalidHandle;
+	};
+
+	explicit TlsfAllocator(uint64_t ui64_Size);
+
+	// ui64_Alignment must be a power of two. Returns false if no free block can hold the aligned allocation
+	bool Allocate(uint64_t ui64_Size, uint64_t ui64_Alignment, Allocation& r_Allocation);
+	void Free(Handle block);
+
+	uint64_t GetSize() const { return m_Size; }
+	uint64_t GetAllocatedSize() const { return m_AllocatedSize; }
+	uint32_t GetNumAllocations() const { return m_NumAllocations; }
+	bool IsEmpty() const { return m_NumAllocations == 0; }
+
+	TlsfStats GetStats() const;
+
+protected:
+	static const uint32_t SecondLevelBits = 4;
+	static const uint32_t SecondLevelCount = 1u << SecondLevelBits;
+	static const uint32_t FirstLevelCount = 64;
+
+	struct Block
+	{
+		uint64_t Offset = 0;
+		uint64_t Size = 0;
+
+		// Neighbours in the range
+		Handle PrevPhysical = InvalidHandle;
+		Handle NextPhysical = InvalidHandle;
+
+		// Neighbours in the free list of the bin, when free
+		Handle PrevFree = InvalidHandle;
+		Handle NextFree = InvalidHandle;
+
+		bool bFree = false;
+	};
+
+	static void Mapping(uint64_t ui64_Size, uint32_t& r_FirstLevel, uint32_t& r_SecondLevel);
+
+	// First non empty bin whose blocks all hold ui64_Size bytes, false if there is none
+	bool FindBin(uint64_t ui64_Size, uint32_t& r_FirstLevel, uint32_t& r_SecondLevel) const;
+
+	Handle CreateBlock(uint64_t ui64_Offset, uint64_t ui64_Size);
+	void DestroyBlock(Handle block);
+
+	void InsertFree(Handle block);
+	void RemoveFree(Handle block);
+
+	// Splits the first ui64_Size bytes of a block off, the rest becomes a new free block. Returns the handle of the rest
+	Handle Split(Handle block, uint64_t ui64_Size);
+	void MergeWithNext(Handle block);
+
+	uint64_t m_Size = 0;
+	uint64_t m_AllocatedSize = 0;
+	uint32_t m_NumAllocations = 0;
+	uint32_t m_NumFreeBlocks = 0;
+
+	std::vector<Block> m_Blocks;
+	std::vector<Handle> m_UnusedBlocks;	// Recycled entries of m_Blocks
+
+	uint64_t m_FirstLevelBitmap = 0;
+	uint32_t m_SecondLevelBitmaps[FirstLevelCount] = {};
+	Handle m_FreeLists[FirstLevelCount][SecondLevelCount];
+};
@@ -0,0 +1,200 @@
+#include "pch.h"
+
+#include "TransformBatch.h"
+
+#include <algorithm>
+#include <execution>
+
+using namespace DirectX;
+
+// Objects per task when a request is split across worker threads, a multiple of 4
+static const size_t s_ObjectsPerTask = 4096;
+
+static_assert(sizeof(TransformBatch::Output) == 128, "Output must match the per object constants");
+
+void TransformBatch::Resize(uint32_t ui_Count)
+{
+	const size_t paddedCount = (size_t(ui_Count) + 3) & ~size_t(3);
+
+	for (int row = 0; row < 3; ++row)
+	{
+		for (int column = 0; column < 4; ++column)
+		{
+			m_Rows[row][column].resize(paddedCount, row == column ? 1.0f : 0.0f);
+		}
+	}
+
+	Output identity;
+	XMStoreFloat4x4A(&identity.World, XMMatrixIdentity());
+	XMStoreFloat4x4A(&identity.WorldInvTranspose, XMMatrixIdentity());
+	m_Outputs.resize(ui_Count, identity);
+
+	m_Count = ui_Count;
+}
+
+void TransformBatch::SetWorld(uint32_t index, FXMMATRIX world)
+{
+	XMFLOAT4X4 w;
+	XMStoreFloat4x4(&w, world);
+
+	// Row r of the transpose is column r of the world, the translation ends up in the last column
+	for (int row = 0; row < 3; ++row)
+	{
+		for (int column = 0; column < 4; ++column)
+		{
+			m_Rows[row][column][index] = w.m[column][row];
+		}
+	}
+}
+
+// Calls task(first, count) over ranges of ui_Count items, in parallel when there are several
+template<typename Task>
+static void ForEachRange(size_t ui_Count, const Task& task)
+{
+	if (ui_Count <= s_ObjectsPerTask)
+	{
+		task(size_t(0), ui_Count);
+		return;
+	}
+
+	std::vector<size_t> tasks((ui_Count + s_ObjectsPerTask - 1) / s_ObjectsPerTask);
+	for (size_t i = 0; i < tasks.size(); ++i)
+	{
+		tasks[i] = i * s_ObjectsPerTask;
+	}
+
+	std::for_each(std::execution::par, tasks.begin(), tasks.end(), [&](size_t first)
+	{
+		task(first, (std::min)(s_ObjectsPerTask, ui_Count - first));
+	});
+}
+
+void TransformBatch::Update(const uint32_t* a_Indices, size_t ui_Count)
+{
+	// Ranges are multiples of 4 objects : a SIMD group never spans two tasks
+	ForEachRange(ui_Count, [&](size_t first, size_t count)
+	{
+		UpdateRange(a_Indices + first, count);
+	});
+}
+
+void TransformBatch::Write(const uint32_t* a_Indices, size_t ui_Count, void* p_Dst, size_t ui_Stride, TransformOutput e_Output) const
+{
+	unsigned char* dst = static_cast<unsigned char*>(p_Dst);
+
+	ForEachRange(ui_Count, [&](size_t first, size_t count)
+	{
+		WriteRange(a_Indices + first, count, first, dst, ui_Stride, e_Output);
+	});
+}
+
+static void StreamRow(unsigned char* p_Dst, FXMVECTOR row)
+{
+#if defined(_XM_SSE_INTRINSICS_)
+	_mm_stream_ps(reinterpret_cast<float*>(p_Dst), row);
+#else
+	XMStoreFloat4A(reinterpret_cast<XMFLOAT4A*>(p_Dst), row);
+#endif
+}
+
+void TransformBatch::UpdateRange(const uint32_t* a_Indices, size_t ui_Count)
+{
+	const XMVECTOR lastRow = g_XMIdentityR3;
+
+	for (size_t i = 0; i < ui_Count; i += 4)
+	{
+		const size_t numLanes = (std::min)(ui_Count - i, size_t(4));
+
+		// Missing lanes repeat the last object, they are not written
+		uint32_t lanes[4];
+		for (size_t l = 0; l < 4; ++l)
+		{
+			lanes[l] = a_Indices[i + (std::min)(l, numLanes - 1)];
+		}
+
+		const bool bContiguous = lanes[1] == lanes[0] + 1 && lanes[2] == lanes[0] + 2 && lanes[3] == lanes[0] + 3;
+
+		// m[r][c] : component (r, c) of the transposed worlds of the 4 objects
+		XMVECTOR m[3][4];
+		for (int row = 0; row < 3; ++row)
+		{
+			for (int column = 0; column < 4; ++column)
+			{
+				const float* component = m_Rows[row][column].data();
+				m[row][column] = bContiguous ? XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&component[lanes[0]])) : XMVectorSet(component[lanes[0]], component[lanes[1]], component[lanes[2]], component[lanes[3]]);
+			}
+		}
+
+		// Inverse of the 3x3 part : its columns are the cross products of the rows, over the determinant
+		XMVECTOR inv[3][4];
+		inv[0][0] = XMVectorSubtract(XMVectorMultiply(m[1][1], m[2][2]), XMVectorMultiply(m[1][2], m[2][1]));
+		inv[1][0] = XMVectorSubtract(XMVectorMultiply(m[1][2], m[2][0]), XMVectorMultiply(m[1][0], m[2][2]));
+		inv[2][0] = XMVectorSubtract(XMVectorMultiply(m[1][0], m[2][1]), XMVectorMultiply(m[1][1], m[2][0]));
+
+		inv[0][1] = XMVectorSubtract(XMVectorMultiply(m[2][1], m[0][2]), XMVectorMultiply(m[2][2], m[0][1]));
+		inv[1][1] = XMVectorSubtract(XMVectorMultiply(m[2][2], m[0][0]), XMVectorMultiply(m[2][0], m[0][2]));
+		inv[2][1] = XMVectorSubtract(XMVectorMultiply(m[2][0], m[0][1]), XMVectorMultiply(m[2][1], m[0][0]));
+
+		inv[0][2] = XMVectorSubtract(XMVectorMultiply(m[0][1], m[1][2]), XMVectorMultiply(m[0][2], m[1][1]));
+		inv[1][2] = XMVectorSubtract(XMVectorMultiply(m[0][2], m[1][0]), XMVectorMultiply(m[0][0], m[1][2]));
+		inv[2][2] = XMVectorSubtract(XMVectorMultiply(m[0][0], m[1][1]), XMVectorMultiply(m[0][1], m[1][0]));
+
+		const XMVECTOR det = XMVectorMultiplyAdd(m[0][0], inv[0][0], XMVectorMultiplyAdd(m[0][1], inv[1][0], XMVectorMultiply(m[0][2], inv[2][0])));
+		const XMVECTOR invDet = XMVectorReciprocal(det);
+
+		for (int row = 0; row < 3; ++row)
+		{
+			for (int column = 0; column < 3; ++column)
+			{
+				inv[row][column] = XMVectorMultiply(inv[row][column], invDet);
+			}
+
+			// Inverse translation : -inverse(3x3) * translation
+			inv[row][3] = XMVectorNegate(XMVectorMultiplyAdd(inv[row][0], m[0][3], XMVectorMultiplyAdd(inv[row][1], m[1][3], XMVectorMultiply(inv[row][2], m[2][3]))));
+		}
+
+		// Back to one row per object
+		XMMATRIX worldRows[3];
+		XMMATRIX invRows[3];
+		for (int row = 0; row < 3; ++row)
+		{
+			worldRows[row] = XMMatrixTranspose(XMMATRIX(m[row][0], m[row][1], m[row][2], m[row][3]));
+			invRows[row] = XMMatrixTranspose(XMMATRIX(inv[row][0], inv[row][1], inv[row][2], inv[row][3]));
+		}
+
+		for (size_t l = 0; l < numLanes; ++l)
+		{
+			Output& output = m_Outputs[lanes[l]];
+
+			for (int row = 0; row < 3; ++row)
+			{
+				XMStoreFloat4A(reinterpret_cast<XMFLOAT4A*>(output.World.m[row]), worldRows[row].r[l]);
+				XMStoreFloat4A(reinterpret_cast<XMFLOAT4A*>(output.WorldInvTranspose.m[row]), invRows[row].r[l]);
+			}
+
+			XMStoreFloat4A(reinterpret_cast<XMFLOAT4A*>(output.World.m[3]), lastRow);
+			XMStoreFloat4A(reinterpret_cast<XMFLOAT4A*>(output.WorldInvTranspose.m[3]), lastRow);
+		}
+	}
+}
+
+void TransformBatch::WriteRange(const uint32_t* a_Indices, size_t ui_Count, size_t ui_FirstOutput, unsigned char* p_Dst, size_t ui_Stride, TransformOutput e_Output) const
+{
+	for (size_t i = 0; i < ui_Count; ++i)
+	{
+		const size_t outputIndex = e_Output == TransformOutput::Packed ? ui_FirstOutput + i : a_Indices[i];
+		unsigned char* dst = p_Dst + outputIndex * ui_Stride;
+
+		const Output& output = m_Outputs[a_Indices[i]];
+		for (int row = 0; row < 4; ++row)
+		{
+			StreamRow(dst + offsetof(Output, World) + row * sizeof(XMFLOAT4), XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(output.World.m[row])));
+			StreamRow(dst + offsetof(Output, WorldInvTranspose) + row * sizeof(XMFLOAT4), XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(output.WorldInvTranspose.m[row])));
+		}
+	}
+
+#if defined(_XM_SSE_INTRINSICS_)
+	// Non-temporal stores are weakly ordered : make them visible before the memory is submitted
+	_mm_sfence();
+#endif
+}
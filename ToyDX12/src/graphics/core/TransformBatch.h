@@ -0,0 +1,58 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Where the matrices of the i-th requested object are written
+enum class TransformOutput
+{
+	Packed,			// p_Dst + i * stride
+	ByObjectIndex	// p_Dst + objectIndex * stride, e.g. an array of per object constants
+};
+
+// World matrices of objects, and the per object constants computed from them : world and inverse world, both transposed for HLSL
+// - Worlds are affine : they are stored as the 3 rows of their transpose (3x4), in structure of arrays
+// - Constants are computed when a world changes, 4 objects at a time, one per SIMD lane, with an affine-only inverse, and kept
+// - They are copied out with non-temporal stores : meant for mapped upload memory, which is written once and never read back
+// - Large requests are split across worker threads
+class TransformBatch
+{
+public:
+	// Layout of the output of each object, same as the per object constants of the renderer
+	struct Output
+	{
+		DirectX::XMFLOAT4X4A World;				// Transposed
+		DirectX::XMFLOAT4X4A WorldInvTranspose;	// Inverse world, transposed
+	};
+
+	TransformBatch() = default;
+
+	// New objects have an identity world and identity constants
+	void Resize(uint32_t ui_Count);
+	uint32_t GetCount() const { return m_Count; }
+
+	// The last column of the world is assumed to be (0, 0, 0, 1). The constants are only computed by Update
+	void SetWorld(uint32_t index, DirectX::FXMMATRIX world);
+
+	// Computes the constants of the objects in a_Indices from their current world
+	void Update(const uint32_t* a_Indices, size_t ui_Count);
+
+	// Copies the constants of the objects in a_Indices, as last updated, to p_Dst which must be 16 bytes aligned as well as the stride
+	void Write(const uint32_t* a_Indices, size_t ui_Count, void* p_Dst, size_t ui_Stride, TransformOutput e_Output) const;
+
+	const Output& GetOutput(uint32_t index) const { return m_Outputs[index]; }
+
+protected:
+	void UpdateRange(const uint32_t* a_Indices, size_t ui_Count);
+	void WriteRange(const uint32_t* a_Indices, size_t ui_Count, size_t ui_FirstOutput, unsigned char* p_Dst, size_t ui_Stride, TransformOutput e_Output) const;
+
+	uint32_t m_Count = 0;
+
+	// Component (row, column) of the transposed worlds, padded to a multiple of 4 objects
+	std::vector<float> m_Rows[3][4];
+
+	std::vector<Output> m_Outputs;
+};
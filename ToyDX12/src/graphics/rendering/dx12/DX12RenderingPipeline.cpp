@@ -14,6 +14,9 @@ ComPtr<ID3D12Fence>					DX12RenderingPipeline::s_Fence;
 ComPtr<ID3D12GraphicsCommandList>	DX12RenderingPipeline::s_CommandList;
 ComPtr<ID3D12CommandQueue>			DX12RenderingPipeline::s_CommandQueue;
 ComPtr<ID3D12CommandAllocator>		DX12RenderingPipeline::s_CmdAllocator;
+std::unique_ptr<ToyDX::GpuHeapAllocator>	DX12RenderingPipeline::s_HeapAllocator;
+std::unique_ptr<ToyDX::UploadManager>	DX12RenderingPipeline::s_UploadManager;
+std::unique_ptr<ToyDX::PipelineStateCache>	DX12RenderingPipeline::s_PipelineStateCache;
 DXGI_SAMPLE_DESC					DX12RenderingPipeline::s_SampleDesc;
 
 UINT								DX12RenderingPipeline::CBV_SRV_UAV_Size;
@@ -38,6 +41,10 @@ void DX12RenderingPipeline::Init(const Win32Window& p_Window)
 	CreateCommandObjects();
 	CreateFence();
 
+	s_HeapAllocator = std::make_unique<ToyDX::GpuHeapAllocator>(&s_TDXDevice->GetDevice());
+	s_PipelineStateCache = std::make_unique<ToyDX::PipelineStateCache>(&s_TDXDevice->GetDevice());
+	s_UploadManager = std::make_unique<ToyDX::UploadManager>(&s_TDXDevice->GetDevice(), s_CommandQueue.Get());
+
 	// Create descriptors for the render targets in the swapchain and for the depth-stencil
 	mp_RTVDescriptorHeap = CreateDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_RTV, s_NumSwapChainBuffers);
 	mp_DSVDescriptorHeap = CreateDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_DSV, 1);
@@ -376,7 +383,7 @@ ID3D12Resource* DX12RenderingPipeline::GetDepthStencil() const
 
 //*********************************************************
 
-ComPtr<ID3D12Resource> DX12RenderingPipeline::CreateDefaultBuffer(const void* pData, UINT64 ui64_SizeInBytes, Microsoft::WRL::ComPtr<ID3D12Resource>& p_UploadBuffer, D3D12_RESOURCE_STATES e_ResourceState)
+ComPtr<ID3D12Resource> DX12RenderingPipeline::CreateDefaultBuffer(const void* pData, UINT64 ui64_SizeInBytes)
 {
 	// To create a buffer in the Default Heap that can only be accessed by the GPU
 	// We first need to store the data into an Upload Buffer in the Upload Heap accessible by the CPU
@@ -386,43 +393,12 @@ ComPtr<ID3D12Resource> DX12RenderingPipeline::CreateDefaultBuffer(const void* pD
 	//	Default Buffer Resource creation
 	//*********************************************************
 
-	ComPtr<ID3D12Resource> p_DefaultBuffer;
-	CD3DX12_HEAP_PROPERTIES defaultHeapProperty = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
-	CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(ui64_SizeInBytes);
-	ThrowIfFailed(DX12RenderingPipeline::GetDevice()->CreateCommittedResource(
-		&defaultHeapProperty, D3D12_HEAP_FLAG_NONE, &bufferDesc,
-		D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(p_DefaultBuffer.GetAddressOf())));
-
-	//*********************************************************
-	//	Upload Buffer Resource creation 
-	//*********************************************************
-	CD3DX12_HEAP_PROPERTIES uploadHeapProperty = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-	
-	ThrowIfFailed(DX12RenderingPipeline::GetDevice()->CreateCommittedResource(
-		&uploadHeapProperty, D3D12_HEAP_FLAG_NONE, &bufferDesc,
-		D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(p_UploadBuffer.GetAddressOf())));
-
-	//**************************************************************
-	//	Description of the data to be copied into the default buffer 
-	//**************************************************************
-
-	D3D12_SUBRESOURCE_DATA subResourceDataDesc = {};
-	subResourceDataDesc.pData = pData;
-	subResourceDataDesc.RowPitch = ui64_SizeInBytes;
-	subResourceDataDesc.RowPitch = ui64_SizeInBytes;
-
-	//	Schedule the copy to the default buffer, by using the upload buffer as an intermediate buffer
-	UpdateSubresources<1>(&DX12RenderingPipeline::GetCommandList(), p_DefaultBuffer.Get(), p_UploadBuffer.Get(), 0, 0, 1, &subResourceDataDesc);
+	// Created in the COMMON state : buffers are promoted to the state of their first use (vertex, index...) without a barrier
+	ComPtr<ID3D12Resource> p_DefaultBuffer = s_HeapAllocator->CreateBuffer(ui64_SizeInBytes, D3D12_RESOURCE_STATE_COMMON);
 
-	CD3DX12_RESOURCE_BARRIER barriers[1] =
-	{
-		CD3DX12_RESOURCE_BARRIER::Transition(p_DefaultBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, e_ResourceState)
-	};
-
-	DX12RenderingPipeline::GetCommandList().ResourceBarrier(_countof(barriers), barriers);
+	//	Schedule the copy to the default buffer on the copy queue, the staging memory is reclaimed once the copy is executed
+	s_UploadManager->UploadToBuffer(p_DefaultBuffer.Get(), pData, ui64_SizeInBytes);
 
-	// The upload buffer has to be kept alive at least until the UpdateSubresources command is executed in the command queue
-	// After that, the Upload buffer can be safely released
 	return p_DefaultBuffer;
 }
 
@@ -506,31 +482,29 @@ ComPtr<ID3D12PipelineState> DX12RenderingPipeline::CreatePipelineStateObject(
 	//.DSVFormat = e_DsvFormat,
 	//.SampleDesc = st_SampleDesc
 
-	ComPtr<ID3D12PipelineState> pso;
-	ThrowIfFailed(DX12RenderingPipeline::GetDevice()->CreateGraphicsPipelineState(&pipelineStateDesc, IID_PPV_ARGS(pso.GetAddressOf())));
-
-	return pso;
+	// Same description as an earlier request : same object, otherwise loaded from the pipeline library or compiled
+	return s_PipelineStateCache->GetGraphicsPipeline(pipelineStateDesc);
 }
 
-void DX12RenderingPipeline::CreateTexture2D(UINT64 ui_Width, UINT ui_Height, UINT ui_Channels, DXGI_FORMAT e_Format, unsigned char* data, ComPtr<ID3D12Resource>& m_texture, ComPtr<ID3D12Resource>& textureUploadHeap, const std::wstring& debugName)
+void DX12RenderingPipeline::CreateTexture2D(UINT64 ui_Width, UINT ui_Height, UINT ui_Channels, DXGI_FORMAT e_Format, unsigned char* data, ComPtr<ID3D12Resource>& m_texture, const std::wstring& debugName)
 {
-	// Note: ComPtr's are CPU objects but this resource needs to stay in scope until
-	// the command list that references it has finished executing on the GPU.
-	// We will flush the GPU at the end of this method to ensure the resource is not
-	// prematurely destroyed.
+	D3D12_SUBRESOURCE_DATA textureData = {};
+	textureData.pData = &data[0];
+	textureData.RowPitch = ui_Width * ui_Channels;
+	textureData.SlicePitch = textureData.RowPitch * ui_Height;
 
+	CreateTexture2D(ui_Width, ui_Height, 1, e_Format, &textureData, m_texture, debugName);
+}
 
-	ID3D12Device* p_Device = DX12RenderingPipeline::GetDevice();
-	ID3D12GraphicsCommandList* p_CmdList = &DX12RenderingPipeline::GetCommandList();
-	ID3D12CommandQueue* p_CmdQueue = &DX12RenderingPipeline::GetCommandQueue();
-	ID3D12CommandAllocator* p_CmdAlloc = &DX12RenderingPipeline::GetCommandAllocator();
-	ThrowIfFailed(p_CmdList->Reset(p_CmdAlloc, nullptr));
+void DX12RenderingPipeline::CreateTexture2D(UINT64 ui_Width, UINT ui_Height, UINT16 ui_MipLevels, DXGI_FORMAT e_Format, const D3D12_SUBRESOURCE_DATA* a_Subresources, ComPtr<ID3D12Resource>& m_texture, const std::wstring& debugName)
+{
+	// The copy is recorded in the current batch of the upload manager, the texels go through its staging ring
 
 	// Create the texture.
 	{
 		// Describe and create a Texture2D.
 		D3D12_RESOURCE_DESC textureDesc = {};
-		textureDesc.MipLevels = 1;
+		textureDesc.MipLevels = ui_MipLevels;
 		textureDesc.Format = e_Format;
 		textureDesc.Width = ui_Width;
 		textureDesc.Height = ui_Height;
@@ -540,50 +514,24 @@ void DX12RenderingPipeline::CreateTexture2D(UINT64 ui_Width, UINT ui_Height, UIN
 		textureDesc.SampleDesc.Quality = 0;
 		textureDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
 
-		CD3DX12_HEAP_PROPERTIES defaultHeap = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+		// The range of a texture being replaced is reused right away : the GPU must be done with it
+		// Textures the frames in flight may still sample are released with GpuHeapAllocator::FreeDeferred before
+		if (m_texture != nullptr)
+		{
+			s_HeapAllocator->Free(m_texture.Get());
+			m_texture.Reset();
+		}
 
-		ThrowIfFailed(p_Device->CreateCommittedResource(
-			&defaultHeap,
-			D3D12_HEAP_FLAG_NONE,
-			&textureDesc,
-			D3D12_RESOURCE_STATE_COPY_DEST,
-			nullptr,
-			IID_PPV_ARGS(&m_texture)));
+		// COMMON : promoted to COPY_DEST on the copy queue, then to PIXEL_SHADER_RESOURCE when first sampled on the direct queue
+		m_texture = s_HeapAllocator->CreateResource(textureDesc, D3D12_RESOURCE_STATE_COMMON);
 
 		m_texture->SetName(debugName.c_str());
 
-		const UINT64 uploadBufferSize = GetRequiredIntermediateSize(m_texture.Get(), 0, 1);
-
-		CD3DX12_HEAP_PROPERTIES uploadHeap = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-		CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize);
-		// Create the GPU upload buffer.
-		ThrowIfFailed(p_Device->CreateCommittedResource(
-			&uploadHeap,
-			D3D12_HEAP_FLAG_NONE,
-			&bufferDesc,
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(&textureUploadHeap)));
-
-		// Copy data to the intermediate upload heap and then schedule a copy 
-		// from the upload heap to the Texture2D.
-		D3D12_SUBRESOURCE_DATA textureData = {};
-		textureData.pData = &data[0];
-		textureData.RowPitch = ui_Width * ui_Channels;
-		textureData.SlicePitch = textureData.RowPitch * ui_Height;
-
-		CD3DX12_RESOURCE_BARRIER transitionBarrier = CD3DX12_RESOURCE_BARRIER::Transition(m_texture.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-		UpdateSubresources(p_CmdList, m_texture.Get(), textureUploadHeap.Get(), 0, 0, 1, &textureData);
-		p_CmdList->ResourceBarrier(1, &transitionBarrier);
+		// Copy data to the staging ring and then schedule a copy 
+		// from the staging ring to the Texture2D.
+		// Row pitches of block compressed formats count rows of 4x4 blocks, UpdateSubresources takes care of the layout
+		s_UploadManager->UploadToTexture(m_texture.Get(), ui_MipLevels, a_Subresources);
 	}
-
-	// Close the command list and execute it to begin the initial GPU setup.
-	ThrowIfFailed(p_CmdList->Close());
-	ID3D12CommandList* ppCommandLists[] = { p_CmdList };
-	p_CmdQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
-
-	FlushCommandQueue();
-
 }
 //*********************************************************
 
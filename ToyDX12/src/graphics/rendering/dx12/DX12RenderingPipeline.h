@@ -4,6 +4,9 @@
 #include "DX12Device.h"
 #include "DX12CachedValues.h"
 #include "ToyDXResource.h"
+#include "UploadManager.h"
+#include "GpuHeapAllocator.h"
+#include "PipelineStateCache.h"
 #include "Window.h"
 
 class DX12RenderingPipeline : public IPipeline
@@ -35,6 +38,9 @@ public:
 	static ID3D12GraphicsCommandList& GetCommandList() { return *s_CommandList.Get(); };
 	static ID3D12CommandAllocator& GetCommandAllocator() { return *s_CmdAllocator.Get(); };
 	static ID3D12CommandQueue& GetCommandQueue() { return *s_CommandQueue.Get(); };
+	static ToyDX::UploadManager& GetUploadManager() { return *s_UploadManager; };
+	static ToyDX::GpuHeapAllocator& GetHeapAllocator() { return *s_HeapAllocator; };
+	static ToyDX::PipelineStateCache& GetPipelineStateCache() { return *s_PipelineStateCache; };
 	D3D12_VIEWPORT& GetViewport() { return m_Viewport; };
 	D3D12_RECT& GetScissorRect() { return m_ScissorRect; };
 
@@ -55,13 +61,14 @@ public:
 	D3D12_CLEAR_VALUE RTClearValues;
 
 
-	// Creates a default buffer in the GPU default heap by using an upload buffer as an intermediate CPU accessible buffer
-	static ComPtr<ID3D12Resource> CreateDefaultBuffer(const void* pData, UINT64 ui64_SizeInBytes, Microsoft::WRL::ComPtr<ID3D12Resource>& p_UploadBuffer, D3D12_RESOURCE_STATES e_ResourceState);
+	// Creates a default buffer placed in a page of the heap allocator, the data goes through the staging ring of the upload manager
+	// The copy is recorded in the current batch of the upload manager : the buffer can be used once the batch is submitted
+	static ComPtr<ID3D12Resource> CreateDefaultBuffer(const void* pData, UINT64 ui64_SizeInBytes);
 	static D3D12_VERTEX_BUFFER_VIEW CreateVertexBufferView(Microsoft::WRL::ComPtr<ID3D12Resource>& p_VertexBufferGPU, UINT64 ui_SizeInBytes, UINT64 ui_StrideInBytes);
 	static D3D12_INDEX_BUFFER_VIEW CreateIndexBufferView(Microsoft::WRL::ComPtr<ID3D12Resource>& p_IndexBufferGPU, UINT ui_SizeInBytes, DXGI_FORMAT e_Format = DXGI_FORMAT_R16_UINT);
 	static void CreateConstantBufferView(ID3D12DescriptorHeap* st_CbvHeap, D3D12_GPU_VIRTUAL_ADDRESS ui64_CbvAddress, UINT ui_SizeInBytes);
 
-	// Pipeline state object
+	// Pipeline state object, from the pipeline state cache : the root signature must be registered to it
 	static ComPtr<ID3D12PipelineState> CreatePipelineStateObject(
 		ID3D12RootSignature* p_RootSignature,
 		ID3DBlob* st_VsByteCode,
@@ -86,6 +93,15 @@ public:
 	static ComPtr<ID3D12GraphicsCommandList> s_CommandList;
 	static ComPtr<ID3D12CommandAllocator> s_CmdAllocator;
 
+	// Default heap memory of static resources, placed resources in large heaps
+	static std::unique_ptr<ToyDX::GpuHeapAllocator> s_HeapAllocator;
+
+	// Pipeline states by description, stored on disk between launches
+	static std::unique_ptr<ToyDX::PipelineStateCache> s_PipelineStateCache;
+
+	// Uploads of static resources, on a copy queue the command queue waits for
+	static std::unique_ptr<ToyDX::UploadManager> s_UploadManager;
+
 	// Descriptor heaps
 	ComPtr<ID3D12DescriptorHeap> mp_RTVDescriptorHeap;
 	ComPtr<ID3D12DescriptorHeap> mp_DSVDescriptorHeap;
@@ -100,7 +116,11 @@ public:
 	ComPtr<ID3D12Resource> mp_SwapChainBuffers[s_NumSwapChainBuffers];
 	CD3DX12_CPU_DESCRIPTOR_HANDLE m_SwapChainRTViews[s_NumSwapChainBuffers];
 
-	static void CreateTexture2D(UINT64 ui_Width, UINT ui_Height, UINT ui_Channels, DXGI_FORMAT e_Format, unsigned char* data, ComPtr<ID3D12Resource>& textureResource, ComPtr<ID3D12Resource>& uploadBuffer, const std::wstring& debugName);
+	// Textures are placed and uploaded like default buffers, through the current batch of the upload manager
+	// An existing textureResource is freed first : the GPU must be done with it
+	static void CreateTexture2D(UINT64 ui_Width, UINT ui_Height, UINT ui_Channels, DXGI_FORMAT e_Format, unsigned char* data, ComPtr<ID3D12Resource>& textureResource, const std::wstring& debugName);
+	// Creates a texture from pre-laid out subresources (one per mip level), e.g block compressed texels
+	static void CreateTexture2D(UINT64 ui_Width, UINT ui_Height, UINT16 ui_MipLevels, DXGI_FORMAT e_Format, const D3D12_SUBRESOURCE_DATA* a_Subresources, ComPtr<ID3D12Resource>& textureResource, const std::wstring& debugName);
 		
 	int  m_iCurrentBackBuffer = 0;
 	bool m_bUse4xMsaa = false;
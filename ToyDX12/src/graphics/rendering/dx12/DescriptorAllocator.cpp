@@ -0,0 +1,120 @@
+#include "pch.h"
+
+#include "DescriptorAllocator.h"
+
+ToyDX::DescriptorAllocator::DescriptorAllocator(ID3D12Device* p_Device, D3D12_DESCRIPTOR_HEAP_TYPE e_Type, UINT ui_PersistentCapacity, UINT ui_TransientCapacityPerFrame, UINT ui_NumFrames)
+	: m_Device(p_Device), m_Type(e_Type), m_PersistentCapacity(ui_PersistentCapacity), m_Persistent(ui_PersistentCapacity),
+	  m_TransientCapacityPerFrame(ui_TransientCapacityPerFrame), m_NumFrames(ui_NumFrames)
+{
+	m_DescriptorSize = m_Device->GetDescriptorHandleIncrementSize(m_Type);
+
+	D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+	heapDesc.Type = m_Type;
+	heapDesc.NumDescriptors = m_PersistentCapacity + m_TransientCapacityPerFrame * m_NumFrames;
+	heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+	heapDesc.NodeMask = 0;
+
+	ThrowIfFailed(m_Device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(m_Heap.GetAddressOf())));
+	m_Heap->SetName(L"Shader Visible Descriptor Heap");
+
+	heapDesc.NumDescriptors = m_PersistentCapacity;
+	heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+
+	ThrowIfFailed(m_Device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(m_StagingHeap.GetAddressOf())));
+	m_StagingHeap->SetName(L"Staging Descriptor Heap");
+
+	m_TransientBase = m_PersistentCapacity;
+
+	LOG_INFO("DescriptorAllocator: {0} persistent descriptors, {1} transient descriptors per frame ({2} frames).", m_PersistentCapacity, m_TransientCapacityPerFrame, m_NumFrames);
+}
+
+ToyDX::DescriptorRange ToyDX::DescriptorAllocator::AllocatePersistent(UINT ui_Count)
+{
+	DescriptorRange range;
+
+	TlsfAllocator::Allocation allocation;
+	if (!m_Persistent.Allocate(ui_Count, 1, allocation))
+	{
+		LOG_ERROR("DescriptorAllocator: No room for {0} persistent descriptors ({1} of {2} used).", ui_Count, m_Persistent.GetAllocatedSize(), m_PersistentCapacity);
+		return range;
+	}
+
+	range.Index = (UINT)allocation.Offset;
+	range.Count = ui_Count;
+	range.Block = allocation.Block;
+
+	return range;
+}
+
+void ToyDX::DescriptorAllocator::FreePersistent(DescriptorRange& r_Range)
+{
+	if (!r_Range.IsValid())
+	{
+		return;
+	}
+
+	// Frames recorded up to now may still reference the descriptors
+	m_PendingFrees.push_back({ m_FrameSerial, r_Range.Block });
+
+	r_Range = DescriptorRange();
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE ToyDX::DescriptorAllocator::GetStagingHandle(UINT ui_Index) const
+{
+	assert(ui_Index < m_PersistentCapacity);
+	return CD3DX12_CPU_DESCRIPTOR_HANDLE(m_StagingHeap->GetCPUDescriptorHandleForHeapStart(), ui_Index, m_DescriptorSize);
+}
+
+void ToyDX::DescriptorAllocator::Commit(UINT ui_Index, UINT ui_Count)
+{
+	assert(ui_Index + ui_Count <= m_PersistentCapacity);
+
+	CD3DX12_CPU_DESCRIPTOR_HANDLE destination(m_Heap->GetCPUDescriptorHandleForHeapStart(), ui_Index, m_DescriptorSize);
+	m_Device->CopyDescriptorsSimple(ui_Count, destination, GetStagingHandle(ui_Index), m_Type);
+}
+
+void ToyDX::DescriptorAllocator::BeginFrame(UINT ui_FrameIndex)
+{
+	assert(ui_FrameIndex < m_NumFrames);
+
+	m_FrameSerial++;
+
+	m_TransientBase = m_PersistentCapacity + ui_FrameIndex * m_TransientCapacityPerFrame;
+	m_TransientHead = 0;
+
+	RetirePendingFrees();
+}
+
+UINT ToyDX::DescriptorAllocator::CopyToTransient(UINT ui_NumDescriptors, const D3D12_CPU_DESCRIPTOR_HANDLE* a_StagingDescriptors)
+{
+	if (m_TransientHead + ui_NumDescriptors > m_TransientCapacityPerFrame)
+	{
+		LOG_ERROR("DescriptorAllocator: Transient region of the frame is full ({0} descriptors).", m_TransientCapacityPerFrame);
+		assert(false);
+		return DescriptorRange::InvalidIndex;
+	}
+
+	const UINT index = m_TransientBase + m_TransientHead;
+	m_TransientHead += ui_NumDescriptors;
+
+	// One contiguous destination range, gathered from scattered staging descriptors
+	CD3DX12_CPU_DESCRIPTOR_HANDLE destination(m_Heap->GetCPUDescriptorHandleForHeapStart(), index, m_DescriptorSize);
+	m_Device->CopyDescriptors(1, &destination, &ui_NumDescriptors, ui_NumDescriptors, a_StagingDescriptors, nullptr, m_Type);
+
+	return index;
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE ToyDX::DescriptorAllocator::GetGpuHandle(UINT ui_Index) const
+{
+	return CD3DX12_GPU_DESCRIPTOR_HANDLE(m_Heap->GetGPUDescriptorHandleForHeapStart(), ui_Index, m_DescriptorSize);
+}
+
+void ToyDX::DescriptorAllocator::RetirePendingFrees()
+{
+	// BeginFrame is called once the frame resource is free : every frame begun m_NumFrames frames ago or before is done on the GPU
+	while (!m_PendingFrees.empty() && m_PendingFrees.front().FrameSerial + m_NumFrames <= m_FrameSerial)
+	{
+		m_Persistent.Free(m_PendingFrees.front().Block);
+		m_PendingFrees.pop_front();
+	}
+}
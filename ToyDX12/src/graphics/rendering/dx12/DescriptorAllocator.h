@@ -0,0 +1,89 @@
+#pragma once
+
+#include <wrl/client.h>
+#include <deque>
+
+#include "d3d12.h"
+#include "TlsfAllocator.h"
+
+namespace ToyDX
+{
+	// Contiguous descriptors of a DescriptorAllocator, by index in its heaps
+	struct DescriptorRange
+	{
+		static const UINT InvalidIndex = UINT_MAX;
+
+		UINT Index = InvalidIndex;
+		UINT Count = 0;
+		TlsfAllocator::Handle Block = TlsfAllocator::InvalidHandle;
+
+		bool IsValid() const { return Index != InvalidIndex; }
+	};
+
+	// Descriptors of a shader visible heap, split in two regions :
+	// - Persistent : ranges allocated and freed at any time, freed ranges are reused (and merged with their free neighbours).
+	//   Views are written to a non shader visible staging heap at the same indices, then committed to the shader visible heap.
+	//   A freed range is only reused once the frames in flight that may reference it are done
+	// - Transient : a linear region per frame resource, reset by BeginFrame, where per frame tables are gathered from the staging heap with CopyDescriptors
+	// The shader visible heap is write only for the CPU : descriptors are always created in the staging heap and copied
+	// Not thread safe
+	class DescriptorAllocator
+	{
+	public:
+		DescriptorAllocator(ID3D12Device* p_Device, D3D12_DESCRIPTOR_HEAP_TYPE e_Type, UINT ui_PersistentCapacity, UINT ui_TransientCapacityPerFrame, UINT ui_NumFrames);
+		DescriptorAllocator(const DescriptorAllocator&) = delete;
+		DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+
+		// Returns an invalid range when the persistent region is full
+		DescriptorRange AllocatePersistent(UINT ui_Count = 1);
+		void FreePersistent(DescriptorRange& r_Range);
+
+		// Where views of the persistent region are created
+		D3D12_CPU_DESCRIPTOR_HANDLE GetStagingHandle(UINT ui_Index) const;
+
+		// Copies staging descriptors to the shader visible heap : the GPU must not be using the previous ones
+		void Commit(UINT ui_Index, UINT ui_Count = 1);
+		void Commit(const DescriptorRange& range) { Commit(range.Index, range.Count); }
+
+		// Starts the transient region of a frame resource, once the GPU is done with its previous frame
+		void BeginFrame(UINT ui_FrameIndex);
+
+		// Gathers staging descriptors into a table of the transient region of the current frame, returns the index of the table
+		UINT CopyToTransient(UINT ui_NumDescriptors, const D3D12_CPU_DESCRIPTOR_HANDLE* a_StagingDescriptors);
+
+		D3D12_GPU_DESCRIPTOR_HANDLE GetGpuHandle(UINT ui_Index) const;
+		ID3D12DescriptorHeap* GetHeap() const { return m_Heap.Get(); }
+
+		UINT GetPersistentCapacity() const { return m_PersistentCapacity; }
+		UINT GetTransientCapacityPerFrame() const { return m_TransientCapacityPerFrame; }
+		UINT GetTransientUsed() const { return m_TransientHead; }
+		TlsfStats GetPersistentStats() const { return m_Persistent.GetStats(); }
+
+	protected:
+		struct PendingFree
+		{
+			UINT64 FrameSerial = 0;
+			TlsfAllocator::Handle Block = TlsfAllocator::InvalidHandle;
+		};
+
+		void RetirePendingFrees();
+
+		ID3D12Device* m_Device = nullptr;
+		D3D12_DESCRIPTOR_HEAP_TYPE m_Type;
+		UINT m_DescriptorSize = 0;
+
+		Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_Heap;			// Shader visible : persistent region, then one transient region per frame
+		Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_StagingHeap;	// Same indices as the persistent region
+
+		UINT m_PersistentCapacity = 0;
+		TlsfAllocator m_Persistent;
+		std::deque<PendingFree> m_PendingFrees;	// By increasing frame serial
+
+		UINT m_TransientCapacityPerFrame = 0;
+		UINT m_NumFrames = 0;
+		UINT m_TransientBase = 0;	// Of the current frame
+		UINT m_TransientHead = 0;
+
+		UINT64 m_FrameSerial = 0;	// Frames begun so far
+	};
+}
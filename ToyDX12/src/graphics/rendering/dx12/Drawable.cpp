@@ -28,6 +28,8 @@ namespace ToyDX
 		WorldMatrix = &primitive->WorldMatrix;
 		StartIndexLocation = primitive->StartIndexLocation;
 		BaseVertexLocation = primitive->BaseVertexLocation;
+		LocalBounds = primitive->Bounds;
+		UvDensity = primitive->UvDensity;
 	}
 }
 
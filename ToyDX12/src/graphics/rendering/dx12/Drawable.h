@@ -21,15 +21,24 @@ namespace ToyDX
 
 		DirectX::XMMATRIX& GetWorld() { return *WorldMatrix; }
 
+		// Object space bounds of the primitive and its UV density (UV units per object space unit)
+		AABB LocalBounds;
+		float UvDensity = 0.0f;
+
+		AABB GetWorldBounds() { return LocalBounds.Transform(GetWorld()); }
+
 		Mesh* Mesh = nullptr;
 
+		// Index of the mesh in the renderer, used to group the draws sharing vertex/index buffers
+		uint32_t MeshId = 0;
+
+		// Index of the index range drawn, shared by the drawables drawing the same part of the same mesh : they can be instanced
+		uint32_t GeometryId = 0;
+
 		Material* material = nullptr;
 		
 		bool HasSubMeshes = false;
 
-		// Number of frame resources that need an update, initially : all frame resources
-		unsigned int NumFramesDirty = DefaultNumFrameResources;
-
 		// Index in GPU constant buffer of the corresponding per object CB for this drawable
 		size_t PerObjectCbIndex = -1;
 
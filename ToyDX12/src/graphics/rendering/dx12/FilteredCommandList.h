@@ -0,0 +1,341 @@
+#pragma once
+
+#include "d3d12.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace ToyDX
+{
+	struct CommandListStats
+	{
+		uint32_t NumIssued = 0;		// State calls forwarded to the command list
+		uint32_t NumElided = 0;		// State calls dropped because they would set what is already bound
+		uint32_t NumDraws = 0;
+
+		CommandListStats& operator+=(const CommandListStats& other)
+		{
+			NumIssued += other.NumIssued;
+			NumElided += other.NumElided;
+			NumDraws  += other.NumDraws;
+			return *this;
+		}
+	};
+
+	// Thin layer over a graphics command list that shadows the bound state and drops the calls that wouldn't change it
+	// - Only the calls made through this layer are known : call Invalidate() after using the command list directly
+	// - Changing the root signature unbinds every root argument, changing the descriptor heaps every descriptor table
+	// Templated on the command list so that it can record into a mock exposing the same methods
+	template <typename CommandList = ID3D12GraphicsCommandList>
+	class FilteredCommandList
+	{
+	public:
+		explicit FilteredCommandList(CommandList& r_CmdList) : m_CmdList(r_CmdList) {}
+
+		CommandList& Get() { return m_CmdList; }
+		const CommandListStats& GetStats() const { return m_Stats; }
+
+		// Forgets the bound state, e.g. after the command list was reset
+		void Invalidate()
+		{
+			m_PipelineState = nullptr;
+			m_RootSignature = nullptr;
+			m_NumDescriptorHeaps = 0;
+			m_Topology = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+			m_bIndexBufferValid = false;
+
+			for (bool& bValid : m_VertexBufferValid)
+			{
+				bValid = false;
+			}
+
+			InvalidateRootArguments();
+		}
+
+		void SetPipelineState(ID3D12PipelineState* p_PipelineState)
+		{
+			if (Filter(p_PipelineState == m_PipelineState))
+			{
+				return;
+			}
+
+			m_PipelineState = p_PipelineState;
+			m_CmdList.SetPipelineState(p_PipelineState);
+		}
+
+		void SetGraphicsRootSignature(ID3D12RootSignature* p_RootSignature)
+		{
+			if (Filter(p_RootSignature == m_RootSignature))
+			{
+				return;
+			}
+
+			m_RootSignature = p_RootSignature;
+			InvalidateRootArguments();
+			m_CmdList.SetGraphicsRootSignature(p_RootSignature);
+		}
+
+		void SetDescriptorHeaps(UINT ui_NumHeaps, ID3D12DescriptorHeap* const* a_Heaps)
+		{
+			bool bSame = ui_NumHeaps == m_NumDescriptorHeaps;
+			for (UINT i = 0; i < ui_NumHeaps && bSame; ++i)
+			{
+				bSame = a_Heaps[i] == m_DescriptorHeaps[i];
+			}
+
+			if (Filter(bSame))
+			{
+				return;
+			}
+
+			m_NumDescriptorHeaps = ui_NumHeaps <= MaxDescriptorHeaps ? ui_NumHeaps : 0;
+			for (UINT i = 0; i < m_NumDescriptorHeaps; ++i)
+			{
+				m_DescriptorHeaps[i] = a_Heaps[i];
+			}
+
+			for (RootArgument& argument : m_RootArguments)
+			{
+				if (argument.Type == RootArgumentType::DescriptorTable)
+				{
+					argument.Type = RootArgumentType::None;
+				}
+			}
+
+			m_CmdList.SetDescriptorHeaps(ui_NumHeaps, a_Heaps);
+		}
+
+		void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY e_Topology)
+		{
+			if (Filter(e_Topology == m_Topology))
+			{
+				return;
+			}
+
+			m_Topology = e_Topology;
+			m_CmdList.IASetPrimitiveTopology(e_Topology);
+		}
+
+		void IASetVertexBuffers(UINT ui_StartSlot, UINT ui_NumViews, const D3D12_VERTEX_BUFFER_VIEW* a_Views)
+		{
+			bool bSame = a_Views != nullptr && ui_StartSlot + ui_NumViews <= MaxVertexBuffers;
+			for (UINT i = 0; i < ui_NumViews && bSame; ++i)
+			{
+				const UINT slot = ui_StartSlot + i;
+				bSame = m_VertexBufferValid[slot] && memcmp(&m_VertexBuffers[slot], &a_Views[i], sizeof(D3D12_VERTEX_BUFFER_VIEW)) == 0;
+			}
+
+			if (Filter(bSame))
+			{
+				return;
+			}
+
+			for (UINT i = 0; i < ui_NumViews && ui_StartSlot + i < MaxVertexBuffers; ++i)
+			{
+				const UINT slot = ui_StartSlot + i;
+				m_VertexBufferValid[slot] = a_Views != nullptr;
+
+				if (a_Views != nullptr)
+				{
+					m_VertexBuffers[slot] = a_Views[i];
+				}
+			}
+
+			m_CmdList.IASetVertexBuffers(ui_StartSlot, ui_NumViews, a_Views);
+		}
+
+		void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* p_View)
+		{
+			const bool bSame = p_View != nullptr && m_bIndexBufferValid && memcmp(&m_IndexBuffer, p_View, sizeof(D3D12_INDEX_BUFFER_VIEW)) == 0;
+
+			if (Filter(bSame))
+			{
+				return;
+			}
+
+			m_bIndexBufferValid = p_View != nullptr;
+			if (p_View != nullptr)
+			{
+				m_IndexBuffer = *p_View;
+			}
+
+			m_CmdList.IASetIndexBuffer(p_View);
+		}
+
+		void SetGraphicsRootDescriptorTable(UINT ui_RootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor)
+		{
+			if (Filter(SetRootArgument(ui_RootParameterIndex, RootArgumentType::DescriptorTable, baseDescriptor.ptr)))
+			{
+				return;
+			}
+
+			m_CmdList.SetGraphicsRootDescriptorTable(ui_RootParameterIndex, baseDescriptor);
+		}
+
+		void SetGraphicsRootConstantBufferView(UINT ui_RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+		{
+			if (Filter(SetRootArgument(ui_RootParameterIndex, RootArgumentType::ConstantBufferView, bufferLocation)))
+			{
+				return;
+			}
+
+			m_CmdList.SetGraphicsRootConstantBufferView(ui_RootParameterIndex, bufferLocation);
+		}
+
+		void SetGraphicsRootShaderResourceView(UINT ui_RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+		{
+			if (Filter(SetRootArgument(ui_RootParameterIndex, RootArgumentType::ShaderResourceView, bufferLocation)))
+			{
+				return;
+			}
+
+			m_CmdList.SetGraphicsRootShaderResourceView(ui_RootParameterIndex, bufferLocation);
+		}
+
+		void SetGraphicsRoot32BitConstants(UINT ui_RootParameterIndex, UINT ui_Num32BitValues, const void* p_Data, UINT ui_DestOffsetIn32BitValues)
+		{
+			bool bSame = false;
+
+			if (ui_RootParameterIndex < MaxRootParameters && ui_DestOffsetIn32BitValues + ui_Num32BitValues <= MaxRootConstants)
+			{
+				RootArgument& argument = m_RootArguments[ui_RootParameterIndex];
+
+				if (argument.Type != RootArgumentType::Constants)
+				{
+					argument.Type = RootArgumentType::Constants;
+					argument.ConstantsMask = 0;
+				}
+
+				// Every value written must already be bound with the same content
+				const uint32_t writtenMask = ((ui_Num32BitValues == 32 ? 0u : (1u << ui_Num32BitValues)) - 1) << ui_DestOffsetIn32BitValues;
+				bSame = (argument.ConstantsMask & writtenMask) == writtenMask && memcmp(&argument.Constants[ui_DestOffsetIn32BitValues], p_Data, ui_Num32BitValues * sizeof(uint32_t)) == 0;
+
+				memcpy(&argument.Constants[ui_DestOffsetIn32BitValues], p_Data, ui_Num32BitValues * sizeof(uint32_t));
+				argument.ConstantsMask |= writtenMask;
+			}
+			else if (ui_RootParameterIndex < MaxRootParameters)
+			{
+				m_RootArguments[ui_RootParameterIndex].Type = RootArgumentType::None;
+			}
+
+			if (Filter(bSame))
+			{
+				return;
+			}
+
+			m_CmdList.SetGraphicsRoot32BitConstants(ui_RootParameterIndex, ui_Num32BitValues, p_Data, ui_DestOffsetIn32BitValues);
+		}
+
+		void DrawIndexedInstanced(UINT ui_IndexCountPerInstance, UINT ui_InstanceCount, UINT ui_StartIndexLocation, INT i_BaseVertexLocation, UINT ui_StartInstanceLocation)
+		{
+			m_Stats.NumDraws++;
+			m_CmdList.DrawIndexedInstanced(ui_IndexCountPerInstance, ui_InstanceCount, ui_StartIndexLocation, i_BaseVertexLocation, ui_StartInstanceLocation);
+		}
+
+		// The commands may change the input assembler state and root arguments : they are all assumed unknown afterwards
+		void ExecuteIndirect(ID3D12CommandSignature* p_CommandSignature, UINT ui_MaxCommandCount, ID3D12Resource* p_ArgumentBuffer, UINT64 ui64_ArgumentBufferOffset, ID3D12Resource* p_CountBuffer, UINT64 ui64_CountBufferOffset)
+		{
+			m_Stats.NumDraws++;
+			m_CmdList.ExecuteIndirect(p_CommandSignature, ui_MaxCommandCount, p_ArgumentBuffer, ui64_ArgumentBufferOffset, p_CountBuffer, ui64_CountBufferOffset);
+
+			m_bIndexBufferValid = false;
+			for (bool& bValid : m_VertexBufferValid)
+			{
+				bValid = false;
+			}
+
+			InvalidateRootArguments();
+		}
+
+		void DrawInstanced(UINT ui_VertexCountPerInstance, UINT ui_InstanceCount, UINT ui_StartVertexLocation, UINT ui_StartInstanceLocation)
+		{
+			m_Stats.NumDraws++;
+			m_CmdList.DrawInstanced(ui_VertexCountPerInstance, ui_InstanceCount, ui_StartVertexLocation, ui_StartInstanceLocation);
+		}
+
+	protected:
+		enum class RootArgumentType : uint8_t
+		{
+			None,
+			DescriptorTable,
+			ConstantBufferView,
+			ShaderResourceView,
+			Constants
+		};
+
+		// A root signature holds at most 64 DWORDs
+		static const UINT MaxRootParameters = 64;
+		static const UINT MaxRootConstants = 32;
+		static const UINT MaxVertexBuffers = D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT;
+		static const UINT MaxDescriptorHeaps = 2;
+
+		struct RootArgument
+		{
+			RootArgumentType Type = RootArgumentType::None;
+			uint64_t Value = 0;
+
+			// Root constants : which values are bound
+			uint32_t ConstantsMask = 0;
+			uint32_t Constants[MaxRootConstants];
+		};
+
+		// Counts the call and returns true when it must be dropped
+		bool Filter(bool bRedundant)
+		{
+			if (bRedundant)
+			{
+				m_Stats.NumElided++;
+			}
+			else
+			{
+				m_Stats.NumIssued++;
+			}
+
+			return bRedundant;
+		}
+
+		// Returns true when the argument was already bound
+		bool SetRootArgument(UINT ui_RootParameterIndex, RootArgumentType e_Type, uint64_t value)
+		{
+			if (ui_RootParameterIndex >= MaxRootParameters)
+			{
+				return false;
+			}
+
+			RootArgument& argument = m_RootArguments[ui_RootParameterIndex];
+			const bool bSame = argument.Type == e_Type && argument.Value == value;
+
+			argument.Type = e_Type;
+			argument.Value = value;
+
+			return bSame;
+		}
+
+		void InvalidateRootArguments()
+		{
+			for (RootArgument& argument : m_RootArguments)
+			{
+				argument.Type = RootArgumentType::None;
+			}
+		}
+
+		CommandList& m_CmdList;
+		CommandListStats m_Stats;
+
+		ID3D12PipelineState* m_PipelineState = nullptr;
+		ID3D12RootSignature* m_RootSignature = nullptr;
+
+		ID3D12DescriptorHeap* m_DescriptorHeaps[MaxDescriptorHeaps] = {};
+		UINT m_NumDescriptorHeaps = 0;
+
+		D3D12_PRIMITIVE_TOPOLOGY m_Topology = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+
+		D3D12_VERTEX_BUFFER_VIEW m_VertexBuffers[MaxVertexBuffers] = {};
+		bool m_VertexBufferValid[MaxVertexBuffers] = {};
+
+		D3D12_INDEX_BUFFER_VIEW m_IndexBuffer = {};
+		bool m_bIndexBufferValid = false;
+
+		RootArgument m_RootArguments[MaxRootParameters];
+	};
+}
@@ -4,16 +4,53 @@
 #include "TDXRenderer.h"
 #include "DX12RenderingPipeline.h"
 
-ToyDX::FrameResource::FrameResource(ID3D12Device* p_Device, UINT ui_NumPasses, UINT ui_NumObjects, UINT ui_NumMaterials)
+ToyDX::FrameResource::FrameResource(ID3D12Device* p_Device, UINT ui_NumPasses, UINT ui_NumObjects, UINT ui_NumMaterials, UINT ui_NumRecordingWorkers)
 	: deviceHandle(p_Device)
 {
 	ThrowIfFailed(p_Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(cmdListAllocator.GetAddressOf())));
 
+	workerAllocators.resize(ui_NumRecordingWorkers);
+	workerCmdLists.resize(ui_NumRecordingWorkers);
+
+	for (UINT i = 0; i < ui_NumRecordingWorkers; ++i)
+	{
+		ThrowIfFailed(p_Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(workerAllocators[i].GetAddressOf())));
+		ThrowIfFailed(p_Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, workerAllocators[i].Get(), nullptr, IID_PPV_ARGS(workerCmdLists[i].GetAddressOf())));
+
+		// Created in the recording state, closed so that every frame starts with a Reset
+		ThrowIfFailed(workerCmdLists[i]->Close());
+	}
+
 	cbPerPass   = std::make_unique<UploadBuffer>();
-	cbPerObject = std::make_unique<UploadBuffer>();
 	cbMaterial  = std::make_unique<UploadBuffer>();
 
-	cbPerObject->Create(DX12RenderingPipeline::GetDevice(), ui_NumObjects, sizeof(PerObjectData), true, L"PerObject");
 	cbPerPass->Create(DX12RenderingPipeline::GetDevice(), 1, sizeof(PerPassData), true, L"PerPass");
 	cbMaterial->Create(DX12RenderingPipeline::GetDevice(), ui_NumMaterials, sizeof(MaterialConstants), true, L"PerMaterial");
+
+	// A page holds the constants of 4096 objects, more pages are added when more are visible
+	frameConstants = std::make_unique<LinearUploadAllocator>(DX12RenderingPipeline::GetDevice(), 4096 * UploadBuffer::CalcConstantBufferSize(sizeof(PerObjectData)), L"FrameConstants");
+
+	sbPerObject = std::make_unique<UploadBuffer>();
+	sbMaterial  = std::make_unique<UploadBuffer>();
+
+	sbPerObject->Create(DX12RenderingPipeline::GetDevice(), ui_NumObjects, sizeof(PerObjectData), false, L"PerObject_Structured");
+	sbMaterial->Create(DX12RenderingPipeline::GetDevice(), ui_NumMaterials, sizeof(MetallicRoughnessMaterial), false, L"PerMaterial_Structured");
+
+	// At most one instance per object
+	sbInstances = std::make_unique<UploadBuffer>();
+	sbInstances->Create(DX12RenderingPipeline::GetDevice(), ui_NumObjects, sizeof(UINT), false, L"Instances_Structured");
+
+	ReserveIndirectCommands(ui_NumObjects);
+}
+
+void ToyDX::FrameResource::ReserveIndirectCommands(UINT ui_NumCommands)
+{
+	if (indirectCommands != nullptr && indirectCommands->GetNumElements() >= ui_NumCommands)
+	{
+		return;
+	}
+
+	// Not used by the GPU yet : the previous buffer is released right away
+	indirectCommands = std::make_unique<UploadBuffer>();
+	indirectCommands->Create(DX12RenderingPipeline::GetDevice(), (std::max)(ui_NumCommands, 1u), IndirectCommandBuilder::ByteStride, false, L"IndirectCommands");
 }
@@ -1,11 +1,14 @@
 #pragma once
 #include <wrl/client.h>
 #include <memory>
+#include <vector>
 
 #include "ToyDXUploadBuffer.h"
+#include "LinearUploadAllocator.h"
 
 class ID3D12Device;
 class ID3D12CommandAllocator;
+class ID3D12GraphicsCommandList;
 
 namespace ToyDX
 {
@@ -15,30 +18,42 @@ namespace ToyDX
 	class FrameResource
 	{
 	public:
-		FrameResource(ID3D12Device* p_Device, UINT ui_NumPasses, UINT ui_NumObjects, UINT ui_NumMaterials);
+		FrameResource(ID3D12Device* p_Device, UINT ui_NumPasses, UINT ui_NumObjects, UINT ui_NumMaterials, UINT ui_NumRecordingWorkers = 1);
 		FrameResource(const FrameResource&) = delete;
 		FrameResource& operator=(const FrameResource&) = delete;
 
 		// Command list allocator
 		Microsoft::WRL::ComPtr<ID3D12CommandAllocator> cmdListAllocator;
 
+		// Draws are recorded in parallel, each worker into its own command list
+		// An allocator can't be used by several threads at once : each list has its own
+		std::vector<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>> workerAllocators;
+		std::vector<Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>> workerCmdLists;
+
 		// Each frame has its constant buffer
 		std::unique_ptr<UploadBuffer> cbPerPass   = nullptr;
-		std::unique_ptr<UploadBuffer> cbPerObject = nullptr;
 		std::unique_ptr<UploadBuffer> cbMaterial  = nullptr;
 
+		// Constants allocated for the frame only, e.g. per object constants of the visible drawables, bound as root CBVs
+		std::unique_ptr<LinearUploadAllocator> frameConstants = nullptr;
+
+		// Same per object and material data laid out as structured buffers, read by the bindless shaders
+		std::unique_ptr<UploadBuffer> sbPerObject = nullptr;
+		std::unique_ptr<UploadBuffer> sbMaterial  = nullptr;
+
+		// Per object index of each instance of the instanced draws of the frame
+		std::unique_ptr<UploadBuffer> sbInstances = nullptr;
+
+		// Arguments of the ExecuteIndirect draw of the frame, one command per primitive drawn
+		std::unique_ptr<UploadBuffer> indirectCommands = nullptr;
+		void ReserveIndirectCommands(UINT ui_NumCommands);
+
 		// Constant buffer setters
 		template<typename T>
 		void SetPerPassData(T& data, unsigned int numElements)
 		{
 			cbPerPass->Create(deviceHandle, 1, sizeof(T), true);
 		}
-
-		template<typename T>
-		void SetPerObjectData(T& data, unsigned int numElements)
-		{
-			cbPerObject->Create(deviceHandle, 1, sizeof(T), true);
-		}
 		
 
 		// To check if the frame resources are still in use by the GPU
@@ -0,0 +1,235 @@
+#include "pch.h"
+
+#include "GpuHeapAllocator.h"
+
+namespace
+{
+	const wchar_t* const s_PageNames[] = { L"Buffer Heap Page", L"Texture Heap Page", L"Render Target Heap Page" };
+	const char* const s_KindNames[] = { "Buffers", "Textures", "Render targets" };
+
+	UINT64 GetHeapAlignment(ToyDX::GpuHeapKind e_Kind)
+	{
+		// Multisampled render targets need 4 MB aligned ranges
+		return e_Kind == ToyDX::GpuHeapKind::RenderTargets ? D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+	}
+}
+
+ToyDX::GpuHeapAllocator::GpuHeapAllocator(ID3D12Device* p_Device, UINT64 ui64_PageSizeInBytes)
+	: m_Device(p_Device), m_PageSize(ui64_PageSizeInBytes)
+{
+	assert(m_PageSize % D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT == 0);
+}
+
+Microsoft::WRL::ComPtr<ID3D12Resource> ToyDX::GpuHeapAllocator::CreateBuffer(UINT64 ui64_SizeInBytes, D3D12_RESOURCE_STATES e_InitialState, D3D12_RESOURCE_FLAGS e_Flags)
+{
+	return CreateResource(CD3DX12_RESOURCE_DESC::Buffer(ui64_SizeInBytes, e_Flags), e_InitialState);
+}
+
+Microsoft::WRL::ComPtr<ID3D12Resource> ToyDX::GpuHeapAllocator::CreateResource(const D3D12_RESOURCE_DESC& st_Desc, D3D12_RESOURCE_STATES e_InitialState, const D3D12_CLEAR_VALUE* p_ClearValue)
+{
+	const GpuHeapKind kind = GetKind(st_Desc);
+
+	D3D12_RESOURCE_DESC desc = st_Desc;
+	D3D12_RESOURCE_ALLOCATION_INFO info = {};
+	bool bSmallTexture = false;
+
+	// Textures of less than 64 KB may be placed at 4 KB boundaries, the device tells if a texture is small enough
+	if (kind == GpuHeapKind::Textures && desc.SampleDesc.Count <= 1)
+	{
+		desc.Alignment = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+		info = m_Device->GetResourceAllocationInfo(0, 1, &desc);
+		bSmallTexture = info.Alignment == D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+	}
+
+	if (!bSmallTexture)
+	{
+		desc.Alignment = 0;
+		info = m_Device->GetResourceAllocationInfo(0, 1, &desc);
+	}
+
+	Placement placement;
+	UINT64 offset = 0;
+	Allocate(kind, info, placement, offset);
+
+	Page& page = *m_Pages[(size_t)kind][placement.PageIndex];
+
+	Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+	ThrowIfFailed(m_Device->CreatePlacedResource(page.Heap.Get(), offset, &desc, e_InitialState, p_ClearValue, IID_PPV_ARGS(resource.GetAddressOf())));
+
+	m_Placements[resource.Get()] = placement;
+
+	return resource;
+}
+
+void ToyDX::GpuHeapAllocator::Free(ID3D12Resource* p_Resource)
+{
+	auto placementIte = m_Placements.find(p_Resource);
+	if (placementIte == m_Placements.end())
+	{
+		return;
+	}
+
+	const Placement placement = placementIte->second;
+	m_Placements.erase(placementIte);
+
+	std::unique_ptr<Page>& page = m_Pages[(size_t)placement.Kind][placement.PageIndex];
+	page->Allocator.Free(placement.Block);
+
+	if (page->bDedicated)
+	{
+		page.reset();
+	}
+}
+
+void ToyDX::GpuHeapAllocator::FreeDeferred(Microsoft::WRL::ComPtr<ID3D12Resource> p_Resource, UINT64 ui64_FenceValue)
+{
+	if (p_Resource == nullptr)
+	{
+		return;
+	}
+
+	assert(m_PendingFrees.empty() || m_PendingFrees.back().FenceValue <= ui64_FenceValue);
+	m_PendingFrees.push_back({ ui64_FenceValue, std::move(p_Resource) });
+}
+
+void ToyDX::GpuHeapAllocator::RetireDeferredFrees(UINT64 ui64_CompletedFenceValue)
+{
+	while (!m_PendingFrees.empty() && m_PendingFrees.front().FenceValue <= ui64_CompletedFenceValue)
+	{
+		// The range is released before the last reference to the resource
+		Free(m_PendingFrees.front().Resource.Get());
+		m_PendingFrees.pop_front();
+	}
+}
+
+ToyDX::GpuHeapStats ToyDX::GpuHeapAllocator::GetStats(GpuHeapKind e_Kind) const
+{
+	GpuHeapStats stats;
+
+	for (const std::unique_ptr<Page>& page : m_Pages[(size_t)e_Kind])
+	{
+		if (page == nullptr)
+		{
+			continue;
+		}
+
+		const TlsfStats pageStats = page->Allocator.GetStats();
+
+		stats.NumPages++;
+		stats.NumDedicatedPages += page->bDedicated ? 1 : 0;
+
+		stats.Usage.Size += pageStats.Size;
+		stats.Usage.AllocatedSize += pageStats.AllocatedSize;
+		stats.Usage.NumAllocations += pageStats.NumAllocations;
+		stats.Usage.NumFreeBlocks += pageStats.NumFreeBlocks;
+		stats.Usage.LargestFreeBlock = (std::max)(stats.Usage.LargestFreeBlock, pageStats.LargestFreeBlock);
+	}
+
+	return stats;
+}
+
+void ToyDX::GpuHeapAllocator::LogStats() const
+{
+	for (size_t kind = 0; kind < (size_t)GpuHeapKind::Count; ++kind)
+	{
+		const GpuHeapStats stats = GetStats((GpuHeapKind)kind);
+		if (stats.NumPages == 0)
+		{
+			continue;
+		}
+
+		LOG_INFO("GpuHeapAllocator: {0} : {1} resources, {2:.2f} / {3:.2f} MB in {4} pages ({5} dedicated), {6} free blocks, fragmentation {7:.2f}",
+			s_KindNames[kind], stats.Usage.NumAllocations,
+			stats.Usage.AllocatedSize / (1024.0 * 1024.0), stats.Usage.Size / (1024.0 * 1024.0),
+			stats.NumPages, stats.NumDedicatedPages, stats.Usage.NumFreeBlocks, stats.Usage.GetFragmentation());
+	}
+}
+
+ToyDX::GpuHeapKind ToyDX::GpuHeapAllocator::GetKind(const D3D12_RESOURCE_DESC& st_Desc)
+{
+	if (st_Desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+	{
+		return GpuHeapKind::Buffers;
+	}
+
+	if (st_Desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL))
+	{
+		return GpuHeapKind::RenderTargets;
+	}
+
+	return GpuHeapKind::Textures;
+}
+
+void ToyDX::GpuHeapAllocator::Allocate(GpuHeapKind e_Kind, const D3D12_RESOURCE_ALLOCATION_INFO& st_Info, Placement& r_Placement, UINT64& r_Offset)
+{
+	std::vector<std::unique_ptr<Page>>& pages = m_Pages[(size_t)e_Kind];
+
+	r_Placement.Kind = e_Kind;
+
+	TlsfAllocator::Allocation allocation;
+
+	if (st_Info.SizeInBytes <= m_PageSize)
+	{
+		for (UINT pageIndex = 0; pageIndex < (UINT)pages.size(); ++pageIndex)
+		{
+			if (pages[pageIndex] != nullptr && !pages[pageIndex]->bDedicated && pages[pageIndex]->Allocator.Allocate(st_Info.SizeInBytes, st_Info.Alignment, allocation))
+			{
+				r_Placement.PageIndex = pageIndex;
+				r_Placement.Block = allocation.Block;
+				r_Offset = allocation.Offset;
+
+				return;
+			}
+		}
+
+		r_Placement.PageIndex = CreatePage(e_Kind, m_PageSize, false);
+	}
+	else
+	{
+		const UINT64 heapAlignment = GetHeapAlignment(e_Kind);
+		const UINT64 dedicatedSize = (st_Info.SizeInBytes + heapAlignment - 1) & ~(heapAlignment - 1);
+
+		LOG_WARN("GpuHeapAllocator: Resource of {0:.2f} MB is larger than a page, placing it in a heap of its own.", st_Info.SizeInBytes / (1024.0 * 1024.0));
+		r_Placement.PageIndex = CreatePage(e_Kind, dedicatedSize, true);
+	}
+
+	// A new page is empty : the allocation fits
+	const bool bAllocated = pages[r_Placement.PageIndex]->Allocator.Allocate(st_Info.SizeInBytes, st_Info.Alignment, allocation);
+	assert(bAllocated);
+
+	r_Placement.Block = allocation.Block;
+	r_Offset = allocation.Offset;
+}
+
+UINT ToyDX::GpuHeapAllocator::CreatePage(GpuHeapKind e_Kind, UINT64 ui64_SizeInBytes, bool bDedicated)
+{
+	static const D3D12_HEAP_FLAGS heapFlags[] =
+	{
+		D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS,
+		D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES,
+		D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES
+	};
+
+	std::unique_ptr<Page> page = std::make_unique<Page>(ui64_SizeInBytes);
+	page->bDedicated = bDedicated;
+
+	CD3DX12_HEAP_DESC heapDesc(ui64_SizeInBytes, D3D12_HEAP_TYPE_DEFAULT, GetHeapAlignment(e_Kind), heapFlags[(size_t)e_Kind]);
+	ThrowIfFailed(m_Device->CreateHeap(&heapDesc, IID_PPV_ARGS(page->Heap.GetAddressOf())));
+	page->Heap->SetName(s_PageNames[(size_t)e_Kind]);
+
+	LOG_INFO("GpuHeapAllocator: New {0} page of {1:.2f} MB.", s_KindNames[(size_t)e_Kind], ui64_SizeInBytes / (1024.0 * 1024.0));
+
+	std::vector<std::unique_ptr<Page>>& pages = m_Pages[(size_t)e_Kind];
+
+	for (UINT pageIndex = 0; pageIndex < (UINT)pages.size(); ++pageIndex)
+	{
+		if (pages[pageIndex] == nullptr)
+		{
+			pages[pageIndex] = std::move(page);
+			return pageIndex;
+		}
+	}
+
+	pages.push_back(std::move(page));
+	return (UINT)pages.size() - 1;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <wrl/client.h>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "d3d12.h"
+#include "TlsfAllocator.h"
+
+namespace ToyDX
+{
+	// Resources that may share a heap on every resource heap tier
+	enum class GpuHeapKind
+	{
+		Buffers,
+		Textures,		// Non render target, non depth stencil
+		RenderTargets,	// Render targets and depth stencils
+		Count
+	};
+
+	struct GpuHeapStats
+	{
+		UINT NumPages = 0;
+		UINT NumDedicatedPages = 0;
+		TlsfStats Usage;	// Of all the pages, LargestFreeBlock is the largest of a single page
+	};
+
+	// Places default heap resources in large ID3D12Heap pages instead of creating one committed resource (and one implicit heap) each
+	// - Each page has a TLSF allocator of its range : placement and release are constant time, freed ranges merge with their free neighbours
+	// - Pages are per GpuHeapKind, resources larger than a page get a page of their own that is released with them
+	// - Small textures use the 4 KB placement alignment when the device allows it, other resources use 64 KB
+	// The caller must make sure the GPU is done with a resource before freeing it : its range is reused right away
+	// Resources the frames in flight may still use go through FreeDeferred instead
+	// Not thread safe
+	class GpuHeapAllocator
+	{
+	public:
+		explicit GpuHeapAllocator(ID3D12Device* p_Device, UINT64 ui64_PageSizeInBytes = DefaultPageSizeInBytes);
+		GpuHeapAllocator(const GpuHeapAllocator&) = delete;
+		GpuHeapAllocator& operator=(const GpuHeapAllocator&) = delete;
+
+		Microsoft::WRL::ComPtr<ID3D12Resource> CreateBuffer(UINT64 ui64_SizeInBytes, D3D12_RESOURCE_STATES e_InitialState, D3D12_RESOURCE_FLAGS e_Flags = D3D12_RESOURCE_FLAG_NONE);
+		Microsoft::WRL::ComPtr<ID3D12Resource> CreateResource(const D3D12_RESOURCE_DESC& st_Desc, D3D12_RESOURCE_STATES e_InitialState, const D3D12_CLEAR_VALUE* p_ClearValue = nullptr);
+
+		// Releases the range of a resource created by the allocator, other resources are ignored
+		void Free(ID3D12Resource* p_Resource);
+
+		// Keeps the resource and its range alive until the GPU has passed the fence value
+		void FreeDeferred(Microsoft::WRL::ComPtr<ID3D12Resource> p_Resource, UINT64 ui64_FenceValue);
+
+		// Frees the deferred resources of every fence value up to the completed one
+		void RetireDeferredFrees(UINT64 ui64_CompletedFenceValue);
+
+		GpuHeapStats GetStats(GpuHeapKind e_Kind) const;
+		void LogStats() const;
+
+		static GpuHeapKind GetKind(const D3D12_RESOURCE_DESC& st_Desc);
+
+		static const UINT64 DefaultPageSizeInBytes = 64ull * 1024 * 1024;
+
+	protected:
+		struct Page
+		{
+			Page(UINT64 ui64_Size) : Allocator(ui64_Size) {}
+
+			Microsoft::WRL::ComPtr<ID3D12Heap> Heap;
+			TlsfAllocator Allocator;
+			bool bDedicated = false;
+		};
+
+		struct Placement
+		{
+			GpuHeapKind Kind = GpuHeapKind::Buffers;
+			UINT PageIndex = 0;
+			TlsfAllocator::Handle Block = TlsfAllocator::InvalidHandle;
+		};
+
+		struct PendingFree
+		{
+			UINT64 FenceValue = 0;
+			Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+		};
+
+		// Finds or creates a page with room for the allocation
+		void Allocate(GpuHeapKind e_Kind, const D3D12_RESOURCE_ALLOCATION_INFO& st_Info, Placement& r_Placement, UINT64& r_Offset);
+		UINT CreatePage(GpuHeapKind e_Kind, UINT64 ui64_SizeInBytes, bool bDedicated);
+
+		ID3D12Device* m_Device = nullptr;
+		UINT64 m_PageSize = 0;
+
+		// Released dedicated pages leave an empty slot, reused by the next page
+		std::vector<std::unique_ptr<Page>> m_Pages[(size_t)GpuHeapKind::Count];
+		std::unordered_map<ID3D12Resource*, Placement> m_Placements;
+
+		std::deque<PendingFree> m_PendingFrees;	// By increasing fence value
+	};
+}
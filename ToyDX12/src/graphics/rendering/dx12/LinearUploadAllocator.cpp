@@ -0,0 +1,86 @@
+#include "pch.h"
+
+#include "LinearUploadAllocator.h"
+
+ToyDX::LinearUploadAllocator::LinearUploadAllocator(ID3D12Device* p_Device, size_t sz_PageSizeInBytes, const std::wstring& sz_DebugName)
+	: m_Device(p_Device), m_DebugName(sz_DebugName), m_PageSize(sz_PageSizeInBytes)
+{
+	CreatePage(m_PageSize);
+}
+
+ToyDX::LinearUploadAllocator::~LinearUploadAllocator()
+{
+	for (Page& page : m_Pages)
+	{
+		page.Resource->Unmap(0, nullptr);
+	}
+}
+
+ToyDX::LinearUploadAllocator::Allocation ToyDX::LinearUploadAllocator::Allocate(size_t sz_SizeInBytes, size_t sz_Alignment)
+{
+	size_t offset = (m_Offset + sz_Alignment - 1) & ~(sz_Alignment - 1);
+
+	// Move on to the next page that is large enough, pages are created with the page alignment
+	while (offset + sz_SizeInBytes > m_Pages[m_CurrentPage].Size)
+	{
+		m_CurrentPage++;
+		offset = 0;
+
+		if (m_CurrentPage == m_Pages.size())
+		{
+			CreatePage((std::max)(m_PageSize, sz_SizeInBytes));
+		}
+	}
+
+	m_Offset = offset + sz_SizeInBytes;
+	m_AllocatedSize += sz_SizeInBytes;
+
+	const Page& page = m_Pages[m_CurrentPage];
+
+	Allocation allocation;
+	allocation.CpuAddress = page.CpuAddress + offset;
+	allocation.GpuAddress = page.GpuAddress + offset;
+
+	return allocation;
+}
+
+void ToyDX::LinearUploadAllocator::Reset()
+{
+	m_CurrentPage = 0;
+	m_Offset = 0;
+	m_AllocatedSize = 0;
+}
+
+size_t ToyDX::LinearUploadAllocator::GetCapacity() const
+{
+	size_t capacity = 0;
+	for (const Page& page : m_Pages)
+	{
+		capacity += page.Size;
+	}
+
+	return capacity;
+}
+
+void ToyDX::LinearUploadAllocator::CreatePage(size_t sz_SizeInBytes)
+{
+	Page page;
+	page.Size = sz_SizeInBytes;
+
+	CD3DX12_HEAP_PROPERTIES heapProperty(D3D12_HEAP_TYPE_UPLOAD);
+	CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(sz_SizeInBytes);
+
+	ThrowIfFailed(m_Device->CreateCommittedResource(&heapProperty, D3D12_HEAP_FLAG_NONE, &bufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(page.Resource.GetAddressOf())));
+	page.Resource->SetName((m_DebugName + L"_Page" + std::to_wstring(m_Pages.size())).c_str());
+
+	// Upload heaps can stay mapped for their whole lifetime
+	ThrowIfFailed(page.Resource->Map(0, nullptr, (void**)&page.CpuAddress));
+	page.GpuAddress = page.Resource->GetGPUVirtualAddress();
+
+	m_Pages.push_back(std::move(page));
+
+	if (m_Pages.size() > 1)
+	{
+		LOG_INFO("LinearUploadAllocator: Grown to {0} pages ({1} KB).", m_Pages.size(), GetCapacity() / 1024);
+	}
+}
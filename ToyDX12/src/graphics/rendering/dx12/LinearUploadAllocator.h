@@ -0,0 +1,59 @@
+#pragma once
+
+#include <wrl/client.h>
+#include <string>
+#include <vector>
+
+#include "d3d12.h"
+
+namespace ToyDX
+{
+	// Persistently mapped upload memory handed out linearly, for data written once and read by the commands of a frame
+	// - Memory comes from pages of upload heap : a new page is created when the current one is full
+	// - Reset() rewinds to the first page once the GPU is done with every allocation, pages are kept and reused
+	// Memory follows what is actually allocated in a frame. Not thread safe
+	class LinearUploadAllocator
+	{
+	public:
+		struct Allocation
+		{
+			void* CpuAddress = nullptr;
+			D3D12_GPU_VIRTUAL_ADDRESS GpuAddress = 0;
+		};
+
+		LinearUploadAllocator(ID3D12Device* p_Device, size_t sz_PageSizeInBytes, const std::wstring& sz_DebugName);
+		LinearUploadAllocator(const LinearUploadAllocator&) = delete;
+		LinearUploadAllocator& operator=(const LinearUploadAllocator&) = delete;
+		~LinearUploadAllocator();
+
+		// sz_Alignment must be a power of two, constant buffers are 256 bytes aligned
+		Allocation Allocate(size_t sz_SizeInBytes, size_t sz_Alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+
+		void Reset();
+
+		// Since the last reset
+		size_t GetAllocatedSize() const { return m_AllocatedSize; }
+		size_t GetCapacity() const;
+
+	protected:
+		struct Page
+		{
+			Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+			BYTE* CpuAddress = nullptr;
+			D3D12_GPU_VIRTUAL_ADDRESS GpuAddress = 0;
+			size_t Size = 0;
+		};
+
+		void CreatePage(size_t sz_SizeInBytes);
+
+		ID3D12Device* m_Device = nullptr;
+		std::wstring m_DebugName;
+
+		std::vector<Page> m_Pages;
+		size_t m_PageSize = 0;
+
+		size_t m_CurrentPage = 0;
+		size_t m_Offset = 0;			// In the current page
+		size_t m_AllocatedSize = 0;
+	};
+}
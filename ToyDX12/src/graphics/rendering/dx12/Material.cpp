@@ -1 +1,54 @@
-#include "pch.h"
\ No newline at end of file
+#include "pch.h"
+
+#include "Material.h"
+
+MaterialContentKey MaterialContentKey::FromProperties(const MaterialProperties& properties)
+{
+	MaterialContentKey key = {};
+
+	key.Type  = (uint32_t)properties.type;
+	key.Flags = (properties.bTransparent ? 1u : 0u) | (properties.hasEmissive ? 2u : 0u) | (properties.hasNormalMap ? 4u : 0u);
+
+	const SpecularGlossiness& sg = properties.specularGlossiness;
+	const MetallicRoughness&  mr = properties.metallicRoughness;
+
+	key.Textures[EmissiveSlot] = properties.hasEmissive ? properties.hEmissiveTexture : -1;
+	key.Textures[NormalSlot]   = properties.hasNormalMap ? properties.hNormalTexture : -1;
+
+	// The parameters of the other workflow are not used (and not always initialized)
+	if (properties.type == MaterialWorkflowType::SpecularGlossiness)
+	{
+		const float factors[] =
+		{
+			sg.DiffuseFactor.x, sg.DiffuseFactor.y, sg.DiffuseFactor.z, sg.DiffuseFactor.w,
+			sg.SpecularFactor.x, sg.SpecularFactor.y, sg.SpecularFactor.z,
+			sg.GlossinessFactor
+		};
+		static_assert(sizeof(factors) == sizeof(key.Factors));
+		memcpy(key.Factors, factors, sizeof(factors));
+
+		key.Textures[DiffuseSlot]            = sg.hasDiffuse ? sg.hDiffuseTexture : -1;
+		key.Textures[SpecularGlossinessSlot] = sg.hasSpecularGlossiness ? sg.hSpecularGlossinessTexture : -1;
+		key.Textures[BaseColorSlot]          = -1;
+		key.Textures[MetallicRoughnessSlot]  = -1;
+	}
+	else
+	{
+		const float factors[] =
+		{
+			mr.BaseColor.x, mr.BaseColor.y, mr.BaseColor.z, mr.BaseColor.w,
+			mr.Metallic,
+			mr.Roughness,
+			0.0f, 0.0f
+		};
+		static_assert(sizeof(factors) == sizeof(key.Factors));
+		memcpy(key.Factors, factors, sizeof(factors));
+
+		key.Textures[DiffuseSlot]            = -1;
+		key.Textures[SpecularGlossinessSlot] = -1;
+		key.Textures[BaseColorSlot]          = mr.hasBaseColorTex ? mr.hBaseColorTexture : -1;
+		key.Textures[MetallicRoughnessSlot]  = mr.hasMetallicRoughnessTex ? mr.hMetallicRoughnessTexture : -1;
+	}
+
+	return key;
+}
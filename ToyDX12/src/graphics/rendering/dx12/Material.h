@@ -1,6 +1,10 @@
 #pragma once
 
 #include "MathUtil.h"
+#include "NameTable.h"
+#include "HashUtil.h"
+
+namespace DirectX { class ScratchImage; }
 
 const int NumFrameResources = 3;
 
@@ -11,6 +15,17 @@ enum class MaterialWorkflowType
 	MetallicRoughness  = 2
 };
 
+// How a texture is sampled by the materials, used to pick its GPU format at import time
+enum class TextureRole
+{
+	Unknown = 0,
+	BaseColor,
+	Normal,
+	MetallicRoughness,
+	SpecularGlossiness,
+	Emissive
+};
+
 struct Texture
 {
 	const char* Name;
@@ -20,10 +35,22 @@ struct Texture
 	int Channels = -1;
 	unsigned char* data;
 
+	TextureRole Role = TextureRole::Unknown;
+
+	// Format and texels that are uploaded to the GPU
+	// Cooked holds the mip chain (block-compressed when possible) when the texture went through the TextureCooker, otherwise data is uploaded as is
+	DXGI_FORMAT Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	std::shared_ptr<DirectX::ScratchImage> Cooked = nullptr;
+
+	// Key of the texture in the on-disk texture cache, 0 if the texture is not cached
+	uint64_t CacheKey = 0;
+
 	int SrvHeapIndex = -1;
 
+	// Handle of the texture in the TextureStreamer, -1 if all its mips are resident
+	int StreamingHandle = -1;
+
 	Microsoft::WRL::ComPtr<ID3D12Resource> Resource = nullptr;
-	Microsoft::WRL::ComPtr<ID3D12Resource> UploadHeap = nullptr;
 };
 
 struct SpecularGlossiness
@@ -56,11 +83,14 @@ struct MetallicRoughness
 
 struct MaterialProperties
 {
-	std::string name;
+	NameId name = InvalidNameId;
 	int Id = -1;
 
 	bool hasEmissive = false;
 	bool hasNormalMap = false;
+
+	// Alpha blended : drawn after the opaque drawables, back to front
+	bool bTransparent = false;
 	int hEmissiveTexture = -1;
 	int hNormalTexture   = -1;
 
@@ -70,13 +100,39 @@ struct MaterialProperties
 	struct MetallicRoughness  metallicRoughness;
 };
 
+// What a material looks like : its parameters and textures, without its name and id
+// Materials with the same key draw the same, one of them can be used in place of the others
+// Every member is 4 bytes wide : the key has no padding and is hashed and compared as bytes
+struct MaterialContentKey
+{
+	enum TextureSlot { EmissiveSlot, NormalSlot, DiffuseSlot, SpecularGlossinessSlot, BaseColorSlot, MetallicRoughnessSlot, NumTextureSlots };
+
+	uint32_t Type;
+	uint32_t Flags;
+	float Factors[8];	// Of the workflow of the material
+	int32_t Textures[NumTextureSlots];	// -1 when the material has no texture in this slot
+
+	// Textures are identified by their handles in the texture list of the mesh
+	static MaterialContentKey FromProperties(const MaterialProperties& properties);
 
+	bool operator==(const MaterialContentKey& other) const { return memcmp(this, &other, sizeof(MaterialContentKey)) == 0; }
+
+	struct Hasher
+	{
+		size_t operator()(const MaterialContentKey& key) const { return (size_t)HashUtil::Fnv1a(key); }
+	};
+};
+
+
+
+// Materials of every mesh are stored contiguously by the renderer : a material handle is its index in that array
+using MaterialHandle = uint32_t;
 
 struct Material
 {
-	std::string Name;
+	NameId Name = InvalidNameId;
 
-	// Index corresponding to this material into the constant buffer 
+	// Index corresponding to this material into the constant buffer, equal to its handle
 	int CBIndex = -1;
 
 	// Index corresponding to the diffuse texture into the SRV heap
@@ -85,10 +141,6 @@ struct Material
 
 	int NormalSrvHeapIndex = -1; 
 
-	// Indicate that the material has changed and we need to update the constant buffers
-	// of each frame resources
-	int NumFramesDirty = NumFrameResources;
-
 	// Constant buffer data
 	// Physical properties
 	MaterialProperties properties;
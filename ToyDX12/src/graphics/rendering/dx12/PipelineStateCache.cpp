@@ -0,0 +1,306 @@
+#include "pch.h"
+
+#include "PipelineStateCache.h"
+#include "MappedFile.h"
+
+#include <filesystem>
+#include <fstream>
+
+// Bump when the way pipelines are keyed changes, to ignore every stored pipeline
+static const uint64_t PipelineStateCacheVersion = 1;
+
+std::string ToyDX::PipelineStateCache::s_DefaultLibraryPath = "./data/cache/pipelines.bin";
+
+ToyDX::PipelineStateCache::PipelineStateCache(ID3D12Device1* p_Device, const std::string& sz_LibraryPath)
+	: m_Device(p_Device), m_LibraryPath(sz_LibraryPath)
+{
+	OpenLibrary();
+}
+
+ToyDX::PipelineStateCache::~PipelineStateCache()
+{
+	SaveLibrary();
+}
+
+void ToyDX::PipelineStateCache::RegisterRootSignature(ID3D12RootSignature* p_RootSignature, const void* p_SerializedBlob, size_t sz_SizeInBytes)
+{
+	m_RootSignatureHashes[p_RootSignature] = HashUtil::Fnv1a(p_SerializedBlob, sz_SizeInBytes);
+}
+
+Microsoft::WRL::ComPtr<ID3D12PipelineState> ToyDX::PipelineStateCache::GetGraphicsPipeline(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& st_Desc, const wchar_t* sz_DebugName)
+{
+	PipelineStateKey key = MakeKey(st_Desc);
+
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_NumRequests++;
+
+		for (;;)
+		{
+			auto pipelineIte = m_Pipelines.find(key);
+			if (pipelineIte != m_Pipelines.end())
+			{
+				return pipelineIte->second;
+			}
+
+			if (m_PendingPipelines.find(key) == m_PendingPipelines.end())
+			{
+				break;
+			}
+
+			m_PipelineCreated.wait(lock);
+		}
+
+		m_PendingPipelines.insert(key);
+	}
+
+	const std::wstring name = key.GetName();
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> pso;
+	bool bLoaded = false;
+	bool bStored = false;
+
+	try
+	{
+		// The library synchronizes itself, but for loads of the same pipeline : a pipeline is only created by one thread at a time
+		// E_INVALIDARG : not in the library, or stored with another description
+		if (m_Library != nullptr && SUCCEEDED(m_Library->LoadGraphicsPipeline(name.c_str(), &st_Desc, IID_PPV_ARGS(pso.GetAddressOf()))))
+		{
+			bLoaded = true;
+		}
+		else
+		{
+			ThrowIfFailed(m_Device->CreateGraphicsPipelineState(&st_Desc, IID_PPV_ARGS(pso.GetAddressOf())));
+
+			if (m_Library != nullptr)
+			{
+				bStored = SUCCEEDED(m_Library->StorePipeline(name.c_str(), pso.Get()));
+				if (!bStored)
+				{
+					LOG_WARN("PipelineStateCache: Could not store pipeline {0} in the library.", key.GetHash());
+				}
+			}
+		}
+	}
+	catch (...)
+	{
+		// Waiting requests create it in turn, and fail the same way
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_PendingPipelines.erase(key);
+		}
+		m_PipelineCreated.notify_all();
+
+		throw;
+	}
+
+	if (sz_DebugName != nullptr)
+	{
+		pso->SetName(sz_DebugName);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		if (bLoaded)
+		{
+			m_NumLoaded++;
+		}
+		else
+		{
+			m_NumCompiled++;
+		}
+		m_bLibraryDirty |= bStored;
+
+		m_PendingPipelines.erase(key);
+		m_Pipelines.insert({ std::move(key), pso });
+	}
+	m_PipelineCreated.notify_all();
+
+	return pso;
+}
+
+void ToyDX::PipelineStateCache::SaveLibrary()
+{
+	if (m_Library == nullptr || !m_bLibraryDirty)
+	{
+		return;
+	}
+
+	std::vector<uint8_t> data(m_Library->GetSerializedSize());
+	if (FAILED(m_Library->Serialize(data.data(), data.size())))
+	{
+		LOG_WARN("PipelineStateCache: Could not serialize the pipeline library.");
+		return;
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories(std::filesystem::path(m_LibraryPath).parent_path(), error);
+
+	// Written aside then renamed : a crash while writing never leaves a corrupted library
+	const std::string temporaryPath = m_LibraryPath + ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(data.data()), data.size());
+
+		if (!file)
+		{
+			LOG_WARN("PipelineStateCache: Could not write {0}.", m_LibraryPath);
+			return;
+		}
+	}
+
+	std::filesystem::rename(temporaryPath, m_LibraryPath, error);
+	if (error)
+	{
+		LOG_WARN("PipelineStateCache: Could not write {0}.", m_LibraryPath);
+		std::filesystem::remove(temporaryPath, error);
+		return;
+	}
+
+	m_bLibraryDirty = false;
+
+	LOG_INFO("PipelineStateCache: Library of {0:.2f} KB saved to {1}.", data.size() / 1024.0, m_LibraryPath);
+}
+
+PipelineStateKey ToyDX::PipelineStateCache::MakeKey(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& st_Desc) const
+{
+	PipelineStateKey key;
+	key.Append(PipelineStateCacheVersion);
+
+	// Root signatures are keyed by content : their address changes from one launch to the next
+	auto rootSignatureIte = m_RootSignatureHashes.find(st_Desc.pRootSignature);
+	if (rootSignatureIte != m_RootSignatureHashes.end())
+	{
+		key.Append(rootSignatureIte->second);
+	}
+	else
+	{
+		LOG_WARN("PipelineStateCache: Unregistered root signature, pipelines using it are keyed by its address.");
+		key.Append(reinterpret_cast<uintptr_t>(st_Desc.pRootSignature));
+	}
+
+	const D3D12_SHADER_BYTECODE* shaders[] = { &st_Desc.VS, &st_Desc.PS, &st_Desc.DS, &st_Desc.HS, &st_Desc.GS };
+	for (const D3D12_SHADER_BYTECODE* shader : shaders)
+	{
+		key.AppendBlob(shader->pShaderBytecode, shader->BytecodeLength);
+	}
+
+	key.Append(st_Desc.StreamOutput.NumEntries);
+	for (UINT i = 0; i < st_Desc.StreamOutput.NumEntries; ++i)
+	{
+		const D3D12_SO_DECLARATION_ENTRY& entry = st_Desc.StreamOutput.pSODeclaration[i];
+
+		key.Append(entry.Stream);
+		key.AppendString(entry.SemanticName);
+		key.Append(entry.SemanticIndex);
+		key.Append(entry.StartComponent);
+		key.Append(entry.ComponentCount);
+		key.Append(entry.OutputSlot);
+	}
+	key.AppendBlob(st_Desc.StreamOutput.pBufferStrides, st_Desc.StreamOutput.NumStrides * sizeof(UINT));
+	key.Append(st_Desc.StreamOutput.RasterizedStream);
+
+	// Blend and depth stencil descriptions have padding : appended field by field
+	key.Append(st_Desc.BlendState.AlphaToCoverageEnable);
+	key.Append(st_Desc.BlendState.IndependentBlendEnable);
+	for (const D3D12_RENDER_TARGET_BLEND_DESC& target : st_Desc.BlendState.RenderTarget)
+	{
+		key.Append(target.BlendEnable);
+		key.Append(target.LogicOpEnable);
+		key.Append(target.SrcBlend);
+		key.Append(target.DestBlend);
+		key.Append(target.BlendOp);
+		key.Append(target.SrcBlendAlpha);
+		key.Append(target.DestBlendAlpha);
+		key.Append(target.BlendOpAlpha);
+		key.Append(target.LogicOp);
+		key.Append(target.RenderTargetWriteMask);
+	}
+
+	key.Append(st_Desc.SampleMask);
+	key.Append(st_Desc.RasterizerState);
+
+	const D3D12_DEPTH_STENCIL_DESC& depthStencil = st_Desc.DepthStencilState;
+	key.Append(depthStencil.DepthEnable);
+	key.Append(depthStencil.DepthWriteMask);
+	key.Append(depthStencil.DepthFunc);
+	key.Append(depthStencil.StencilEnable);
+	key.Append(depthStencil.StencilReadMask);
+	key.Append(depthStencil.StencilWriteMask);
+	key.Append(depthStencil.FrontFace);
+	key.Append(depthStencil.BackFace);
+
+	key.Append(st_Desc.InputLayout.NumElements);
+	for (UINT i = 0; i < st_Desc.InputLayout.NumElements; ++i)
+	{
+		const D3D12_INPUT_ELEMENT_DESC& element = st_Desc.InputLayout.pInputElementDescs[i];
+
+		key.AppendString(element.SemanticName);
+		key.Append(element.SemanticIndex);
+		key.Append(element.Format);
+		key.Append(element.InputSlot);
+		key.Append(element.AlignedByteOffset);
+		key.Append(element.InputSlotClass);
+		key.Append(element.InstanceDataStepRate);
+	}
+
+	key.Append(st_Desc.IBStripCutValue);
+	key.Append(st_Desc.PrimitiveTopologyType);
+	key.Append(st_Desc.NumRenderTargets);
+	key.Append(st_Desc.RTVFormats);
+	key.Append(st_Desc.DSVFormat);
+	key.Append(st_Desc.SampleDesc);
+	key.Append(st_Desc.NodeMask);
+	key.Append(st_Desc.Flags);
+
+	// CachedPSO is only a hint to the driver, it doesn't change the pipeline
+
+	return key;
+}
+
+UINT ToyDX::PipelineStateCache::GetNumPipelines() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return (UINT)m_Pipelines.size();
+}
+
+void ToyDX::PipelineStateCache::LogStats() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	LOG_INFO("PipelineStateCache: {0} pipelines for {1} requests, {2} loaded from the library, {3} compiled.", m_Pipelines.size(), m_NumRequests, m_NumLoaded, m_NumCompiled);
+}
+
+void ToyDX::PipelineStateCache::OpenLibrary()
+{
+	{
+		MappedFile file;
+		if (file.Open(m_LibraryPath))
+		{
+			const uint8_t* bytes = static_cast<const uint8_t*>(file.Data());
+			m_LibraryData.assign(bytes, bytes + file.Size());
+		}
+	}
+
+	if (!m_LibraryData.empty())
+	{
+		const HRESULT result = m_Device->CreatePipelineLibrary(m_LibraryData.data(), m_LibraryData.size(), IID_PPV_ARGS(m_Library.GetAddressOf()));
+
+		if (SUCCEEDED(result))
+		{
+			LOG_INFO("PipelineStateCache: Library of {0:.2f} KB loaded from {1}.", m_LibraryData.size() / 1024.0, m_LibraryPath);
+			return;
+		}
+
+		// Another driver or adapter, or a corrupted file : every pipeline is compiled again
+		LOG_WARN("PipelineStateCache: Library {0} rejected by the driver ({1:#x}), it is rebuilt.", m_LibraryPath, (uint32_t)result);
+		m_LibraryData.clear();
+	}
+
+	if (FAILED(m_Device->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(m_Library.GetAddressOf()))))
+	{
+		// e.g. D3D12_FEATURE_SHADER_CACHE doesn't report library support : pipelines are only cached in memory
+		LOG_WARN("PipelineStateCache: Pipeline libraries are not supported, pipelines are not stored on disk.");
+		m_Library.Reset();
+	}
+}
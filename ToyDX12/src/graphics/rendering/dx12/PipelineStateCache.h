@@ -0,0 +1,69 @@
+#pragma once
+
+#include <wrl/client.h>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "d3d12.h"
+#include "PipelineStateKey.h"
+
+namespace ToyDX
+{
+	// Graphics pipeline states by content : a request for a description that was already created returns the same object
+	// - The key is the whole D3D12_GRAPHICS_PIPELINE_STATE_DESC, shader bytecode and input layout included.
+	//   Root signatures are keyed by their serialized blob, they must be registered before use
+	// - Created pipelines are stored in an ID3D12PipelineLibrary saved to disk : on the next launch they are loaded
+	//   instead of being compiled by the driver. The driver rejects a library of another driver or adapter, it is then rebuilt
+	// GetGraphicsPipeline is thread safe, pipelines are created in parallel. Root signatures are registered and the library saved
+	// while no pipeline is being requested
+	class PipelineStateCache
+	{
+	public:
+		explicit PipelineStateCache(ID3D12Device1* p_Device, const std::string& sz_LibraryPath = s_DefaultLibraryPath);
+		PipelineStateCache(const PipelineStateCache&) = delete;
+		PipelineStateCache& operator=(const PipelineStateCache&) = delete;
+		~PipelineStateCache();
+
+		void RegisterRootSignature(ID3D12RootSignature* p_RootSignature, const void* p_SerializedBlob, size_t sz_SizeInBytes);
+
+		Microsoft::WRL::ComPtr<ID3D12PipelineState> GetGraphicsPipeline(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& st_Desc, const wchar_t* sz_DebugName = nullptr);
+
+		// Writes the library if pipelines were added to it
+		void SaveLibrary();
+
+		PipelineStateKey MakeKey(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& st_Desc) const;
+
+		UINT GetNumPipelines() const;
+		void LogStats() const;
+
+		static std::string s_DefaultLibraryPath;
+
+	protected:
+		void OpenLibrary();
+
+		ID3D12Device1* m_Device = nullptr;
+		std::string m_LibraryPath;
+
+		std::unordered_map<PipelineStateKey, Microsoft::WRL::ComPtr<ID3D12PipelineState>, PipelineStateKey::Hasher> m_Pipelines;
+		std::unordered_map<ID3D12RootSignature*, uint64_t> m_RootSignatureHashes;
+
+		// Guards the pipelines and the statistics. Pipelines are created outside of it : a request for a pipeline
+		// being created by another thread waits for it instead of creating it twice
+		mutable std::mutex m_Mutex;
+		std::condition_variable m_PipelineCreated;
+		std::unordered_set<PipelineStateKey, PipelineStateKey::Hasher> m_PendingPipelines;
+
+		// The library reads its pipelines from the serialized data : it is kept as long as the library
+		Microsoft::WRL::ComPtr<ID3D12PipelineLibrary> m_Library;
+		std::vector<uint8_t> m_LibraryData;
+		bool m_bLibraryDirty = false;
+
+		UINT m_NumRequests = 0;
+		UINT m_NumLoaded = 0;	// From the library
+		UINT m_NumCompiled = 0;
+	};
+}
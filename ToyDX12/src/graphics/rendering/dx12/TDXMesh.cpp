@@ -33,6 +33,9 @@ namespace ToyDX
 	}
 	Mesh::~Mesh()
 	{
+		DX12RenderingPipeline::GetHeapAllocator().Free(p_VertexBufferGPU.Get());
+		DX12RenderingPipeline::GetHeapAllocator().Free(p_IndexBufferGPU.Get());
+
 		for (auto& tex : Data.textures)
 		{
 			free(tex.data);
@@ -2,6 +2,7 @@
 
 #include "wrl/client.h"
 #include "MathUtil.h"
+#include "Bounds.h"
 #include "DX12RenderingPipeline.h"
 #include "DX12Geometry.h"
 #include "Material.h"
@@ -19,10 +20,15 @@ struct Primitive
 	size_t NumIndices;
 	size_t StartIndexLocation;	// The location of the first index read by the GPU from the index buffer. == Number of indices before the first index of this primitive
 	size_t BaseVertexLocation;  // A value added to each index before reading a vertex from the vertex buffer == Number of vertices before the first vertex of this primitive
-	int MaterialId;	// To retrieve material properties is the unordered map
-	std::string MaterialName;	// To retrieve material properties is the unordered map
+	int MaterialId;	// Index of the material properties in MeshData::materials
 
 	DirectX::XMMATRIX WorldMatrix;
+
+	// Object space bounds
+	AABB Bounds;
+
+	// UV units per object space unit : sqrt(UV area / surface area), used to estimate which texture mips are needed
+	float UvDensity = 0.0f;
 };
 
 struct MeshData
@@ -32,7 +38,9 @@ struct MeshData
 	std::vector<Primitive> Primitives;
 
 	std::vector<MaterialProperties> materials;
-	std::unordered_map<const char*, int> materialTable;
+	std::unordered_map<NameId, int> materialTable;	// By interned glTF material name
+	std::unordered_map<MaterialContentKey, int, MaterialContentKey::Hasher> materialContentTable;	// By parameters and textures
+	int numDuplicateMaterials = 0;	// glTF materials replaced by an identical one
 
 	std::vector<Texture> textures;
 	std::unordered_map<const char*, int> textureTable;
@@ -64,8 +72,8 @@ namespace ToyDX
 			p_IndexBufferGPU.Reset();
 
 			// Create the vertex buffer and a view to it
-			p_VertexBufferGPU = DX12RenderingPipeline::CreateDefaultBuffer(a_Vertices, ui64_VertexBufferSizeInBytes, p_VertexBufferCPU, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
-			p_IndexBufferGPU = DX12RenderingPipeline::CreateDefaultBuffer(a_Indices, ui64_IndexBufferSizeInBytes, p_IndexBufferCPU, D3D12_RESOURCE_STATE_INDEX_BUFFER);
+			p_VertexBufferGPU = DX12RenderingPipeline::CreateDefaultBuffer(a_Vertices, ui64_VertexBufferSizeInBytes);
+			p_IndexBufferGPU = DX12RenderingPipeline::CreateDefaultBuffer(a_Indices, ui64_IndexBufferSizeInBytes);
 
 			// Create buffer views
 			m_VertexBufferView = DX12RenderingPipeline::CreateVertexBufferView(p_VertexBufferGPU, ui64_VertexBufferSizeInBytes, sizeof(T));
@@ -92,10 +100,6 @@ namespace ToyDX
 		Microsoft::WRL::ComPtr<ID3D12Resource> p_VertexBufferGPU = nullptr;
 		Microsoft::WRL::ComPtr<ID3D12Resource> p_IndexBufferGPU  = nullptr;
 
-		// Upload buffers
-		Microsoft::WRL::ComPtr<ID3D12Resource> p_VertexBufferCPU  = nullptr;
-		Microsoft::WRL::ComPtr<ID3D12Resource> p_IndexBufferCPU   = nullptr;
-
 		// Descriptors
 		D3D12_INDEX_BUFFER_VIEW  m_IndexBufferView;
 		D3D12_VERTEX_BUFFER_VIEW m_VertexBufferView;
@@ -10,40 +10,117 @@
 #include "TDXMesh.h"
 #include "ToyDXCamera.h"
 #include "FrameResource.h"
+#include "TextureCooker.h"
+#include "ShaderCache.h"
+#include "TaskGraph.h"
 
-void ToyDX::Renderer::Initialize()
+#include "DirectXTex.h"
+
+#include <algorithm>
+#include <execution>
+#include <map>
+#include <thread>
+#include <tuple>
+
+// Below this number of drawables, testing every box with SIMD is faster than walking a tree
+static const size_t s_BvhCullingMinDrawables = 4096;
+
+// Draws are recorded by at most one worker per hardware thread, each with enough draws to amortize
+// the frame state every command list has to bind again
+static const UINT s_MaxRecordingWorkers = 16;
+static const size_t s_MinDrawsPerChunk = 256;
+
+// Persistent CBV/SRV descriptors : twice what the loaded content needs, so that content can be streamed in later
+static const UINT s_MinPersistentDescriptors = 4096;
+static const UINT s_TransientDescriptorsPerFrame = 256;
+
+static_assert(sizeof(PerObjectData) == sizeof(TransformBatch::Output), "Per object constants are written by the transform batch");
+
+static const D3D_SHADER_MACRO s_BindlessDefines[] = { { "BINDLESS", "1" }, { nullptr, nullptr } };
+
+// Source of every shader of the shader table
+struct ShaderSource
 {
-	// Renderer
-	ID3D12CommandAllocator& rst_CommandAllocator = DX12RenderingPipeline::GetCommandAllocator();
-	ID3D12GraphicsCommandList& rst_CommandList = DX12RenderingPipeline::GetCommandList();
-	ID3D12CommandQueue& rst_CommandQueue = DX12RenderingPipeline::GetCommandQueue();
+	const char* Name;
+	const WCHAR* Filename;
+	ShaderKind Kind;
+	const D3D_SHADER_MACRO* Defines;
+};
+
+static const ShaderSource s_ShaderSources[ShaderList::ShaderCount] =
+{
+	{ "Default_Vertex",                      L"./data/shaders/DefaultVertex.hlsl",                ShaderKind::VERTEX, nullptr },
+	{ "Default_Pixel",                       L"./data/shaders/DefaultPixel.hlsl",                 ShaderKind::PIXEL,  nullptr },
+	{ "PbrMetallicRoughness_Pixel",          L"./data/shaders/PBR_MetallicRoughness_Pixel.hlsl",  ShaderKind::PIXEL,  nullptr },
+	{ "Default_Vertex_Bindless",             L"./data/shaders/DefaultVertex.hlsl",                ShaderKind::VERTEX, s_BindlessDefines },
+	{ "PbrMetallicRoughness_Pixel_Bindless", L"./data/shaders/PBR_MetallicRoughness_Pixel.hlsl",  ShaderKind::PIXEL,  s_BindlessDefines },
+};
 
-	ThrowIfFailed(rst_CommandList.Reset(&rst_CommandAllocator, nullptr));
+static const ShaderList s_AllShaders[] = { Default_Vertex, Default_Pixel, PbrMetallicRoughness_Pixel, Default_Vertex_Bindless, PbrMetallicRoughness_Pixel_Bindless };
+static_assert(_countof(s_AllShaders) == ShaderList::ShaderCount, "Every shader is compiled at startup");
 
-	LoadMeshes();
+// Shaders edited at runtime, see RecompileShaders
+static const ShaderList s_RecompiledShaders[] = { PbrMetallicRoughness_Pixel, PbrMetallicRoughness_Pixel_Bindless };
+
+// Shaders and states of every pipeline of the pipeline table
+struct PipelineSource
+{
+	const char* Name;
+	ShaderList VertexShader;
+	ShaderList PixelShader;
+	bool bBindless;
+	D3D12_FILL_MODE FillMode;
+	D3D12_CULL_MODE CullMode;
+};
+
+static const PipelineSource s_PipelineSources[PsoList::PsoCount] =
+{
+	{ "Wireframe",                      Default_Vertex,          Default_Pixel,                       false, D3D12_FILL_MODE_WIREFRAME, D3D12_CULL_MODE_NONE },
+	{ "PBR_MetallicRoughness",          Default_Vertex,          PbrMetallicRoughness_Pixel,          false, D3D12_FILL_MODE_SOLID,     D3D12_CULL_MODE_FRONT },
+	{ "PBR_MetallicRoughness_Bindless", Default_Vertex_Bindless, PbrMetallicRoughness_Pixel_Bindless, true,  D3D12_FILL_MODE_SOLID,     D3D12_CULL_MODE_FRONT },
+};
 
-	ThrowIfFailed(rst_CommandList.Close());
-	ID3D12CommandList* a_CmdLists[1] = { &rst_CommandList };
-	rst_CommandQueue.ExecuteCommandLists(_countof(a_CmdLists), a_CmdLists);
-	DX12RenderingPipeline::FlushCommandQueue();
+// Indirect commands are built without the D3D12 headers
+static_assert(sizeof(IndirectVertexBufferView) == sizeof(D3D12_VERTEX_BUFFER_VIEW), "Indirect vertex buffer view must match D3D12_VERTEX_BUFFER_VIEW");
+static_assert(sizeof(IndirectIndexBufferView) == sizeof(D3D12_INDEX_BUFFER_VIEW), "Indirect index buffer view must match D3D12_INDEX_BUFFER_VIEW");
+static_assert(sizeof(IndirectDrawIndexedArguments) == sizeof(D3D12_DRAW_INDEXED_ARGUMENTS), "Indirect draw arguments must match D3D12_DRAW_INDEXED_ARGUMENTS");
+static_assert(IndirectDrawCommand::NumRootConstants * sizeof(UINT) == sizeof(DrawConstants), "Indirect root constants must be the draw constants");
+
+void ToyDX::Renderer::Initialize()
+{
+	// Renderer
+	// Vertex, index buffers and textures are uploaded in batches on the copy queue, the first frame waits for them on the GPU
+	LoadMeshes();
 
 	BuildFrameResources();
 
 	CreateDescriptorHeap_Cbv_Srv();
 
+	m_TextureStreamer = std::make_unique<TextureStreamer>();
+
 	CreateFallbackTexture();
 	LoadTextures();
 
+	const UploadTicket uploads = DX12RenderingPipeline::GetUploadManager().Submit();
+	LOG_INFO("Renderer: Static resources uploads submitted (last batch {0}).", uploads);
+	DX12RenderingPipeline::GetHeapAllocator().LogStats();
+
 	LoadMaterials();
 	BuildDrawables();
 	
-	LoadShaders();
 	CreateStaticSamplers();
 
 	CreateConstantBufferViews(); // Per object, pass, materials CBVs
 
+	CheckBindlessSupport();
+
 	BuildRootSignature();
-	CreatePipelineStateObjects();
+	if (m_bBindlessSupported)
+	{
+		BuildBindlessRootSignature();
+		BuildIndirectCommandSignature();
+	}
+	BuildPipelines(s_AllShaders);
 }
 
 void ToyDX::Renderer::UpdateFrameResource()
@@ -65,28 +142,43 @@ void ToyDX::Renderer::UpdateFrameResource()
 		CloseHandle(eventHandle);
 	}
 
+	// The GPU is done with the constants of the last frame that used this frame resource
+	m_CurrentFrameResource->frameConstants->Reset();
+	m_CbvSrvDescriptors->BeginFrame(m_CurrentFrameResourceIdx);
+
+	// Staging memory of the uploads the copy queue is done with
+	DX12RenderingPipeline::GetUploadManager().RetireCompletedBatches();
+
+	// Resources replaced while the previous frames were in flight
+	DX12RenderingPipeline::GetHeapAllocator().RetireDeferredFrees(LastCompletedFenceValue);
+
+	UpdateTextureStreaming();
+
 	UpdatePerObjectCBs();
 	UpdatePerPassCB();
 	UpdateMaterialCBs();
+
+	CullDrawables();
 }
 
 void ToyDX::Renderer::UpdatePerObjectCBs()
 {
-	// Called once per frame
-	UploadBuffer* currObjectCB = m_CurrentFrameResource->cbPerObject.get();
+	// Called once per frame, only the changed drawables are visited
+	const std::vector<uint32_t>& dirtyDrawables = m_DirtyDrawables.GetDirty();
 
-	for (auto& d : m_AllDrawables)
+	for (uint32_t i : dirtyDrawables)
 	{
-		if (d->NumFramesDirty > 0)
-		{
-			PerObjectData perObjectData;
-			DirectX::XMStoreFloat4x4(&perObjectData.gWorld, DirectX::XMMatrixTranspose(d->GetWorld()));
-			DirectX::XMStoreFloat4x4(&perObjectData.gWorldInvTranspose, DirectX::XMMatrixTranspose(DirectX::XMMatrixInverse(nullptr, d->GetWorld())));
-			
-			currObjectCB->CopyData(d->PerObjectCbIndex, &perObjectData, sizeof(PerObjectData));
-			d->NumFramesDirty--;
-		}
+		Drawable* d = m_AllDrawables[i].get();
+
+		m_ObjectTransforms.SetWorld(i, d->GetWorld());
+		SetDrawableBounds(i, d->GetWorldBounds());
 	}
+
+	// Matrices are only computed for the changed drawables, then streamed to the mapped structured buffer at their per object index
+	m_ObjectTransforms.Update(dirtyDrawables.data(), dirtyDrawables.size());
+	m_ObjectTransforms.Write(dirtyDrawables.data(), dirtyDrawables.size(), m_CurrentFrameResource->sbPerObject->GetMappedData(), sizeof(PerObjectData), TransformOutput::ByObjectIndex);
+
+	m_DirtyDrawables.Advance();
 }
 
 void ToyDX::Renderer::UpdatePerPassCB()
@@ -107,39 +199,48 @@ void ToyDX::Renderer::UpdatePerPassCB()
 	
 	UploadBuffer* currPassCB = m_CurrentFrameResource->cbPerPass.get();
 	currPassCB->CopyData(0, &perPassData, sizeof(PerPassData));
+
+	// Table of this frame, shared by every recording worker
+	const D3D12_CPU_DESCRIPTOR_HANDLE passCbv = m_CbvSrvDescriptors->GetStagingHandle(m_PassCbvs.Index + m_CurrentFrameResourceIdx);
+	m_PassCbvTable = m_CbvSrvDescriptors->GetGpuHandle(m_CbvSrvDescriptors->CopyToTransient(1, &passCbv));
 }
 
 void ToyDX::Renderer::UpdateMaterialCBs()
 {
 	UploadBuffer* currMaterialCb = m_CurrentFrameResource->cbMaterial.get();
 
-	for (auto& material : m_Materials)
+	// Only the changed materials are visited
+	for (MaterialHandle materialHandle : m_DirtyMaterials.GetDirty())
 	{
-		Material* mat = material.second.get();
+		const Material* mat = &m_Materials[materialHandle];
 
-		if (mat->NumFramesDirty > 0)
-		{
-			XMMATRIX matTransform = XMLoadFloat4x4(&mat->MatTransform);
+		XMMATRIX matTransform = XMLoadFloat4x4(&mat->MatTransform);
 
-			//MaterialConstants matConstants;
+		//MaterialConstants matConstants;
 
-			//matConstants.DiffuseFactor    = mat->properties.specularGlossiness.DiffuseFactor;
-			//matConstants.SpecularFactor   = mat->properties.specularGlossiness.SpecularFactor;
-			//matConstants.GlossinessFactor = mat->properties.specularGlossiness.GlossinessFactor;
+		//matConstants.DiffuseFactor    = mat->properties.specularGlossiness.DiffuseFactor;
+		//matConstants.SpecularFactor   = mat->properties.specularGlossiness.SpecularFactor;
+		//matConstants.GlossinessFactor = mat->properties.specularGlossiness.GlossinessFactor;
 
-			//currMaterialCb->CopyData(mat->CBIndex, &matConstants, sizeof(MaterialConstants));
+		//currMaterialCb->CopyData(mat->CBIndex, &matConstants, sizeof(MaterialConstants));
 
-			MetallicRoughnessMaterial matConstants;
+		MetallicRoughnessMaterial matConstants;
 
-			matConstants.BaseColor = mat->properties.metallicRoughness.BaseColor;
-			matConstants.Metallic  = mat->properties.metallicRoughness.Metallic;
-			matConstants.Roughness = mat->properties.metallicRoughness.Roughness;
+		matConstants.BaseColor = mat->properties.metallicRoughness.BaseColor;
+		matConstants.Metallic  = mat->properties.metallicRoughness.Metallic;
+		matConstants.Roughness = mat->properties.metallicRoughness.Roughness;
 
-			currMaterialCb->CopyData(mat->CBIndex, &matConstants, sizeof(MetallicRoughnessMaterial));
+		// Same textures as the per draw descriptor tables, the bindless texture table starts at the first persistent descriptor
+		const bool bSpecGloss = mat->properties.type == MaterialWorkflowType::SpecularGlossiness;
+		matConstants.BaseColorTexture = bSpecGloss ? mat->DiffuseSrvHeapIndex : mat->BaseColorSrvHeapIndex;
+		matConstants.MetallicRoughnessTexture = bSpecGloss ? mat->properties.specularGlossiness.SpecGlossSrvHeapIndex : mat->properties.metallicRoughness.MetallicRoughnessSrvHeapIndex;
+		matConstants.NormalTexture = mat->NormalSrvHeapIndex;
 
-			mat->NumFramesDirty--;
-		}
+		currMaterialCb->CopyData(mat->CBIndex, &matConstants, sizeof(MetallicRoughnessMaterial));
+		m_CurrentFrameResource->sbMaterial->CopyData(mat->CBIndex, &matConstants, sizeof(MetallicRoughnessMaterial));
 	}
+
+	m_DirtyMaterials.Advance();
 }
 
 std::vector<UINT8> ToyDX::Renderer::CreateFallbackTexture()
@@ -178,39 +279,35 @@ std::vector<UINT8> ToyDX::Renderer::CreateFallbackTexture()
 	}
 	
 	m_FallbackTexture.Name = "Fallback Texture";
-	m_FallbackTexture.SrvHeapIndex = m_IndexOf_FirstSrv_DescriptorHeap;
+	m_FallbackTexture.SrvHeapIndex = m_CbvSrvDescriptors->AllocatePersistent().Index;
 
-	DX12RenderingPipeline::CreateTexture2D(TextureWidth, TextureHeight, 4, DXGI_FORMAT_R8G8B8A8_UNORM, pData, m_FallbackTexture.Resource, m_FallbackTexture.UploadHeap, L"Fallback Texture");
+	DX12RenderingPipeline::CreateTexture2D(TextureWidth, TextureHeight, 4, DXGI_FORMAT_R8G8B8A8_UNORM, pData, m_FallbackTexture.Resource, L"Fallback Texture");
 
 	m_Textures[0] = &m_FallbackTexture;
 
 	return data;
 }
 
-void ToyDX::Renderer::RenderDrawables(ID3D12GraphicsCommandList& r_cmdList, std::vector<Drawable*>& opaques)
+void ToyDX::Renderer::RenderDrawables(FilteredCommandList<>& r_cmdList, std::span<Drawable* const> opaques, std::span<const D3D12_GPU_VIRTUAL_ADDRESS> objectCbvs)
 {
-	size_t NumFrameResources = m_FrameResources.size();
-	size_t NumMaterials = m_Materials.size();
-	size_t NumOpaques = m_AllDrawables.size();
-	size_t NumPerPassCbv = m_FrameResources.size(); // 1 pass cbv per frame resource
+	const DescriptorAllocator& descriptors = *m_CbvSrvDescriptors;
 
-	for (size_t i=0; i < NumOpaques; ++i)
+	for (size_t i = 0; i < opaques.size(); ++i)
 	{
-		Drawable* obj = m_AllDrawables[i].get();
+		Drawable* obj = opaques[i];
+
 		r_cmdList.IASetPrimitiveTopology(obj->PrimitiveTopology);
 		r_cmdList.IASetVertexBuffers(0, 1, &obj->Mesh->GetVertexBufferView());
 		r_cmdList.IASetIndexBuffer(&obj->Mesh->GetIndexBufferView());
 		
-		// Offset in the descriptor heap for this drawable's per object constant buffer
-		size_t perObjectCBDescriptor = m_CurrentFrameResourceIdx * NumOpaques + obj->PerObjectCbIndex;
-		D3D12_GPU_DESCRIPTOR_HANDLE objectDescriptorTable = CD3DX12_GPU_DESCRIPTOR_HANDLE(m_CbvSrvHeap->GetGPUDescriptorHandleForHeapStart()).Offset(perObjectCBDescriptor, DX12RenderingPipeline::CBV_SRV_UAV_Size);
-		r_cmdList.SetGraphicsRootDescriptorTable(0, objectDescriptorTable);
+		// Per object constants of this frame, bound directly without a descriptor
+		r_cmdList.SetGraphicsRootConstantBufferView(0, objectCbvs[i]);
 
 		// Set material
 		{
-			size_t matDescriptor = (m_IndexOf_FirstMaterialCbv_DescriptorHeap + m_CurrentFrameResourceIdx * NumMaterials) + obj->material->CBIndex;
+			UINT matDescriptor = m_MaterialCbvs[m_CurrentFrameResourceIdx].Index + obj->material->CBIndex;
 
-			D3D12_GPU_DESCRIPTOR_HANDLE matDescriptorTable = CD3DX12_GPU_DESCRIPTOR_HANDLE(m_CbvSrvHeap->GetGPUDescriptorHandleForHeapStart()).Offset(matDescriptor, DX12RenderingPipeline::CBV_SRV_UAV_Size);
+			D3D12_GPU_DESCRIPTOR_HANDLE matDescriptorTable = descriptors.GetGpuHandle(matDescriptor);
 			r_cmdList.SetGraphicsRootDescriptorTable(1, matDescriptorTable);
 		}
 
@@ -219,10 +316,10 @@ void ToyDX::Renderer::RenderDrawables(ID3D12GraphicsCommandList& r_cmdList, std:
 			if (obj->material->properties.type == MaterialWorkflowType::SpecularGlossiness)
 			{
 				// Diffuse
-				D3D12_GPU_DESCRIPTOR_HANDLE diffuseTextureTable = CD3DX12_GPU_DESCRIPTOR_HANDLE(m_CbvSrvHeap->GetGPUDescriptorHandleForHeapStart()).Offset(obj->material->DiffuseSrvHeapIndex, DX12RenderingPipeline::CBV_SRV_UAV_Size);
+				D3D12_GPU_DESCRIPTOR_HANDLE diffuseTextureTable = descriptors.GetGpuHandle(obj->material->DiffuseSrvHeapIndex);
 
 				// SpecularGlossiness
-				D3D12_GPU_DESCRIPTOR_HANDLE specGlossTextureTable = CD3DX12_GPU_DESCRIPTOR_HANDLE(m_CbvSrvHeap->GetGPUDescriptorHandleForHeapStart()).Offset(obj->material->properties.specularGlossiness.SpecGlossSrvHeapIndex, DX12RenderingPipeline::CBV_SRV_UAV_Size);
+				D3D12_GPU_DESCRIPTOR_HANDLE specGlossTextureTable = descriptors.GetGpuHandle(obj->material->properties.specularGlossiness.SpecGlossSrvHeapIndex);
 
 				r_cmdList.SetGraphicsRootDescriptorTable(3, diffuseTextureTable);
 				r_cmdList.SetGraphicsRootDescriptorTable(4, specGlossTextureTable);
@@ -230,16 +327,16 @@ void ToyDX::Renderer::RenderDrawables(ID3D12GraphicsCommandList& r_cmdList, std:
 			else if (obj->material->properties.type == MaterialWorkflowType::MetallicRoughness)
 			{
 				// BaseColor
-				D3D12_GPU_DESCRIPTOR_HANDLE baseColor = CD3DX12_GPU_DESCRIPTOR_HANDLE(m_CbvSrvHeap->GetGPUDescriptorHandleForHeapStart()).Offset(obj->material->BaseColorSrvHeapIndex, DX12RenderingPipeline::CBV_SRV_UAV_Size);
+				D3D12_GPU_DESCRIPTOR_HANDLE baseColor = descriptors.GetGpuHandle(obj->material->BaseColorSrvHeapIndex);
 
-				D3D12_GPU_DESCRIPTOR_HANDLE metalRough = CD3DX12_GPU_DESCRIPTOR_HANDLE(m_CbvSrvHeap->GetGPUDescriptorHandleForHeapStart()).Offset(obj->material->properties.metallicRoughness.MetallicRoughnessSrvHeapIndex, DX12RenderingPipeline::CBV_SRV_UAV_Size);
+				D3D12_GPU_DESCRIPTOR_HANDLE metalRough = descriptors.GetGpuHandle(obj->material->properties.metallicRoughness.MetallicRoughnessSrvHeapIndex);
 
 				r_cmdList.SetGraphicsRootDescriptorTable(3, baseColor);
 				r_cmdList.SetGraphicsRootDescriptorTable(4, metalRough);
 			}
 
 			// Normal
-			D3D12_GPU_DESCRIPTOR_HANDLE normalTextureTable = CD3DX12_GPU_DESCRIPTOR_HANDLE(m_CbvSrvHeap->GetGPUDescriptorHandleForHeapStart()).Offset(obj->material->NormalSrvHeapIndex, DX12RenderingPipeline::CBV_SRV_UAV_Size);
+			D3D12_GPU_DESCRIPTOR_HANDLE normalTextureTable = descriptors.GetGpuHandle(obj->material->NormalSrvHeapIndex);
 			r_cmdList.SetGraphicsRootDescriptorTable(5, normalTextureTable);
 		}
 
@@ -259,6 +356,38 @@ void ToyDX::Renderer::RenderDrawables(ID3D12GraphicsCommandList& r_cmdList, std:
 	}
 }
 
+void ToyDX::Renderer::RenderDrawablesBindless(FilteredCommandList<>& r_cmdList, std::span<const InstanceBatch> batches)
+{
+	// Every resource is bound once per frame : a batch only changes its root constants,
+	// and its vertex/index buffers when the mesh changes (other calls are elided by the filtering layer)
+	for (const InstanceBatch& batch : batches)
+	{
+		// Every instance draws the same geometry with the same material
+		Drawable* obj = m_AllDrawables[batch.FirstItem].get();
+
+		r_cmdList.IASetPrimitiveTopology(obj->PrimitiveTopology);
+		r_cmdList.IASetVertexBuffers(0, 1, &obj->Mesh->GetVertexBufferView());
+		r_cmdList.IASetIndexBuffer(&obj->Mesh->GetIndexBufferView());
+
+		const DrawConstants drawConstants = { batch.FirstInstance, (UINT)obj->material->CBIndex };
+		r_cmdList.SetGraphicsRoot32BitConstants(0, sizeof(DrawConstants) / sizeof(UINT), &drawConstants, 0);
+
+		// Draw
+		if (obj->HasSubMeshes)
+		{
+			for (size_t p = 0; p < obj->Mesh->Data.Primitives.size(); ++p)
+			{
+				Primitive* prim = &obj->Mesh->Data.Primitives[p];
+				r_cmdList.DrawIndexedInstanced(prim->NumIndices, batch.NumInstances, prim->StartIndexLocation, prim->BaseVertexLocation, 0);
+			}
+		}
+		else
+		{
+			r_cmdList.DrawIndexedInstanced(obj->NumIndices, batch.NumInstances, obj->StartIndexLocation, obj->BaseVertexLocation, 0);
+		}
+	}
+}
+
 void ToyDX::Renderer::Render()
 {
 	ID3D12CommandAllocator& rst_CommandAllocator    = DX12RenderingPipeline::GetCommandAllocator();
@@ -294,6 +423,10 @@ void ToyDX::Renderer::Render()
 		m_hRenderingPipeline->DSClearValues.DepthStencil.Stencil,
 		0, nullptr); // Clear entire render target
 
+	// Lists recorded this frame : every list but the last one is closed by whoever recorded it
+	m_FrameCmdLists.clear();
+	m_FrameCmdLists.push_back(&r_CmdList);
+
 	if (m_Raster)
 	{
 		RenderRasterized(r_CmdList, backBufferView, depthStencilView);
@@ -303,16 +436,18 @@ void ToyDX::Renderer::Render()
 		RenderRaytraced(r_CmdList, backBufferView, depthStencilView);
 	}
 
+	ID3D12GraphicsCommandList* lastCmdList = m_FrameCmdLists.back();
+
 	// Indicate a state transition on the resource usage.
 	barrier = CD3DX12_RESOURCE_BARRIER::Transition(backBufferResource, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
-	r_CmdList.ResourceBarrier(1, &barrier);
+	lastCmdList->ResourceBarrier(1, &barrier);
 
 	// Stop recording commands
-	ThrowIfFailed(r_CmdList.Close());
+	ThrowIfFailed(lastCmdList->Close());
 
-	// Add command list to GPU command queue for execution
-	ID3D12CommandList* a_CommandLists[] = { &r_CmdList };
-	rst_CommandQueue.ExecuteCommandLists(_countof(a_CommandLists), a_CommandLists);
+	// Add the command lists to GPU command queue for execution, in a single submission
+	std::vector<ID3D12CommandList*> a_CommandLists(m_FrameCmdLists.begin(), m_FrameCmdLists.end());
+	rst_CommandQueue.ExecuteCommandLists((UINT)a_CommandLists.size(), a_CommandLists.data());
 
 	// Present then swap front and back buffer
 	ThrowIfFailed(m_hRenderingPipeline->GetSwapChain()->Present(0, 0)); // SyncInterval = 0  : V-Sync disabled
@@ -335,25 +470,105 @@ void ToyDX::Renderer::RenderRasterized(ID3D12GraphicsCommandList& r_CmdList, D3D
 	// Clear the back buffer and depth buffer.
 	r_CmdList.ClearRenderTargetView(backbufferView, m_hRenderingPipeline->RTClearValues.Color, 0, nullptr);
 
-	r_CmdList.SetPipelineState(m_PSOTable[PsoList::PbrMetallicRoughness].Get());
+	// Draws follow in the worker lists
+	ThrowIfFailed(r_CmdList.Close());
+
+	// Bindless draws are instanced batches of visible drawables, recorded in a single call when they are drawn indirectly
+	const size_t numDraws = m_bBindless ? m_InstanceBatcher.GetBatches().size() : m_VisibleDrawables.size();
+	const size_t numChunks = m_bBindless && m_bIndirect ? 1 : std::clamp<size_t>((numDraws + s_MinDrawsPerChunk - 1) / s_MinDrawsPerChunk, 1, m_NumRecordingWorkers);
+
+	// Chunks are contiguous and executed in order : the draw order of the sorted list is kept
+	m_DrawChunks.resize(numChunks);
+	for (size_t i = 0; i < numChunks; ++i)
+	{
+		DrawChunk& chunk = m_DrawChunks[i];
+		chunk.Worker = (UINT)i;
+		chunk.First = numDraws * i / numChunks;
+		chunk.Count = numDraws * (i + 1) / numChunks - chunk.First;
+		chunk.Stats = {};
+	}
+
+	std::for_each(std::execution::par, m_DrawChunks.begin(), m_DrawChunks.end(), [&](DrawChunk& chunk)
+	{
+		// The last list stays open for the back buffer transition
+		RecordDrawChunk(chunk, backbufferView, depthStencilView, chunk.Worker + 1 < numChunks);
+	});
+
+	m_CommandStats = {};
+	for (const DrawChunk& chunk : m_DrawChunks)
+	{
+		m_CommandStats += chunk.Stats;
+		m_FrameCmdLists.push_back(m_CurrentFrameResource->workerCmdLists[chunk.Worker].Get());
+	}
+}
+
+void ToyDX::Renderer::RecordDrawChunk(DrawChunk& r_Chunk, D3D12_CPU_DESCRIPTOR_HANDLE backbufferView, D3D12_CPU_DESCRIPTOR_HANDLE depthStencilView, bool bClose)
+{
+	ID3D12CommandAllocator* allocator = m_CurrentFrameResource->workerAllocators[r_Chunk.Worker].Get();
+	ID3D12GraphicsCommandList& r_CmdList = *m_CurrentFrameResource->workerCmdLists[r_Chunk.Worker].Get();
+
+	// The frame resource isn't used by the GPU anymore, see UpdateFrameResource
+	ThrowIfFailed(allocator->Reset());
+	ThrowIfFailed(r_CmdList.Reset(allocator, nullptr));
+
+	// A command list doesn't inherit any state : the viewport and render targets are set again
+	r_CmdList.RSSetViewports(1, &m_hRenderingPipeline->GetViewport());
+	r_CmdList.RSSetScissorRects(1, &m_hRenderingPipeline->GetScissorRect());
+	r_CmdList.OMSetRenderTargets(1, &backbufferView, true, &depthStencilView);
+
+	// State calls go through the filtering layer, which drops the ones that wouldn't change anything
+	FilteredCommandList<> cmdList(r_CmdList);
 
 	// Set descriptor heaps containing textures, materials
-	ID3D12DescriptorHeap* descriptorHeaps[] = { m_CbvSrvHeap.Get() };
-	r_CmdList.SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
-	r_CmdList.SetGraphicsRootSignature(m_RootSignature.Get());
+	ID3D12DescriptorHeap* descriptorHeaps[] = { m_CbvSrvDescriptors->GetHeap() };
+	cmdList.SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
 
-	// Build and submit command lists for this frame.
+	// Per pass constant buffer, gathered in the transient region of this frame
+	D3D12_GPU_DESCRIPTOR_HANDLE passCbvDescriptor = m_PassCbvTable;
+
+	if (m_bBindless)
 	{
-		// Set per pass constant buffer
-		int passCbvIndex = m_IndexOf_FirstPerPassCbv_DescriptorHeap + m_CurrentFrameResourceIdx;
-		D3D12_GPU_DESCRIPTOR_HANDLE passCbvDescriptor = CD3DX12_GPU_DESCRIPTOR_HANDLE(m_CbvSrvHeap->GetGPUDescriptorHandleForHeapStart()).Offset(passCbvIndex, DX12RenderingPipeline::CBV_SRV_UAV_Size);
-		r_CmdList.SetGraphicsRootDescriptorTable(2, passCbvDescriptor);
+		cmdList.SetPipelineState(m_PSOTable[PsoList::PbrMetallicRoughness_Bindless].Get());
+		cmdList.SetGraphicsRootSignature(m_BindlessRootSignature.Get());
+
+		// Per object and material data of this frame
+		cmdList.SetGraphicsRootShaderResourceView(1, m_CurrentFrameResource->sbPerObject->GetResource()->GetGPUVirtualAddress());
+		cmdList.SetGraphicsRootShaderResourceView(2, m_CurrentFrameResource->sbMaterial->GetResource()->GetGPUVirtualAddress());
+		cmdList.SetGraphicsRootShaderResourceView(5, m_CurrentFrameResource->sbInstances->GetResource()->GetGPUVirtualAddress());
 
-		// Specify the buffers we are going to render to.
-		r_CmdList.OMSetRenderTargets(1, &backbufferView, true, &depthStencilView);
+		cmdList.SetGraphicsRootDescriptorTable(3, passCbvDescriptor);
+
+		// Every texture
+		D3D12_GPU_DESCRIPTOR_HANDLE texturesDescriptor = m_CbvSrvDescriptors->GetGpuHandle(0);
+		cmdList.SetGraphicsRootDescriptorTable(4, texturesDescriptor);
+
+		if (m_bIndirect)
+		{
+			// Every batch in one call, from the commands built with the batches
+			cmdList.IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+			cmdList.ExecuteIndirect(m_IndirectCommandSignature.Get(), (UINT)m_IndirectCommands.GetCount(), m_CurrentFrameResource->indirectCommands->GetResource(), 0, nullptr, 0);
+		}
+		else
+		{
+			RenderDrawablesBindless(cmdList, std::span<const InstanceBatch>(m_InstanceBatcher.GetBatches()).subspan(r_Chunk.First, r_Chunk.Count));
+		}
+	}
+	else
+	{
+		cmdList.SetPipelineState(m_PSOTable[PsoList::PbrMetallicRoughness].Get());
+		cmdList.SetGraphicsRootSignature(m_RootSignature.Get());
+
+		cmdList.SetGraphicsRootDescriptorTable(2, passCbvDescriptor);
 
 		// Set Per Object Constant Buffer and render
-		RenderDrawables(r_CmdList, m_OpaqueDrawables);
+		RenderDrawables(cmdList, std::span<Drawable* const>(m_VisibleDrawables).subspan(r_Chunk.First, r_Chunk.Count), std::span<const D3D12_GPU_VIRTUAL_ADDRESS>(m_VisibleObjectCbvs).subspan(r_Chunk.First, r_Chunk.Count));
+	}
+
+	r_Chunk.Stats = cmdList.GetStats();
+
+	if (bClose)
+	{
+		ThrowIfFailed(r_CmdList.Close());
 	}
 }
 
@@ -366,13 +581,17 @@ void ToyDX::Renderer::AdvanceToNextFrameResource()
 
 void ToyDX::Renderer::BuildFrameResources()
 {
+	// One recording worker per hardware thread
+	m_NumRecordingWorkers = std::clamp(std::thread::hardware_concurrency(), 1u, s_MaxRecordingWorkers);
+
 	for (int i = 0; i < DefaultNumFrameResources; ++i)
 	{
 		m_FrameResources.push_back(std::make_unique<FrameResource>(
 			DX12RenderingPipeline::GetDevice(),
 			1, // Number of passes
 			m_TotalDrawableCount,// Number of objects
-			m_TotalMaterialCount
+			m_TotalMaterialCount,
+			m_NumRecordingWorkers
 		));
 	}
 
@@ -382,26 +601,18 @@ void ToyDX::Renderer::BuildFrameResources()
 
 void ToyDX::Renderer::CreateDescriptorHeap_Cbv_Srv()
 {
-	size_t NumDrawables = m_TotalDrawableCount;
 	size_t NumFrameResources = m_FrameResources.size();
 	size_t NumMaterials = m_TotalMaterialCount;
 	size_t NumTextures = m_TotalTextureCount;
 
 	// We have 1 CBV per frame resource (per pass constants)
-	// We have 1 CBV per drawable (per object constant)
 	// We have 1 CBV per material (per material constants)
-	// We need to create (NumFrameResources * NumDrawables) + NumFrameResources CBVs
-	size_t NumDescriptors = (NumDrawables + NumMaterials) * NumFrameResources + NumFrameResources + NumTextures;
-	
-	// Offset to the materials CBVs
-	m_IndexOf_FirstMaterialCbv_DescriptorHeap = NumDrawables * NumFrameResources;
+	// Per object constants are bound as root CBVs : they don't need descriptors
+	// Ranges are allocated when the views are created : the heap only has to be large enough
+	size_t NumDescriptors = NumMaterials * NumFrameResources + NumFrameResources + NumTextures;
+	UINT PersistentCapacity = (std::max)(s_MinPersistentDescriptors, (UINT)NumDescriptors * 2);
 
-	// Offset to the per pass CBVs
-	m_IndexOf_FirstPerPassCbv_DescriptorHeap = (NumDrawables + NumMaterials) * NumFrameResources;
-
-	m_IndexOf_FirstSrv_DescriptorHeap = m_IndexOf_FirstPerPassCbv_DescriptorHeap + NumFrameResources;
-
-	m_CbvSrvHeap = DX12RenderingPipeline::CreateDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, NumDescriptors, D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE);
+	m_CbvSrvDescriptors = std::make_unique<DescriptorAllocator>(DX12RenderingPipeline::GetDevice(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, PersistentCapacity, s_TransientDescriptorsPerFrame, (UINT)NumFrameResources);
 }
 
 void ToyDX::Renderer::CreateStaticSamplers()
@@ -456,34 +667,7 @@ void ToyDX::Renderer::CreateStaticSamplers()
 
 void ToyDX::Renderer::CreateConstantBufferViews()
 {
-	// Build per object constant buffer views
-	size_t PerObjectCbSizeCPU = sizeof(PerObjectData);
-	size_t PerObjectCbSizeGPU = UploadBuffer::CalcConstantBufferSize(PerObjectCbSizeCPU);
-
-	size_t NumObjects = m_AllDrawables.size();
-
-	for (int i = 0; i < m_FrameResources.size(); ++i)
-	{
-		const auto& cbObject = m_FrameResources[i]->cbPerObject->GetResource();
-
-		for (int j = 0; j < NumObjects; ++j)
-		{
-			D3D12_GPU_VIRTUAL_ADDRESS CurrentCbGPUAddr = cbObject->GetGPUVirtualAddress();
-
-			// Offset to the jth constant buffer 
-			CurrentCbGPUAddr += j * PerObjectCbSizeGPU;
-
-			// Offset to the its descriptor in the descriptor heap
-			int indexInDescriptorHeap = i * NumObjects + j;
-			D3D12_CPU_DESCRIPTOR_HANDLE descriptor = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_CbvSrvHeap->GetCPUDescriptorHandleForHeapStart()).Offset(indexInDescriptorHeap, DX12RenderingPipeline::CBV_SRV_UAV_Size);
-
-			D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc;
-			cbvDesc.BufferLocation = CurrentCbGPUAddr;
-			cbvDesc.SizeInBytes    = PerObjectCbSizeGPU;
-
-			DX12RenderingPipeline::GetDevice()->CreateConstantBufferView(&cbvDesc, descriptor);
-		}
-	}
+	// Per object constants are allocated each frame for the visible drawables, see UploadVisibleObjectConstants
 
 	// Build materials constant buffer views
 	//size_t MaterialCbSizeCPU = sizeof(MaterialConstants);
@@ -492,10 +676,15 @@ void ToyDX::Renderer::CreateConstantBufferViews()
 
 	size_t NumMaterials = m_Materials.size();
 
+	// Views are written to the staging heap, material CBVs are then committed to the shader visible heap
+	m_MaterialCbvs.resize(m_FrameResources.size());
+
 	for (int i = 0; i < m_FrameResources.size(); ++i)
 	{
 		const auto& materialCB = m_FrameResources[i]->cbMaterial->GetResource();
 
+		m_MaterialCbvs[i] = m_CbvSrvDescriptors->AllocatePersistent((UINT)NumMaterials);
+
 		for (int j = 0; j < NumMaterials; ++j)
 		{
 			D3D12_GPU_VIRTUAL_ADDRESS CurrentCbGPUAddr = materialCB->GetGPUVirtualAddress();
@@ -504,9 +693,7 @@ void ToyDX::Renderer::CreateConstantBufferViews()
 			CurrentCbGPUAddr += j * MaterialCbSizeGPU;
 
 			// Offset to the its descriptor in the descriptor heap
-			int indexInDescriptorHeap = (m_IndexOf_FirstMaterialCbv_DescriptorHeap + i * NumMaterials) + j;
-
-			D3D12_CPU_DESCRIPTOR_HANDLE descriptor = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_CbvSrvHeap->GetCPUDescriptorHandleForHeapStart()).Offset(indexInDescriptorHeap, DX12RenderingPipeline::CBV_SRV_UAV_Size);
+			D3D12_CPU_DESCRIPTOR_HANDLE descriptor = m_CbvSrvDescriptors->GetStagingHandle(m_MaterialCbvs[i].Index + j);
 
 			D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc;
 			cbvDesc.BufferLocation = CurrentCbGPUAddr;
@@ -514,20 +701,23 @@ void ToyDX::Renderer::CreateConstantBufferViews()
 
 			DX12RenderingPipeline::GetDevice()->CreateConstantBufferView(&cbvDesc, descriptor);
 		}
+
+		m_CbvSrvDescriptors->Commit(m_MaterialCbvs[i]);
 	}
 
 	// Build per pass constant buffer views
 	size_t PerPassCbSizeCPU = sizeof(PerPassData);
 	size_t PerPassCbSizeGPU = UploadBuffer::CalcConstantBufferSize(PerPassCbSizeCPU);
 
+	// Copied to the transient region each frame, see UpdatePerPassCB
+	m_PassCbvs = m_CbvSrvDescriptors->AllocatePersistent((UINT)m_FrameResources.size());
+
 	for (int i = 0; i < m_FrameResources.size(); ++i)
 	{
 		D3D12_GPU_VIRTUAL_ADDRESS CurrentCbGPUAddr = m_FrameResources[i]->cbPerPass->GetResource()->GetGPUVirtualAddress();
 
 		// Offset to the its descriptor in the descriptor heap
-		int indexInDescriptorHeap = m_IndexOf_FirstPerPassCbv_DescriptorHeap + i;
-
-		D3D12_CPU_DESCRIPTOR_HANDLE descriptor = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_CbvSrvHeap->GetCPUDescriptorHandleForHeapStart()).Offset(indexInDescriptorHeap, DX12RenderingPipeline::CBV_SRV_UAV_Size);
+		D3D12_CPU_DESCRIPTOR_HANDLE descriptor = m_CbvSrvDescriptors->GetStagingHandle(m_PassCbvs.Index + i);
 
 		D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc;
 		cbvDesc.BufferLocation = CurrentCbGPUAddr;
@@ -539,78 +729,145 @@ void ToyDX::Renderer::CreateConstantBufferViews()
 
 }
 
+// Content of a material as drawn : textures are identified by their SRV, which is the same across meshes
+static MaterialContentKey GetGpuContentKey(const Material& material)
+{
+	MaterialContentKey key = MaterialContentKey::FromProperties(material.properties);
+
+	// Emissive textures are not drawn
+	key.Textures[MaterialContentKey::EmissiveSlot] = -1;
+	key.Textures[MaterialContentKey::NormalSlot]   = material.NormalSrvHeapIndex;
+
+	if (material.properties.type == MaterialWorkflowType::SpecularGlossiness)
+	{
+		key.Textures[MaterialContentKey::DiffuseSlot]            = material.DiffuseSrvHeapIndex;
+		key.Textures[MaterialContentKey::SpecularGlossinessSlot] = material.properties.specularGlossiness.SpecGlossSrvHeapIndex;
+	}
+	else if (material.properties.type == MaterialWorkflowType::MetallicRoughness)
+	{
+		key.Textures[MaterialContentKey::BaseColorSlot]         = material.BaseColorSrvHeapIndex;
+		key.Textures[MaterialContentKey::MetallicRoughnessSlot] = material.properties.metallicRoughness.MetallicRoughnessSrvHeapIndex;
+	}
+
+	return key;
+}
+
 void ToyDX::Renderer::LoadMaterials()
 {
-	int CBIndex = 0;
+	// Drawables keep pointers to the materials : the array is sized once
+	size_t NumMaterials = 0;
+	for (auto& mesh : m_Meshes)
+	{
+		NumMaterials += mesh->Data.materials.size();
+	}
+
+	m_Materials.clear();
+	m_Materials.reserve(NumMaterials);
+	m_MeshMaterials.clear();
+
+	// Materials of different meshes that use the same parameters and SRVs are stored once
+	std::unordered_map<MaterialContentKey, MaterialHandle, MaterialContentKey::Hasher> materialsByContent;
+	size_t NumDuplicates = 0;
+
 	for (auto& mesh : m_Meshes)
 	{
+		std::vector<MaterialHandle>& meshMaterials = m_MeshMaterials.emplace_back();
+		size_t NumMeshDuplicates = 0;
+
 		for (auto& material : mesh->Data.materials)
 		{
-			std::unique_ptr<Material> renderMat = std::make_unique<Material>();
-			renderMat->Name = material.name;
-			renderMat->properties.type = material.type;
-			renderMat->CBIndex = CBIndex++;
+			Material renderMat;
+			renderMat.Name = material.name;
+			renderMat.properties = material;
 
-			// By default : first SRV contains a fallback texture
-			renderMat->NormalSrvHeapIndex = m_IndexOf_FirstSrv_DescriptorHeap;
+			// By default : the fallback texture
+			renderMat.NormalSrvHeapIndex = m_FallbackTexture.SrvHeapIndex;
 
 			if (material.hasNormalMap)
 			{
-				renderMat->NormalSrvHeapIndex = m_Textures.at(material.hNormalTexture)->SrvHeapIndex;
+				renderMat.NormalSrvHeapIndex = m_Textures.at(material.hNormalTexture)->SrvHeapIndex;
 			}
 
 			if (material.type == MaterialWorkflowType::SpecularGlossiness)
 			{
-				renderMat->properties.specularGlossiness = material.specularGlossiness;
+				renderMat.properties.specularGlossiness = material.specularGlossiness;
 				
-				renderMat->DiffuseSrvHeapIndex = m_IndexOf_FirstSrv_DescriptorHeap;
-				renderMat->properties.specularGlossiness.SpecGlossSrvHeapIndex = m_IndexOf_FirstSrv_DescriptorHeap;
+				renderMat.DiffuseSrvHeapIndex = m_FallbackTexture.SrvHeapIndex;
+				renderMat.properties.specularGlossiness.SpecGlossSrvHeapIndex = m_FallbackTexture.SrvHeapIndex;
 
 				if (material.specularGlossiness.hasDiffuse)
 				{
-					renderMat->DiffuseSrvHeapIndex = m_Textures.at(material.specularGlossiness.hDiffuseTexture)->SrvHeapIndex;
+					renderMat.DiffuseSrvHeapIndex = m_Textures.at(material.specularGlossiness.hDiffuseTexture)->SrvHeapIndex;
 				}
 
 				if (material.specularGlossiness.hasSpecularGlossiness)
 				{
-					renderMat->properties.specularGlossiness.SpecGlossSrvHeapIndex = m_Textures.at(material.specularGlossiness.hSpecularGlossinessTexture)->SrvHeapIndex;
+					renderMat.properties.specularGlossiness.SpecGlossSrvHeapIndex = m_Textures.at(material.specularGlossiness.hSpecularGlossinessTexture)->SrvHeapIndex;
 				}
 			}
 
 			else if (material.type == MaterialWorkflowType::MetallicRoughness)
 			{
-				renderMat->properties.metallicRoughness = material.metallicRoughness;
+				renderMat.properties.metallicRoughness = material.metallicRoughness;
 
-				renderMat->BaseColorSrvHeapIndex = m_IndexOf_FirstSrv_DescriptorHeap; // 0 : id of fallback texture by default
-				renderMat->properties.metallicRoughness.MetallicRoughnessSrvHeapIndex = m_IndexOf_FirstSrv_DescriptorHeap;
+				renderMat.BaseColorSrvHeapIndex = m_FallbackTexture.SrvHeapIndex;
+				renderMat.properties.metallicRoughness.MetallicRoughnessSrvHeapIndex = m_FallbackTexture.SrvHeapIndex;
 
 				if (material.metallicRoughness.hasBaseColorTex)
 				{
-					renderMat->BaseColorSrvHeapIndex = m_Textures.at(material.metallicRoughness.hBaseColorTexture)->SrvHeapIndex;
+					renderMat.BaseColorSrvHeapIndex = m_Textures.at(material.metallicRoughness.hBaseColorTexture)->SrvHeapIndex;
 				}
 
 				if (material.metallicRoughness.hasMetallicRoughnessTex)
 				{
-					renderMat->properties.metallicRoughness.MetallicRoughnessSrvHeapIndex = m_Textures.at(material.metallicRoughness.hMetallicRoughnessTexture)->SrvHeapIndex;
+					renderMat.properties.metallicRoughness.MetallicRoughnessSrvHeapIndex = m_Textures.at(material.metallicRoughness.hMetallicRoughnessTexture)->SrvHeapIndex;
 				}
 			}
 
-			m_Materials[material.name.c_str()] = std::move(renderMat);
+			const MaterialContentKey key = GetGpuContentKey(renderMat);
+			auto existing = materialsByContent.find(key);
+
+			if (existing != materialsByContent.end())
+			{
+				meshMaterials.push_back(existing->second);
+				NumMeshDuplicates++;
+				continue;
+			}
+
+			const MaterialHandle handle = (MaterialHandle)m_Materials.size();
+			renderMat.CBIndex = (int)handle;
+
+			m_Materials.push_back(renderMat);
+			materialsByContent.insert({ key, handle });
+			meshMaterials.push_back(handle);
 		}
+
+		if (NumMeshDuplicates > 0)
+		{
+			LOG_INFO("Renderer: {0} of the {1} materials of mesh {2} are shared with previous meshes.", NumMeshDuplicates, mesh->Data.materials.size(), m_MeshMaterials.size() - 1);
+		}
+
+		NumDuplicates += NumMeshDuplicates;
 	}
+
+	LOG_INFO("Renderer: {0} materials, {1} duplicates across meshes removed.", m_Materials.size(), NumDuplicates);
+
+	m_DirtyMaterials.Resize((uint32_t)m_Materials.size());
 }
 
-void ToyDX::Renderer::CreateShaderResourceView(const Texture& texture, ID3D12DescriptorHeap* CbvSrvUavHeap, int SrvIndexInDescriptorHeap)
+void ToyDX::Renderer::CreateShaderResourceView(const Texture& texture)
 {
-	D3D12_CPU_DESCRIPTOR_HANDLE descriptor = CD3DX12_CPU_DESCRIPTOR_HANDLE(CbvSrvUavHeap->GetCPUDescriptorHandleForHeapStart()).Offset(SrvIndexInDescriptorHeap, DX12RenderingPipeline::CBV_SRV_UAV_Size);
+	D3D12_CPU_DESCRIPTOR_HANDLE descriptor = m_CbvSrvDescriptors->GetStagingHandle(texture.SrvHeapIndex);
 
 	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
 	srvDesc.Format = texture.Resource->GetDesc().Format;
 	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-	srvDesc.Texture2D.MipLevels = 1;
+	// Packed textures (R8, R8G8, BC4, BC5) are swizzled back to what the materials sample
+	srvDesc.Shader4ComponentMapping = TextureCooker::GetComponentMapping(texture.Role, srvDesc.Format);
+	srvDesc.Texture2D.MipLevels = texture.Resource->GetDesc().MipLevels;
 
 	DX12RenderingPipeline::GetDevice()->CreateShaderResourceView(texture.Resource.Get(), &srvDesc, descriptor);
+	m_CbvSrvDescriptors->Commit(texture.SrvHeapIndex);
 }
 
 void ToyDX::Renderer::BuildRootSignature()
@@ -620,16 +877,10 @@ void ToyDX::Renderer::BuildRootSignature()
 	CD3DX12_ROOT_PARAMETER rootParameterSlot[6] = { };
 
 	// Create descriptor table of Constant Buffer Views
-	CD3DX12_DESCRIPTOR_RANGE objectsCbvDescriptorTable0(
-		D3D12_DESCRIPTOR_RANGE_TYPE_CBV,
-		1,	// How many CBV descriptors in the table
-		0	// Shader register that this root parameter (here a constant buffer) will be bound to. (e.g register (b0))
-	);
-
 	CD3DX12_DESCRIPTOR_RANGE materialsCbvDescriptorTable1(
 		D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 
-		1,
-		1
+		1,	// How many CBV descriptors in the table
+		1	// Shader register that this root parameter (here a constant buffer) will be bound to. (e.g register (b1))
 	);
 
 	// Create descriptor table of Constant Buffer Views
@@ -663,7 +914,8 @@ void ToyDX::Renderer::BuildRootSignature()
 	);
 
 
-	rootParameterSlot[0].InitAsDescriptorTable(1, &objectsCbvDescriptorTable0);
+	// Per object constants : root CBV, register (b0)
+	rootParameterSlot[0].InitAsConstantBufferView(0);
 	rootParameterSlot[1].InitAsDescriptorTable(1, &materialsCbvDescriptorTable1);
 	rootParameterSlot[2].InitAsDescriptorTable(1, &passCbvDescriptorTable2);
 	rootParameterSlot[3].InitAsDescriptorTable(1, &srvDescriptorTable);
@@ -688,117 +940,227 @@ void ToyDX::Renderer::BuildRootSignature()
 
 	D3D12SerializeRootSignature(&rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1, rootSignatureBlob.GetAddressOf(), errorBlob.GetAddressOf());
 	ThrowIfFailed(DX12RenderingPipeline::GetDevice()->CreateRootSignature(0, rootSignatureBlob->GetBufferPointer(), rootSignatureBlob->GetBufferSize(), IID_PPV_ARGS(m_RootSignature.GetAddressOf())));
+
+	// Pipelines are keyed by the serialized root signature
+	DX12RenderingPipeline::GetPipelineStateCache().RegisterRootSignature(m_RootSignature.Get(), rootSignatureBlob->GetBufferPointer(), rootSignatureBlob->GetBufferSize());
 }
 
-void ToyDX::Renderer::SetRasterizerState(bool bWireframe, bool bBackFaceCulling)
+void ToyDX::Renderer::CheckBindlessSupport()
 {
-	m_RasterizerState =
-	CD3DX12_RASTERIZER_DESC (D3D12_FILL_MODE_WIREFRAME, D3D12_CULL_MODE_NONE,
-    FALSE /* FrontCounterClockwise */,
-    D3D12_DEFAULT_DEPTH_BIAS,
-    D3D12_DEFAULT_DEPTH_BIAS_CLAMP,
-    D3D12_DEFAULT_SLOPE_SCALED_DEPTH_BIAS,
-    TRUE /* DepthClipEnable */,
-    TRUE /* MultisampleEnable */,
-    FALSE /* AntialiasedLineEnable */,
-    0 /* ForceSampleCount */,
-    D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF);
+	D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+	ThrowIfFailed(DX12RenderingPipeline::GetDevice()->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options)));
 
+	// Tier 1 limits a table to a fixed number of SRVs : creating the bindless root signature would fail
+	m_bBindlessSupported = options.ResourceBindingTier >= D3D12_RESOURCE_BINDING_TIER_2;
 
-	// By default : Front face is clockwise
+	if (!m_bBindlessSupported)
+	{
+		LOG_WARN("Renderer: Resource binding tier {0} doesn't support bindless textures, drawing with per draw descriptor tables.", (int)options.ResourceBindingTier);
+		m_bBindless = false;
+	}
 }
 
-void ToyDX::Renderer::CreatePipelineStateObjects()
+void ToyDX::Renderer::BuildBindlessRootSignature()
 {
-	DXGI_FORMAT rtvFormats[] = { DXGI_FORMAT_R8G8B8A8_UNORM };
+	CD3DX12_ROOT_PARAMETER rootParameterSlot[6] = { };
 
-	m_PSOTable[PsoList::Wireframe] = DX12RenderingPipeline::CreatePipelineStateObject
-	(
-		m_RootSignature.Get(),
-		m_ShaderTable[ShaderList::Default_Vertex].GetByteCode(),
-		m_ShaderTable[ShaderList::Default_Pixel].GetByteCode(),
-		*m_AllDrawables[0]->Mesh->GetInputLayout(),
-		rtvFormats,
-		CD3DX12_RASTERIZER_DESC(D3D12_FILL_MODE_WIREFRAME, D3D12_CULL_MODE_NONE,
-			FALSE /* FrontCounterClockwise */,
-			D3D12_DEFAULT_DEPTH_BIAS,
-			D3D12_DEFAULT_DEPTH_BIAS_CLAMP,
-			D3D12_DEFAULT_SLOPE_SCALED_DEPTH_BIAS,
-			TRUE /* DepthClipEnable */,
-			TRUE /* MultisampleEnable */,
-			FALSE /* AntialiasedLineEnable */,
-			0 /* ForceSampleCount */,
-			D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF),
-		_countof(rtvFormats)
+	// Per pass constants : register (b2)
+	CD3DX12_DESCRIPTOR_RANGE passCbvDescriptorTable(
+		D3D12_DESCRIPTOR_RANGE_TYPE_CBV,
+		1,
+		2
 	);
 
-	m_PSOTable[PsoList::Wireframe]->SetName(L"Wireframe");
+	// Every texture SRV, from the first SRV of the heap : register (t0, space2)
+	CD3DX12_DESCRIPTOR_RANGE texturesSrvDescriptorTable(
+		D3D12_DESCRIPTOR_RANGE_TYPE_SRV,
+		UINT_MAX,	// Unbounded
+		0,
+		2
+	);
 
-	/////////////////////////////////////////////////////////////////////////
-	
-	m_PSOTable[PsoList::PbrMetallicRoughness] = DX12RenderingPipeline::CreatePipelineStateObject
+	// First instance and material index of the draw : register (b3)
+	rootParameterSlot[0].InitAsConstants(sizeof(DrawConstants) / sizeof(UINT), 3);
+
+	// Per object and per material structured buffers : register (t0, space1) and register (t1, space1)
+	rootParameterSlot[1].InitAsShaderResourceView(0, 1);
+	rootParameterSlot[2].InitAsShaderResourceView(1, 1);
+
+	rootParameterSlot[3].InitAsDescriptorTable(1, &passCbvDescriptorTable);
+	rootParameterSlot[4].InitAsDescriptorTable(1, &texturesSrvDescriptorTable, D3D12_SHADER_VISIBILITY_PIXEL);
+
+	// Object index of each instance : register (t2, space1)
+	rootParameterSlot[5].InitAsShaderResourceView(2, 1, D3D12_SHADER_VISIBILITY_VERTEX);
+
+	CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc = {};
+	rootSignatureDesc.NumParameters = _countof(rootParameterSlot);
+	rootSignatureDesc.NumStaticSamplers = m_StaticSamplers.size();
+	rootSignatureDesc.pParameters = rootParameterSlot;
+	rootSignatureDesc.pStaticSamplers = m_StaticSamplers.data();
+	rootSignatureDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+
+	ComPtr<ID3DBlob> rootSignatureBlob = nullptr;
+	ComPtr<ID3DBlob> errorBlob = nullptr;
+
+	HRESULT result = D3D12SerializeRootSignature(&rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1, rootSignatureBlob.GetAddressOf(), errorBlob.GetAddressOf());
+	if (errorBlob != nullptr)
+	{
+		LOG_ERROR("Renderer: Bindless root signature : {0}", (char*)errorBlob->GetBufferPointer());
+	}
+
+	ThrowIfFailed(result);
+	ThrowIfFailed(DX12RenderingPipeline::GetDevice()->CreateRootSignature(0, rootSignatureBlob->GetBufferPointer(), rootSignatureBlob->GetBufferSize(), IID_PPV_ARGS(m_BindlessRootSignature.GetAddressOf())));
+	DX12RenderingPipeline::GetPipelineStateCache().RegisterRootSignature(m_BindlessRootSignature.Get(), rootSignatureBlob->GetBufferPointer(), rootSignatureBlob->GetBufferSize());
+}
+
+void ToyDX::Renderer::BuildIndirectCommandSignature()
+{
+	// Same layout as IndirectDrawCommand
+	D3D12_INDIRECT_ARGUMENT_DESC arguments[4] = {};
+
+	// Draw constants : root parameter 0 of the bindless root signature
+	arguments[0].Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+	arguments[0].Constant.RootParameterIndex = 0;
+	arguments[0].Constant.DestOffsetIn32BitValues = 0;
+	arguments[0].Constant.Num32BitValuesToSet = IndirectDrawCommand::NumRootConstants;
+
+	arguments[1].Type = D3D12_INDIRECT_ARGUMENT_TYPE_VERTEX_BUFFER_VIEW;
+	arguments[1].VertexBuffer.Slot = 0;
+
+	arguments[2].Type = D3D12_INDIRECT_ARGUMENT_TYPE_INDEX_BUFFER_VIEW;
+
+	arguments[3].Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+
+	D3D12_COMMAND_SIGNATURE_DESC commandSignatureDesc = {};
+	commandSignatureDesc.ByteStride = IndirectCommandBuilder::ByteStride;
+	commandSignatureDesc.NumArgumentDescs = _countof(arguments);
+	commandSignatureDesc.pArgumentDescs = arguments;
+
+	// Root arguments are changed : the command signature is tied to the root signature
+	ThrowIfFailed(DX12RenderingPipeline::GetDevice()->CreateCommandSignature(&commandSignatureDesc, m_BindlessRootSignature.Get(), IID_PPV_ARGS(m_IndirectCommandSignature.GetAddressOf())));
+}
+
+// Every pipeline uses the same rasterizer state but for the fill and cull modes
+static CD3DX12_RASTERIZER_DESC MakeRasterizerDesc(D3D12_FILL_MODE e_FillMode, D3D12_CULL_MODE e_CullMode)
+{
+	return CD3DX12_RASTERIZER_DESC(e_FillMode, e_CullMode,
+		FALSE /* FrontCounterClockwise */,
+		D3D12_DEFAULT_DEPTH_BIAS,
+		D3D12_DEFAULT_DEPTH_BIAS_CLAMP,
+		D3D12_DEFAULT_SLOPE_SCALED_DEPTH_BIAS,
+		TRUE /* DepthClipEnable */,
+		TRUE /* MultisampleEnable */,
+		FALSE /* AntialiasedLineEnable */,
+		0 /* ForceSampleCount */,
+		D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF);
+}
+
+void ToyDX::Renderer::SetRasterizerState(bool bWireframe, bool bBackFaceCulling)
+{
+	m_RasterizerState = MakeRasterizerDesc(D3D12_FILL_MODE_WIREFRAME, D3D12_CULL_MODE_NONE);
+
+	// By default : Front face is clockwise
+}
+
+void ToyDX::Renderer::BuildPipelines(std::span<const ShaderList> shaders)
+{
+	TaskGraph graph;
+
+	TaskGraph::TaskId shaderTasks[ShaderList::ShaderCount];
+	std::fill(std::begin(shaderTasks), std::end(shaderTasks), TaskGraph::InvalidTask);
+
+	for (ShaderList shader : shaders)
+	{
+		// Bindless shaders are only compiled for the bindless pipelines
+		if (s_ShaderSources[shader].Defines == s_BindlessDefines && !m_bBindlessSupported)
+		{
+			continue;
+		}
+
+		shaderTasks[shader] = graph.AddTask(s_ShaderSources[shader].Name, [this, shader]() { CompileShader(shader); });
+	}
+
+	// Shaders that are not compiled again are already there : the pipelines using them only wait for the other ones
+	for (int pso = 0; pso < PsoList::PsoCount; ++pso)
+	{
+		const PipelineSource& source = s_PipelineSources[pso];
+		if (source.bBindless && !m_bBindlessSupported)
+		{
+			continue;
+		}
+
+		graph.AddTask(source.Name, [this, pso]() { CreatePipelineStateObject((PsoList)pso); }, { shaderTasks[source.VertexShader], shaderTasks[source.PixelShader] });
+	}
+
+	// Startup is bounded by the slowest chain of a shader and its pipeline instead of the sum of every task
+	graph.Run();
+	graph.LogStats("Pipelines");
+
+	ShaderCache::LogStats();
+
+	ToyDX::PipelineStateCache& pipelineCache = DX12RenderingPipeline::GetPipelineStateCache();
+	pipelineCache.LogStats();
+	pipelineCache.SaveLibrary();
+}
+
+void ToyDX::Renderer::CompileShader(ShaderList e_Shader)
+{
+	const ShaderSource& source = s_ShaderSources[e_Shader];
+	m_ShaderTable[e_Shader].Compile(source.Filename, "main", source.Kind, source.Defines);
+}
+
+void ToyDX::Renderer::CreatePipelineStateObject(PsoList e_Pso)
+{
+	// Pipelines go through the pipeline state cache : unchanged ones are not created again (e.g. after RecompileShaders)
+	// and the ones created on a previous launch are loaded from the pipeline library
+	const PipelineSource& source = s_PipelineSources[e_Pso];
+	DXGI_FORMAT rtvFormats[] = { DXGI_FORMAT_R8G8B8A8_UNORM };
+
+	m_PSOTable[e_Pso] = DX12RenderingPipeline::CreatePipelineStateObject
 	(
-		m_RootSignature.Get(),
-		m_ShaderTable[ShaderList::Default_Vertex].GetByteCode(),
-		m_ShaderTable[ShaderList::PbrMetallicRoughness_Pixel].GetByteCode(),
+		source.bBindless ? m_BindlessRootSignature.Get() : m_RootSignature.Get(),
+		m_ShaderTable[source.VertexShader].GetByteCode(),
+		m_ShaderTable[source.PixelShader].GetByteCode(),
 		*m_AllDrawables[0]->Mesh->GetInputLayout(),
 		rtvFormats,
-		CD3DX12_RASTERIZER_DESC(D3D12_FILL_MODE_SOLID, D3D12_CULL_MODE_FRONT,
-			FALSE /* FrontCounterClockwise */,
-			D3D12_DEFAULT_DEPTH_BIAS,
-			D3D12_DEFAULT_DEPTH_BIAS_CLAMP,
-			D3D12_DEFAULT_SLOPE_SCALED_DEPTH_BIAS,
-			TRUE /* DepthClipEnable */,
-			TRUE /* MultisampleEnable */,
-			FALSE /* AntialiasedLineEnable */,
-			0 /* ForceSampleCount */,
-			D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF),
+		MakeRasterizerDesc(source.FillMode, source.CullMode),
 		_countof(rtvFormats)
 	);
-	
-	m_PSOTable[PsoList::PbrMetallicRoughness]->SetName(L"PBR_MetallicRoughness");
+
+	const std::string name = source.Name;
+	m_PSOTable[e_Pso]->SetName(std::wstring(name.begin(), name.end()).c_str());
 }
 
 void ToyDX::Renderer::RecompileShaders()
 {
-	DXGI_FORMAT rtvFormats[] = { DXGI_FORMAT_R8G8B8A8_UNORM };
+	// Only the pipelines whose shaders changed are created
+	BuildPipelines(s_RecompiledShaders);
+}
 
-	m_ShaderTable[ShaderList::PbrMetallicRoughness_Pixel].Compile(L"./data/shaders/PBR_MetallicRoughness_Pixel.hlsl", "main", ShaderKind::PIXEL);
+void ToyDX::Renderer::ToggleRenderMode()
+{
+	m_Raster = !m_Raster;
+}
 
-	m_PSOTable[PsoList::PbrMetallicRoughness] =
-		DX12RenderingPipeline::CreatePipelineStateObject
-		(
-			m_RootSignature.Get(),
-			m_ShaderTable[ShaderList::Default_Vertex].GetByteCode(),
-			m_ShaderTable[ShaderList::PbrMetallicRoughness_Pixel].GetByteCode(),
-			*m_AllDrawables[0]->Mesh->GetInputLayout(),
-			rtvFormats,
+void ToyDX::Renderer::ToggleBindless()
+{
+	if (!m_bBindlessSupported)
+	{
+		LOG_WARN("Renderer: Bindless textures are not supported by this device.");
+		return;
+	}
 
-			CD3DX12_RASTERIZER_DESC(D3D12_FILL_MODE_SOLID, D3D12_CULL_MODE_FRONT,
-				FALSE /* FrontCounterClockwise */,
-				D3D12_DEFAULT_DEPTH_BIAS,
-				D3D12_DEFAULT_DEPTH_BIAS_CLAMP,
-				D3D12_DEFAULT_SLOPE_SCALED_DEPTH_BIAS,
-				TRUE /* DepthClipEnable */,
-				TRUE /* MultisampleEnable */,
-				FALSE /* AntialiasedLineEnable */,
-				0 /* ForceSampleCount */,
-				D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF),
-			_countof(rtvFormats)
-		);
+	m_bBindless = !m_bBindless;
 }
 
-void ToyDX::Renderer::LoadShaders()
+void ToyDX::Renderer::ToggleOcclusionCulling()
 {
-	m_ShaderTable[ShaderList::Default_Vertex].Compile(L"./data/shaders/DefaultVertex.hlsl", "main", ShaderKind::VERTEX);
-	m_ShaderTable[ShaderList::Default_Pixel].Compile(L"./data/shaders/DefaultPixel.hlsl", "main", ShaderKind::PIXEL);
-
-	m_ShaderTable[ShaderList::PbrMetallicRoughness_Pixel].Compile(L"./data/shaders/PBR_MetallicRoughness_Pixel.hlsl", "main", ShaderKind::PIXEL);
+	m_bOcclusionCulling = !m_bOcclusionCulling;
 }
 
-void ToyDX::Renderer::ToggleRenderMode()
+void ToyDX::Renderer::ToggleIndirect()
 {
-	m_Raster = !m_Raster;
+	m_bIndirect = !m_bIndirect;
 }
 
 void ToyDX::Renderer::LoadMeshes()
@@ -835,25 +1197,58 @@ void ToyDX::Renderer::LoadMeshes()
 
 void ToyDX::Renderer::LoadTextures()
 {
-	CreateShaderResourceView(m_FallbackTexture, m_CbvSrvHeap.Get(), m_FallbackTexture.SrvHeapIndex);
-
-	int TextureNumber = 1; // Id 0 is reserverd for a fallback texture 
+	CreateShaderResourceView(m_FallbackTexture);
 
 	for (auto& mesh : m_Meshes)
 	{
 		for (auto& texture : mesh->Data.textures)
 		{
-			std::string name = texture.Name ? std::string("Unnamed Texture") : std::string(texture.Name);
+			std::string name = texture.Name ? std::string(texture.Name) : std::string("Unnamed Texture");
+
+			const DescriptorRange srv = m_CbvSrvDescriptors->AllocatePersistent();
+			texture.SrvHeapIndex = srv.Index;
 
-			DX12RenderingPipeline::CreateTexture2D(texture.Width, texture.Height, texture.Channels, DXGI_FORMAT_R8G8B8A8_UNORM, texture.data, texture.Resource, texture.UploadHeap,  std::wstring(&name[0], &name[name.size()]));
+			if (texture.Cooked)
+			{
+				// Mip chain from the texture cooker, streamed in by the TextureStreamer
+				const DirectX::TexMetadata& metadata = texture.Cooked->GetMetadata();
+
+				// The top mip of a block compressed texture must be 4x4 block aligned
+				// Mips from the first unaligned one on are accounted as a single tail, in the entry of the mip before it :
+				// streamer levels stay the indices of the cooked mips, which CreateStreamedTexture takes as top mip
+				std::vector<uint64_t> mipSizes;
+				bool bInTail = false;
+				for (size_t mip = 0; mip < metadata.mipLevels; ++mip)
+				{
+					const DirectX::Image* image = texture.Cooked->GetImage(mip, 0, 0);
+					const bool bCanBeTopMip = !DirectX::IsCompressed(metadata.format) || (image->width % 4 == 0 && image->height % 4 == 0);
+
+					bInTail = bInTail || (!bCanBeTopMip && !mipSizes.empty());
+
+					if (bInTail)
+					{
+						mipSizes.back() += image->slicePitch;
+					}
+					else
+					{
+						mipSizes.push_back(image->slicePitch);
+					}
+				}
+
+				texture.StreamingHandle = m_TextureStreamer->RegisterTexture((uint32_t)metadata.width, (uint32_t)metadata.height, mipSizes);
+				m_StreamedTextures.push_back(&texture);
+				m_StreamedTextureSrvs.push_back(srv);
 
-			texture.SrvHeapIndex = m_IndexOf_FirstSrv_DescriptorHeap + TextureNumber;
+				CreateStreamedTexture(texture, m_TextureStreamer->GetResidentMip(texture.StreamingHandle));
+			}
+			else
+			{
+				DX12RenderingPipeline::CreateTexture2D(texture.Width, texture.Height, texture.Channels, texture.Format, texture.data, texture.Resource, std::wstring(&name[0], &name[name.size()]));
 
-			CreateShaderResourceView(texture, m_CbvSrvHeap.Get(), texture.SrvHeapIndex);
+				CreateShaderResourceView(texture);
+			}
 
 			m_Textures[texture.Id] = &texture;
-
-			++TextureNumber;
 		}
 	}
 }
@@ -861,16 +1256,448 @@ void ToyDX::Renderer::LoadTextures()
 void ToyDX::Renderer::BuildDrawables()
 {
 	int PerObjectCbIndex = 0;
-	for (auto& mesh : m_Meshes)
+	for (uint32_t meshId = 0; meshId < m_Meshes.size(); ++meshId)
 	{
+		auto& mesh = m_Meshes[meshId];
+
 		for (auto& primitive : mesh->Data.Primitives)
 		{
-			Material* rendererMaterial = m_Materials.at(primitive.MaterialName.c_str()).get();
+			Material* rendererMaterial = &m_Materials[m_MeshMaterials[meshId][primitive.MaterialId]];
 			
 			m_AllDrawables.push_back(std::make_unique<Drawable>(mesh.get(), &primitive, rendererMaterial));
 			m_AllDrawables.back()->PerObjectCbIndex = PerObjectCbIndex++;
+			m_AllDrawables.back()->MeshId = meshId;
+		}
+	}
+
+	// Drawables drawing the same index range of the same mesh share their geometry
+	std::map<std::tuple<uint32_t, size_t, size_t, size_t, bool>, uint32_t> geometryIds;
+	for (auto& drawable : m_AllDrawables)
+	{
+		const auto geometry = std::make_tuple(drawable->MeshId, drawable->StartIndexLocation, drawable->BaseVertexLocation, drawable->NumIndices, drawable->HasSubMeshes);
+		drawable->GeometryId = geometryIds.try_emplace(geometry, (uint32_t)geometryIds.size()).first->second;
+	}
+
+	m_DrawList.Reserve(m_AllDrawables.size());
+	m_InstanceBatcher.Reserve(m_AllDrawables.size());
+
+	// A drawable with sub-meshes is drawn with one indirect command per primitive of its mesh
+	UINT numPrimitiveDraws = 0;
+	for (const auto& drawable : m_AllDrawables)
+	{
+		numPrimitiveDraws += drawable->HasSubMeshes ? (UINT)drawable->Mesh->Data.Primitives.size() : 1;
+	}
+
+	m_IndirectCommands.Reserve(numPrimitiveDraws);
+	for (auto& frameResource : m_FrameResources)
+	{
+		frameResource->ReserveIndirectCommands(numPrimitiveDraws);
+	}
+	m_ObjectTransforms.Resize((uint32_t)m_AllDrawables.size());
+	m_DirtyDrawables.Resize((uint32_t)m_AllDrawables.size());
+
+	m_FrustumCuller.Resize((uint32_t)m_AllDrawables.size());
+	m_DrawableBounds.resize(m_AllDrawables.size());
+	for (uint32_t i = 0; i < m_AllDrawables.size(); ++i)
+	{
+		SetDrawableBounds(i, m_AllDrawables[i]->GetWorldBounds());
+	}
+
+	m_bUseDrawableBvh = m_AllDrawables.size() >= s_BvhCullingMinDrawables;
+	if (m_bUseDrawableBvh)
+	{
+		m_DrawableBvh.Build(m_DrawableBounds);
+		m_bDrawableBvhDirty = false;
+
+		LOG_INFO("Renderer: Built a BVH of {0} nodes over {1} drawables.", m_DrawableBvh.GetNumNodes(), m_AllDrawables.size());
+	}
+
+	SelectOccluders();
+
+	RegisterTextureUsages();
+}
+
+void ToyDX::Renderer::CreateStreamedTexture(Texture& texture, int firstMip)
+{
+	// The most detailed resident mip becomes mip 0 of the GPU texture, UVs are unchanged
+	const DirectX::TexMetadata& metadata = texture.Cooked->GetMetadata();
+	const size_t numMips = metadata.mipLevels - firstMip;
+
+	std::vector<D3D12_SUBRESOURCE_DATA> subresources(numMips);
+	for (size_t mip = 0; mip < numMips; ++mip)
+	{
+		const DirectX::Image* image = texture.Cooked->GetImage(firstMip + mip, 0, 0);
+		subresources[mip] = { image->pixels, (LONG_PTR)image->rowPitch, (LONG_PTR)image->slicePitch };
+	}
+
+	const DirectX::Image* topMip = texture.Cooked->GetImage(firstMip, 0, 0);
+	std::string name = texture.Name ? std::string(texture.Name) : std::string("Unnamed Texture");
+
+	DX12RenderingPipeline::CreateTexture2D(topMip->width, (UINT)topMip->height, (UINT16)numMips, metadata.format, subresources.data(), texture.Resource, std::wstring(&name[0], &name[name.size()]));
+
+	CreateShaderResourceView(texture);
+}
+
+void ToyDX::Renderer::RestreamTexture(int streamingHandle)
+{
+	Texture& texture = *m_StreamedTextures[streamingHandle];
+	const int firstMip = m_TextureStreamer->GetResidentMip(streamingHandle);
+
+	// The frames in flight keep sampling the previous resource through the previous SRV : the new texture gets an SRV of its own
+	DescriptorRange srv = m_CbvSrvDescriptors->AllocatePersistent();
+	if (!srv.IsValid())
+	{
+		// No room for a second SRV : the texture is replaced in place once the GPU is idle
+		DX12RenderingPipeline::FlushCommandQueue();
+		CreateStreamedTexture(texture, firstMip);
+		return;
+	}
+
+	// Released once the GPU passes the fence of the last submitted frame
+	DX12RenderingPipeline::GetHeapAllocator().FreeDeferred(std::move(texture.Resource), m_CurrentFence);
+
+	const int previousSrvHeapIndex = texture.SrvHeapIndex;
+	m_CbvSrvDescriptors->FreePersistent(m_StreamedTextureSrvs[streamingHandle]);
+	m_StreamedTextureSrvs[streamingHandle] = srv;
+	texture.SrvHeapIndex = srv.Index;
+
+	CreateStreamedTexture(texture, firstMip);
+
+	RemapMaterialTexture(previousSrvHeapIndex, texture.SrvHeapIndex);
+}
+
+void ToyDX::Renderer::RemapMaterialTexture(int previousSrvHeapIndex, int srvHeapIndex)
+{
+	// Materials point to their textures by SRV index, in their constants (bindless) and per draw tables
+	for (Material& material : m_Materials)
+	{
+		int* srvHeapIndices[] =
+		{
+			&material.NormalSrvHeapIndex,
+			&material.DiffuseSrvHeapIndex,
+			&material.BaseColorSrvHeapIndex,
+			&material.properties.specularGlossiness.SpecGlossSrvHeapIndex,
+			&material.properties.metallicRoughness.MetallicRoughnessSrvHeapIndex
+		};
+
+		bool bRemapped = false;
+		for (int* index : srvHeapIndices)
+		{
+			if (*index == previousSrvHeapIndex)
+			{
+				*index = srvHeapIndex;
+				bRemapped = true;
+			}
+		}
+
+		// The constants of every frame resource are rewritten, those of the frames in flight keep the previous SRV until then
+		if (bRemapped)
+		{
+			MarkMaterialDirty(material);
+		}
+	}
+}
+
+void ToyDX::Renderer::RegisterTextureUsages()
+{
+	for (auto& drawable : m_AllDrawables)
+	{
+		const MaterialProperties& properties = drawable->material->properties;
+
+		const int textureHandles[] =
+		{
+			properties.hNormalTexture,
+			properties.hEmissiveTexture,
+			properties.specularGlossiness.hDiffuseTexture,
+			properties.specularGlossiness.hSpecularGlossinessTexture,
+			properties.metallicRoughness.hBaseColorTexture,
+			properties.metallicRoughness.hMetallicRoughnessTexture
+		};
+
+		// The UV density is in object space : scale it to world space with the largest scale of the world matrix
+		const DirectX::XMMATRIX& world = drawable->GetWorld();
+		const float scale = (std::max)({ DirectX::XMVectorGetX(DirectX::XMVector3Length(world.r[0])), DirectX::XMVectorGetX(DirectX::XMVector3Length(world.r[1])), DirectX::XMVectorGetX(DirectX::XMVector3Length(world.r[2])) });
+		const float uvDensity = scale > 0.0f ? drawable->UvDensity / scale : drawable->UvDensity;
+
+		const AABB worldBounds = drawable->GetWorldBounds();
+
+		for (int handle : textureHandles)
+		{
+			auto textureIte = m_Textures.find(handle);
+
+			if (handle >= 0 && textureIte != m_Textures.end() && textureIte->second->StreamingHandle >= 0)
+			{
+				m_TextureStreamer->AddUsage(textureIte->second->StreamingHandle, worldBounds, uvDensity);
+			}
+		}
+	}
+}
+
+void ToyDX::Renderer::MarkDrawableDirty(uint32_t index)
+{
+	m_DirtyDrawables.MarkDirty(index);
+}
+
+void ToyDX::Renderer::MarkMaterialDirty(const Material& material)
+{
+	m_DirtyMaterials.MarkDirty(material.CBIndex);
+}
+
+void ToyDX::Renderer::SetDrawableBounds(uint32_t index, const AABB& worldBounds)
+{
+	m_FrustumCuller.SetBounds(index, worldBounds);
+	m_DrawableBounds[index] = worldBounds;
+	m_bDrawableBvhDirty = true;
+}
+
+void ToyDX::Renderer::CullDrawables()
+{
+	const DirectX::XMMATRIX viewProj = DirectX::XMMatrixMultiply(m_CameraHandle->GetViewMatrix(), m_CameraHandle->GetProjMatrix());
+	const FrustumPlanes frustum = FrustumPlanes::FromViewProj(viewProj);
+
+	const std::vector<uint32_t>* visible = nullptr;
+
+	if (m_bUseDrawableBvh)
+	{
+		if (m_bDrawableBvhDirty)
+		{
+			m_DrawableBvh.Refit(m_DrawableBounds);
+			m_bDrawableBvhDirty = false;
+		}
+
+		m_VisibleIndices.clear();
+		m_DrawableBvh.QueryFrustum(frustum, m_VisibleIndices);
+
+		visible = &m_VisibleIndices;
+	}
+	else
+	{
+		visible = &m_FrustumCuller.Cull(frustum);
+	}
+
+	const bool bOcclusionCulling = m_bOcclusionCulling && !m_OccluderIndices.empty();
+	if (bOcclusionCulling)
+	{
+		m_OcclusionCuller.BeginFrame(viewProj);
+
+		for (uint32_t index : m_OccluderIndices)
+		{
+			Drawable* occluder = m_AllDrawables[index].get();
+			const MeshData& data = occluder->Mesh->Data;
+
+			m_OcclusionCuller.RasterizeTriangles(&data.Vertices[occluder->BaseVertexLocation].Pos, sizeof(Vertex), &data.Indices[occluder->StartIndexLocation], occluder->NumIndices, occluder->GetWorld());
+		}
+	}
+
+	// Visible drawables are recorded in the order of their sort keys, so that consecutive draws share their bindings
+	const DirectX::XMMATRIX& view = m_CameraHandle->GetViewMatrix();
+	const PsoList pso = m_bBindless ? PsoList::PbrMetallicRoughness_Bindless : PsoList::PbrMetallicRoughness;
+
+	m_DrawList.Clear();
+	m_DrawList.SetDepthRange(m_CameraHandle->GetFrustum().fNearZ, m_CameraHandle->GetFrustum().fFarZ);
+
+	for (uint32_t index : *visible)
+	{
+		if (bOcclusionCulling && !m_IsOccluder[index] && !m_OcclusionCuller.IsVisible(m_DrawableBounds[index]))
+		{
+			continue;
+		}
+
+		const Drawable* drawable = m_AllDrawables[index].get();
+
+		DrawKeyFields fields;
+		fields.Pass = drawable->material->properties.bTransparent ? DrawPass::Transparent : DrawPass::Opaque;
+		fields.Pso = pso;
+		fields.Material = drawable->material->CBIndex;
+		fields.Mesh = drawable->MeshId;
+
+		if (m_DrawableBounds[index].IsValid())
+		{
+			const DirectX::XMFLOAT3 center = m_DrawableBounds[index].Center();
+			fields.ViewDepth = DirectX::XMVectorGetZ(DirectX::XMVector3TransformCoord(DirectX::XMLoadFloat3(&center), view));
+		}
+
+		m_DrawList.Add(m_DrawList.MakeKey(fields), index);
+	}
+
+	m_DrawList.Sort();
+
+	m_VisibleDrawables.clear();
+	for (size_t i = 0; i < m_DrawList.Size(); ++i)
+	{
+		m_VisibleDrawables.push_back(m_AllDrawables[m_DrawList.GetItem(i)].get());
+	}
+
+	if (m_bBindless)
+	{
+		BatchInstances();
+	}
+	else
+	{
+		UploadVisibleObjectConstants();
+	}
+}
+
+void ToyDX::Renderer::UploadVisibleObjectConstants()
+{
+	const size_t numVisible = m_VisibleDrawables.size();
+	if (numVisible == 0)
+	{
+		return;
+	}
+
+	// Only the visible drawables get constants for this frame, one constant buffer after the other
+	const size_t constantsSize = UploadBuffer::CalcConstantBufferSize(sizeof(PerObjectData));
+	const LinearUploadAllocator::Allocation allocation = m_CurrentFrameResource->frameConstants->Allocate(numVisible * constantsSize);
+
+	m_VisibleObjects.resize(numVisible);
+	m_VisibleObjectCbvs.resize(numVisible);
+	for (size_t i = 0; i < numVisible; ++i)
+	{
+		m_VisibleObjects[i] = (uint32_t)m_VisibleDrawables[i]->PerObjectCbIndex;
+		m_VisibleObjectCbvs[i] = allocation.GpuAddress + i * constantsSize;
+	}
+
+	// Constants computed when the drawables last changed, see UpdatePerObjectCBs : nothing is computed for the ones that didn't
+	m_ObjectTransforms.Write(m_VisibleObjects.data(), numVisible, allocation.CpuAddress, constantsSize, TransformOutput::Packed);
+}
+
+void ToyDX::Renderer::BatchInstances()
+{
+	m_InstanceBatcher.Clear();
+
+	// Same geometry and material : a single instanced draw, placed where the first of its drawables was in the sorted list
+	for (size_t i = 0; i < m_DrawList.Size(); ++i)
+	{
+		const uint32_t index = m_DrawList.GetItem(i);
+		const Drawable* drawable = m_AllDrawables[index].get();
+
+		// Transparent drawables blend in depth order, they keep their own draw
+		const uint64_t batchKey = (uint64_t(drawable->GeometryId) << 32) | uint64_t(drawable->material->CBIndex);
+		m_InstanceBatcher.Add(batchKey, index, !drawable->material->properties.bTransparent);
+	}
+
+	m_InstanceBatcher.Build();
+
+	// The vertex shader reads the object of each instance from the instance buffer
+	const std::vector<uint32_t>& instances = m_InstanceBatcher.GetInstances();
+	UploadBuffer* instanceBuffer = m_CurrentFrameResource->sbInstances.get();
+
+	for (size_t i = 0; i < instances.size(); ++i)
+	{
+		UINT objectIndex = (UINT)m_AllDrawables[instances[i]]->PerObjectCbIndex;
+		instanceBuffer->CopyData((int)i, &objectIndex, sizeof(UINT));
+	}
+
+	if (m_bIndirect)
+	{
+		BuildIndirectCommands();
+	}
+}
+
+void ToyDX::Renderer::BuildIndirectCommands()
+{
+	m_IndirectCommands.Clear();
+
+	// Batches keep their order : transparent drawables still blend back to front
+	for (const InstanceBatch& batch : m_InstanceBatcher.GetBatches())
+	{
+		Drawable* obj = m_AllDrawables[batch.FirstItem].get();
+
+		const uint32_t rootConstants[IndirectDrawCommand::NumRootConstants] = { batch.FirstInstance, (uint32_t)obj->material->CBIndex };
+
+		const D3D12_VERTEX_BUFFER_VIEW& vbv = obj->Mesh->GetVertexBufferView();
+		const D3D12_INDEX_BUFFER_VIEW& ibv = obj->Mesh->GetIndexBufferView();
+		const IndirectVertexBufferView vertexBuffer = { vbv.BufferLocation, vbv.SizeInBytes, vbv.StrideInBytes };
+		const IndirectIndexBufferView indexBuffer = { ibv.BufferLocation, ibv.SizeInBytes, (uint32_t)ibv.Format };
+
+		if (obj->HasSubMeshes)
+		{
+			for (const Primitive& prim : obj->Mesh->Data.Primitives)
+			{
+				m_IndirectCommands.AddDrawIndexed(rootConstants, vertexBuffer, indexBuffer, (uint32_t)prim.NumIndices, batch.NumInstances, (uint32_t)prim.StartIndexLocation, (int32_t)prim.BaseVertexLocation);
+			}
+		}
+		else
+		{
+			m_IndirectCommands.AddDrawIndexed(rootConstants, vertexBuffer, indexBuffer, (uint32_t)obj->NumIndices, batch.NumInstances, (uint32_t)obj->StartIndexLocation, (int32_t)obj->BaseVertexLocation);
+		}
+	}
+
+	assert(m_IndirectCommands.GetCount() <= m_CurrentFrameResource->indirectCommands->GetNumElements() && "More indirect commands than primitive draws.");
+
+	if (m_IndirectCommands.GetCount() > 0)
+	{
+		m_CurrentFrameResource->indirectCommands->CopyData(0, m_IndirectCommands.GetData(), m_IndirectCommands.GetSizeInBytes());
+	}
+}
+
+void ToyDX::Renderer::SelectOccluders()
+{
+	// Large and simple drawables first (walls, floors...) : the most screen coverage for the fewest triangles
+	auto GetScore = [this](uint32_t index)
+	{
+		return m_DrawableBounds[index].SurfaceArea() / (m_AllDrawables[index]->NumIndices / 3);
+	};
+
+	std::vector<uint32_t> candidates;
+	for (uint32_t i = 0; i < m_AllDrawables.size(); ++i)
+	{
+		const Drawable* drawable = m_AllDrawables[i].get();
+
+		if (!drawable->HasSubMeshes && drawable->NumIndices >= 3 && m_DrawableBounds[i].IsValid())
+		{
+			candidates.push_back(i);
 		}
 	}
+
+	std::sort(candidates.begin(), candidates.end(), [&](uint32_t a, uint32_t b) { return GetScore(a) > GetScore(b); });
+
+	const size_t maxTriangles = m_OcclusionCuller.GetSettings().MaxOccluderTriangles;
+	size_t numTriangles = 0;
+
+	m_OccluderIndices.clear();
+	m_IsOccluder.assign(m_AllDrawables.size(), false);
+	for (uint32_t index : candidates)
+	{
+		const size_t triangles = m_AllDrawables[index]->NumIndices / 3;
+
+		if (numTriangles + triangles <= maxTriangles)
+		{
+			m_OccluderIndices.push_back(index);
+			m_IsOccluder[index] = true;
+			numTriangles += triangles;
+		}
+	}
+
+	LOG_INFO("Renderer: {0} occluders ({1} triangles) selected among {2} drawables.", m_OccluderIndices.size(), numTriangles, m_AllDrawables.size());
+}
+
+void ToyDX::Renderer::UpdateTextureStreaming()
+{
+	StreamingView view;
+	DirectX::XMStoreFloat3(&view.EyePosWS, m_CameraHandle->GetPosWS());
+	DirectX::XMStoreFloat3(&view.ForwardWS, m_CameraHandle->GetForward());
+	view.FovY  = m_CameraHandle->GetFrustum().fFovY;
+	view.NearZ = m_CameraHandle->GetFrustum().fNearZ;
+	view.ViewportHeight = m_hRenderingPipeline->GetViewport().Height;
+
+	const std::vector<int>& changedTextures = m_TextureStreamer->Update(view);
+
+	if (changedTextures.empty())
+	{
+		return;
+	}
+
+	for (int handle : changedTextures)
+	{
+		RestreamTexture(handle);
+	}
+
+	// The frame sampling the new textures waits for their upload on the GPU
+	DX12RenderingPipeline::GetUploadManager().Submit();
+
+	LOG_DEBUG("Renderer: {0} textures restreamed, {1:.2f}/{2:.2f} MB resident", changedTextures.size(), m_TextureStreamer->GetResidentSize() / (1024.0 * 1024.0), m_TextureStreamer->GetBudget() / (1024.0 * 1024.0));
 }
 
 void ToyDX::Renderer::Terminate()
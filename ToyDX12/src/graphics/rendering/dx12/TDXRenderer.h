@@ -6,6 +6,19 @@
 #include "Drawable.h"
 #include "Timer.h"
 #include "TDXShader.h"
+#include "TextureStreamer.h"
+#include "FrustumCuller.h"
+#include "BoundingVolumeHierarchy.h"
+#include "OcclusionCuller.h"
+#include "DrawList.h"
+#include "InstanceBatcher.h"
+#include "IndirectCommandBuilder.h"
+#include "TransformBatch.h"
+#include "DirtySet.h"
+#include "FilteredCommandList.h"
+#include "DescriptorAllocator.h"
+
+#include <span>
 
 class DX12RenderingPipeline;
 
@@ -43,12 +56,26 @@ struct MetallicRoughnessMaterial
 	DirectX::XMFLOAT4 BaseColor = { 1.0f, 1.0f, 1.0f, 1.0f };
 	float Metallic  = 0.0f;
 	float Roughness = 1.0f;
+
+	// Indices of the textures in the SRV range of the descriptor heap, read by the bindless shaders
+	UINT BaseColorTexture = 0;
+	UINT MetallicRoughnessTexture = 0;
+	UINT NormalTexture = 0;
+};
+
+// Root constants of a draw in bindless mode
+// Draws are instanced : the object of an instance is read from the instance buffer, at FirstInstance + SV_InstanceID
+struct DrawConstants
+{
+	UINT FirstInstance;
+	UINT MaterialIndex;
 };
 
 enum PsoList
 {
 	Wireframe = 0,
 	PbrMetallicRoughness = 1,
+	PbrMetallicRoughness_Bindless = 2,
 	PsoCount
 };
 
@@ -57,6 +84,8 @@ enum ShaderList
 	Default_Vertex = 0,
 	Default_Pixel  = 1,
 	PbrMetallicRoughness_Pixel = 2,
+	Default_Vertex_Bindless = 3,
+	PbrMetallicRoughness_Pixel_Bindless = 4,
 	ShaderCount
 };
 
@@ -80,12 +109,21 @@ namespace ToyDX
 		void UpdatePerPassCB();
 		void UpdateMaterialCBs();
 
+		// To call when the world matrix of a drawable (index in the drawables) or the properties of a material change :
+		// the copies of every frame resource are updated in the next frames
+		void MarkDrawableDirty(uint32_t index);
+		void MarkMaterialDirty(const Material& material);
+
 
-		void RenderDrawables(ID3D12GraphicsCommandList& r_cmdList, std::vector<Drawable*>& drawables);
+		void RenderDrawables(FilteredCommandList<>& r_cmdList, std::span<Drawable* const> drawables, std::span<const D3D12_GPU_VIRTUAL_ADDRESS> objectCbvs);
+		void RenderDrawablesBindless(FilteredCommandList<>& r_cmdList, std::span<const InstanceBatch> batches);
 		void RecompileShaders();
-		void CreatePipelineStateObjects();
 		void AdvanceToNextFrameResource();
 		FrameResource* GetCurrentFrameResource() { return m_CurrentFrameResource; }
+		TextureStreamer* GetTextureStreamer() { return m_TextureStreamer.get(); }
+
+		// State calls issued and elided while recording the last frame
+		const CommandListStats& GetCommandStats() const { return m_CommandStats; }
 		
 		~Renderer() = default;
 
@@ -105,9 +143,91 @@ namespace ToyDX
 		std::vector< std::unique_ptr<Drawable>> m_AllDrawables;
 		std::vector<Drawable*> m_OpaqueDrawables;
 		std::vector<std::unique_ptr<Mesh>> m_Meshes;
-		std::unordered_map <std::string, std::unique_ptr<Material>> m_Materials;
+		std::vector<Material> m_Materials;					// By handle, drawables point into it : filled once by LoadMaterials
+		std::vector<std::vector<MaterialHandle>> m_MeshMaterials;	// Per mesh, handle of each of its materials (by index in MeshData::materials)
+
+		// Changed drawables and materials (by constant buffer index) whose frame resources copies are out of date
+		DirtySet m_DirtyDrawables = DirtySet(DefaultNumFrameResources);
+		DirtySet m_DirtyMaterials = DirtySet(DefaultNumFrameResources);
 
-		void CreateShaderResourceView(const Texture& texture, ID3D12DescriptorHeap* CbvSrvUavHeap, int SrvIndexInDescriptorHeap);
+		// Written to the staging heap at texture.SrvHeapIndex, then committed to the shader visible heap
+		void CreateShaderResourceView(const Texture& texture);
+
+	protected:
+		// Texture mip residency
+		std::unique_ptr<TextureStreamer> m_TextureStreamer;
+		std::vector<Texture*> m_StreamedTextures; // Indexed by streaming handle
+		std::vector<DescriptorRange> m_StreamedTextureSrvs; // Indexed by streaming handle
+
+		void CreateStreamedTexture(Texture& texture, int firstMip);
+		// Recreates the texture with a new SRV, the previous resource and SRV are released once the frames in flight are done with them
+		void RestreamTexture(int streamingHandle);
+		void RemapMaterialTexture(int previousSrvHeapIndex, int srvHeapIndex);
+		void RegisterTextureUsages();
+		void UpdateTextureStreaming();
+
+	protected:
+		// Visibility : world bounds of m_AllDrawables (same indices) are tested against the camera frustum each frame
+		// Large scenes walk a BVH instead, refitted when drawables move
+		FrustumCuller m_FrustumCuller;
+		BoundingVolumeHierarchy m_DrawableBvh;
+		std::vector<AABB> m_DrawableBounds;
+		std::vector<uint32_t> m_VisibleIndices;
+		std::vector<Drawable*> m_VisibleDrawables;	// Sorted by draw key
+		DrawList m_DrawList;
+		InstanceBatcher m_InstanceBatcher;	// Bindless : visible drawables of the same geometry and material, drawn instanced
+		CommandListStats m_CommandStats;
+		bool m_bUseDrawableBvh = false;
+		bool m_bDrawableBvhDirty = false;
+
+		void SetDrawableBounds(uint32_t index, const AABB& worldBounds);
+
+		// Occlusion : frustum visible drawables hidden behind a few large occluders are not recorded
+		OcclusionCuller m_OcclusionCuller;
+		std::vector<uint32_t> m_OccluderIndices;
+		std::vector<bool> m_IsOccluder;	// By drawable index : occluders are drawn without being tested against themselves
+		bool m_bOcclusionCulling = true;
+
+		void SelectOccluders();
+
+		void CullDrawables();
+		void BatchInstances();
+
+		// World matrices and per object constants of every drawable (same indices as m_AllDrawables). Constants are computed in batches
+		// for the dirty drawables only, then copied to the per object structured buffer and, for the visible ones, to the frame constants
+		// of the descriptor table path
+		TransformBatch m_ObjectTransforms;
+		std::vector<uint32_t> m_VisibleObjects;
+		std::vector<D3D12_GPU_VIRTUAL_ADDRESS> m_VisibleObjectCbvs;	// Same indices as m_VisibleDrawables
+
+		void UploadVisibleObjectConstants();
+
+	protected:
+		// GPU driven submission : in bindless mode, the instance batches can be drawn with a single ExecuteIndirect
+		// Each command sets the root constants and geometry buffers of a batch, then draws it
+		Microsoft::WRL::ComPtr<ID3D12CommandSignature> m_IndirectCommandSignature;
+		IndirectCommandBuilder m_IndirectCommands;
+		bool m_bIndirect = false;
+
+		void BuildIndirectCommandSignature();
+		void BuildIndirectCommands();
+
+	protected:
+		// Multi-threaded recording : the sorted visible drawables are split into contiguous chunks,
+		// each one recorded by a worker into its own command list of the frame resource
+		struct DrawChunk
+		{
+			UINT Worker = 0;
+			size_t First = 0;
+			size_t Count = 0;
+			CommandListStats Stats;
+		};
+
+		UINT m_NumRecordingWorkers = 1;
+		std::vector<DrawChunk> m_DrawChunks;
+		std::vector<ID3D12GraphicsCommandList*> m_FrameCmdLists;	// Submitted this frame, in execution order
+
+		void RecordDrawChunk(DrawChunk& r_Chunk, D3D12_CPU_DESCRIPTOR_HANDLE backbufferView, D3D12_CPU_DESCRIPTOR_HANDLE depthStencilView, bool bClose);
 
 		
 		Camera* m_CameraHandle;
@@ -118,16 +238,22 @@ namespace ToyDX
 		Microsoft::WRL::ComPtr<ID3D12RootSignature> m_RootSignature;
 		void BuildRootSignature();
 
+		// Bindless : objects and materials are structured buffers, textures one unbounded SRV table
+		// A draw only sets its object and material indices as root constants
+		Microsoft::WRL::ComPtr<ID3D12RootSignature> m_BindlessRootSignature;
+		void BuildBindlessRootSignature();
+		bool m_bBindless = true;
+
+		// An unbounded SRV table from the first descriptor of the heap needs resource binding tier 2 or higher
+		// Without it, only the per draw descriptor tables are built and used
+		void CheckBindlessSupport();
+		bool m_bBindlessSupported = false;
+
 	protected:
 		int m_CurrentFrameResourceIdx = 0;
 		FrameResource* m_CurrentFrameResource;
 		std::vector<std::unique_ptr<FrameResource>> m_FrameResources;
 
-		// Offset in the descriptor heap to the first per pass CBV
-		int m_IndexOf_FirstPerPassCbv_DescriptorHeap;
-		int m_IndexOf_FirstMaterialCbv_DescriptorHeap;
-		int m_IndexOf_FirstSrv_DescriptorHeap;
-
 		int m_TotalMaterialCount = 0;
 		int m_TotalTextureCount = 1; 
 		int m_TotalDrawableCount = 0;
@@ -147,10 +273,19 @@ namespace ToyDX
 
 		UINT64 m_CurrentFence = 0;
 	protected:
-		Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_CbvSrvHeap;
+		// CBV/SRV descriptors. Texture SRVs and material CBVs are persistent : the bindless texture table starts at the first persistent descriptor,
+		// so SRV heap indices are also bindless texture indices. The pass CBV table is gathered in the transient region each frame
+		std::unique_ptr<DescriptorAllocator> m_CbvSrvDescriptors;
+		std::vector<DescriptorRange> m_MaterialCbvs;	// Per frame resource, by material constant buffer index
+		DescriptorRange m_PassCbvs;						// One per frame resource, only in the staging heap
+		D3D12_GPU_DESCRIPTOR_HANDLE m_PassCbvTable = {};	// Of the current frame
 
 	protected:
-		void LoadShaders();
+		// Compiles the shaders, then creates every pipeline : the ones whose shaders didn't change come from the pipeline state cache
+		// Compilations and pipeline creations are tasks run in parallel, a pipeline waits for the shaders it uses
+		void BuildPipelines(std::span<const ShaderList> shaders);
+		void CompileShader(ShaderList e_Shader);
+		void CreatePipelineStateObject(PsoList e_Pso);
 		Shader m_ShaderTable[ShaderList::ShaderCount];
 
 	protected:
@@ -166,6 +301,9 @@ namespace ToyDX
 		void RenderRasterized(ID3D12GraphicsCommandList& r_CmdList, D3D12_CPU_DESCRIPTOR_HANDLE backbufferView, D3D12_CPU_DESCRIPTOR_HANDLE depthStencilView);
 	public:
 		void ToggleRenderMode();	// Toggle between raytraced or rasterized graphics
+		void ToggleBindless();				// Toggle between bindless and per draw descriptor tables
+		void ToggleOcclusionCulling();
+		void ToggleIndirect();				// Toggle between ExecuteIndirect and a draw per batch, in bindless mode
 	};
 }
 
@@ -2,13 +2,49 @@
 
 #include "TDXShader.h"
 #include "DX12RenderingPipeline.h"
+#include "ShaderCache.h"
+#include "HashUtil.h"
+
+#include <cstring>
 
 using namespace Microsoft::WRL;
 
-Microsoft::WRL::ComPtr<ID3DBlob> ToyDX::Shader::Compile(const WCHAR* sz_Filename, const char* sz_EntryPoint, ShaderKind e_ShaderProgramKind)
+// Bump when the way shaders are compiled changes, to ignore every cached bytecode
+static const uint64_t ShaderCacheVersion = 1;
+
+static uint64_t HashString(const char* sz_String, uint64_t seed)
+{
+	// The terminator separates consecutive strings, a null string differs from an empty one
+	if (sz_String == nullptr)
+	{
+		return HashUtil::Combine(seed, UINT64_MAX);
+	}
+
+	return HashUtil::Fnv1a(sz_String, strlen(sz_String) + 1, seed);
+}
+
+static uint64_t ComputeShaderKey(uint64_t sourceHash, const char* sz_EntryPoint, const char* sz_Target, UINT ui_Flags, const D3D_SHADER_MACRO* a_Defines)
+{
+	uint64_t key = HashUtil::Combine(ShaderCacheVersion, D3D_COMPILER_VERSION);
+	key = HashUtil::Combine(key, sourceHash);
+	key = HashString(sz_EntryPoint, key);
+	key = HashString(sz_Target, key);
+	key = HashUtil::Combine(key, ui_Flags);
+
+	for (const D3D_SHADER_MACRO* define = a_Defines; define != nullptr && define->Name != nullptr; ++define)
+	{
+		key = HashString(define->Name, key);
+		key = HashString(define->Definition, key);
+	}
+
+	return key;
+}
+
+Microsoft::WRL::ComPtr<ID3DBlob> ToyDX::Shader::Compile(const WCHAR* sz_Filename, const char* sz_EntryPoint, ShaderKind e_ShaderProgramKind, const D3D_SHADER_MACRO* a_Defines)
 {
 	// Optional compile flags
-	UINT shaderCompileOptions = 0;
+	// Unbounded descriptor tables are used by the bindless shaders
+	UINT shaderCompileOptions = D3DCOMPILE_ENABLE_UNBOUNDED_DESCRIPTOR_TABLES;
 	
 #if defined(DEBUG_BUILD)
 	shaderCompileOptions |= (D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION);
@@ -19,13 +55,13 @@ Microsoft::WRL::ComPtr<ID3DBlob> ToyDX::Shader::Compile(const WCHAR* sz_Filename
 	switch (e_ShaderProgramKind)
 	{
 	case ShaderKind::VERTEX:
-		sz_Target = "vs_5_0";
+		sz_Target = "vs_5_1";
 		break;
 	case ShaderKind::PIXEL:
-		sz_Target = "ps_5_0";
+		sz_Target = "ps_5_1";
 		break;
 	case ShaderKind::COMPUTE:
-		sz_Target = "cs_5_0";
+		sz_Target = "cs_5_1";
 		break;
 
 	default:
@@ -35,10 +71,24 @@ Microsoft::WRL::ComPtr<ID3DBlob> ToyDX::Shader::Compile(const WCHAR* sz_Filename
 		}
 	}
 
+	// Cached bytecode : the compiler isn't invoked
+	uint64_t sourceHash = 0;
+	const bool bCacheable = ShaderCache::HashSources(sz_Filename, sourceHash);
+	const uint64_t cacheKey = bCacheable ? ComputeShaderKey(sourceHash, sz_EntryPoint, sz_Target, shaderCompileOptions, a_Defines) : 0;
+
+	std::vector<uint8_t> cachedBytecode;
+	if (bCacheable && ShaderCache::Load(cacheKey, cachedBytecode))
+	{
+		ThrowIfFailed(D3DCreateBlob(cachedBytecode.size(), m_Bytecode.ReleaseAndGetAddressOf()));
+		memcpy(m_Bytecode->GetBufferPointer(), cachedBytecode.data(), cachedBytecode.size());
+
+		return m_Bytecode;
+	}
+
 	// Compilation
 	ComPtr<ID3DBlob> shaderCompileErrors   = nullptr;
 
-	HRESULT result = D3DCompileFromFile(sz_Filename, nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, sz_EntryPoint, sz_Target, shaderCompileOptions, 0, m_Bytecode.GetAddressOf(), shaderCompileErrors.GetAddressOf());
+	HRESULT result = D3DCompileFromFile(sz_Filename, a_Defines, D3D_COMPILE_STANDARD_FILE_INCLUDE, sz_EntryPoint, sz_Target, shaderCompileOptions, 0, m_Bytecode.ReleaseAndGetAddressOf(), shaderCompileErrors.GetAddressOf());
 
 	if (shaderCompileErrors != nullptr)
 	{
@@ -49,6 +99,11 @@ Microsoft::WRL::ComPtr<ID3DBlob> ToyDX::Shader::Compile(const WCHAR* sz_Filename
 
 	ThrowIfFailed(result);
 
+	if (bCacheable)
+	{
+		ShaderCache::Store(cacheKey, m_Bytecode->GetBufferPointer(), m_Bytecode->GetBufferSize());
+	}
+
 	return m_Bytecode;
 }
 
@@ -18,7 +18,7 @@ namespace ToyDX
 		Shader() = default;
 		~Shader() = default;
 
-		Microsoft::WRL::ComPtr<ID3DBlob> Compile(const WCHAR* sz_Filename, const char* sz_EntryPoint, ShaderKind e_ShaderProgramKind);
+		Microsoft::WRL::ComPtr<ID3DBlob> Compile(const WCHAR* sz_Filename, const char* sz_EntryPoint, ShaderKind e_ShaderProgramKind, const D3D_SHADER_MACRO* a_Defines = nullptr);
 		ID3DBlob* GetByteCode() const { return m_Bytecode.Get(); }
 		D3D12_INPUT_LAYOUT_DESC* GetInputLayout() { return m_InputLayout; }
 		void Release();
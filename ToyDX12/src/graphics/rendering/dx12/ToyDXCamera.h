@@ -71,6 +71,7 @@ namespace ToyDX
 		DirectX::XMMATRIX& GetViewMatrix() { return m_ViewMatrix; }
 		DirectX::XMMATRIX& GetProjMatrix() { return m_ProjMatrix; }
 		DirectX::XMVECTOR& GetPosWS() { return m_Pos; }
+		DirectX::XMVECTOR& GetForward() { return m_Forward; }
 
 		// Setters
 		Camera& SetControlParameters(const ControlParams& st_ControlParams = {}, float fRadius = 5.0);
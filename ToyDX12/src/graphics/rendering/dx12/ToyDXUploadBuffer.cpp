@@ -4,7 +4,7 @@
 int ToyDX::UploadBuffer::NumUploadBuffers;
 
 ToyDX::UploadBuffer::UploadBuffer()
-	: m_bIsConstantBuffer(false), m_MappedData(nullptr), m_szElementSizeInBytes(0) 
+	: m_bIsConstantBuffer(false), m_MappedData(nullptr), m_szElementSizeInBytes(0), m_NumElements(0) 
 {
 	ToyDX::UploadBuffer::NumUploadBuffers = 0;
 
@@ -18,6 +18,7 @@ ToyDX::UploadBuffer& ToyDX::UploadBuffer::operator=(UploadBuffer&& other) noexce
 		m_UploadBuffer = std::move(other.m_UploadBuffer);
 		m_MappedData = other.m_MappedData;
 		m_szElementSizeInBytes = other.m_szElementSizeInBytes;
+		m_NumElements = other.m_NumElements;
 		m_bIsConstantBuffer = other.m_bIsConstantBuffer;
 
 		other.m_UploadBuffer->Release();
@@ -37,6 +38,7 @@ void ToyDX::UploadBuffer::Create(ID3D12Device* p_Device, UINT ui_NumElements, si
 
 	m_bIsConstantBuffer = bIsConstantBuffer;
 	m_szElementSizeInBytes = sz_ElementSizeInBytes;
+	m_NumElements = ui_NumElements;
 
 	// Create and map resource
 	CD3DX12_HEAP_PROPERTIES heapProperty(D3D12_HEAP_TYPE_UPLOAD);
@@ -53,8 +55,10 @@ void ToyDX::UploadBuffer::Create(ID3D12Device* p_Device, UINT ui_NumElements, si
 
 //*********************************************************
 
-void ToyDX::UploadBuffer::CopyData(int i_Index, void* p_Data, size_t sz_DataSizeInBytes)
+void ToyDX::UploadBuffer::CopyData(int i_Index, const void* p_Data, size_t sz_DataSizeInBytes)
 {
+	assert(i_Index >= 0 && i_Index * m_szElementSizeInBytes + sz_DataSizeInBytes <= m_NumElements * m_szElementSizeInBytes && "Copy past the end of the upload buffer.");
+
 	memcpy(&m_MappedData[i_Index * m_szElementSizeInBytes], p_Data, sz_DataSizeInBytes);
 }
 
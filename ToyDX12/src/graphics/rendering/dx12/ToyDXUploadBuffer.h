@@ -17,11 +17,15 @@ namespace ToyDX
 
 		ID3D12Resource* GetResource() const { return m_UploadBuffer.Get(); }
 
+		// Persistently mapped : written by the CPU, never read back
+		BYTE* GetMappedData() const { return m_MappedData; }
+
 		void Create(ID3D12Device* p_Device, UINT ui_NumElements, size_t sz_ElementSizeInBytes, bool bIsConstantBuffer, const std::wstring& sz_DebugName);
-		void CopyData(int i_Index, void* p_Data, size_t sz_DataSizeInBytes);
+		void CopyData(int i_Index, const void* p_Data, size_t sz_DataSizeInBytes);
 		void Destroy();
 
 		size_t GetElementSizeInBytes() const { return m_szElementSizeInBytes; }
+		UINT GetNumElements() const { return m_NumElements; }
 
 		bool IsConstantBuffer() { return m_bIsConstantBuffer; };
 
@@ -34,6 +38,7 @@ namespace ToyDX
 		Microsoft::WRL::ComPtr<ID3D12Resource> m_UploadBuffer;
 		BYTE* m_MappedData;
 		size_t m_szElementSizeInBytes;
+		UINT m_NumElements;
 		bool m_bIsConstantBuffer;
 	};
 }
\ No newline at end of file
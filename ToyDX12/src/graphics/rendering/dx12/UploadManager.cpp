@@ -0,0 +1,217 @@
+#include "pch.h"
+
+#include "UploadManager.h"
+
+ToyDX::UploadManager::UploadManager(ID3D12Device* p_Device, ID3D12CommandQueue* p_ConsumerQueue, UINT64 ui64_StagingSizeInBytes)
+	: m_Device(p_Device), m_ConsumerQueue(p_ConsumerQueue), m_StagingRing(ui64_StagingSizeInBytes)
+{
+	D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+	queueDesc.Type  = D3D12_COMMAND_LIST_TYPE_COPY;
+	queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+
+	ThrowIfFailed(m_Device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_CopyQueue)));
+	m_CopyQueue->SetName(L"Upload Copy Queue");
+
+	ThrowIfFailed(m_Device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_Fence)));
+
+	CD3DX12_HEAP_PROPERTIES uploadHeap = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+	CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(ui64_StagingSizeInBytes);
+
+	ThrowIfFailed(m_Device->CreateCommittedResource(
+		&uploadHeap, D3D12_HEAP_FLAG_NONE, &bufferDesc,
+		D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(m_StagingBuffer.GetAddressOf())));
+	m_StagingBuffer->SetName(L"Upload Staging Ring");
+
+	// The CPU only writes to the staging ring
+	CD3DX12_RANGE noRead(0, 0);
+	ThrowIfFailed(m_StagingBuffer->Map(0, &noRead, reinterpret_cast<void**>(&m_StagingCpuAddress)));
+
+	LOG_INFO("UploadManager: Staging ring of {0:.2f} MB.", ui64_StagingSizeInBytes / (1024.0 * 1024.0));
+}
+
+ToyDX::UploadManager::~UploadManager()
+{
+	// Staging buffers and allocators must outlive the copies that use them
+	if (m_bBatchOpen)
+	{
+		Submit();
+	}
+
+	Wait(m_LastSubmittedTicket);
+
+	m_StagingBuffer->Unmap(0, nullptr);
+}
+
+void ToyDX::UploadManager::UploadToBuffer(ID3D12Resource* p_Destination, const void* p_Data, UINT64 ui64_SizeInBytes)
+{
+	const StagingAllocation staging = AllocateStaging(ui64_SizeInBytes, 16);
+	OpenBatch();
+
+	memcpy(staging.CpuAddress, p_Data, ui64_SizeInBytes);
+	m_CommandList->CopyBufferRegion(p_Destination, 0, staging.Resource, staging.Offset, ui64_SizeInBytes);
+
+	m_NumBatchUploads++;
+	m_BatchSize += ui64_SizeInBytes;
+}
+
+void ToyDX::UploadManager::UploadToTexture(ID3D12Resource* p_Destination, UINT ui_NumSubresources, const D3D12_SUBRESOURCE_DATA* a_Subresources)
+{
+	const UINT64 stagingSize = GetRequiredIntermediateSize(p_Destination, 0, ui_NumSubresources);
+
+	const StagingAllocation staging = AllocateStaging(stagingSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+	OpenBatch();
+
+	// Texels are laid out as the copy footprints of the subresources, block compressed rows included
+	if (UpdateSubresources(m_CommandList.Get(), p_Destination, staging.Resource, staging.Offset, 0, ui_NumSubresources, a_Subresources) == 0)
+	{
+		LOG_ERROR("UploadManager: Could not record the upload of a texture ({0} subresources).", ui_NumSubresources);
+	}
+
+	m_NumBatchUploads++;
+	m_BatchSize += stagingSize;
+}
+
+ToyDX::UploadTicket ToyDX::UploadManager::Submit()
+{
+	if (!m_bBatchOpen)
+	{
+		return m_LastSubmittedTicket;
+	}
+
+	ThrowIfFailed(m_CommandList->Close());
+	ID3D12CommandList* cmdLists[] = { m_CommandList.Get() };
+	m_CopyQueue->ExecuteCommandLists(_countof(cmdLists), cmdLists);
+
+	m_LastSubmittedTicket++;
+	ThrowIfFailed(m_CopyQueue->Signal(m_Fence.Get(), m_LastSubmittedTicket));
+	m_StagingRing.CloseGroup(m_LastSubmittedTicket);
+
+	// Work submitted to the consumer queue from now on starts once the uploads are done
+	ThrowIfFailed(m_ConsumerQueue->Wait(m_Fence.Get(), m_LastSubmittedTicket));
+
+	LOG_DEBUG("UploadManager: Batch {0} submitted, {1} uploads ({2:.2f} MB)", m_LastSubmittedTicket, m_NumBatchUploads, m_BatchSize / (1024.0 * 1024.0));
+
+	m_CurrentBatch.Ticket = m_LastSubmittedTicket;
+	m_PendingBatches.push_back(std::move(m_CurrentBatch));
+
+	m_CurrentBatch = Batch();
+	m_bBatchOpen = false;
+
+	return m_LastSubmittedTicket;
+}
+
+void ToyDX::UploadManager::Wait(UploadTicket ticket)
+{
+	if (!IsComplete(ticket))
+	{
+		HANDLE eventHandle = CreateEventEx(nullptr, nullptr, false, EVENT_ALL_ACCESS);
+
+		ThrowIfFailed(m_Fence->SetEventOnCompletion(ticket, eventHandle));
+
+		WaitForSingleObject(eventHandle, INFINITE);
+		CloseHandle(eventHandle);
+	}
+
+	RetireCompletedBatches();
+}
+
+void ToyDX::UploadManager::RetireCompletedBatches()
+{
+	const UploadTicket completed = m_Fence->GetCompletedValue();
+
+	while (!m_PendingBatches.empty() && m_PendingBatches.front().Ticket <= completed)
+	{
+		m_FreeAllocators.push_back(std::move(m_PendingBatches.front().Allocator));
+		m_PendingBatches.pop_front();
+	}
+
+	m_StagingRing.Reclaim(completed);
+}
+
+ToyDX::UploadManager::StagingAllocation ToyDX::UploadManager::AllocateStaging(UINT64 ui64_SizeInBytes, UINT64 ui64_Alignment)
+{
+	StagingAllocation allocation;
+
+	if (ui64_SizeInBytes > m_StagingRing.GetCapacity())
+	{
+		LOG_WARN("UploadManager: Upload of {0:.2f} MB is larger than the staging ring, using a staging buffer of its own.", ui64_SizeInBytes / (1024.0 * 1024.0));
+
+		Microsoft::WRL::ComPtr<ID3D12Resource> stagingBuffer;
+		CD3DX12_HEAP_PROPERTIES uploadHeap = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+		CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(ui64_SizeInBytes);
+
+		ThrowIfFailed(m_Device->CreateCommittedResource(
+			&uploadHeap, D3D12_HEAP_FLAG_NONE, &bufferDesc,
+			D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(stagingBuffer.GetAddressOf())));
+
+		// Released with its batch, upload heaps may be released while mapped
+		CD3DX12_RANGE noRead(0, 0);
+		ThrowIfFailed(stagingBuffer->Map(0, &noRead, reinterpret_cast<void**>(&allocation.CpuAddress)));
+		allocation.Resource = stagingBuffer.Get();
+
+		OpenBatch();
+		m_CurrentBatch.OversizedStagingBuffers.push_back(std::move(stagingBuffer));
+
+		return allocation;
+	}
+
+	UINT64 offset = m_StagingRing.Allocate(ui64_SizeInBytes, ui64_Alignment);
+
+	// Full : the uploads recorded so far are submitted so that their space can be reclaimed, then the oldest batches are waited for
+	while (offset == RingAllocator::InvalidOffset)
+	{
+		if (m_bBatchOpen)
+		{
+			Submit();
+		}
+		else
+		{
+			assert(!m_PendingBatches.empty());
+			Wait(m_PendingBatches.front().Ticket);
+		}
+
+		offset = m_StagingRing.Allocate(ui64_SizeInBytes, ui64_Alignment);
+	}
+
+	allocation.Resource = m_StagingBuffer.Get();
+	allocation.Offset = offset;
+	allocation.CpuAddress = m_StagingCpuAddress + offset;
+
+	return allocation;
+}
+
+void ToyDX::UploadManager::OpenBatch()
+{
+	if (m_bBatchOpen)
+	{
+		return;
+	}
+
+	RetireCompletedBatches();
+
+	if (m_FreeAllocators.empty())
+	{
+		ThrowIfFailed(m_Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&m_CurrentBatch.Allocator)));
+	}
+	else
+	{
+		m_CurrentBatch.Allocator = std::move(m_FreeAllocators.back());
+		m_FreeAllocators.pop_back();
+
+		ThrowIfFailed(m_CurrentBatch.Allocator->Reset());
+	}
+
+	if (m_CommandList == nullptr)
+	{
+		ThrowIfFailed(m_Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, m_CurrentBatch.Allocator.Get(), nullptr, IID_PPV_ARGS(&m_CommandList)));
+		m_CommandList->SetName(L"Upload Command List");
+	}
+	else
+	{
+		ThrowIfFailed(m_CommandList->Reset(m_CurrentBatch.Allocator.Get(), nullptr));
+	}
+
+	m_bBatchOpen = true;
+	m_NumBatchUploads = 0;
+	m_BatchSize = 0;
+}
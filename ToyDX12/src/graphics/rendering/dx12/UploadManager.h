@@ -0,0 +1,94 @@
+#pragma once
+
+#include <wrl/client.h>
+#include <deque>
+#include <vector>
+
+#include "d3d12.h"
+#include "RingAllocator.h"
+
+namespace ToyDX
+{
+	// Value reached by the fence of the copy queue once a batch of uploads is executed
+	using UploadTicket = UINT64;
+
+	// Records buffer and texture uploads in batches executed on a dedicated copy queue
+	// - Uploads are recorded in one command list until Submit(), each batch signals the copy fence : callers poll or wait for its ticket
+	// - The queue that draws waits for every submitted batch on the GPU timeline, the CPU is never blocked
+	// - Destination resources are created in the COMMON state : they decay back to COMMON after the copy and are implicitly promoted
+	//   to the state of their first use on the direct queue, no barrier is recorded
+	// - Data goes through a fixed size staging ring, space is reclaimed once the batch that used it completes.
+	//   When the ring is full, the current batch is submitted and the oldest batches are waited for : staging memory stays bounded
+	//   however much is uploaded. Only an upload larger than the whole ring gets a staging buffer of its own
+	// Not thread safe
+	class UploadManager
+	{
+	public:
+		UploadManager(ID3D12Device* p_Device, ID3D12CommandQueue* p_ConsumerQueue, UINT64 ui64_StagingSizeInBytes = DefaultStagingSizeInBytes);
+		UploadManager(const UploadManager&) = delete;
+		UploadManager& operator=(const UploadManager&) = delete;
+		~UploadManager();
+
+		// The data is copied to the staging ring when the upload is recorded, it doesn't have to outlive the call
+		void UploadToBuffer(ID3D12Resource* p_Destination, const void* p_Data, UINT64 ui64_SizeInBytes);
+		void UploadToTexture(ID3D12Resource* p_Destination, UINT ui_NumSubresources, const D3D12_SUBRESOURCE_DATA* a_Subresources);
+
+		// Executes the recorded uploads. Returns the ticket of the batch, or the one of the last batch if nothing was recorded
+		UploadTicket Submit();
+
+		bool IsComplete(UploadTicket ticket) const { return m_Fence->GetCompletedValue() >= ticket; }
+		void Wait(UploadTicket ticket);
+
+		// Recycles the command allocators and the staging memory of the completed batches
+		void RetireCompletedBatches();
+
+		ID3D12CommandQueue* GetCopyQueue() const { return m_CopyQueue.Get(); }
+		UploadTicket GetLastSubmittedTicket() const { return m_LastSubmittedTicket; }
+		size_t GetNumPendingBatches() const { return m_PendingBatches.size(); }
+		UINT64 GetStagingUsedSize() const { return m_StagingRing.GetUsedSize(); }
+		UINT64 GetStagingCapacity() const { return m_StagingRing.GetCapacity(); }
+
+		static const UINT64 DefaultStagingSizeInBytes = 64ull * 1024 * 1024;
+
+	protected:
+		struct Batch
+		{
+			UploadTicket Ticket = 0;
+			Microsoft::WRL::ComPtr<ID3D12CommandAllocator> Allocator;
+			std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> OversizedStagingBuffers;	// Uploads that don't fit in the ring
+		};
+
+		struct StagingAllocation
+		{
+			ID3D12Resource* Resource = nullptr;
+			UINT64 Offset = 0;
+			BYTE* CpuAddress = nullptr;
+		};
+
+		// May submit the current batch and wait for older ones to make room : call it before recording anything in the batch
+		StagingAllocation AllocateStaging(UINT64 ui64_SizeInBytes, UINT64 ui64_Alignment);
+		void OpenBatch();
+
+		ID3D12Device* m_Device = nullptr;
+		ID3D12CommandQueue* m_ConsumerQueue = nullptr;
+
+		Microsoft::WRL::ComPtr<ID3D12CommandQueue> m_CopyQueue;
+		Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> m_CommandList;
+		Microsoft::WRL::ComPtr<ID3D12Fence> m_Fence;
+		UploadTicket m_LastSubmittedTicket = 0;
+
+		// Persistently mapped upload heap
+		Microsoft::WRL::ComPtr<ID3D12Resource> m_StagingBuffer;
+		BYTE* m_StagingCpuAddress = nullptr;
+		RingAllocator m_StagingRing;
+
+		// Batch being recorded, valid when m_bBatchOpen
+		Batch m_CurrentBatch;
+		bool m_bBatchOpen = false;
+		UINT m_NumBatchUploads = 0;
+		UINT64 m_BatchSize = 0;
+
+		std::deque<Batch> m_PendingBatches;	// Submitted, by increasing ticket
+		std::vector<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>> m_FreeAllocators;
+	};
+}
@@ -0,0 +1,106 @@
+#include "pch.h"
+
+#include "BoundingVolumeHierarchy.h"
+#include "TestUtil.h"
+
+using namespace DirectX;
+
+// Build, refit and query throughput over 200k objects, queries against the brute force test of every box
+int main()
+{
+	const uint32_t NumObjects = 200000;
+	const int NumQueries = 100;
+
+	std::vector<AABB> bounds = TestUtil::MakeRandomBoxes(NumObjects, 1000.0f, 3);
+
+	BoundingVolumeHierarchy bvh;
+	const double buildMs = TestUtil::MeasureMs([&]() { bvh.Build(bounds); }, 3);
+	const float builtSahCost = bvh.GetSahCost();
+
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> position(-1000.0f, 1000.0f);
+
+	const XMMATRIX proj = XMMatrixPerspectiveFovLH(XMConvertToRadians(45.0f), 16.0f / 9.0f, 1.0f, 400.0f);
+
+	std::vector<FrustumPlanes> frustums;
+	std::vector<XMFLOAT3> points;
+	for (int query = 0; query < NumQueries; ++query)
+	{
+		const XMMATRIX view = XMMatrixLookToLH(XMVectorSet(position(rng), 0.0f, position(rng), 1.0f), XMVectorSet(position(rng), 0.0f, position(rng), 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		frustums.push_back(FrustumPlanes::FromViewProj(XMMatrixMultiply(view, proj)));
+		points.push_back({ position(rng), 0.0f, position(rng) });
+	}
+
+	std::vector<uint32_t> items;
+	items.reserve(NumObjects);
+	size_t numFrustumItems = 0;
+	size_t numDistanceItems = 0;
+
+	const double bvhFrustumMs = TestUtil::MeasureMs([&]()
+	{
+		numFrustumItems = 0;
+		for (const FrustumPlanes& frustum : frustums)
+		{
+			items.clear();
+			bvh.QueryFrustum(frustum, items);
+			numFrustumItems += items.size();
+		}
+	}, 3) / NumQueries;
+
+	const double bruteFrustumMs = TestUtil::MeasureMs([&]()
+	{
+		for (const FrustumPlanes& frustum : frustums)
+		{
+			items.clear();
+			for (uint32_t i = 0; i < NumObjects; ++i)
+			{
+				if (!TestUtil::IsOutside(frustum.Planes, bounds[i]))
+				{
+					items.push_back(i);
+				}
+			}
+		}
+	}, 3) / NumQueries;
+
+	const double bvhDistanceMs = TestUtil::MeasureMs([&]()
+	{
+		numDistanceItems = 0;
+		for (const XMFLOAT3& point : points)
+		{
+			items.clear();
+			bvh.QueryDistance(point, 50.0f, items);
+			numDistanceItems += items.size();
+		}
+	}, 3) / NumQueries;
+
+	const double bruteDistanceMs = TestUtil::MeasureMs([&]()
+	{
+		for (const XMFLOAT3& point : points)
+		{
+			items.clear();
+			for (uint32_t i = 0; i < NumObjects; ++i)
+			{
+				if (TestUtil::IsWithinDistance(bounds[i], point, 50.0f))
+				{
+					items.push_back(i);
+				}
+			}
+		}
+	}, 3) / NumQueries;
+
+	// Every object moves a little, the tree is refitted
+	for (AABB& box : bounds)
+	{
+		box.Min.x += 3.0f;
+		box.Max.x += 3.0f;
+	}
+
+	const double refitMs = TestUtil::MeasureMs([&]() { bvh.Refit(bounds); }, 3);
+
+	printf("BoundingVolumeHierarchyBench: %u objects, %u nodes, build %.2f ms (SAH cost %.1f), refit %.2f ms (SAH cost %.1f).\n", NumObjects, bvh.GetNumNodes(), buildMs, builtSahCost, refitMs, bvh.GetSahCost());
+	printf("BoundingVolumeHierarchyBench: frustum query %.3f ms (%zu items on average), brute force %.3f ms, x%.1f.\n", bvhFrustumMs, numFrustumItems / NumQueries, bruteFrustumMs, bruteFrustumMs / bvhFrustumMs);
+	printf("BoundingVolumeHierarchyBench: distance query %.4f ms (%zu items on average), brute force %.3f ms, x%.1f.\n", bvhDistanceMs, numDistanceItems / NumQueries, bruteDistanceMs, bruteDistanceMs / bvhDistanceMs);
+	printf("BoundingVolumeHierarchyBench: %.0f frustum queries per second.\n", 1000.0 / bvhFrustumMs);
+
+	return 0;
+}
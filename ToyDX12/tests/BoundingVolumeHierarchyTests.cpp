@@ -0,0 +1,125 @@
+#include "pch.h"
+
+#include <algorithm>
+
+#include "BoundingVolumeHierarchy.h"
+#include "TestUtil.h"
+
+using namespace DirectX;
+
+namespace
+{
+	std::vector<uint32_t> QueryFrustum(const BoundingVolumeHierarchy& bvh, const FrustumPlanes& frustum)
+	{
+		std::vector<uint32_t> items;
+		bvh.QueryFrustum(frustum, items);
+		std::sort(items.begin(), items.end());
+		return items;
+	}
+
+	std::vector<uint32_t> QueryDistance(const BoundingVolumeHierarchy& bvh, const XMFLOAT3& point, float distance)
+	{
+		std::vector<uint32_t> items;
+		bvh.QueryDistance(point, distance, items);
+		std::sort(items.begin(), items.end());
+		return items;
+	}
+
+	// Items without valid bounds are returned by every query, like the brute force tests would
+	std::vector<uint32_t> BruteForceFrustum(const std::vector<AABB>& a_Bounds, const FrustumPlanes& frustum)
+	{
+		std::vector<uint32_t> items;
+		for (uint32_t i = 0; i < a_Bounds.size(); ++i)
+		{
+			if (!a_Bounds[i].IsValid() || !TestUtil::IsOutside(frustum.Planes, a_Bounds[i]))
+			{
+				items.push_back(i);
+			}
+		}
+		return items;
+	}
+
+	std::vector<uint32_t> BruteForceDistance(const std::vector<AABB>& a_Bounds, const XMFLOAT3& point, float distance)
+	{
+		std::vector<uint32_t> items;
+		for (uint32_t i = 0; i < a_Bounds.size(); ++i)
+		{
+			if (!a_Bounds[i].IsValid() || TestUtil::IsWithinDistance(a_Bounds[i], point, distance))
+			{
+				items.push_back(i);
+			}
+		}
+		return items;
+	}
+
+	void CheckQueries(const BoundingVolumeHierarchy& bvh, const std::vector<AABB>& a_Bounds, uint32_t seed)
+	{
+		std::mt19937 rng(seed);
+		std::uniform_real_distribution<float> position(-1000.0f, 1000.0f);
+
+		const XMMATRIX proj = XMMatrixPerspectiveFovLH(XMConvertToRadians(45.0f), 16.0f / 9.0f, 1.0f, 400.0f);
+
+		for (int query = 0; query < 20; ++query)
+		{
+			const XMMATRIX view = XMMatrixLookToLH(XMVectorSet(position(rng), 0.0f, position(rng), 1.0f), XMVectorSet(position(rng), 0.0f, position(rng), 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+			const FrustumPlanes frustum = FrustumPlanes::FromViewProj(XMMatrixMultiply(view, proj));
+
+			TEST_CHECK(QueryFrustum(bvh, frustum) == BruteForceFrustum(a_Bounds, frustum));
+
+			const XMFLOAT3 point = { position(rng), 0.0f, position(rng) };
+			TEST_CHECK(QueryDistance(bvh, point, 50.0f) == BruteForceDistance(a_Bounds, point, 50.0f));
+		}
+	}
+
+	void TestEmptyAndSingle()
+	{
+		BoundingVolumeHierarchy bvh;
+		bvh.Build({});
+		TEST_CHECK(bvh.IsEmpty());
+		TEST_CHECK(QueryDistance(bvh, { 0.0f, 0.0f, 0.0f }, 1e6f).empty());
+
+		bvh.Build({ TestUtil::MakeBox({ 0.0f, 0.0f, 0.0f }, 1.0f) });
+		TEST_CHECK(QueryDistance(bvh, { 0.0f, 0.0f, 3.0f }, 2.5f) == std::vector<uint32_t>{ 0 });
+		TEST_CHECK(QueryDistance(bvh, { 0.0f, 0.0f, 3.0f }, 1.5f).empty());
+	}
+
+	void TestBuildAndRefit()
+	{
+		std::vector<AABB> bounds = TestUtil::MakeRandomBoxes(20000, 1000.0f, 3);
+		bounds[17] = AABB();
+		bounds[18] = AABB();
+
+		BoundingVolumeHierarchy bvh;
+		bvh.Build(bounds);
+		TEST_CHECK(bvh.GetNumItems() == bounds.size());
+		CheckQueries(bvh, bounds, 1);
+
+		// Every item moves : the refitted tree must still give the brute force results
+		std::mt19937 rng(4);
+		std::uniform_real_distribution<float> offset(-20.0f, 20.0f);
+		for (AABB& box : bounds)
+		{
+			if (box.IsValid())
+			{
+				const XMFLOAT3 move = { offset(rng), offset(rng), offset(rng) };
+				box.Min = { box.Min.x + move.x, box.Min.y + move.y, box.Min.z + move.z };
+				box.Max = { box.Max.x + move.x, box.Max.y + move.y, box.Max.z + move.z };
+			}
+		}
+
+		bvh.Refit(bounds);
+		CheckQueries(bvh, bounds, 2);
+
+		// Few items per leaf and a few bins
+		bvh.Build(bounds, { 1, 4 });
+		CheckQueries(bvh, bounds, 3);
+	}
+}
+
+int main()
+{
+	TestEmptyAndSingle();
+	TestBuildAndRefit();
+
+	return TestUtil::Finish("BoundingVolumeHierarchyTests");
+}
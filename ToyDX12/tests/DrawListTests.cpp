@@ -0,0 +1,133 @@
+#include "pch.h"
+
+#include <algorithm>
+
+#include "DrawList.h"
+#include "TestUtil.h"
+
+namespace
+{
+	std::vector<SortEntry> MakeEntries(size_t count, int numKeyBits, uint32_t seed)
+	{
+		std::mt19937_64 rng(seed);
+
+		std::vector<SortEntry> entries(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			const uint64_t key = rng();
+			entries[i] = { numKeyBits == 64 ? key : key & ((1ull << numKeyBits) - 1), (uint32_t)i };
+		}
+
+		return entries;
+	}
+
+	bool IsSameAsStableSort(std::vector<SortEntry> entries)
+	{
+		std::vector<SortEntry> expected = entries;
+		std::stable_sort(expected.begin(), expected.end(), [](const SortEntry& a, const SortEntry& b) { return a.Key < b.Key; });
+
+		std::vector<SortEntry> scratch(entries.size());
+		RadixSort::Sort(entries.data(), scratch.data(), entries.size());
+
+		return std::equal(entries.begin(), entries.end(), expected.begin(), [](const SortEntry& a, const SortEntry& b) { return a.Key == b.Key && a.Value == b.Value; });
+	}
+
+	// Counts around the single block threshold, keys with unused high bits and many equal keys (stability)
+	void TestRadixSort()
+	{
+		for (size_t count : { size_t(0), size_t(1), size_t(2), size_t(1000), RadixSort::MinEntriesPerBlock - 1, RadixSort::MinEntriesPerBlock + 1, size_t(300000) })
+		{
+			TEST_CHECK(IsSameAsStableSort(MakeEntries(count, 64, (uint32_t)count)));
+			TEST_CHECK(IsSameAsStableSort(MakeEntries(count, 20, (uint32_t)count)));
+			TEST_CHECK(IsSameAsStableSort(MakeEntries(count, 4, (uint32_t)count)));
+		}
+
+		// Every key equal : every pass is skipped
+		std::vector<SortEntry> same = MakeEntries(50000, 64, 1);
+		for (SortEntry& entry : same)
+		{
+			entry.Key = 0x0123456789ABCDEFull;
+		}
+		TEST_CHECK(IsSameAsStableSort(same));
+	}
+
+	void TestKeys()
+	{
+		DrawList drawList;
+		drawList.SetDepthRange(0.1f, 1000.0f);
+
+		// Opaque draws : by PSO, then material, then front to back
+		DrawKeyFields nearDraw = { DrawPass::Opaque, 1, 5, 0, 1.0f };
+		DrawKeyFields farDraw = nearDraw;
+		farDraw.ViewDepth = 100.0f;
+		TEST_CHECK(drawList.MakeKey(nearDraw) < drawList.MakeKey(farDraw));
+
+		DrawKeyFields otherMaterial = nearDraw;
+		otherMaterial.Material = 6;
+		otherMaterial.ViewDepth = 0.5f;
+		TEST_CHECK(drawList.MakeKey(farDraw) < drawList.MakeKey(otherMaterial));
+
+		DrawKeyFields otherPso = nearDraw;
+		otherPso.Pso = 2;
+		otherPso.Material = 0;
+		TEST_CHECK(drawList.MakeKey(otherMaterial) < drawList.MakeKey(otherPso));
+
+		// Transparent draws : after the opaque ones, back to front whatever their bindings
+		DrawKeyFields transparentNear = { DrawPass::Transparent, 0, 0, 0, 1.0f };
+		DrawKeyFields transparentFar = { DrawPass::Transparent, 3, 9, 0, 100.0f };
+		TEST_CHECK(drawList.MakeKey(otherPso) < drawList.MakeKey(transparentFar));
+		TEST_CHECK(drawList.MakeKey(transparentFar) < drawList.MakeKey(transparentNear));
+
+		// Depth quantization is monotonic and clamped
+		uint32_t previous = 0;
+		bool bMonotonic = true;
+		for (float depth = 0.01f; depth < 2000.0f; depth *= 1.1f)
+		{
+			const uint32_t quantized = DrawList::QuantizeDepth(depth, 0.1f, 1000.0f);
+			bMonotonic = bMonotonic && quantized >= previous && quantized < (1u << DrawList::DepthBits);
+			previous = quantized;
+		}
+		TEST_CHECK(bMonotonic);
+	}
+
+	void TestSort()
+	{
+		std::mt19937 rng(2);
+
+		DrawList drawList;
+		drawList.SetDepthRange(0.1f, 1000.0f);
+
+		for (uint32_t i = 0; i < 100000; ++i)
+		{
+			DrawKeyFields fields;
+			fields.Pass = rng() % 10 ? DrawPass::Opaque : DrawPass::Transparent;
+			fields.Pso = rng() % 4;
+			fields.Material = rng() % 300;
+			fields.Mesh = rng() % 5000;
+			fields.ViewDepth = 0.1f + (rng() % 100000) * 0.01f;
+			drawList.Add(drawList.MakeKey(fields), i);
+		}
+
+		drawList.Sort();
+
+		bool bSorted = true;
+		std::vector<bool> found(drawList.Size(), false);
+		for (size_t i = 0; i < drawList.Size(); ++i)
+		{
+			bSorted = bSorted && (i == 0 || drawList.GetKey(i - 1) <= drawList.GetKey(i));
+			found[drawList.GetItem(i)] = true;
+		}
+
+		TEST_CHECK(bSorted);
+		TEST_CHECK(std::find(found.begin(), found.end(), false) == found.end());
+	}
+}
+
+int main()
+{
+	TestRadixSort();
+	TestKeys();
+	TestSort();
+
+	return TestUtil::Finish("DrawListTests");
+}
@@ -0,0 +1,218 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "FilteredCommandList.h"
+#include "TestUtil.h"
+
+namespace
+{
+	// Records the calls that reach the command list
+	struct RecordingCommandList
+	{
+		std::vector<std::string> Calls;
+
+		void SetPipelineState(ID3D12PipelineState*) { Calls.push_back("SetPipelineState"); }
+		void SetGraphicsRootSignature(ID3D12RootSignature*) { Calls.push_back("SetGraphicsRootSignature"); }
+		void SetDescriptorHeaps(UINT, ID3D12DescriptorHeap* const*) { Calls.push_back("SetDescriptorHeaps"); }
+		void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY) { Calls.push_back("IASetPrimitiveTopology"); }
+		void IASetVertexBuffers(UINT, UINT, const D3D12_VERTEX_BUFFER_VIEW*) { Calls.push_back("IASetVertexBuffers"); }
+		void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW*) { Calls.push_back("IASetIndexBuffer"); }
+		void SetGraphicsRootDescriptorTable(UINT, D3D12_GPU_DESCRIPTOR_HANDLE) { Calls.push_back("SetGraphicsRootDescriptorTable"); }
+		void SetGraphicsRootConstantBufferView(UINT, D3D12_GPU_VIRTUAL_ADDRESS) { Calls.push_back("SetGraphicsRootConstantBufferView"); }
+		void SetGraphicsRootShaderResourceView(UINT, D3D12_GPU_VIRTUAL_ADDRESS) { Calls.push_back("SetGraphicsRootShaderResourceView"); }
+		void SetGraphicsRoot32BitConstants(UINT, UINT, const void*, UINT) { Calls.push_back("SetGraphicsRoot32BitConstants"); }
+		void DrawIndexedInstanced(UINT, UINT, UINT, INT, UINT) { Calls.push_back("DrawIndexedInstanced"); }
+		void DrawInstanced(UINT, UINT, UINT, UINT) { Calls.push_back("DrawInstanced"); }
+		void ExecuteIndirect(ID3D12CommandSignature*, UINT, ID3D12Resource*, UINT64, ID3D12Resource*, UINT64) { Calls.push_back("ExecuteIndirect"); }
+
+		// Returns the calls recorded since the last time, and forgets them
+		std::vector<std::string> Take()
+		{
+			std::vector<std::string> calls;
+			calls.swap(Calls);
+			return calls;
+		}
+	};
+
+	using Calls = std::vector<std::string>;
+
+	// The filter only compares addresses : the objects don't need to exist
+	template<typename T>
+	T* FakeObject(uintptr_t address)
+	{
+		return reinterpret_cast<T*>(address);
+	}
+
+	void TestPipelineState()
+	{
+		RecordingCommandList recorder;
+		ToyDX::FilteredCommandList<RecordingCommandList> cmdList(recorder);
+
+		ID3D12PipelineState* psoA = FakeObject<ID3D12PipelineState>(0x10);
+		ID3D12PipelineState* psoB = FakeObject<ID3D12PipelineState>(0x20);
+
+		cmdList.SetPipelineState(psoA);
+		cmdList.SetPipelineState(psoA);
+		cmdList.SetPipelineState(psoB);
+		cmdList.SetPipelineState(psoA);
+		TEST_CHECK((recorder.Take() == Calls{ "SetPipelineState", "SetPipelineState", "SetPipelineState" }));
+
+		cmdList.IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		cmdList.IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		cmdList.IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_LINELIST);
+		TEST_CHECK((recorder.Take() == Calls{ "IASetPrimitiveTopology", "IASetPrimitiveTopology" }));
+
+		// Forgotten state is set again
+		cmdList.Invalidate();
+		cmdList.SetPipelineState(psoA);
+		cmdList.IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_LINELIST);
+		TEST_CHECK((recorder.Take() == Calls{ "SetPipelineState", "IASetPrimitiveTopology" }));
+
+		TEST_CHECK(cmdList.GetStats().NumIssued == 7);
+		TEST_CHECK(cmdList.GetStats().NumElided == 2);
+	}
+
+	void TestBuffers()
+	{
+		RecordingCommandList recorder;
+		ToyDX::FilteredCommandList<RecordingCommandList> cmdList(recorder);
+
+		const D3D12_VERTEX_BUFFER_VIEW vertexBuffers[] = { { 0x1000, 256, 32 }, { 0x2000, 128, 16 } };
+		const D3D12_VERTEX_BUFFER_VIEW otherVertexBuffer = { 0x3000, 256, 32 };
+		const D3D12_INDEX_BUFFER_VIEW indexBuffer = { 0x4000, 64, DXGI_FORMAT_R16_UINT };
+		const D3D12_INDEX_BUFFER_VIEW otherIndexBuffer = { 0x4000, 64, DXGI_FORMAT_R32_UINT };
+
+		cmdList.IASetVertexBuffers(0, 2, vertexBuffers);
+		cmdList.IASetVertexBuffers(0, 2, vertexBuffers);
+		cmdList.IASetVertexBuffers(1, 1, &vertexBuffers[1]);	// Already bound to slot 1
+		cmdList.IASetVertexBuffers(1, 1, &vertexBuffers[0]);
+		cmdList.IASetVertexBuffers(0, 1, &otherVertexBuffer);
+		cmdList.IASetVertexBuffers(2, 1, &otherVertexBuffer);	// Slot never bound
+		TEST_CHECK((recorder.Take() == Calls{ "IASetVertexBuffers", "IASetVertexBuffers", "IASetVertexBuffers", "IASetVertexBuffers" }));
+
+		cmdList.IASetIndexBuffer(&indexBuffer);
+		cmdList.IASetIndexBuffer(&indexBuffer);
+		cmdList.IASetIndexBuffer(&otherIndexBuffer);	// Same address, other format
+		cmdList.IASetIndexBuffer(nullptr);
+		cmdList.IASetIndexBuffer(nullptr);				// Unbinding is always forwarded
+		TEST_CHECK((recorder.Take() == Calls{ "IASetIndexBuffer", "IASetIndexBuffer", "IASetIndexBuffer", "IASetIndexBuffer" }));
+	}
+
+	void TestRootArguments()
+	{
+		RecordingCommandList recorder;
+		ToyDX::FilteredCommandList<RecordingCommandList> cmdList(recorder);
+
+		ID3D12RootSignature* rootSignatureA = FakeObject<ID3D12RootSignature>(0x10);
+		ID3D12RootSignature* rootSignatureB = FakeObject<ID3D12RootSignature>(0x20);
+		ID3D12DescriptorHeap* heapA = FakeObject<ID3D12DescriptorHeap>(0x30);
+		ID3D12DescriptorHeap* heapB = FakeObject<ID3D12DescriptorHeap>(0x40);
+
+		cmdList.SetGraphicsRootSignature(rootSignatureA);
+		cmdList.SetDescriptorHeaps(1, &heapA);
+		cmdList.SetDescriptorHeaps(1, &heapA);
+		TEST_CHECK((recorder.Take() == Calls{ "SetGraphicsRootSignature", "SetDescriptorHeaps" }));
+
+		cmdList.SetGraphicsRootDescriptorTable(0, { 100 });
+		cmdList.SetGraphicsRootDescriptorTable(0, { 100 });
+		cmdList.SetGraphicsRootDescriptorTable(0, { 200 });
+		cmdList.SetGraphicsRootConstantBufferView(1, 0x5000);
+		cmdList.SetGraphicsRootConstantBufferView(1, 0x5000);
+		cmdList.SetGraphicsRootShaderResourceView(1, 0x5000);	// Same value, other type of argument
+		cmdList.SetGraphicsRootShaderResourceView(1, 0x5000);
+		TEST_CHECK((recorder.Take() == Calls{ "SetGraphicsRootDescriptorTable", "SetGraphicsRootDescriptorTable", "SetGraphicsRootConstantBufferView", "SetGraphicsRootShaderResourceView" }));
+
+		// Changing the descriptor heaps unbinds the descriptor tables only
+		cmdList.SetDescriptorHeaps(1, &heapB);
+		cmdList.SetGraphicsRootDescriptorTable(0, { 200 });
+		cmdList.SetGraphicsRootShaderResourceView(1, 0x5000);
+		TEST_CHECK((recorder.Take() == Calls{ "SetDescriptorHeaps", "SetGraphicsRootDescriptorTable" }));
+
+		// Changing the root signature unbinds every argument
+		cmdList.SetGraphicsRootSignature(rootSignatureB);
+		cmdList.SetGraphicsRootDescriptorTable(0, { 200 });
+		cmdList.SetGraphicsRootShaderResourceView(1, 0x5000);
+		TEST_CHECK((recorder.Take() == Calls{ "SetGraphicsRootSignature", "SetGraphicsRootDescriptorTable", "SetGraphicsRootShaderResourceView" }));
+
+		// Setting the same root signature again keeps them
+		cmdList.SetGraphicsRootSignature(rootSignatureB);
+		cmdList.SetGraphicsRootDescriptorTable(0, { 200 });
+		TEST_CHECK(recorder.Take().empty());
+	}
+
+	void TestRootConstants()
+	{
+		RecordingCommandList recorder;
+		ToyDX::FilteredCommandList<RecordingCommandList> cmdList(recorder);
+
+		const UINT constants[] = { 1, 2, 3, 4 };
+		const UINT otherConstants[] = { 1, 2, 5, 4 };
+
+		cmdList.SetGraphicsRoot32BitConstants(2, 4, constants, 0);
+		cmdList.SetGraphicsRoot32BitConstants(2, 4, constants, 0);
+		cmdList.SetGraphicsRoot32BitConstants(2, 2, constants, 0);		// Subset already bound
+		cmdList.SetGraphicsRoot32BitConstants(2, 1, &constants[2], 2);	// Same value at an offset
+		cmdList.SetGraphicsRoot32BitConstants(2, 4, otherConstants, 0);
+		cmdList.SetGraphicsRoot32BitConstants(2, 1, &constants[2], 2);	// Changed by the previous call
+		cmdList.SetGraphicsRoot32BitConstants(2, 1, &constants[0], 4);	// Not bound yet
+		TEST_CHECK((recorder.Take() == Calls{ "SetGraphicsRoot32BitConstants", "SetGraphicsRoot32BitConstants", "SetGraphicsRoot32BitConstants", "SetGraphicsRoot32BitConstants" }));
+
+		// Other arguments of the same index replace the constants
+		cmdList.SetGraphicsRootConstantBufferView(2, 0x5000);
+		cmdList.SetGraphicsRoot32BitConstants(2, 4, otherConstants, 0);
+		TEST_CHECK((recorder.Take() == Calls{ "SetGraphicsRootConstantBufferView", "SetGraphicsRoot32BitConstants" }));
+	}
+
+	void TestDraws()
+	{
+		RecordingCommandList recorder;
+		ToyDX::FilteredCommandList<RecordingCommandList> cmdList(recorder);
+
+		const D3D12_VERTEX_BUFFER_VIEW vertexBuffer = { 0x1000, 256, 32 };
+		const D3D12_INDEX_BUFFER_VIEW indexBuffer = { 0x4000, 64, DXGI_FORMAT_R16_UINT };
+
+		// The draws of one mesh with one material : only the first one binds anything
+		for (int draw = 0; draw < 10; ++draw)
+		{
+			cmdList.IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+			cmdList.IASetVertexBuffers(0, 1, &vertexBuffer);
+			cmdList.IASetIndexBuffer(&indexBuffer);
+			cmdList.SetGraphicsRootDescriptorTable(0, { 100 });
+			cmdList.DrawIndexedInstanced(36, 1, 0, 0, 0);
+		}
+
+		const Calls calls = recorder.Take();
+		TEST_CHECK(calls.size() == 4 + 10);
+		TEST_CHECK(std::count(calls.begin(), calls.end(), "DrawIndexedInstanced") == 10);
+		TEST_CHECK(cmdList.GetStats().NumIssued == 4);
+		TEST_CHECK(cmdList.GetStats().NumElided == 36);
+		TEST_CHECK(cmdList.GetStats().NumDraws == 10);
+
+		// The indirect commands may set buffers and root arguments, but not the topology
+		cmdList.ExecuteIndirect(nullptr, 10, nullptr, 0, nullptr, 0);
+		cmdList.IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		cmdList.IASetVertexBuffers(0, 1, &vertexBuffer);
+		cmdList.IASetIndexBuffer(&indexBuffer);
+		cmdList.SetGraphicsRootDescriptorTable(0, { 100 });
+		TEST_CHECK((recorder.Take() == Calls{ "ExecuteIndirect", "IASetVertexBuffers", "IASetIndexBuffer", "SetGraphicsRootDescriptorTable" }));
+
+		ToyDX::CommandListStats total;
+		total += cmdList.GetStats();
+		total += cmdList.GetStats();
+		TEST_CHECK(total.NumDraws == 2 * cmdList.GetStats().NumDraws);
+	}
+}
+
+int main()
+{
+	TestPipelineState();
+	TestBuffers();
+	TestRootArguments();
+	TestRootConstants();
+	TestDraws();
+
+	return TestUtil::Finish("FilteredCommandListTests");
+}
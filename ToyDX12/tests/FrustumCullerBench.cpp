@@ -0,0 +1,47 @@
+#include "pch.h"
+
+#include "FrustumCuller.h"
+#include "TestUtil.h"
+
+using namespace DirectX;
+
+// Culls 100k synthetic objects, against the scalar test of one box and one plane at a time
+int main()
+{
+	const uint32_t NumObjects = 100000;
+
+	const std::vector<AABB> boxes = TestUtil::MakeRandomBoxes(NumObjects, 500.0f, 1);
+
+	FrustumCuller culler;
+	culler.Resize(NumObjects);
+	for (uint32_t i = 0; i < NumObjects; ++i)
+	{
+		culler.SetBounds(i, boxes[i]);
+	}
+
+	const XMMATRIX view = XMMatrixLookToLH(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.3f, 0.0f, 1.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	const XMMATRIX proj = XMMatrixPerspectiveFovLH(XMConvertToRadians(45.0f), 16.0f / 9.0f, 1.0f, 1000.0f);
+	const FrustumPlanes frustum = FrustumPlanes::FromViewProj(XMMatrixMultiply(view, proj));
+
+	size_t numVisible = 0;
+	const double simdMs = TestUtil::MeasureMs([&]() { numVisible = culler.Cull(frustum).size(); }, 50);
+
+	std::vector<uint32_t> scalarVisible;
+	scalarVisible.reserve(NumObjects);
+	const double scalarMs = TestUtil::MeasureMs([&]()
+	{
+		scalarVisible.clear();
+		for (uint32_t i = 0; i < NumObjects; ++i)
+		{
+			if (!TestUtil::IsOutside(frustum.Planes, boxes[i]))
+			{
+				scalarVisible.push_back(i);
+			}
+		}
+	}, 50);
+
+	printf("FrustumCullerBench: %u objects, %zu visible (scalar %zu).\n", NumObjects, numVisible, scalarVisible.size());
+	printf("FrustumCullerBench: SoA SIMD %.3f ms, scalar %.3f ms, x%.1f.\n", simdMs, scalarMs, scalarMs / simdMs);
+
+	return numVisible == scalarVisible.size() ? 0 : 1;
+}
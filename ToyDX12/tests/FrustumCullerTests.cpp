@@ -0,0 +1,83 @@
+#include "pch.h"
+
+#include "FrustumCuller.h"
+#include "TestUtil.h"
+
+using namespace DirectX;
+
+namespace
+{
+	FrustumPlanes MakeFrustum(FXMVECTOR eyePos, FXMVECTOR direction, float farZ)
+	{
+		const XMMATRIX view = XMMatrixLookToLH(eyePos, direction, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		const XMMATRIX proj = XMMatrixPerspectiveFovLH(XMConvertToRadians(45.0f), 16.0f / 9.0f, 1.0f, farZ);
+		return FrustumPlanes::FromViewProj(XMMatrixMultiply(view, proj));
+	}
+
+	void TestKnownBoxes()
+	{
+		const FrustumPlanes frustum = MakeFrustum(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), 100.0f);
+
+		const AABB boxes[] =
+		{
+			TestUtil::MakeBox({ 0.0f, 0.0f, 10.0f }, 1.0f),		// In front
+			TestUtil::MakeBox({ 0.0f, 0.0f, -10.0f }, 1.0f),	// Behind
+			TestUtil::MakeBox({ 0.0f, 0.0f, 200.0f }, 1.0f),	// Past the far plane
+			TestUtil::MakeBox({ 50.0f, 0.0f, 10.0f }, 1.0f),	// Right of the frustum
+			TestUtil::MakeBox({ 0.0f, 0.0f, 100.0f }, 2.0f),	// Crossing the far plane
+			AABB()												// Not set : never culled
+		};
+
+		FrustumCuller culler;
+		culler.Resize((uint32_t)std::size(boxes));
+		for (uint32_t i = 0; i < (uint32_t)std::size(boxes) - 1; ++i)
+		{
+			culler.SetBounds(i, boxes[i]);
+		}
+
+		const std::vector<uint32_t>& visible = culler.Cull(frustum);
+
+		TEST_CHECK((visible == std::vector<uint32_t>{ 0, 4, 5 }));
+	}
+
+	// Same result as testing every box against every plane, for counts that are not multiples of 4
+	void TestAgainstReference()
+	{
+		for (uint32_t count : { 1u, 3u, 4u, 5u, 1023u, 10000u })
+		{
+			const std::vector<AABB> boxes = TestUtil::MakeRandomBoxes(count, 500.0f, count);
+
+			FrustumCuller culler;
+			culler.Resize(count);
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				culler.SetBounds(i, boxes[i]);
+			}
+
+			for (int view = 0; view < 8; ++view)
+			{
+				const float angle = view * XM_2PI / 8.0f;
+				const FrustumPlanes frustum = MakeFrustum(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(sinf(angle), 0.0f, cosf(angle), 0.0f), 1000.0f);
+
+				std::vector<uint32_t> expected;
+				for (uint32_t i = 0; i < count; ++i)
+				{
+					if (!TestUtil::IsOutside(frustum.Planes, boxes[i]))
+					{
+						expected.push_back(i);
+					}
+				}
+
+				TEST_CHECK(culler.Cull(frustum) == expected);
+			}
+		}
+	}
+}
+
+int main()
+{
+	TestKnownBoxes();
+	TestAgainstReference();
+
+	return TestUtil::Finish("FrustumCullerTests");
+}
@@ -0,0 +1,359 @@
+#include "pch.h"
+
+#include "GpuHeapAllocator.h"
+#include "TestUtil.h"
+
+using Microsoft::WRL::ComPtr;
+using ToyDX::GpuHeapAllocator;
+using ToyDX::GpuHeapKind;
+using ToyDX::GpuHeapStats;
+
+namespace
+{
+	class MockDevice;
+
+	struct MockHeap : public ID3D12Heap
+	{
+		explicit MockHeap(const D3D12_HEAP_DESC& desc) : Desc(desc) {}
+
+		HRESULT SetName(const wchar_t*) override { return S_OK; }
+
+		D3D12_HEAP_DESC Desc;
+	};
+
+	// Keeps its heap alive, and tells the device when it is released
+	struct MockResource : public ID3D12Resource
+	{
+		MockResource(MockDevice& device, MockHeap* p_Heap, UINT64 offset, UINT64 size)
+			: Device(device), Heap(p_Heap), Offset(offset), Size(size) {}
+		~MockResource() override;
+
+		HRESULT SetName(const wchar_t*) override { return S_OK; }
+
+		MockDevice& Device;
+		ComPtr<MockHeap> Heap;
+		UINT64 Offset;
+		UINT64 Size;
+	};
+
+	// Sizes and alignments like a GPU would report them, and checks of the placements
+	class MockDevice : public ID3D12Device
+	{
+	public:
+		HRESULT SetName(const wchar_t*) override { return S_OK; }
+
+		D3D12_RESOURCE_ALLOCATION_INFO GetResourceAllocationInfo(UINT, UINT numResourceDescs, const D3D12_RESOURCE_DESC* pResourceDescs) override
+		{
+			assert(numResourceDescs == 1);
+			const D3D12_RESOURCE_DESC& desc = *pResourceDescs;
+
+			UINT64 size = desc.Width;
+			if (desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER)
+			{
+				size = desc.Width * desc.Height * desc.DepthOrArraySize * desc.SampleDesc.Count * 4;
+			}
+
+			UINT64 alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+			if (desc.SampleDesc.Count > 1)
+			{
+				alignment = D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT;
+			}
+			else if (desc.Alignment == D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT && size <= D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT)
+			{
+				alignment = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+			}
+
+			return { (size + alignment - 1) & ~(alignment - 1), alignment };
+		}
+
+		HRESULT CreateHeap(const D3D12_HEAP_DESC* pDesc, REFIID, void** ppvHeap) override
+		{
+			if (pDesc->SizeInBytes % pDesc->Alignment != 0)
+			{
+				return E_INVALIDARG;
+			}
+
+			NumHeapsCreated++;
+			*ppvHeap = static_cast<ID3D12Heap*>(new MockHeap(*pDesc));
+			return S_OK;
+		}
+
+		HRESULT CreatePlacedResource(ID3D12Heap* pHeap, UINT64 heapOffset, const D3D12_RESOURCE_DESC* pDesc, D3D12_RESOURCE_STATES,
+			const D3D12_CLEAR_VALUE*, REFIID, void** ppvResource) override
+		{
+			MockHeap* heap = static_cast<MockHeap*>(pHeap);
+			const D3D12_RESOURCE_ALLOCATION_INFO info = GetResourceAllocationInfo(0, 1, pDesc);
+
+			// The range must be aligned, in the heap, not used by another resource, and the heap must allow the resource
+			bool bValid = heapOffset % info.Alignment == 0 && heapOffset + info.SizeInBytes <= heap->Desc.SizeInBytes;
+			bValid = bValid && ToyDX::GpuHeapAllocator::GetKind(*pDesc) == GetKind(heap->Desc.Flags);
+
+			for (const MockResource* resource : LiveResources)
+			{
+				if (resource->Heap.Get() == heap && heapOffset < resource->Offset + resource->Size && resource->Offset < heapOffset + info.SizeInBytes)
+				{
+					bValid = false;
+				}
+			}
+
+			if (!bValid)
+			{
+				NumInvalidPlacements++;
+				return E_INVALIDARG;
+			}
+
+			MockResource* resource = new MockResource(*this, heap, heapOffset, info.SizeInBytes);
+			LiveResources.push_back(resource);
+			*ppvResource = static_cast<ID3D12Resource*>(resource);
+			return S_OK;
+		}
+
+		static GpuHeapKind GetKind(D3D12_HEAP_FLAGS flags)
+		{
+			switch (flags)
+			{
+			case D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS: return GpuHeapKind::Buffers;
+			case D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES: return GpuHeapKind::Textures;
+			default: return GpuHeapKind::RenderTargets;
+			}
+		}
+
+		std::vector<const MockResource*> LiveResources;
+		int NumHeapsCreated = 0;
+		int NumInvalidPlacements = 0;
+	};
+
+	MockResource::~MockResource()
+	{
+		std::erase(Device.LiveResources, this);
+	}
+
+	const MockResource& GetMock(const ComPtr<ID3D12Resource>& resource)
+	{
+		return *static_cast<const MockResource*>(resource.Get());
+	}
+
+	const UINT64 PageSize = 2 * D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT;
+
+	void TestBuffers()
+	{
+		MockDevice device;
+		GpuHeapAllocator allocator(&device, PageSize);
+
+		std::vector<ComPtr<ID3D12Resource>> buffers;
+		for (int i = 0; i < 6; ++i)
+		{
+			buffers.push_back(allocator.CreateBuffer(1000 * 1000, D3D12_RESOURCE_STATE_COMMON));
+		}
+
+		// Rounded to 64 KB, one page is enough
+		TEST_CHECK(device.NumHeapsCreated == 1);
+		TEST_CHECK(allocator.GetStats(GpuHeapKind::Buffers).NumPages == 1);
+		TEST_CHECK(allocator.GetStats(GpuHeapKind::Buffers).Usage.NumAllocations == 6);
+		TEST_CHECK(allocator.GetStats(GpuHeapKind::Buffers).Usage.AllocatedSize == 6 * 1024 * 1024);
+		TEST_CHECK(allocator.GetStats(GpuHeapKind::Textures).NumPages == 0);
+
+		// A freed range is reused
+		const UINT64 freedOffset = GetMock(buffers[2]).Offset;
+		allocator.Free(buffers[2].Get());
+		buffers[2].Reset();
+		buffers[2] = allocator.CreateBuffer(1000 * 1000, D3D12_RESOURCE_STATE_COMMON);
+		TEST_CHECK(GetMock(buffers[2]).Offset == freedOffset);
+		TEST_CHECK(device.NumHeapsCreated == 1);
+
+		// The next page is created when the first one is full
+		buffers.push_back(allocator.CreateBuffer(PageSize - 6 * 1024 * 1024, D3D12_RESOURCE_STATE_COMMON));
+		buffers.push_back(allocator.CreateBuffer(1, D3D12_RESOURCE_STATE_COMMON));
+		TEST_CHECK(allocator.GetStats(GpuHeapKind::Buffers).NumPages == 2);
+		TEST_CHECK(GetMock(buffers[6]).Heap.Get() == GetMock(buffers[0]).Heap.Get());
+		TEST_CHECK(GetMock(buffers[7]).Heap.Get() != GetMock(buffers[0]).Heap.Get());
+
+		// Resources of other allocators are ignored
+		GpuHeapAllocator otherAllocator(&device, PageSize);
+		ComPtr<ID3D12Resource> other = otherAllocator.CreateBuffer(1024, D3D12_RESOURCE_STATE_COMMON);
+		allocator.Free(other.Get());
+		TEST_CHECK(allocator.GetStats(GpuHeapKind::Buffers).Usage.NumAllocations == 8);
+
+		for (ComPtr<ID3D12Resource>& buffer : buffers)
+		{
+			allocator.Free(buffer.Get());
+		}
+		buffers.clear();
+
+		TEST_CHECK(allocator.GetStats(GpuHeapKind::Buffers).Usage.NumAllocations == 0);
+		TEST_CHECK(allocator.GetStats(GpuHeapKind::Buffers).Usage.NumFreeBlocks == 2);
+		TEST_CHECK(device.NumInvalidPlacements == 0);
+	}
+
+	void TestTextures()
+	{
+		MockDevice device;
+		GpuHeapAllocator allocator(&device, PageSize);
+
+		// 16 KB each : 4 KB aligned, 4 of them in 64 KB
+		std::vector<ComPtr<ID3D12Resource>> smallTextures;
+		for (int i = 0; i < 4; ++i)
+		{
+			smallTextures.push_back(allocator.CreateResource(CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 64, 64), D3D12_RESOURCE_STATE_COPY_DEST));
+		}
+
+		TEST_CHECK(allocator.GetStats(GpuHeapKind::Textures).Usage.AllocatedSize == 4 * 16 * 1024);
+		for (const ComPtr<ID3D12Resource>& texture : smallTextures)
+		{
+			TEST_CHECK(GetMock(texture).Offset < D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+		}
+
+		// 1 MB : 64 KB aligned
+		ComPtr<ID3D12Resource> texture = allocator.CreateResource(CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 512, 512), D3D12_RESOURCE_STATE_COPY_DEST);
+		TEST_CHECK(GetMock(texture).Offset % D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT == 0);
+		TEST_CHECK(GetMock(texture).Heap.Get() == GetMock(smallTextures[0]).Heap.Get());
+
+		// Render targets and depth buffers have pages of their own, multisampled ones are 4 MB aligned
+		ComPtr<ID3D12Resource> renderTarget = allocator.CreateResource(
+			CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 256, 256, 1, 1, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET), D3D12_RESOURCE_STATE_RENDER_TARGET);
+		ComPtr<ID3D12Resource> depthBuffer = allocator.CreateResource(
+			CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_D24_UNORM_S8_UINT, 256, 256, 1, 1, 4, 0, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL), D3D12_RESOURCE_STATE_DEPTH_WRITE);
+
+		TEST_CHECK(allocator.GetStats(GpuHeapKind::RenderTargets).NumPages == 1);
+		TEST_CHECK(GetMock(renderTarget).Heap.Get() != GetMock(texture).Heap.Get());
+		TEST_CHECK(GetMock(depthBuffer).Heap.Get() == GetMock(renderTarget).Heap.Get());
+		TEST_CHECK(GetMock(depthBuffer).Offset % D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT == 0);
+		TEST_CHECK(GetMock(depthBuffer).Heap->Desc.Alignment == D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT);
+
+		TEST_CHECK(device.NumInvalidPlacements == 0);
+	}
+
+	void TestDedicatedPages()
+	{
+		MockDevice device;
+		GpuHeapAllocator allocator(&device, PageSize);
+
+		ComPtr<ID3D12Resource> small = allocator.CreateBuffer(1024, D3D12_RESOURCE_STATE_COMMON);
+		ComPtr<ID3D12Resource> large = allocator.CreateBuffer(PageSize + 1, D3D12_RESOURCE_STATE_COMMON);
+
+		GpuHeapStats stats = allocator.GetStats(GpuHeapKind::Buffers);
+		TEST_CHECK(stats.NumPages == 2);
+		TEST_CHECK(stats.NumDedicatedPages == 1);
+		TEST_CHECK(GetMock(large).Heap->Desc.SizeInBytes >= PageSize + 1);
+
+		// Nothing else goes in a dedicated page, and it is released with its resource
+		ComPtr<ID3D12Resource> other = allocator.CreateBuffer(1024, D3D12_RESOURCE_STATE_COMMON);
+		TEST_CHECK(GetMock(other).Heap.Get() == GetMock(small).Heap.Get());
+
+		allocator.Free(large.Get());
+		large.Reset();
+		stats = allocator.GetStats(GpuHeapKind::Buffers);
+		TEST_CHECK(stats.NumPages == 1);
+		TEST_CHECK(stats.NumDedicatedPages == 0);
+
+		// Its slot is reused by the next page
+		large = allocator.CreateBuffer(2 * PageSize, D3D12_RESOURCE_STATE_COMMON);
+		TEST_CHECK(allocator.GetStats(GpuHeapKind::Buffers).NumPages == 2);
+
+		TEST_CHECK(device.NumInvalidPlacements == 0);
+	}
+
+	void TestDeferredFrees()
+	{
+		MockDevice device;
+		GpuHeapAllocator allocator(&device, PageSize);
+
+		ComPtr<ID3D12Resource> first = allocator.CreateBuffer(1024, D3D12_RESOURCE_STATE_COMMON);
+		ComPtr<ID3D12Resource> second = allocator.CreateBuffer(1024, D3D12_RESOURCE_STATE_COMMON);
+		const UINT64 firstOffset = GetMock(first).Offset;
+
+		// The allocator holds the last references until the fences pass
+		allocator.FreeDeferred(std::move(first), 5);
+		allocator.FreeDeferred(std::move(second), 6);
+		allocator.FreeDeferred(nullptr, 6);
+		TEST_CHECK(device.LiveResources.size() == 2);
+
+		allocator.RetireDeferredFrees(4);
+		TEST_CHECK(device.LiveResources.size() == 2);
+		TEST_CHECK(allocator.GetStats(GpuHeapKind::Buffers).Usage.NumAllocations == 2);
+
+		// Until then, the ranges are not reused
+		ComPtr<ID3D12Resource> third = allocator.CreateBuffer(1024, D3D12_RESOURCE_STATE_COMMON);
+		TEST_CHECK(GetMock(third).Offset != firstOffset);
+
+		allocator.RetireDeferredFrees(5);
+		TEST_CHECK(device.LiveResources.size() == 2);
+		TEST_CHECK(allocator.GetStats(GpuHeapKind::Buffers).Usage.NumAllocations == 2);
+
+		ComPtr<ID3D12Resource> fourth = allocator.CreateBuffer(1024, D3D12_RESOURCE_STATE_COMMON);
+		TEST_CHECK(GetMock(fourth).Offset == firstOffset);
+
+		allocator.RetireDeferredFrees(100);
+		TEST_CHECK(device.LiveResources.size() == 2);
+		TEST_CHECK(allocator.GetStats(GpuHeapKind::Buffers).Usage.NumAllocations == 2);
+
+		TEST_CHECK(device.NumInvalidPlacements == 0);
+	}
+
+	// Random creations and releases, the mock device checks that no two live resources overlap
+	void TestRandom()
+	{
+		MockDevice device;
+		GpuHeapAllocator allocator(&device, PageSize);
+
+		std::mt19937 rng(7);
+		std::vector<ComPtr<ID3D12Resource>> resources;
+
+		for (int step = 0; step < 5000; ++step)
+		{
+			if (rng() % 3 != 0 || resources.empty())
+			{
+				const UINT64 size = rng() % 4 == 0 ? rng() % (2 * 1024 * 1024) + 1 : rng() % (64 * 1024) + 1;
+				const UINT width = 1u << (rng() % 11);
+
+				switch (rng() % 3)
+				{
+				case 0: resources.push_back(allocator.CreateBuffer(size, D3D12_RESOURCE_STATE_COMMON)); break;
+				case 1: resources.push_back(allocator.CreateResource(CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, width, width / 2 + 1), D3D12_RESOURCE_STATE_COPY_DEST)); break;
+				default: resources.push_back(allocator.CreateResource(
+					CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, width, width, 1, 1, rng() % 2 == 0 ? 1 : 4, 0, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET), D3D12_RESOURCE_STATE_RENDER_TARGET));
+				}
+			}
+			else
+			{
+				const size_t index = rng() % resources.size();
+				allocator.Free(resources[index].Get());
+				std::swap(resources[index], resources.back());
+				resources.pop_back();
+			}
+		}
+
+		TEST_CHECK(device.NumInvalidPlacements == 0);
+
+		UINT numAllocations = 0;
+		for (size_t kind = 0; kind < (size_t)GpuHeapKind::Count; ++kind)
+		{
+			numAllocations += allocator.GetStats((GpuHeapKind)kind).Usage.NumAllocations;
+		}
+		TEST_CHECK(numAllocations == resources.size());
+
+		for (ComPtr<ID3D12Resource>& resource : resources)
+		{
+			allocator.Free(resource.Get());
+		}
+
+		for (size_t kind = 0; kind < (size_t)GpuHeapKind::Count; ++kind)
+		{
+			const GpuHeapStats stats = allocator.GetStats((GpuHeapKind)kind);
+			TEST_CHECK(stats.Usage.NumAllocations == 0);
+			TEST_CHECK(stats.NumDedicatedPages == 0);
+			TEST_CHECK(stats.Usage.NumFreeBlocks == stats.NumPages);
+		}
+	}
+}
+
+int main()
+{
+	TestBuffers();
+	TestTextures();
+	TestDedicatedPages();
+	TestDeferredFrees();
+	TestRandom();
+
+	return TestUtil::Finish("GpuHeapAllocatorTests");
+}
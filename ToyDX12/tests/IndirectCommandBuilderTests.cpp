@@ -0,0 +1,102 @@
+#include "pch.h"
+
+#include <cstring>
+
+#include "d3d12.h"
+#include "IndirectCommandBuilder.h"
+#include "TestUtil.h"
+
+namespace
+{
+	template<typename T>
+	T ReadAt(const unsigned char* p_Bytes, size_t ui_Offset)
+	{
+		T value;
+		memcpy(&value, p_Bytes + ui_Offset, sizeof(T));
+		return value;
+	}
+
+	void TestLayout()
+	{
+		// The mirrors must match the D3D12 structures they stand for
+		TEST_CHECK(sizeof(IndirectVertexBufferView) == sizeof(D3D12_VERTEX_BUFFER_VIEW));
+		TEST_CHECK(offsetof(IndirectVertexBufferView, SizeInBytes) == offsetof(D3D12_VERTEX_BUFFER_VIEW, SizeInBytes));
+		TEST_CHECK(offsetof(IndirectVertexBufferView, StrideInBytes) == offsetof(D3D12_VERTEX_BUFFER_VIEW, StrideInBytes));
+		TEST_CHECK(sizeof(IndirectIndexBufferView) == sizeof(D3D12_INDEX_BUFFER_VIEW));
+		TEST_CHECK(offsetof(IndirectIndexBufferView, SizeInBytes) == offsetof(D3D12_INDEX_BUFFER_VIEW, SizeInBytes));
+		TEST_CHECK(offsetof(IndirectIndexBufferView, Format) == offsetof(D3D12_INDEX_BUFFER_VIEW, Format));
+		TEST_CHECK(sizeof(IndirectDrawIndexedArguments) == sizeof(D3D12_DRAW_INDEXED_ARGUMENTS));
+		TEST_CHECK(offsetof(IndirectDrawIndexedArguments, BaseVertexLocation) == offsetof(D3D12_DRAW_INDEXED_ARGUMENTS, BaseVertexLocation));
+
+		// Arguments follow each other in the order of the command signature, without gaps
+		TEST_CHECK(IndirectCommandBuilder::RootConstantsOffset == 0);
+		TEST_CHECK(IndirectCommandBuilder::VertexBufferOffset == IndirectDrawCommand::NumRootConstants * sizeof(uint32_t));
+		TEST_CHECK(IndirectCommandBuilder::IndexBufferOffset == IndirectCommandBuilder::VertexBufferOffset + sizeof(D3D12_VERTEX_BUFFER_VIEW));
+		TEST_CHECK(IndirectCommandBuilder::DrawOffset == IndirectCommandBuilder::IndexBufferOffset + sizeof(D3D12_INDEX_BUFFER_VIEW));
+		TEST_CHECK(IndirectCommandBuilder::DrawOffset + sizeof(D3D12_DRAW_INDEXED_ARGUMENTS) <= IndirectCommandBuilder::ByteStride);
+
+		// Buffer addresses stay 8 bytes aligned in every command, and the stride is a multiple of 4 bytes
+		TEST_CHECK(IndirectCommandBuilder::VertexBufferOffset % 8 == 0);
+		TEST_CHECK(IndirectCommandBuilder::IndexBufferOffset % 8 == 0);
+		TEST_CHECK(IndirectCommandBuilder::ByteStride % 8 == 0);
+	}
+
+	void TestCommands()
+	{
+		IndirectCommandBuilder builder;
+		TEST_CHECK(builder.GetCount() == 0);
+		TEST_CHECK(builder.GetSizeInBytes() == 0);
+
+		const uint32_t numCommands = 100;
+		builder.Reserve(numCommands);
+		for (uint32_t i = 0; i < numCommands; ++i)
+		{
+			const uint32_t rootConstants[IndirectDrawCommand::NumRootConstants] = { i, 1000 + i };
+			const IndirectVertexBufferView vertexBuffer = { 0x10000ull * i, 64 * i, 32 };
+			const IndirectIndexBufferView indexBuffer = { 0x20000ull + 8 * i, 12 * i, 57 };	// DXGI_FORMAT_R16_UINT
+			builder.AddDrawIndexed(rootConstants, vertexBuffer, indexBuffer, 36 + i, 1 + i % 3, 3 * i, -int32_t(i));
+		}
+
+		TEST_CHECK(builder.GetCount() == numCommands);
+		TEST_CHECK(builder.GetSizeInBytes() == numCommands * IndirectCommandBuilder::ByteStride);
+
+		// Read the buffer back the way the command processor does
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(builder.GetData());
+		for (uint32_t i = 0; i < numCommands; ++i)
+		{
+			const unsigned char* command = bytes + i * IndirectCommandBuilder::ByteStride;
+
+			TEST_CHECK(ReadAt<uint32_t>(command, IndirectCommandBuilder::RootConstantsOffset) == i);
+			TEST_CHECK(ReadAt<uint32_t>(command, IndirectCommandBuilder::RootConstantsOffset + 4) == 1000 + i);
+
+			const D3D12_VERTEX_BUFFER_VIEW vertexBuffer = ReadAt<D3D12_VERTEX_BUFFER_VIEW>(command, IndirectCommandBuilder::VertexBufferOffset);
+			TEST_CHECK(vertexBuffer.BufferLocation == 0x10000ull * i);
+			TEST_CHECK(vertexBuffer.SizeInBytes == 64 * i);
+			TEST_CHECK(vertexBuffer.StrideInBytes == 32);
+
+			const D3D12_INDEX_BUFFER_VIEW indexBuffer = ReadAt<D3D12_INDEX_BUFFER_VIEW>(command, IndirectCommandBuilder::IndexBufferOffset);
+			TEST_CHECK(indexBuffer.BufferLocation == 0x20000ull + 8 * i);
+			TEST_CHECK(indexBuffer.SizeInBytes == 12 * i);
+			TEST_CHECK(indexBuffer.Format == DXGI_FORMAT_R16_UINT);
+
+			const D3D12_DRAW_INDEXED_ARGUMENTS draw = ReadAt<D3D12_DRAW_INDEXED_ARGUMENTS>(command, IndirectCommandBuilder::DrawOffset);
+			TEST_CHECK(draw.IndexCountPerInstance == 36 + i);
+			TEST_CHECK(draw.InstanceCount == 1 + i % 3);
+			TEST_CHECK(draw.StartIndexLocation == 3 * i);
+			TEST_CHECK(draw.BaseVertexLocation == -INT(i));
+			TEST_CHECK(draw.StartInstanceLocation == 0);
+		}
+
+		builder.Clear();
+		TEST_CHECK(builder.GetCount() == 0);
+		TEST_CHECK(builder.GetSizeInBytes() == 0);
+	}
+}
+
+int main()
+{
+	TestLayout();
+	TestCommands();
+
+	return TestUtil::Finish("IndirectCommandBuilderTests");
+}
@@ -0,0 +1,271 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <random>
+
+#define CGLTF_IMPLEMENTATION
+#include "cgltf.h"
+
+#include "FrustumCuller.h"
+#include "OcclusionCuller.h"
+#include "TestUtil.h"
+
+using namespace DirectX;
+
+namespace
+{
+	struct Primitive
+	{
+		std::vector<XMFLOAT3> Positions;
+		std::vector<uint16_t> Indices;	// Empty when the primitive can't be an occluder
+		XMFLOAT4X4 World;
+		AABB WorldBounds;
+	};
+
+	bool LoadPrimitives(const char* sz_Path, std::vector<Primitive>& r_Primitives)
+	{
+		cgltf_options options = {};
+		cgltf_data* data = nullptr;
+
+		if (cgltf_parse_file(&options, sz_Path, &data) != cgltf_result_success || cgltf_load_buffers(&options, data, sz_Path) != cgltf_result_success)
+		{
+			cgltf_free(data);
+			return false;
+		}
+
+		for (size_t n = 0; n < data->nodes_count; ++n)
+		{
+			const cgltf_node& node = data->nodes[n];
+			if (node.mesh == nullptr)
+			{
+				continue;
+			}
+
+			float world[16];
+			cgltf_node_transform_world(&node, world);
+
+			for (size_t p = 0; p < node.mesh->primitives_count; ++p)
+			{
+				const cgltf_primitive& gltfPrimitive = node.mesh->primitives[p];
+				Primitive& primitive = r_Primitives.emplace_back();
+				memcpy(&primitive.World, world, sizeof(world));
+
+				for (size_t a = 0; a < gltfPrimitive.attributes_count; ++a)
+				{
+					if (gltfPrimitive.attributes[a].type == cgltf_attribute_type_position)
+					{
+						const cgltf_accessor* accessor = gltfPrimitive.attributes[a].data;
+						primitive.Positions.resize(accessor->count);
+
+						for (size_t v = 0; v < accessor->count; ++v)
+						{
+							cgltf_accessor_read_float(accessor, v, &primitive.Positions[v].x, 3);
+						}
+					}
+				}
+
+				AABB bounds;
+				for (const XMFLOAT3& position : primitive.Positions)
+				{
+					bounds.Expand(position);
+				}
+				primitive.WorldBounds = bounds.Transform(XMLoadFloat4x4(&primitive.World));
+
+				// The occlusion culler takes 16 bit indices
+				if (gltfPrimitive.indices != nullptr && primitive.Positions.size() <= 0xFFFF)
+				{
+					primitive.Indices.resize(gltfPrimitive.indices->count);
+					for (size_t i = 0; i < primitive.Indices.size(); ++i)
+					{
+						primitive.Indices[i] = (uint16_t)cgltf_accessor_read_index(gltfPrimitive.indices, i);
+					}
+				}
+			}
+		}
+
+		cgltf_free(data);
+		return true;
+	}
+
+	void AddBox(const XMFLOAT3& min, const XMFLOAT3& max, std::vector<Primitive>& r_Primitives)
+	{
+		Primitive& primitive = r_Primitives.emplace_back();
+		XMStoreFloat4x4(&primitive.World, XMMatrixIdentity());
+
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			primitive.Positions.push_back({ (corner & 1) ? max.x : min.x, (corner & 2) ? max.y : min.y, (corner & 4) ? max.z : min.z });
+			primitive.WorldBounds.Expand(primitive.Positions.back());
+		}
+
+		// Two triangles per face, corners of a face differ by the bits of the two other axes
+		const uint16_t faces[6][4] = { { 0, 2, 6, 4 }, { 1, 5, 7, 3 }, { 0, 4, 5, 1 }, { 2, 3, 7, 6 }, { 0, 1, 3, 2 }, { 4, 6, 7, 5 } };
+		for (const uint16_t (&face)[4] : faces)
+		{
+			primitive.Indices.insert(primitive.Indices.end(), { face[0], face[1], face[2], face[0], face[2], face[3] });
+		}
+	}
+
+	// Stand-in of Sponza when its buffers are not there : an atrium closed by walls and lined with pillars,
+	// with galleries full of small props behind the walls
+	void MakeAtrium(std::vector<Primitive>& r_Primitives)
+	{
+		const float halfLength = 60.0f;
+		const float halfWidth = 10.0f;
+		const float height = 20.0f;
+		const float thickness = 0.5f;
+
+		AddBox({ -halfLength - 20.0f, -thickness, -halfWidth - 15.0f }, { halfLength + 20.0f, 0.0f, halfWidth + 15.0f }, r_Primitives);
+		AddBox({ -halfLength, 0.0f, halfWidth }, { halfLength, height, halfWidth + thickness }, r_Primitives);
+		AddBox({ -halfLength, 0.0f, -halfWidth - thickness }, { halfLength, height, -halfWidth }, r_Primitives);
+		AddBox({ halfLength, 0.0f, -halfWidth }, { halfLength + thickness, height, halfWidth }, r_Primitives);
+		AddBox({ -halfLength - thickness, 0.0f, -halfWidth }, { -halfLength, height, halfWidth }, r_Primitives);
+
+		for (float x = -halfLength + 4.0f; x < halfLength; x += 8.0f)
+		{
+			AddBox({ x - 0.6f, 0.0f, halfWidth - 2.0f }, { x + 0.6f, height, halfWidth - 0.8f }, r_Primitives);
+			AddBox({ x - 0.6f, 0.0f, -halfWidth + 0.8f }, { x + 0.6f, height, -halfWidth + 2.0f }, r_Primitives);
+		}
+
+		std::mt19937 rng(11);
+		std::uniform_real_distribution<float> propX(-halfLength - 15.0f, halfLength + 15.0f);
+		std::uniform_real_distribution<float> propZ(halfWidth + 1.0f, halfWidth + 14.0f);
+		std::uniform_real_distribution<float> propSize(0.2f, 1.5f);
+
+		for (int prop = 0; prop < 4000; ++prop)
+		{
+			const float x = propX(rng);
+			const float z = (prop % 2 ? 1.0f : -1.0f) * propZ(rng);
+			const float size = propSize(rng);
+			AddBox({ x - size, 0.0f, z - size }, { x + size, 2.0f * size, z + size }, r_Primitives);
+		}
+	}
+
+	// Same selection as the renderer : large and simple primitives first, until the triangle budget is spent
+	std::vector<uint32_t> SelectOccluders(const std::vector<Primitive>& a_Primitives, size_t maxTriangles)
+	{
+		auto GetScore = [&](uint32_t index)
+		{
+			return a_Primitives[index].WorldBounds.SurfaceArea() / (a_Primitives[index].Indices.size() / 3);
+		};
+
+		std::vector<uint32_t> candidates;
+		for (uint32_t i = 0; i < a_Primitives.size(); ++i)
+		{
+			if (a_Primitives[i].Indices.size() >= 3 && a_Primitives[i].WorldBounds.IsValid())
+			{
+				candidates.push_back(i);
+			}
+		}
+
+		std::sort(candidates.begin(), candidates.end(), [&](uint32_t a, uint32_t b) { return GetScore(a) > GetScore(b); });
+
+		std::vector<uint32_t> occluders;
+		size_t numTriangles = 0;
+		for (uint32_t index : candidates)
+		{
+			const size_t triangles = a_Primitives[index].Indices.size() / 3;
+			if (numTriangles + triangles <= maxTriangles)
+			{
+				occluders.push_back(index);
+				numTriangles += triangles;
+			}
+		}
+
+		return occluders;
+	}
+}
+
+// Occlusion culling of the Sponza primitives from a few viewpoints inside the atrium
+// The path of a glTF scene can be given as argument, the Sponza of the application data is used otherwise
+int main(int argc, char** argv)
+{
+	const char* path = argc > 1 ? argv[1] : SPONZA_PATH;
+
+	std::vector<Primitive> primitives;
+	if (!LoadPrimitives(path, primitives))
+	{
+		printf("OcclusionCullerBench: Could not load %s, using a generated atrium instead.\n", path);
+
+		path = "Generated atrium";
+		primitives.clear();
+		MakeAtrium(primitives);
+	}
+
+	AABB sceneBounds;
+	for (const Primitive& primitive : primitives)
+	{
+		sceneBounds.Merge(primitive.WorldBounds);
+	}
+
+	OcclusionCuller occlusionCuller;
+	const std::vector<uint32_t> occluders = SelectOccluders(primitives, occlusionCuller.GetSettings().MaxOccluderTriangles);
+
+	std::vector<bool> isOccluder(primitives.size(), false);
+	for (uint32_t index : occluders)
+	{
+		isOccluder[index] = true;
+	}
+
+	FrustumCuller frustumCuller;
+	frustumCuller.Resize((uint32_t)primitives.size());
+	for (uint32_t i = 0; i < primitives.size(); ++i)
+	{
+		frustumCuller.SetBounds(i, primitives[i].WorldBounds);
+	}
+
+	printf("OcclusionCullerBench: %s, %zu primitives, %zu occluders.\n", path, primitives.size(), occluders.size());
+
+	// Eye height and view directions relative to the scene bounds : along the atrium, across it, and from its end
+	const XMFLOAT3 center = sceneBounds.Center();
+	const XMFLOAT3 extents = sceneBounds.Extents();
+	const float eyeY = sceneBounds.Min.y + 0.3f * extents.y;
+
+	const XMVECTOR eyes[] =
+	{
+		XMVectorSet(center.x + 0.8f * extents.x, eyeY, center.z, 1.0f),
+		XMVectorSet(center.x, eyeY, center.z, 1.0f),
+		XMVectorSet(center.x - 0.5f * extents.x, eyeY + 0.3f * extents.y, center.z, 1.0f)
+	};
+
+	const XMVECTOR directions[] =
+	{
+		XMVectorSet(-1.0f, 0.0f, 0.0f, 0.0f),
+		XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f),
+		XMVectorSet(1.0f, 0.0f, 0.2f, 0.0f)
+	};
+
+	const XMMATRIX proj = XMMatrixPerspectiveFovLH(XMConvertToRadians(45.0f), 16.0f / 9.0f, 0.01f * extents.x, 4.0f * extents.x);
+
+	for (size_t v = 0; v < std::size(eyes); ++v)
+	{
+		const XMMATRIX viewProj = XMMatrixMultiply(XMMatrixLookToLH(eyes[v], directions[v], XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)), proj);
+		const std::vector<uint32_t> frustumVisible = frustumCuller.Cull(FrustumPlanes::FromViewProj(viewProj));
+
+		const double rasterizeMs = TestUtil::MeasureMs([&]()
+		{
+			occlusionCuller.BeginFrame(viewProj);
+			for (uint32_t index : occluders)
+			{
+				const Primitive& occluder = primitives[index];
+				occlusionCuller.RasterizeTriangles(occluder.Positions.data(), sizeof(XMFLOAT3), occluder.Indices.data(), occluder.Indices.size(), XMLoadFloat4x4(&occluder.World));
+			}
+		}, 20);
+
+		// Like the renderer, occluders are drawn without being tested
+		size_t numVisible = 0;
+		const double testMs = TestUtil::MeasureMs([&]()
+		{
+			numVisible = 0;
+			for (uint32_t index : frustumVisible)
+			{
+				numVisible += (isOccluder[index] || occlusionCuller.IsVisible(primitives[index].WorldBounds)) ? 1 : 0;
+			}
+		}, 20);
+
+		printf("OcclusionCullerBench: view %zu : %zu in the frustum, %zu visible, %u occluder triangles rasterized in %.3f ms, boxes tested in %.3f ms.\n",
+			v, frustumVisible.size(), numVisible, occlusionCuller.GetNumRasterizedTriangles(), rasterizeMs, testMs);
+	}
+
+	return 0;
+}
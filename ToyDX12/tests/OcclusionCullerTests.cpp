@@ -0,0 +1,203 @@
+#include "pch.h"
+
+#include "OcclusionCuller.h"
+#include "TestUtil.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// The camera is on the x axis and looks down +z
+	const float FovY = XMConvertToRadians(60.0f);
+	const float AspectRatio = 16.0f / 9.0f;
+	const float NearZ = 0.1f;
+
+	// Occluders : quads facing the camera at a constant depth
+	struct Wall
+	{
+		float Z;
+		float MinX, MaxX;
+		float MinY, MaxY;
+	};
+
+	const Wall s_Walls[] =
+	{
+		{ 10.0f, -5.0f, 5.0f, -5.0f, 5.0f },
+		{ 30.0f, 0.0f, 40.0f, -50.0f, 50.0f }
+	};
+
+	void RasterizeWalls(OcclusionCuller& r_Culler)
+	{
+		const uint16_t indices[] = { 0, 1, 2, 0, 2, 3 };
+
+		for (const Wall& wall : s_Walls)
+		{
+			const XMFLOAT3 corners[] = { { wall.MinX, wall.MinY, wall.Z }, { wall.MaxX, wall.MinY, wall.Z }, { wall.MaxX, wall.MaxY, wall.Z }, { wall.MinX, wall.MaxY, wall.Z } };
+			r_Culler.RasterizeTriangles(corners, sizeof(XMFLOAT3), indices, std::size(indices), XMMatrixIdentity());
+		}
+	}
+
+	// Exact visibility of a point : outside of the screen, or behind a wall
+	bool IsPointHidden(const XMFLOAT3& position, float cameraX)
+	{
+		const XMFLOAT3 p = { position.x - cameraX, position.y, position.z };
+
+		if (p.z <= NearZ)
+		{
+			return false;
+		}
+
+		const float tanHalfFov = tanf(0.5f * FovY);
+		if (fabsf(p.y / p.z) > tanHalfFov || fabsf(p.x / p.z) > tanHalfFov * AspectRatio)
+		{
+			return true;
+		}
+
+		for (const Wall& wall : s_Walls)
+		{
+			const float t = wall.Z / p.z;
+			const float x = p.x * t + cameraX;
+			if (p.z > wall.Z && x >= wall.MinX && x <= wall.MaxX && p.y * t >= wall.MinY && p.y * t <= wall.MaxY)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// Samples the faces of the box
+	bool IsBoxHidden(const AABB& box, float cameraX)
+	{
+		const int NumSamples = 6;
+
+		for (int i = 0; i <= NumSamples; ++i)
+		{
+			for (int j = 0; j <= NumSamples; ++j)
+			{
+				const float u = (float)i / NumSamples;
+				const float v = (float)j / NumSamples;
+
+				const XMFLOAT3 a = { box.Min.x + u * (box.Max.x - box.Min.x), box.Min.y + v * (box.Max.y - box.Min.y), box.Min.z };
+				const XMFLOAT3 b = { box.Min.x + u * (box.Max.x - box.Min.x), box.Min.y, box.Min.z + v * (box.Max.z - box.Min.z) };
+				const XMFLOAT3 c = { box.Min.x, box.Min.y + u * (box.Max.y - box.Min.y), box.Min.z + v * (box.Max.z - box.Min.z) };
+				const XMFLOAT3 samples[] = { a, { a.x, a.y, box.Max.z }, b, { b.x, box.Max.y, b.z }, c, { box.Max.x, c.y, c.z } };
+
+				for (const XMFLOAT3& sample : samples)
+				{
+					if (!IsPointHidden(sample, cameraX))
+					{
+						return false;
+					}
+				}
+			}
+		}
+
+		return true;
+	}
+
+	OcclusionCuller MakeCuller(float cameraX = 0.0f)
+	{
+		const XMMATRIX view = XMMatrixLookToLH(XMVectorSet(cameraX, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		const XMMATRIX proj = XMMatrixPerspectiveFovLH(FovY, AspectRatio, NearZ, 1000.0f);
+
+		OcclusionCuller culler;
+		culler.BeginFrame(XMMatrixMultiply(view, proj));
+		RasterizeWalls(culler);
+
+		return culler;
+	}
+
+	void TestKnownBoxes()
+	{
+		const OcclusionCuller culler = MakeCuller();
+
+		TEST_CHECK(culler.GetNumRasterizedTriangles() == 4);
+
+		TEST_CHECK(!culler.IsVisible(TestUtil::MakeBox({ 0.0f, 0.0f, 20.0f }, 1.0f)));		// Behind the first wall
+		TEST_CHECK(!culler.IsVisible(TestUtil::MakeBox({ 15.0f, 0.0f, 50.0f }, 2.0f)));		// Behind the second wall
+		TEST_CHECK(culler.IsVisible(TestUtil::MakeBox({ 0.0f, 0.0f, 5.0f }, 1.0f)));		// In front of the first wall
+		TEST_CHECK(culler.IsVisible(TestUtil::MakeBox({ 10.0f, 0.0f, 20.0f }, 1.0f)));		// Across the edge of the first wall
+		TEST_CHECK(culler.IsVisible(TestUtil::MakeBox({ -20.0f, 0.0f, 20.0f }, 1.0f)));		// Beside the walls
+		TEST_CHECK(culler.IsVisible(TestUtil::MakeBox({ 0.0f, 0.0f, 10.0f }, 1.0f)));		// Crossing the first wall
+		TEST_CHECK(culler.IsVisible(TestUtil::MakeBox({ 0.0f, 0.0f, 0.0f }, 1.0f)));		// Crossing the near plane
+
+		// Occluders are never hidden by the depth they wrote themselves
+		for (const Wall& wall : s_Walls)
+		{
+			AABB wallBounds;
+			wallBounds.Expand({ wall.MinX, wall.MinY, wall.Z });
+			wallBounds.Expand({ wall.MaxX, wall.MaxY, wall.Z });
+			TEST_CHECK(culler.IsVisible(wallBounds));
+		}
+	}
+
+	// A box reported occluded must be hidden everywhere
+	// The camera moves by fractions of a pixel, so that the edges of the walls cross the pixels at different places
+	void TestConservative()
+	{
+		std::mt19937 rng(5);
+		std::uniform_real_distribution<float> position(-30.0f, 30.0f);
+		std::uniform_real_distribution<float> depth(5.0f, 100.0f);
+		std::uniform_real_distribution<float> extent(0.05f, 2.0f);
+		std::uniform_real_distribution<float> edgeOffset(-0.15f, 0.15f);
+		std::uniform_real_distribution<float> height(-3.0f, 3.0f);
+
+		int numOccluded = 0;
+		int numWronglyOccluded = 0;
+
+		for (int step = 0; step < 8; ++step)
+		{
+			const float cameraX = step * 0.01f;
+			const OcclusionCuller culler = MakeCuller(cameraX);
+
+			for (int i = 0; i < 20000; ++i)
+			{
+				const AABB box = TestUtil::MakeBox({ position(rng), 0.5f * position(rng), depth(rng) }, extent(rng));
+
+				if (!culler.IsVisible(box))
+				{
+					numOccluded++;
+					numWronglyOccluded += IsBoxHidden(box, cameraX) ? 0 : 1;
+				}
+			}
+
+			// Boxes behind the first wall whose projection ends within a pixel or two of its right edge, on either side
+			const float boxExtent = 0.2f;
+
+			for (int i = 0; i < 20000; ++i)
+			{
+				const float z = depth(rng) + 15.0f;
+				const float nearZ = z - boxExtent;
+				const float x = cameraX + (5.0f - cameraX + edgeOffset(rng)) * nearZ / 10.0f - boxExtent;
+				const AABB box = TestUtil::MakeBox({ x, height(rng) * nearZ / 10.0f, z }, boxExtent);
+
+				if (!culler.IsVisible(box))
+				{
+					numOccluded++;
+					numWronglyOccluded += IsBoxHidden(box, cameraX) ? 0 : 1;
+				}
+			}
+		}
+
+		TEST_CHECK(numOccluded > 1000);
+		TEST_CHECK(numWronglyOccluded == 0);
+	}
+
+	void TestEmptyDepthBuffer()
+	{
+		OcclusionCuller culler;
+		culler.BeginFrame(XMMatrixPerspectiveFovLH(FovY, AspectRatio, NearZ, 1000.0f));
+
+		TEST_CHECK(culler.IsVisible(TestUtil::MakeBox({ 0.0f, 0.0f, 999.0f }, 0.1f)));
+	}
+}
+
+int main()
+{
+	TestKnownBoxes();
+	TestConservative();
+	TestEmptyDepthBuffer();
+
+	return TestUtil::Finish("OcclusionCullerTests");
+}
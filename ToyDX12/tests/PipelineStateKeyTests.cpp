@@ -0,0 +1,150 @@
+#include "pch.h"
+
+#include <cstring>
+#include <unordered_map>
+
+#include "PipelineStateKey.h"
+#include "TestUtil.h"
+
+namespace
+{
+	// Stand-in of a pipeline description : pointers to shader bytecode and semantic names, and a structure with padding
+	struct BlendDesc
+	{
+		bool BlendEnable;		// 3 bytes of padding after it
+		uint32_t SrcBlend;
+		uint8_t WriteMask;		// 3 bytes of padding after it
+	};
+
+	struct PipelineDesc
+	{
+		const char* SemanticName;
+		const unsigned char* pShaderBytecode;
+		size_t BytecodeLength;
+		BlendDesc Blend;
+		uint32_t SampleMask;
+	};
+
+	// Keyed the way PipelineStateCache::MakeKey does
+	PipelineStateKey MakeKey(const PipelineDesc& desc)
+	{
+		PipelineStateKey key;
+		key.AppendString(desc.SemanticName);
+		key.AppendBlob(desc.pShaderBytecode, desc.BytecodeLength);
+		key.Append(desc.Blend.BlendEnable);
+		key.Append(desc.Blend.SrcBlend);
+		key.Append(desc.Blend.WriteMask);
+		key.Append(desc.SampleMask);
+		return key;
+	}
+
+	PipelineDesc MakeDesc(const char* sz_SemanticName, const unsigned char* p_Bytecode, size_t sz_BytecodeLength, unsigned char padding)
+	{
+		PipelineDesc desc;
+		memset(&desc, padding, sizeof(desc));
+
+		desc.SemanticName = sz_SemanticName;
+		desc.pShaderBytecode = p_Bytecode;
+		desc.BytecodeLength = sz_BytecodeLength;
+		desc.Blend.BlendEnable = true;
+		desc.Blend.SrcBlend = 2;
+		desc.Blend.WriteMask = 0xf;
+		desc.SampleMask = UINT32_MAX;
+		return desc;
+	}
+
+	void TestEquality()
+	{
+		const unsigned char bytecode[] = { 1, 2, 3, 4 };
+		const unsigned char sameBytecode[] = { 1, 2, 3, 4 };
+		const unsigned char otherBytecode[] = { 1, 2, 3, 5 };
+		const std::string semanticName = "POSITION";
+
+		// Keyed by content : neither the addresses nor the padding bytes matter
+		const PipelineStateKey key = MakeKey(MakeDesc("POSITION", bytecode, 4, 0x00));
+		const PipelineStateKey sameKey = MakeKey(MakeDesc(semanticName.c_str(), sameBytecode, 4, 0xcd));
+		TEST_CHECK(key == sameKey);
+		TEST_CHECK(key.GetHash() == sameKey.GetHash());
+		TEST_CHECK(key.GetSize() == sameKey.GetSize());
+
+		TEST_CHECK(key != MakeKey(MakeDesc("POSITION", otherBytecode, 4, 0x00)));
+		TEST_CHECK(key != MakeKey(MakeDesc("POSITION", bytecode, 3, 0x00)));
+		TEST_CHECK(key != MakeKey(MakeDesc("POSITIO", bytecode, 4, 0x00)));
+		TEST_CHECK(key.GetHash() != MakeKey(MakeDesc("POSITION", otherBytecode, 4, 0x00)).GetHash());
+
+		// A null string differs from an empty one
+		TEST_CHECK(MakeKey(MakeDesc(nullptr, bytecode, 4, 0x00)) != MakeKey(MakeDesc("", bytecode, 4, 0x00)));
+
+		PipelineDesc desc = MakeDesc("POSITION", bytecode, 4, 0x00);
+		desc.Blend.WriteMask = 0x7;
+		TEST_CHECK(key != MakeKey(desc));
+	}
+
+	void TestHash()
+	{
+		// The hash of bytes appended in pieces is the hash of the whole
+		PipelineStateKey whole;
+		whole.AppendBytes("abcdef", 6);
+
+		PipelineStateKey pieces;
+		pieces.AppendBytes("abc", 3);
+		pieces.AppendBytes("", 0);
+		pieces.AppendBytes("def", 3);
+
+		TEST_CHECK(whole == pieces);
+		TEST_CHECK(whole.GetHash() == HashUtil::Fnv1a(static_cast<const void*>("abcdef"), 6));
+		TEST_CHECK(PipelineStateKey().GetHash() == HashUtil::FnvOffsetBasis);
+
+		// Size prefixed blobs : the boundaries between them are part of the key
+		PipelineStateKey first;
+		first.AppendBlob("ab", 2);
+		first.AppendBlob("c", 1);
+
+		PipelineStateKey second;
+		second.AppendBlob("a", 1);
+		second.AppendBlob("bc", 2);
+
+		TEST_CHECK(first != second);
+		TEST_CHECK(first.GetSize() == 2 * sizeof(uint64_t) + 3);
+	}
+
+	void TestMap()
+	{
+		const unsigned char bytecode[] = { 1, 2, 3, 4 };
+		const unsigned char sameBytecode[] = { 1, 2, 3, 4 };
+		const unsigned char otherBytecode[] = { 4, 3, 2, 1 };
+
+		// Equal descriptions share a pipeline
+		std::unordered_map<PipelineStateKey, int, PipelineStateKey::Hasher> pipelines;
+		pipelines[MakeKey(MakeDesc("POSITION", bytecode, 4, 0x00))] = 1;
+		pipelines[MakeKey(MakeDesc("POSITION", sameBytecode, 4, 0xff))] = 2;
+		pipelines[MakeKey(MakeDesc("POSITION", otherBytecode, 4, 0x00))] = 3;
+
+		TEST_CHECK(pipelines.size() == 2);
+		TEST_CHECK(pipelines[MakeKey(MakeDesc("POSITION", bytecode, 4, 0x00))] == 2);
+	}
+
+	void TestName()
+	{
+		PipelineStateKey key;
+		key.Append(uint32_t(42));
+
+		const std::wstring name = key.GetName();
+		TEST_CHECK(name.size() == 16);
+		TEST_CHECK(name.find_first_not_of(L"0123456789abcdef") == std::wstring::npos);
+		TEST_CHECK(std::stoull(name, nullptr, 16) == key.GetHash());
+
+		// The empty key is named after the FNV offset basis
+		TEST_CHECK(PipelineStateKey().GetName() == L"cbf29ce484222325");
+	}
+}
+
+int main()
+{
+	TestEquality();
+	TestHash();
+	TestMap();
+	TestName();
+
+	return TestUtil::Finish("PipelineStateKeyTests");
+}
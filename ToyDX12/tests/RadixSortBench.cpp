@@ -0,0 +1,64 @@
+#include "pch.h"
+
+#include <algorithm>
+
+#include "DrawList.h"
+#include "TestUtil.h"
+
+// Sorts 1M keys with the parallel radix sort and with std::sort : random 64 bits keys, then draw keys
+int main()
+{
+	const size_t NumKeys = 1000000;
+
+	std::mt19937_64 rng(7);
+
+	std::vector<SortEntry> randomEntries(NumKeys);
+	for (size_t i = 0; i < NumKeys; ++i)
+	{
+		randomEntries[i] = { rng(), (uint32_t)i };
+	}
+
+	// Draw keys : few PSOs and materials, the high bits of the keys are mostly the same
+	DrawList drawList;
+	drawList.SetDepthRange(0.1f, 1000.0f);
+
+	std::vector<SortEntry> drawEntries(NumKeys);
+	for (size_t i = 0; i < NumKeys; ++i)
+	{
+		DrawKeyFields fields;
+		fields.Pass = rng() % 10 ? DrawPass::Opaque : DrawPass::Transparent;
+		fields.Pso = rng() % 4;
+		fields.Material = rng() % 300;
+		fields.Mesh = rng() % 5000;
+		fields.ViewDepth = 0.1f + (rng() % 100000) * 0.01f;
+		drawEntries[i] = { drawList.MakeKey(fields), (uint32_t)i };
+	}
+
+	std::vector<SortEntry> entries(NumKeys);
+	std::vector<SortEntry> scratch(NumKeys);
+
+	for (const std::vector<SortEntry>* input : { &randomEntries, &drawEntries })
+	{
+		const double radixMs = TestUtil::MeasureMs([&]()
+		{
+			entries = *input;
+			RadixSort::Sort(entries.data(), scratch.data(), NumKeys);
+		}, 5);
+
+		const bool bSorted = std::is_sorted(entries.begin(), entries.end(), [](const SortEntry& a, const SortEntry& b) { return a.Key < b.Key; });
+
+		const double stdMs = TestUtil::MeasureMs([&]()
+		{
+			entries = *input;
+			std::sort(entries.begin(), entries.end(), [](const SortEntry& a, const SortEntry& b) { return a.Key < b.Key; });
+		}, 5);
+
+		// The copy of the input is part of both measures
+		const double copyMs = TestUtil::MeasureMs([&]() { entries = *input; }, 5);
+
+		printf("RadixSortBench: 1M %s keys, radix sort %.2f ms (%s), std::sort %.2f ms, copy of the input %.2f ms.\n",
+			input == &randomEntries ? "random" : "draw", radixMs, bSorted ? "sorted" : "NOT SORTED", stdMs, copyMs);
+	}
+
+	return 0;
+}
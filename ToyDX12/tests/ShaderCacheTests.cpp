@@ -0,0 +1,232 @@
+#include "pch.h"
+
+#include <filesystem>
+#include <fstream>
+
+#include "HashUtil.h"
+#include "ShaderCache.h"
+#include "TestUtil.h"
+
+namespace
+{
+	// Access to the include parser
+	class ShaderCacheAccess : public ShaderCache
+	{
+	public:
+		using ShaderCache::ParseIncludes;
+	};
+
+	const std::filesystem::path s_TestDirectory = std::filesystem::temp_directory_path() / "ToyDX12ShaderCacheTests";
+
+	void WriteFile(const std::filesystem::path& path, const std::string& content)
+	{
+		std::filesystem::create_directories(path.parent_path());
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file << content;
+	}
+
+	uint64_t HashOf(const std::filesystem::path& path)
+	{
+		uint64_t hash = 0;
+		TEST_CHECK(ShaderCache::HashSources(path, hash));
+		return hash;
+	}
+
+	void TestParseIncludes()
+	{
+		const std::string source =
+			"#include \"common.hlsli\"\n"
+			"  #  include <lighting/pbr.hlsli>\r\n"
+			"\t#include\t\"tab.hlsli\" // comment\n"
+			"// #include \"commented.hlsli\"\n"
+			"#define INCLUDE \"defined.hlsli\"\n"
+			"#include\n"
+			"#include \"unterminated.hlsli\n"
+			"#ifdef SHADOWS\n"
+			"#include \"shadows.hlsli\"\n"
+			"#endif\n"
+			"float4 main() : SV_Target { return 0; }";
+
+		std::vector<std::string> includes;
+		ShaderCacheAccess::ParseIncludes(source, includes);
+
+		// Includes of every preprocessor branch are returned, in order
+		const std::vector<std::string> expected = { "common.hlsli", "lighting/pbr.hlsli", "tab.hlsli", "shadows.hlsli" };
+		TEST_CHECK(includes == expected);
+
+		includes.clear();
+		ShaderCacheAccess::ParseIncludes("", includes);
+		TEST_CHECK(includes.empty());
+	}
+
+	void TestIncludeClosure()
+	{
+		const std::filesystem::path directory = s_TestDirectory / "closure";
+
+		// main.hlsl -> nested/a.hlsli -> b.hlsli (next to a.hlsli) and common.hlsli (next to main.hlsl)
+		WriteFile(directory / "main.hlsl", "#include \"nested/a.hlsli\"\nfloat4 main() : SV_Target { return A; }\n");
+		WriteFile(directory / "nested/a.hlsli", "#include \"b.hlsli\"\n#include \"common.hlsli\"\n#define A B\n");
+		WriteFile(directory / "nested/b.hlsli", "#define B 1\n");
+		WriteFile(directory / "common.hlsli", "#define COMMON 1\n");
+
+		const uint64_t hash = HashOf(directory / "main.hlsl");
+		TEST_CHECK(HashOf(directory / "main.hlsl") == hash);
+
+		// Editing a nested include changes the key, restoring it gives the key back
+		WriteFile(directory / "nested/b.hlsli", "#define B 2\n");
+		TEST_CHECK(HashOf(directory / "main.hlsl") != hash);
+
+		WriteFile(directory / "nested/b.hlsli", "#define B 1\n");
+		TEST_CHECK(HashOf(directory / "main.hlsl") == hash);
+
+		// So does an include resolved from the directory of the source file
+		WriteFile(directory / "common.hlsli", "#define COMMON 2\n");
+		TEST_CHECK(HashOf(directory / "main.hlsl") != hash);
+
+		WriteFile(directory / "common.hlsli", "#define COMMON 1\n");
+		TEST_CHECK(HashOf(directory / "main.hlsl") == hash);
+
+		// A file next to the including one wins over a file of the same name next to the source file
+		WriteFile(directory / "b.hlsli", "#define B 3\n");
+		TEST_CHECK(HashOf(directory / "main.hlsl") == hash);
+
+		// The boundary between two files is part of the hash : moving text from a file to its include changes the key
+		WriteFile(directory / "split.hlsl", "#include \"split.hlsli\"\n#define X 1");
+		WriteFile(directory / "split.hlsli", "#define Y 1\n");
+		const uint64_t splitHash = HashOf(directory / "split.hlsl");
+
+		WriteFile(directory / "split.hlsl", "#include \"split.hlsli\"\n#define X ");
+		WriteFile(directory / "split.hlsli", "1#define Y 1\n");
+		TEST_CHECK(HashOf(directory / "split.hlsl") != splitHash);
+
+		// Different sources have different keys
+		TEST_CHECK(HashOf(directory / "common.hlsli") != hash);
+	}
+
+	void TestIncludedTwice()
+	{
+		const std::filesystem::path directory = s_TestDirectory / "twice";
+
+		const std::string guarded = "#pragma once\n#include \"leaf.hlsli\"\n#include \"leaf.hlsli\"\n";
+		const std::string leaf = "#define LEAF 1\n";
+		WriteFile(directory / "guarded.hlsli", guarded);
+		WriteFile(directory / "leaf.hlsli", leaf);
+
+		// Hashed once, as with include guards : each file size prefixed, in include order
+		uint64_t expected = HashUtil::FnvOffsetBasis;
+		for (const std::string* p_Text : { &guarded, &leaf })
+		{
+			const uint64_t size = p_Text->size();
+			expected = HashUtil::Fnv1a(&size, sizeof(size), expected);
+			expected = HashUtil::Fnv1a(p_Text->data(), p_Text->size(), expected);
+		}
+
+		const uint64_t hash = HashOf(directory / "guarded.hlsli");
+		TEST_CHECK(hash == expected);
+
+		// Editing the include still changes the key
+		WriteFile(directory / "leaf.hlsli", "#define LEAF 2\n");
+		TEST_CHECK(HashOf(directory / "guarded.hlsli") != hash);
+	}
+
+	void TestCyclicIncludes()
+	{
+		const std::filesystem::path directory = s_TestDirectory / "cycle";
+
+		// a -> b -> a, and a file including itself : the walk ends and both files are part of the key
+		WriteFile(directory / "a.hlsli", "#include \"b.hlsli\"\n#define A 1\n");
+		WriteFile(directory / "b.hlsli", "#include \"a.hlsli\"\n#define B 1\n");
+		WriteFile(directory / "self.hlsli", "#include \"self.hlsli\"\n");
+
+		const uint64_t hash = HashOf(directory / "a.hlsli");
+		TEST_CHECK(HashOf(directory / "self.hlsli") != 0);
+
+		WriteFile(directory / "b.hlsli", "#include \"a.hlsli\"\n#define B 2\n");
+		TEST_CHECK(HashOf(directory / "a.hlsli") != hash);
+	}
+
+	void TestMissingIncludes()
+	{
+		const std::filesystem::path directory = s_TestDirectory / "missing";
+
+		WriteFile(directory / "main.hlsl", "#include \"nested/a.hlsli\"\n");
+		WriteFile(directory / "nested/a.hlsli", "#include \"missing.hlsli\"\n");
+
+		// Left to the compiler to report : no key
+		uint64_t hash = 0;
+		TEST_CHECK(!ShaderCache::HashSources(directory / "main.hlsl", hash));
+		TEST_CHECK(!ShaderCache::HashSources(directory / "nothing.hlsl", hash));
+
+		// Include inside a preprocessor branch that is never taken : still missing, the shader is always compiled
+		WriteFile(directory / "branch.hlsl", "#if 0\n#include \"missing.hlsli\"\n#endif\n");
+		TEST_CHECK(!ShaderCache::HashSources(directory / "branch.hlsl", hash));
+
+		// Once the include exists, the shader has a key
+		WriteFile(directory / "nested/missing.hlsli", "#define FOUND 1\n");
+		TEST_CHECK(ShaderCache::HashSources(directory / "main.hlsl", hash));
+	}
+
+	void TestLoadStore()
+	{
+		const std::filesystem::path directory = s_TestDirectory / "cache";
+		ShaderCache::s_CacheDirectory = directory.string() + "/";
+
+		std::vector<uint8_t> bytecode;
+		TEST_CHECK(!ShaderCache::Load(1, bytecode));
+		TEST_CHECK(bytecode.empty());
+
+		// Stored in a directory created on demand
+		std::vector<uint8_t> stored(4096);
+		for (size_t i = 0; i < stored.size(); ++i)
+		{
+			stored[i] = static_cast<uint8_t>(i * 31 + 7);
+		}
+
+		ShaderCache::Store(1, stored.data(), stored.size());
+		TEST_CHECK(ShaderCache::Load(1, bytecode));
+		TEST_CHECK(bytecode == stored);
+
+		// Other keys still miss, including one differing by the high bits
+		TEST_CHECK(!ShaderCache::Load(2, bytecode));
+		TEST_CHECK(!ShaderCache::Load(1 | (1ull << 63), bytecode));
+
+		// Stored again with other bytecode : replaced
+		const std::vector<uint8_t> replaced = { 0x44, 0x58, 0x42, 0x43 };
+		ShaderCache::Store(1, replaced.data(), replaced.size());
+		TEST_CHECK(ShaderCache::Load(1, bytecode));
+		TEST_CHECK(bytecode == replaced);
+
+		// An empty entry is a miss
+		ShaderCache::Store(3, replaced.data(), 0);
+		TEST_CHECK(!ShaderCache::Load(3, bytecode));
+
+		// No temporary file left behind
+		size_t numEntries = 0;
+		size_t numTemporaryFiles = 0;
+		for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory))
+		{
+			numEntries += entry.path().extension() == ".cso";
+			numTemporaryFiles += entry.path().extension() == ".tmp";
+		}
+
+		TEST_CHECK(numEntries == 2);
+		TEST_CHECK(numTemporaryFiles == 0);
+	}
+}
+
+int main()
+{
+	std::error_code error;
+	std::filesystem::remove_all(s_TestDirectory, error);
+
+	TestParseIncludes();
+	TestIncludeClosure();
+	TestIncludedTwice();
+	TestCyclicIncludes();
+	TestMissingIncludes();
+	TestLoadStore();
+
+	std::filesystem::remove_all(s_TestDirectory, error);
+
+	return TestUtil::Finish("ShaderCacheTests");
+}
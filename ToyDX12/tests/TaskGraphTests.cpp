@@ -0,0 +1,297 @@
+#include "pch.h"
+
+#include <atomic>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+#include "TaskGraph.h"
+#include "TestUtil.h"
+
+namespace
+{
+	void Sleep(double durationMs)
+	{
+		std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(durationMs));
+	}
+
+	// Longest chain of dependent tasks of a run graph, computed from the measured durations
+	double ReferenceCriticalPath(const TaskGraph& graph, const std::vector<std::vector<TaskGraph::TaskId>>& dependencies)
+	{
+		std::vector<double> pathDurations(graph.GetNumTasks(), 0.0);
+		double longestPath = 0.0;
+
+		for (TaskGraph::TaskId id = 0; id < graph.GetNumTasks(); ++id)
+		{
+			double longestDependency = 0.0;
+			for (TaskGraph::TaskId dependency : dependencies[id])
+			{
+				longestDependency = (std::max)(longestDependency, pathDurations[dependency]);
+			}
+
+			pathDurations[id] = longestDependency + graph.GetTaskDuration(id);
+			longestPath = (std::max)(longestPath, pathDurations[id]);
+		}
+
+		return longestPath;
+	}
+
+	void CheckCriticalPath(const TaskGraph& graph, const std::vector<std::vector<TaskGraph::TaskId>>& dependencies)
+	{
+		double duration = 0.0;
+		const std::vector<TaskGraph::TaskId> path = graph.GetCriticalPath(&duration);
+
+		if (!TEST_CHECK(!path.empty()))
+		{
+			return;
+		}
+
+		// Starts with a task without dependencies, each next task depends on the previous one
+		TEST_CHECK(dependencies[path.front()].empty());
+
+		double pathDuration = 0.0;
+		for (size_t i = 0; i < path.size(); ++i)
+		{
+			if (i > 0)
+			{
+				const std::vector<TaskGraph::TaskId>& taskDependencies = dependencies[path[i]];
+				TEST_CHECK(std::find(taskDependencies.begin(), taskDependencies.end(), path[i - 1]) != taskDependencies.end());
+			}
+
+			pathDuration += graph.GetTaskDuration(path[i]);
+		}
+
+		// The longest of all chains
+		const double reference = ReferenceCriticalPath(graph, dependencies);
+		TEST_CHECK(std::abs(duration - pathDuration) <= 1e-9 * (std::max)(1.0, duration));
+		TEST_CHECK(std::abs(duration - reference) <= 1e-9 * (std::max)(1.0, reference));
+		TEST_CHECK(duration <= graph.GetTotalWork() + 1e-9);
+	}
+
+	void TestEmpty()
+	{
+		TaskGraph graph;
+		graph.Run();
+
+		TEST_CHECK(graph.GetNumTasks() == 0);
+		TEST_CHECK(graph.GetCriticalPath().empty());
+		TEST_CHECK(graph.GetTotalWork() == 0.0);
+	}
+
+	// Random graphs : each task checks that the tasks it depends on are done, and runs exactly once
+	void TestRandomGraph(uint32_t seed)
+	{
+		std::mt19937 random(seed);
+
+		const uint32_t numTasks = std::uniform_int_distribution<uint32_t>(1, 300)(random);
+		const uint32_t maxDependencies = std::uniform_int_distribution<uint32_t>(0, 6)(random);
+		const uint32_t numWorkers = std::uniform_int_distribution<uint32_t>(1, 8)(random);
+
+		std::vector<std::atomic<uint32_t>> numRuns(numTasks);
+		std::atomic<uint32_t> numOrderViolations = 0;
+
+		TaskGraph graph;
+		std::vector<std::vector<TaskGraph::TaskId>> dependencies(numTasks);
+
+		for (TaskGraph::TaskId id = 0; id < numTasks; ++id)
+		{
+			std::vector<TaskGraph::TaskId> taskDependencies;
+
+			const uint32_t numDependencies = id > 0 ? std::uniform_int_distribution<uint32_t>(0, maxDependencies)(random) : 0;
+			for (uint32_t i = 0; i < numDependencies; ++i)
+			{
+				// Mostly recent tasks, for long chains, and some invalid ones which are ignored
+				const uint32_t distance = std::uniform_int_distribution<uint32_t>(1, (std::min)(id, 1u + static_cast<uint32_t>(random() % 16)))(random);
+				taskDependencies.push_back(random() % 8 == 0 ? TaskGraph::InvalidTask : id - distance);
+			}
+
+			for (TaskGraph::TaskId dependency : taskDependencies)
+			{
+				if (dependency != TaskGraph::InvalidTask)
+				{
+					dependencies[id].push_back(dependency);
+				}
+			}
+
+			const bool bSpin = random() % 4 == 0;
+			const std::vector<TaskGraph::TaskId> validDependencies = dependencies[id];
+
+			const TaskGraph::TaskId addedId = graph.AddTask("Task " + std::to_string(id), [&numRuns, &numOrderViolations, validDependencies, id, bSpin]()
+			{
+				for (TaskGraph::TaskId dependency : validDependencies)
+				{
+					numOrderViolations += numRuns[dependency].load() != numRuns[id].load() + 1;
+				}
+
+				// Some work, for the workers to overlap
+				if (bSpin)
+				{
+					volatile uint32_t sum = 0;
+					for (uint32_t i = 0; i < 2000; ++i)
+					{
+						sum = sum + i;
+					}
+				}
+
+				numRuns[id]++;
+			}, taskDependencies);
+
+			TEST_CHECK(addedId == id);
+		}
+
+		TEST_CHECK(graph.GetNumTasks() == numTasks);
+
+		// Run twice : the second run starts from a reset graph
+		for (uint32_t run = 1; run <= 2; ++run)
+		{
+			graph.Run(numWorkers);
+
+			uint32_t numWrongRuns = 0;
+			for (const std::atomic<uint32_t>& taskRuns : numRuns)
+			{
+				numWrongRuns += taskRuns.load() != run;
+			}
+
+			TEST_CHECK(numWrongRuns == 0);
+			TEST_CHECK(numOrderViolations.load() == 0);
+
+			CheckCriticalPath(graph, dependencies);
+		}
+	}
+
+	void TestCriticalPath()
+	{
+		// A (20 ms) > B (20 ms) > E (1 ms), C (5 ms) > D (5 ms) > E : the critical path is A > B > E whatever the number of workers
+		for (uint32_t numWorkers : { 1u, 2u, 4u })
+		{
+			TaskGraph graph;
+			const TaskGraph::TaskId a = graph.AddTask("A", []() { Sleep(20.0); });
+			const TaskGraph::TaskId c = graph.AddTask("C", []() { Sleep(5.0); });
+			const TaskGraph::TaskId b = graph.AddTask("B", []() { Sleep(20.0); }, { a });
+			const TaskGraph::TaskId d = graph.AddTask("D", []() { Sleep(5.0); }, { c });
+			const TaskGraph::TaskId e = graph.AddTask("E", []() { Sleep(1.0); }, { d, TaskGraph::InvalidTask, b });
+
+			graph.Run(numWorkers);
+
+			double duration = 0.0;
+			const std::vector<TaskGraph::TaskId> path = graph.GetCriticalPath(&duration);
+			TEST_CHECK(path == std::vector<TaskGraph::TaskId>({ a, b, e }));
+			TEST_CHECK(graph.GetTaskName(path.front()) == "A");
+
+			TEST_CHECK(duration >= 41.0);
+			TEST_CHECK(graph.GetTotalWork() >= 51.0);
+
+			// A lower bound of the run time, reached with enough workers
+			TEST_CHECK(graph.GetRunDuration() >= duration);
+			TEST_CHECK(numWorkers > 1 || graph.GetRunDuration() >= graph.GetTotalWork());
+
+			CheckCriticalPath(graph, { {}, {}, { a }, { c }, { d, b } });
+		}
+	}
+
+	void TestException()
+	{
+		for (uint32_t numWorkers : { 1u, 4u })
+		{
+			bool bFail = true;
+			std::atomic<uint32_t> numRuns[6] = {};
+
+			// 0 > 1 (throws) > 2 > 3, 0 > 4, 5 alone : 2 and 3 are skipped, the others run
+			TaskGraph graph;
+			const TaskGraph::TaskId root = graph.AddTask("Root", [&]() { numRuns[0]++; });
+			const TaskGraph::TaskId failing = graph.AddTask("Failing", [&]()
+			{
+				numRuns[1]++;
+				if (bFail)
+				{
+					throw std::runtime_error("Failing task");
+				}
+			}, { root });
+			const TaskGraph::TaskId skipped = graph.AddTask("Skipped", [&]() { numRuns[2]++; }, { failing });
+			graph.AddTask("Skipped too", [&]() { numRuns[3]++; }, { skipped, root });
+			graph.AddTask("Sibling", [&]() { numRuns[4]++; }, { root });
+			graph.AddTask("Independent", [&]() { numRuns[5]++; });
+
+			bool bThrown = false;
+			try
+			{
+				graph.Run(numWorkers);
+			}
+			catch (const std::runtime_error& error)
+			{
+				bThrown = std::string(error.what()) == "Failing task";
+			}
+
+			TEST_CHECK(bThrown);
+
+			const uint32_t expectedRuns[6] = { 1, 1, 0, 0, 1, 1 };
+			for (uint32_t i = 0; i < 6; ++i)
+			{
+				TEST_CHECK(numRuns[i].load() == expectedRuns[i]);
+			}
+
+			// Skipped tasks run again once the failure is gone
+			bFail = false;
+			bThrown = false;
+			try
+			{
+				graph.Run(numWorkers);
+			}
+			catch (...)
+			{
+				bThrown = true;
+			}
+
+			TEST_CHECK(!bThrown);
+
+			const uint32_t expectedRerun[6] = { 2, 2, 1, 1, 2, 2 };
+			for (uint32_t i = 0; i < 6; ++i)
+			{
+				TEST_CHECK(numRuns[i].load() == expectedRerun[i]);
+			}
+		}
+
+		// Several failing tasks : one of the exceptions is rethrown, every independent task still runs
+		TaskGraph graph;
+		std::atomic<uint32_t> numRuns = 0;
+		for (uint32_t i = 0; i < 64; ++i)
+		{
+			graph.AddTask("Task", [&numRuns, i]()
+			{
+				numRuns++;
+				if (i % 8 == 3)
+				{
+					throw std::runtime_error("Failing task");
+				}
+			});
+		}
+
+		bool bThrown = false;
+		try
+		{
+			graph.Run(4);
+		}
+		catch (const std::runtime_error&)
+		{
+			bThrown = true;
+		}
+
+		TEST_CHECK(bThrown);
+		TEST_CHECK(numRuns.load() == 64);
+	}
+}
+
+int main()
+{
+	TestEmpty();
+
+	for (uint32_t seed = 1; seed <= 200; ++seed)
+	{
+		TestRandomGraph(seed);
+	}
+
+	TestCriticalPath();
+	TestException();
+
+	return TestUtil::Finish("TaskGraphTests");
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "Bounds.h"
+
+// Checks the condition, failures are printed and counted : the test returns TestUtil::Finish()
+#define TEST_CHECK(condition) TestUtil::Check((condition), #condition, __FILE__, __LINE__)
+
+// Helpers of the console tests and benchmarks
+class TestUtil
+{
+public:
+	TestUtil() = delete;
+	~TestUtil() = delete;
+
+	static bool Check(bool bCondition, const char* sz_Condition, const char* sz_File, int line)
+	{
+		s_NumChecks++;
+
+		if (!bCondition)
+		{
+			s_NumFailures++;
+			printf("%s(%d): check failed : %s\n", sz_File, line, sz_Condition);
+		}
+
+		return bCondition;
+	}
+
+	// Exit code of the test
+	static int Finish(const char* sz_TestName)
+	{
+		printf("%s: %d checks, %d failed.\n", sz_TestName, s_NumChecks, s_NumFailures);
+		return s_NumFailures == 0 ? 0 : 1;
+	}
+
+	// Best time of a few runs, in milliseconds
+	template<typename Function>
+	static double MeasureMs(Function function, int numRuns = 10)
+	{
+		double bestMs = 1e30;
+
+		for (int run = 0; run < numRuns; ++run)
+		{
+			const auto start = std::chrono::high_resolution_clock::now();
+			function();
+			const auto end = std::chrono::high_resolution_clock::now();
+
+			bestMs = (std::min)(bestMs, std::chrono::duration<double, std::milli>(end - start).count());
+		}
+
+		return bestMs;
+	}
+
+	static AABB MakeBox(const DirectX::XMFLOAT3& center, float extent)
+	{
+		AABB box;
+		box.Expand({ center.x - extent, center.y - extent, center.z - extent });
+		box.Expand({ center.x + extent, center.y + extent, center.z + extent });
+		return box;
+	}
+
+	// Boxes scattered over a flat square scene, like the objects of a level
+	static std::vector<AABB> MakeRandomBoxes(size_t count, float sceneHalfSize, uint32_t seed)
+	{
+		std::mt19937 rng(seed);
+		std::uniform_real_distribution<float> position(-sceneHalfSize, sceneHalfSize);
+		std::uniform_real_distribution<float> extent(0.1f, 5.0f);
+
+		std::vector<AABB> boxes(count);
+		for (AABB& box : boxes)
+		{
+			const DirectX::XMFLOAT3 center = { position(rng), 0.1f * position(rng), position(rng) };
+			box = MakeBox(center, extent(rng));
+		}
+
+		return boxes;
+	}
+
+	// Reference test of a box against the planes, one plane at a time
+	static bool IsOutside(const DirectX::XMFLOAT4 (&a_Planes)[6], const AABB& box)
+	{
+		const DirectX::XMFLOAT3 center = box.Center();
+		const DirectX::XMFLOAT3 extents = box.Extents();
+
+		for (const DirectX::XMFLOAT4& plane : a_Planes)
+		{
+			const float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+			const float radius = extents.x * fabsf(plane.x) + extents.y * fabsf(plane.y) + extents.z * fabsf(plane.z);
+
+			if (distance + radius < 0.0f)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// Reference test of the distance between a box and a point
+	static bool IsWithinDistance(const AABB& box, const DirectX::XMFLOAT3& point, float distance)
+	{
+		const float dx = (std::max)({ box.Min.x - point.x, 0.0f, point.x - box.Max.x });
+		const float dy = (std::max)({ box.Min.y - point.y, 0.0f, point.y - box.Max.y });
+		const float dz = (std::max)({ box.Min.z - point.z, 0.0f, point.z - box.Max.z });
+
+		return dx * dx + dy * dy + dz * dz <= distance * distance;
+	}
+
+private:
+	inline static int s_NumChecks = 0;
+	inline static int s_NumFailures = 0;
+};
@@ -0,0 +1,300 @@
+#include "pch.h"
+
+#include <cmath>
+#include <set>
+
+#include "TextureStreamer.h"
+#include "TestUtil.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// Full mip chain of an uncompressed RGBA8 texture
+	std::vector<uint64_t> MakeMipSizes(uint32_t width, uint32_t height)
+	{
+		std::vector<uint64_t> mipSizes;
+		for (;;)
+		{
+			mipSizes.push_back(uint64_t(width) * height * 4);
+			if (width == 1 && height == 1)
+			{
+				return mipSizes;
+			}
+
+			width = (std::max)(width / 2, 1u);
+			height = (std::max)(height / 2, 1u);
+		}
+	}
+
+	// Looking at the target from the eye
+	StreamingView MakeView(const XMFLOAT3& eye, const XMFLOAT3& target)
+	{
+		StreamingView view;
+		view.EyePosWS = eye;
+		view.ForwardWS = { target.x - eye.x, target.y - eye.y, target.z - eye.z };
+		return view;
+	}
+
+	// Reference of the required mip : about one texel per pixel at the closest point of the bounding sphere
+	int ReferenceMip(uint32_t textureSize, float uvDensity, const AABB& bounds, const StreamingView& view)
+	{
+		const XMFLOAT3 center = bounds.Center();
+		const double dx = center.x - view.EyePosWS.x;
+		const double dy = center.y - view.EyePosWS.y;
+		const double dz = center.z - view.EyePosWS.z;
+		const double distance = (std::max)(sqrt(dx * dx + dy * dy + dz * dz) - bounds.Radius(), double(view.NearZ));
+
+		const double pixelsPerUnit = view.ViewportHeight / (2.0 * distance * tan(0.5 * view.FovY));
+		const double mip = log2(textureSize * uvDensity / pixelsPerUnit);
+
+		return mip <= 0.0 ? 0 : int(mip);
+	}
+
+	uint64_t ComputeResidentSize(const TextureStreamer& streamer, const std::vector<std::vector<uint64_t>>& mipSizes)
+	{
+		uint64_t residentSize = 0;
+		for (int handle = 0; handle < streamer.GetNumTextures(); ++handle)
+		{
+			for (size_t mip = streamer.GetResidentMip(handle); mip < mipSizes[handle].size(); ++mip)
+			{
+				residentSize += mipSizes[handle][mip];
+			}
+		}
+
+		return residentSize;
+	}
+
+	// Walks toward a textured box and back : the resident mip follows the distance and the UV density
+	void TestMipFollowsDensity()
+	{
+		TextureStreamingSettings settings;
+		settings.BudgetInBytes = 1ull << 40;
+
+		TextureStreamer streamer(settings);
+		const int texture = streamer.RegisterTexture(1024, 1024, MakeMipSizes(1024, 1024));
+		const int denserTexture = streamer.RegisterTexture(1024, 1024, MakeMipSizes(1024, 1024));
+
+		// 64x64 and lower mips are pinned
+		const int pinnedMip = 4;
+		TEST_CHECK(streamer.GetResidentMip(texture) == pinnedMip);
+
+		const AABB bounds = TestUtil::MakeBox({ 0.0f, 0.0f, 0.0f }, 1.0f);
+		streamer.AddUsage(texture, bounds, 0.5f);
+		streamer.AddUsage(denserTexture, bounds, 2.0f);
+
+		size_t numWrong = 0;
+		int previousMip = pinnedMip;
+
+		for (float z = -2000.0f; z < -2.5f; z *= 0.97f)
+		{
+			const StreamingView view = MakeView({ 0.0f, 0.0f, z }, { 0.0f, 0.0f, 0.0f });
+			streamer.Update(view);
+
+			const int expectedMip = (std::min)(ReferenceMip(1024, 0.5f, bounds, view), pinnedMip);
+			const int expectedDenserMip = (std::min)(ReferenceMip(1024, 2.0f, bounds, view), pinnedMip);
+
+			numWrong += streamer.GetRequiredMip(texture) != expectedMip;
+			numWrong += streamer.GetRequiredMip(denserTexture) != expectedDenserMip;
+
+			// Without memory pressure, everything required is made resident
+			numWrong += streamer.GetResidentMip(texture) != expectedMip;
+			numWrong += streamer.GetResidentMip(denserTexture) != expectedDenserMip;
+
+			// Closer is never coarser, a higher UV density (more texels per world unit) is never finer
+			numWrong += streamer.GetResidentMip(texture) > previousMip;
+			numWrong += streamer.GetResidentMip(denserTexture) < streamer.GetResidentMip(texture);
+			previousMip = streamer.GetResidentMip(texture);
+		}
+
+		TEST_CHECK(numWrong == 0);
+		TEST_CHECK(streamer.GetResidentMip(texture) == 0);
+
+		// Stepping back : the detailed mips stay as long as they fit...
+		const StreamingView farView = MakeView({ 0.0f, 0.0f, -20.0f }, { 0.0f, 0.0f, 0.0f });
+		streamer.Update(farView);
+
+		const int farMip = ReferenceMip(1024, 0.5f, bounds, farView);
+		TEST_CHECK(farMip > 0 && farMip < pinnedMip);
+		TEST_CHECK(streamer.GetRequiredMip(texture) == farMip);
+		TEST_CHECK(streamer.GetResidentMip(texture) == 0);
+
+		// ...and are evicted down to the required mips once only those fit
+		const int farDenserMip = streamer.GetRequiredMip(denserTexture);
+		const std::vector<uint64_t> mipSizes = MakeMipSizes(1024, 1024);
+
+		uint64_t requiredSize = 0;
+		for (size_t mip = 0; mip < mipSizes.size(); ++mip)
+		{
+			requiredSize += (int(mip) >= farMip ? mipSizes[mip] : 0) + (int(mip) >= farDenserMip ? mipSizes[mip] : 0);
+		}
+
+		streamer.SetBudget(requiredSize);
+		streamer.Update(farView);
+		TEST_CHECK(streamer.GetResidentMip(texture) == farMip);
+		TEST_CHECK(streamer.GetResidentMip(denserTexture) == farDenserMip);
+		TEST_CHECK(streamer.GetResidentSize() <= streamer.GetBudget());
+	}
+
+	// Three textures in three places, room for the detailed mips of two of them
+	void TestLeastRecentlyUsedEviction()
+	{
+		const uint32_t size = 256;
+		const std::vector<uint64_t> mipSizes = MakeMipSizes(size, size);
+		const int pinnedMip = 2;	// 64x64
+
+		uint64_t pinnedSize = 0;
+		uint64_t streamedSize = 0;
+		for (size_t mip = 0; mip < mipSizes.size(); ++mip)
+		{
+			(int(mip) < pinnedMip ? streamedSize : pinnedSize) += mipSizes[mip];
+		}
+
+		TextureStreamingSettings settings;
+		settings.BudgetInBytes = 3 * pinnedSize + 2 * streamedSize;
+		TextureStreamer streamer(settings);
+
+		const XMFLOAT3 positions[] = { { -1000.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f }, { 1000.0f, 0.0f, 0.0f } };
+		int textures[3];
+		for (int i = 0; i < 3; ++i)
+		{
+			textures[i] = streamer.RegisterTexture(size, size, mipSizes);
+			streamer.AddUsage(textures[i], TestUtil::MakeBox(positions[i], 1.0f), 1.0f);
+		}
+		TEST_CHECK(streamer.GetResidentMip(textures[0]) == pinnedMip);
+		TEST_CHECK(streamer.GetResidentSize() == 3 * pinnedSize);
+
+		auto lookAt = [&](int i) -> std::set<int>
+		{
+			const XMFLOAT3& target = positions[i];
+			const std::vector<int>& changed = streamer.Update(MakeView({ target.x, target.y, target.z - 3.0f }, target));
+			return std::set<int>(changed.begin(), changed.end());
+		};
+
+		// The first two fit
+		TEST_CHECK((lookAt(0) == std::set<int>{ textures[0] }));
+		TEST_CHECK((lookAt(1) == std::set<int>{ textures[1] }));
+		TEST_CHECK(streamer.GetResidentMip(textures[0]) == 0);
+		TEST_CHECK(streamer.GetResidentMip(textures[1]) == 0);
+		TEST_CHECK(streamer.GetResidentSize() == settings.BudgetInBytes);
+
+		// The third one takes the place of the least recently used one
+		TEST_CHECK((lookAt(2) == std::set<int>{ textures[0], textures[2] }));
+		TEST_CHECK(streamer.GetResidentMip(textures[0]) == pinnedMip);
+		TEST_CHECK(streamer.GetResidentMip(textures[1]) == 0);
+		TEST_CHECK(streamer.GetResidentMip(textures[2]) == 0);
+
+		// Back to the first one : the second one is now the least recently used
+		TEST_CHECK((lookAt(0) == std::set<int>{ textures[0], textures[1] }));
+		TEST_CHECK(streamer.GetResidentMip(textures[0]) == 0);
+		TEST_CHECK(streamer.GetResidentMip(textures[1]) == pinnedMip);
+		TEST_CHECK(streamer.GetResidentMip(textures[2]) == 0);
+
+		// Looking at it again doesn't evict anything
+		TEST_CHECK(lookAt(0).empty());
+		TEST_CHECK(streamer.GetResidentSize() <= settings.BudgetInBytes);
+	}
+
+	// A camera path through a scene with more texture data than the budget
+	void TestCameraPath()
+	{
+		std::mt19937 rng(11);
+		std::uniform_int_distribution<int> sizeLog2(6, 11);
+		std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+		std::uniform_real_distribution<float> density(0.05f, 2.0f);
+
+		TextureStreamingSettings settings;
+		settings.BudgetInBytes = 12ull * 1024 * 1024;
+		TextureStreamer streamer(settings);
+
+		std::vector<std::vector<uint64_t>> mipSizes;
+		for (int i = 0; i < 300; ++i)
+		{
+			const uint32_t width = 1u << sizeLog2(rng);
+			const uint32_t height = 1u << sizeLog2(rng);
+
+			mipSizes.push_back(MakeMipSizes(width, height));
+			streamer.RegisterTexture(width, height, mipSizes.back());
+		}
+
+		for (int i = 0; i < 2000; ++i)
+		{
+			const AABB bounds = TestUtil::MakeBox({ position(rng), 0.0f, position(rng) }, 1.0f + 10.0f * density(rng));
+			streamer.AddUsage(int(rng() % mipSizes.size()), bounds, density(rng));
+		}
+
+		TEST_CHECK(streamer.GetResidentSize() == ComputeResidentSize(streamer, mipSizes));
+		TEST_CHECK(streamer.GetResidentSize() <= settings.BudgetInBytes);
+
+		std::vector<int> previousMips(mipSizes.size());
+		for (int handle = 0; handle < streamer.GetNumTextures(); ++handle)
+		{
+			previousMips[handle] = streamer.GetResidentMip(handle);
+		}
+
+		size_t numOverBudget = 0;
+		size_t numWrongSizes = 0;
+		size_t numMissedChanges = 0;
+		size_t numMipsLeftOut = 0;
+		size_t numChanges = 0;
+		size_t numStarvedSteps = 0;
+
+		const int numSteps = 400;
+		for (int step = 0; step < numSteps; ++step)
+		{
+			// Halfway through, the budget is lowered
+			if (step == numSteps / 2)
+			{
+				streamer.SetBudget(settings.BudgetInBytes / 2);
+			}
+
+			// Circling the scene at mid distance, looking at the center
+			const float angle = XM_2PI * step / numSteps;
+			const StreamingView view = MakeView({ 150.0f * cosf(angle), 2.0f, 150.0f * sinf(angle) }, { 0.0f, 0.0f, 0.0f });
+
+			const std::vector<int>& changed = streamer.Update(view);
+			const std::set<int> changedSet(changed.begin(), changed.end());
+			numChanges += changed.size();
+
+			numOverBudget += streamer.GetResidentSize() > streamer.GetBudget();
+			bool bStarved = false;
+			numWrongSizes += streamer.GetResidentSize() != ComputeResidentSize(streamer, mipSizes);
+
+			for (int handle = 0; handle < streamer.GetNumTextures(); ++handle)
+			{
+				const int residentMip = streamer.GetResidentMip(handle);
+
+				// Every texture whose resident mip changed is reported
+				numMissedChanges += residentMip != previousMips[handle] && changedSet.count(handle) == 0;
+				previousMips[handle] = residentMip;
+
+				// A required mip is only left out when it doesn't fit
+				if (residentMip > streamer.GetRequiredMip(handle))
+				{
+					bStarved = true;
+					numMipsLeftOut += streamer.GetResidentSize() + mipSizes[handle][residentMip - 1] <= streamer.GetBudget();
+				}
+			}
+
+			numStarvedSteps += bStarved;
+		}
+
+		TEST_CHECK(numOverBudget == 0);
+		TEST_CHECK(numWrongSizes == 0);
+		TEST_CHECK(numMissedChanges == 0);
+		TEST_CHECK(numMipsLeftOut == 0);
+
+		// The path did stream, and the budget did hold mips back
+		TEST_CHECK(numChanges > 0);
+		TEST_CHECK(numStarvedSteps > 0);
+	}
+}
+
+int main()
+{
+	TestMipFollowsDensity();
+	TestLeastRecentlyUsedEviction();
+	TestCameraPath();
+
+	return TestUtil::Finish("TextureStreamerTests");
+}
@@ -0,0 +1,167 @@
+#include "pch.h"
+
+#include <iterator>
+#include <map>
+
+#include "TlsfAllocator.h"
+#include "TestUtil.h"
+
+namespace
+{
+	void TestBasics()
+	{
+		TlsfAllocator allocator(1024 * 1024);
+		TEST_CHECK(allocator.IsEmpty());
+		TEST_CHECK(allocator.GetStats().NumFreeBlocks == 1);
+		TEST_CHECK(allocator.GetStats().LargestFreeBlock == 1024 * 1024);
+
+		TlsfAllocator::Allocation a, b, c;
+		TEST_CHECK(allocator.Allocate(1000, 1, a));
+		TEST_CHECK(allocator.Allocate(1000, 4096, b));
+		TEST_CHECK(allocator.Allocate(1000, 65536, c));
+		TEST_CHECK(b.Offset % 4096 == 0 && b.Offset >= a.Offset + 1000);
+		TEST_CHECK(c.Offset % 65536 == 0);
+		TEST_CHECK(allocator.GetNumAllocations() == 3);
+		TEST_CHECK(allocator.GetAllocatedSize() == 3000);
+
+		// Too large, or too large once aligned
+		TlsfAllocator::Allocation failed;
+		TEST_CHECK(!allocator.Allocate(2 * 1024 * 1024, 1, failed));
+		TEST_CHECK(allocator.GetNumAllocations() == 3);
+
+		// Freed blocks merge back into a single one, whatever the order
+		allocator.Free(b.Block);
+		allocator.Free(a.Block);
+		allocator.Free(c.Block);
+		TEST_CHECK(allocator.IsEmpty());
+		TEST_CHECK(allocator.GetStats().NumFreeBlocks == 1);
+		TEST_CHECK(allocator.GetStats().GetFragmentation() == 0.0f);
+
+		// The whole range is one allocation
+		TlsfAllocator::Allocation all;
+		TEST_CHECK(allocator.Allocate(1024 * 1024, 65536, all) && all.Offset == 0);
+		TEST_CHECK(!allocator.Allocate(1, 1, failed));
+		allocator.Free(all.Block);
+	}
+
+	void TestFragmentation()
+	{
+		const uint64_t blockSize = 64 * 1024;
+		TlsfAllocator allocator(64 * blockSize);
+
+		std::vector<TlsfAllocator::Allocation> allocations(64);
+		for (TlsfAllocator::Allocation& allocation : allocations)
+		{
+			TEST_CHECK(allocator.Allocate(blockSize, blockSize, allocation));
+		}
+
+		// Every other block free : lots of free memory, none of it in one piece
+		for (size_t i = 0; i < allocations.size(); i += 2)
+		{
+			allocator.Free(allocations[i].Block);
+		}
+
+		const TlsfStats stats = allocator.GetStats();
+		TEST_CHECK(stats.NumFreeBlocks == 32);
+		TEST_CHECK(stats.LargestFreeBlock == blockSize);
+		TEST_CHECK(stats.GetFragmentation() > 0.9f);
+
+		TlsfAllocator::Allocation failed;
+		TEST_CHECK(!allocator.Allocate(2 * blockSize, 1, failed));
+
+		for (size_t i = 1; i < allocations.size(); i += 2)
+		{
+			allocator.Free(allocations[i].Block);
+		}
+		TEST_CHECK(allocator.GetStats().NumFreeBlocks == 1);
+	}
+
+	// Random allocations and frees, checked against the live ranges
+	void TestRandom(uint32_t seed)
+	{
+		std::mt19937_64 rng(seed);
+
+		const uint64_t size = rng() % (1 << 24) + 1;
+		TlsfAllocator allocator(size);
+
+		struct Live
+		{
+			uint64_t Size;
+			TlsfAllocator::Handle Block;
+		};
+		std::map<uint64_t, Live> liveByOffset;
+		uint64_t allocatedSize = 0;
+		size_t numWrong = 0;
+
+		for (int step = 0; step < 3000; ++step)
+		{
+			if (rng() % 2 == 0 || liveByOffset.empty())
+			{
+				const uint64_t allocationSize = rng() % 3 == 0 ? rng() % 64 + 1 : rng() % (size / 8 + 1) + 1;
+				const uint64_t alignment = 1ull << (rng() % 17);
+
+				TlsfAllocator::Allocation allocation;
+				if (!allocator.Allocate(allocationSize, alignment, allocation))
+				{
+					continue;
+				}
+
+				// Aligned, in the range, and not overlapping another allocation
+				numWrong += allocation.Offset % alignment != 0;
+				numWrong += allocation.Offset + allocationSize > size;
+
+				const auto next = liveByOffset.lower_bound(allocation.Offset);
+				if (next != liveByOffset.end())
+				{
+					numWrong += allocation.Offset + allocationSize > next->first;
+				}
+				if (next != liveByOffset.begin())
+				{
+					const auto previous = std::prev(next);
+					numWrong += previous->first + previous->second.Size > allocation.Offset;
+				}
+
+				liveByOffset[allocation.Offset] = { allocationSize, allocation.Block };
+				allocatedSize += allocationSize;
+			}
+			else
+			{
+				auto live = liveByOffset.begin();
+				std::advance(live, rng() % liveByOffset.size());
+
+				allocator.Free(live->second.Block);
+				allocatedSize -= live->second.Size;
+				liveByOffset.erase(live);
+			}
+
+			numWrong += allocator.GetAllocatedSize() != allocatedSize;
+			numWrong += allocator.GetNumAllocations() != liveByOffset.size();
+			numWrong += allocator.GetStats().LargestFreeBlock > size - allocatedSize;
+		}
+
+		TEST_CHECK(numWrong == 0);
+
+		for (const auto& [offset, live] : liveByOffset)
+		{
+			allocator.Free(live.Block);
+		}
+
+		const TlsfStats stats = allocator.GetStats();
+		TEST_CHECK(allocator.IsEmpty());
+		TEST_CHECK(stats.NumFreeBlocks == 1);
+		TEST_CHECK(stats.LargestFreeBlock == size);
+	}
+}
+
+int main()
+{
+	TestBasics();
+	TestFragmentation();
+
+	for (uint32_t seed = 1; seed <= 200; ++seed)
+	{
+		TestRandom(seed);
+	}
+
+	return TestUtil::Finish("TlsfAllocatorTests");
+}
@@ -0,0 +1,96 @@
+#include "pch.h"
+
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <numeric>
+
+#include "TransformBatch.h"
+#include "TestUtil.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// Stand-in of the render items : one allocation each, the world among other members
+	struct RenderItem
+	{
+		char OtherMembers[192] = {};
+		XMFLOAT4X4 World;
+	};
+
+	void Animate(std::vector<std::unique_ptr<RenderItem>>& r_Items, float time)
+	{
+		for (size_t i = 0; i < r_Items.size(); ++i)
+		{
+			const float phase = float(i) * 0.1f + time;
+			const XMMATRIX world = XMMatrixScaling(1.0f + 0.5f * sinf(phase), 1.2f, 0.8f)
+				* XMMatrixRotationRollPitchYaw(phase, float(i) * 0.2f, float(i) * 0.3f)
+				* XMMatrixTranslation(float(i % 1000), float(i / 1000), time);
+			XMStoreFloat4x4(&r_Items[i]->World, world);
+		}
+	}
+}
+
+// Per object constants of 100k animated objects : per object inverse, against the batch (gather, update, copy)
+int main()
+{
+	const uint32_t NumObjects = 100000;
+
+	std::vector<std::unique_ptr<RenderItem>> items(NumObjects);
+	for (std::unique_ptr<RenderItem>& item : items)
+	{
+		item = std::make_unique<RenderItem>();
+	}
+	Animate(items, 0.0f);
+
+	// Upload memory of the per object constants
+	std::vector<TransformBatch::Output> constants(NumObjects);
+
+	const double perObjectMs = TestUtil::MeasureMs([&]()
+	{
+		for (uint32_t i = 0; i < NumObjects; ++i)
+		{
+			const XMMATRIX world = XMLoadFloat4x4(&items[i]->World);
+
+			TransformBatch::Output output;
+			XMStoreFloat4x4A(&output.World, XMMatrixTranspose(world));
+			XMStoreFloat4x4A(&output.WorldInvTranspose, XMMatrixTranspose(XMMatrixInverse(nullptr, world)));
+			memcpy(&constants[i], &output, sizeof(output));
+		}
+	});
+
+	TransformBatch batch;
+	batch.Resize(NumObjects);
+
+	std::vector<uint32_t> indices(NumObjects);
+	std::iota(indices.begin(), indices.end(), 0);
+
+	const double gatherMs = TestUtil::MeasureMs([&]()
+	{
+		for (uint32_t i = 0; i < NumObjects; ++i)
+		{
+			batch.SetWorld(i, XMLoadFloat4x4(&items[i]->World));
+		}
+	});
+	const double updateMs = TestUtil::MeasureMs([&]() { batch.Update(indices.data(), indices.size()); });
+	const double writeMs = TestUtil::MeasureMs([&]()
+	{
+		batch.Write(indices.data(), indices.size(), constants.data(), sizeof(TransformBatch::Output), TransformOutput::ByObjectIndex);
+	});
+
+	// Only the objects that moved : a tenth of them
+	std::vector<uint32_t> moved;
+	for (uint32_t i = 0; i < NumObjects; i += 10)
+	{
+		moved.push_back(i);
+	}
+	const double movedMs = TestUtil::MeasureMs([&]() { batch.Update(moved.data(), moved.size()); });
+
+	const double batchMs = gatherMs + updateMs + writeMs;
+	printf("TransformBatchBench: %u objects, per object XMMatrixInverse %.3f ms.\n", NumObjects, perObjectMs);
+	printf("TransformBatchBench: batch %.3f ms (gather %.3f ms, update %.3f ms, copy %.3f ms), x%.1f.\n", batchMs, gatherMs, updateMs, writeMs, perObjectMs / batchMs);
+	printf("TransformBatchBench: update of the %zu moved objects %.3f ms.\n", moved.size(), movedMs);
+
+	return 0;
+}
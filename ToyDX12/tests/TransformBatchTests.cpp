@@ -0,0 +1,200 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+#include "TransformBatch.h"
+#include "TestUtil.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// Scaled, rotated and translated, the way objects of a scene are placed
+	XMMATRIX MakeRandomWorld(std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> scale(0.1f, 4.0f);
+		std::uniform_real_distribution<float> angle(-XM_PI, XM_PI);
+		std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+
+		return XMMatrixScaling(scale(rng), scale(rng), scale(rng))
+			* XMMatrixRotationRollPitchYaw(angle(rng), angle(rng), angle(rng))
+			* XMMatrixTranslation(position(rng), position(rng), position(rng));
+	}
+
+	// Same constants as the renderer computed them per object
+	TransformBatch::Output MakeReference(FXMMATRIX world)
+	{
+		TransformBatch::Output output;
+		XMStoreFloat4x4A(&output.World, XMMatrixTranspose(world));
+		XMStoreFloat4x4A(&output.WorldInvTranspose, XMMatrixTranspose(XMMatrixInverse(nullptr, world)));
+		return output;
+	}
+
+	bool IsClose(const TransformBatch::Output& a, const TransformBatch::Output& b)
+	{
+		const float* x = &a.World.m[0][0];
+		const float* y = &b.World.m[0][0];
+
+		for (int i = 0; i < 32; ++i)
+		{
+			if (fabsf(x[i] - y[i]) > 1e-4f * (1.0f + fabsf(x[i])))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool IsSame(const TransformBatch::Output& a, const TransformBatch::Output& b)
+	{
+		return memcmp(&a, &b, sizeof(TransformBatch::Output)) == 0;
+	}
+
+	TransformBatch::Output MakeFilled(float value)
+	{
+		TransformBatch::Output output;
+		std::fill(&output.World.m[0][0], &output.World.m[0][0] + 32, value);
+		return output;
+	}
+
+	void TestIdentity()
+	{
+		TransformBatch batch;
+		batch.Resize(7);
+		TEST_CHECK(batch.GetCount() == 7);
+
+		const TransformBatch::Output identity = MakeReference(XMMatrixIdentity());
+		for (uint32_t i = 0; i < batch.GetCount(); ++i)
+		{
+			TEST_CHECK(IsSame(batch.GetOutput(i), identity));
+		}
+
+		// Objects added later start from the identity too, the others are kept
+		batch.SetWorld(3, XMMatrixTranslation(1.0f, 2.0f, 3.0f));
+		const uint32_t index = 3;
+		batch.Update(&index, 1);
+		batch.Resize(13);
+		TEST_CHECK(IsSame(batch.GetOutput(3), MakeReference(XMMatrixTranslation(1.0f, 2.0f, 3.0f))));
+		TEST_CHECK(IsSame(batch.GetOutput(12), identity));
+	}
+
+	void TestAccuracy(uint32_t numObjects)
+	{
+		std::mt19937 rng(numObjects);
+
+		TransformBatch batch;
+		batch.Resize(numObjects);
+
+		std::vector<TransformBatch::Output> reference(numObjects);
+		for (uint32_t i = 0; i < numObjects; ++i)
+		{
+			const XMMATRIX world = MakeRandomWorld(rng);
+			batch.SetWorld(i, world);
+			reference[i] = MakeReference(world);
+		}
+
+		// Every object, in order : contiguous groups of 4, split across threads when large
+		std::vector<uint32_t> indices(numObjects);
+		std::iota(indices.begin(), indices.end(), 0);
+		batch.Update(indices.data(), indices.size());
+
+		size_t numWrong = 0;
+		for (uint32_t i = 0; i < numObjects; ++i)
+		{
+			numWrong += !IsClose(batch.GetOutput(i), reference[i]);
+		}
+		TEST_CHECK(numWrong == 0);
+
+		// Some of them, shuffled : gathered lanes, and a partial last group
+		std::vector<TransformBatch::Output> previous(reference);
+		std::shuffle(indices.begin(), indices.end(), rng);
+		indices.resize(numObjects / 3 + 1);
+
+		for (uint32_t index : indices)
+		{
+			const XMMATRIX world = MakeRandomWorld(rng);
+			batch.SetWorld(index, world);
+			reference[index] = MakeReference(world);
+		}
+
+		// A world set without an update keeps the last constants
+		const uint32_t notUpdated = indices.back();
+		indices.pop_back();
+		batch.Update(indices.data(), indices.size());
+
+		numWrong = 0;
+		for (uint32_t i = 0; i < numObjects; ++i)
+		{
+			numWrong += !IsClose(batch.GetOutput(i), i == notUpdated ? previous[i] : reference[i]);
+		}
+		TEST_CHECK(numWrong == 0);
+	}
+
+	void TestWrite(uint32_t numObjects)
+	{
+		std::mt19937 rng(numObjects + 1);
+
+		TransformBatch batch;
+		batch.Resize(numObjects);
+
+		std::vector<uint32_t> indices(numObjects);
+		std::iota(indices.begin(), indices.end(), 0);
+		for (uint32_t i = 0; i < numObjects; ++i)
+		{
+			batch.SetWorld(i, MakeRandomWorld(rng));
+		}
+		batch.Update(indices.data(), indices.size());
+
+		std::shuffle(indices.begin(), indices.end(), rng);
+		indices.resize(numObjects / 2 + 1);
+
+		const TransformBatch::Output untouched = MakeFilled(-7.0f);
+
+		// Each object at its own index, the others are left alone
+		std::vector<TransformBatch::Output> constants(numObjects, untouched);
+		batch.Write(indices.data(), indices.size(), constants.data(), sizeof(TransformBatch::Output), TransformOutput::ByObjectIndex);
+
+		std::vector<bool> bWritten(numObjects, false);
+		for (uint32_t index : indices)
+		{
+			bWritten[index] = true;
+		}
+
+		size_t numWrong = 0;
+		for (uint32_t i = 0; i < numObjects; ++i)
+		{
+			numWrong += !IsSame(constants[i], bWritten[i] ? batch.GetOutput(i) : untouched);
+		}
+		TEST_CHECK(numWrong == 0);
+
+		// In request order, with a stride larger than the output : the padding is left alone
+		const size_t stride = 2 * sizeof(TransformBatch::Output);
+		std::vector<TransformBatch::Output> packed(2 * indices.size(), untouched);
+		batch.Write(indices.data(), indices.size(), packed.data(), stride, TransformOutput::Packed);
+
+		numWrong = 0;
+		for (size_t i = 0; i < indices.size(); ++i)
+		{
+			numWrong += !IsSame(packed[2 * i], batch.GetOutput(indices[i]));
+			numWrong += !IsSame(packed[2 * i + 1], untouched);
+		}
+		TEST_CHECK(numWrong == 0);
+	}
+}
+
+int main()
+{
+	TestIdentity();
+
+	for (uint32_t numObjects : { 1u, 3u, 4u, 5u, 1003u, 100000u })
+	{
+		TestAccuracy(numObjects);
+		TestWrite(numObjects);
+	}
+
+	return TestUtil::Finish("TransformBatchTests");
+}
@@ -0,0 +1,44 @@
+#include "pch.h"
+
+#include "MappedFile.h"
+
+#include <fstream>
+
+// Stand-in of src/core/MappedFile.cpp for the tests : the file is read in memory instead of being mapped with the Win32 API
+
+bool MappedFile::Open(const std::string& sz_Path)
+{
+	Close();
+
+	std::ifstream file(sz_Path, std::ios::binary | std::ios::ate);
+	if (!file)
+	{
+		return false;
+	}
+
+	const std::streamoff fileSize = file.tellg();
+	if (fileSize <= 0)
+	{
+		return false;
+	}
+
+	uint8_t* bytes = new uint8_t[static_cast<size_t>(fileSize)];
+	file.seekg(0);
+	if (!file.read(reinterpret_cast<char*>(bytes), fileSize))
+	{
+		delete[] bytes;
+		return false;
+	}
+
+	m_View = bytes;
+	m_Size = static_cast<size_t>(fileSize);
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+	delete[] static_cast<const uint8_t*>(m_View);
+	m_View = nullptr;
+	m_Size = 0;
+}
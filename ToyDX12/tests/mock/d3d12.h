@@ -0,0 +1,248 @@
+#pragma once
+
+// Stand-in of the D3D12 header for the tests : the declarations used by the modules under test, nothing more
+// Interfaces the tests only pass around are left incomplete, the others are abstract classes the tests implement
+
+#include <atomic>
+#include <cstdint>
+
+typedef int INT;
+typedef unsigned int UINT;
+typedef uint64_t UINT64;
+typedef long HRESULT;
+
+#define S_OK ((HRESULT)0)
+#define E_OUTOFMEMORY ((HRESULT)0x8007000EL)
+#define E_INVALIDARG ((HRESULT)0x80070057L)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+
+// Interface identifiers : the address of a variable per interface
+typedef const void* REFIID;
+
+template<typename T>
+REFIID MockUuidOf(T**)
+{
+	static const char id = 0;
+	return &id;
+}
+
+#define IID_PPV_ARGS(ppType) MockUuidOf(ppType), reinterpret_cast<void**>(ppType)
+
+// Reference counted, deleted with the last reference
+struct IUnknown
+{
+	virtual ~IUnknown() = default;
+
+	UINT AddRef() { return ++m_RefCount; }
+
+	UINT Release()
+	{
+		const UINT refCount = --m_RefCount;
+		if (refCount == 0)
+		{
+			delete this;
+		}
+		return refCount;
+	}
+
+private:
+	std::atomic<UINT> m_RefCount = 1;
+};
+
+enum DXGI_FORMAT
+{
+	DXGI_FORMAT_UNKNOWN = 0,
+	DXGI_FORMAT_R8G8B8A8_UNORM = 28,
+	DXGI_FORMAT_R32_UINT = 42,
+	DXGI_FORMAT_D24_UNORM_S8_UINT = 45,
+	DXGI_FORMAT_R16_UINT = 57
+};
+
+struct DXGI_SAMPLE_DESC
+{
+	UINT Count;
+	UINT Quality;
+};
+
+struct ID3D12CommandSignature;
+struct ID3D12DescriptorHeap;
+struct ID3D12GraphicsCommandList;
+struct ID3D12PipelineState;
+struct ID3D12RootSignature;
+
+struct ID3D12Object : public IUnknown
+{
+	virtual HRESULT SetName(const wchar_t* name) = 0;
+};
+
+struct ID3D12Heap : public ID3D12Object
+{
+};
+
+struct ID3D12Resource : public ID3D12Object
+{
+};
+
+typedef UINT64 D3D12_GPU_VIRTUAL_ADDRESS;
+
+struct D3D12_GPU_DESCRIPTOR_HANDLE
+{
+	UINT64 ptr;
+};
+
+enum D3D_PRIMITIVE_TOPOLOGY
+{
+	D3D_PRIMITIVE_TOPOLOGY_UNDEFINED = 0,
+	D3D_PRIMITIVE_TOPOLOGY_POINTLIST = 1,
+	D3D_PRIMITIVE_TOPOLOGY_LINELIST = 2,
+	D3D_PRIMITIVE_TOPOLOGY_LINESTRIP = 3,
+	D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST = 4,
+	D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP = 5
+};
+
+typedef D3D_PRIMITIVE_TOPOLOGY D3D12_PRIMITIVE_TOPOLOGY;
+
+#define D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT (32)
+
+struct D3D12_VERTEX_BUFFER_VIEW
+{
+	D3D12_GPU_VIRTUAL_ADDRESS BufferLocation;
+	UINT SizeInBytes;
+	UINT StrideInBytes;
+};
+
+struct D3D12_INDEX_BUFFER_VIEW
+{
+	D3D12_GPU_VIRTUAL_ADDRESS BufferLocation;
+	UINT SizeInBytes;
+	DXGI_FORMAT Format;
+};
+
+struct D3D12_DRAW_INDEXED_ARGUMENTS
+{
+	UINT IndexCountPerInstance;
+	UINT InstanceCount;
+	UINT StartIndexLocation;
+	INT BaseVertexLocation;
+	UINT StartInstanceLocation;
+};
+
+// Resources and heaps
+
+#define D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT (4096)
+#define D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT (65536)
+#define D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT (4194304)
+
+enum D3D12_RESOURCE_DIMENSION
+{
+	D3D12_RESOURCE_DIMENSION_UNKNOWN = 0,
+	D3D12_RESOURCE_DIMENSION_BUFFER = 1,
+	D3D12_RESOURCE_DIMENSION_TEXTURE1D = 2,
+	D3D12_RESOURCE_DIMENSION_TEXTURE2D = 3,
+	D3D12_RESOURCE_DIMENSION_TEXTURE3D = 4
+};
+
+enum D3D12_TEXTURE_LAYOUT
+{
+	D3D12_TEXTURE_LAYOUT_UNKNOWN = 0,
+	D3D12_TEXTURE_LAYOUT_ROW_MAJOR = 1
+};
+
+enum D3D12_RESOURCE_FLAGS
+{
+	D3D12_RESOURCE_FLAG_NONE = 0,
+	D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET = 0x1,
+	D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL = 0x2,
+	D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS = 0x4
+};
+
+enum D3D12_RESOURCE_STATES
+{
+	D3D12_RESOURCE_STATE_COMMON = 0,
+	D3D12_RESOURCE_STATE_RENDER_TARGET = 0x4,
+	D3D12_RESOURCE_STATE_DEPTH_WRITE = 0x10,
+	D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE = 0x80,
+	D3D12_RESOURCE_STATE_COPY_DEST = 0x400,
+	D3D12_RESOURCE_STATE_GENERIC_READ = 0xac3
+};
+
+enum D3D12_HEAP_TYPE
+{
+	D3D12_HEAP_TYPE_DEFAULT = 1,
+	D3D12_HEAP_TYPE_UPLOAD = 2,
+	D3D12_HEAP_TYPE_READBACK = 3
+};
+
+enum D3D12_HEAP_FLAGS
+{
+	D3D12_HEAP_FLAG_NONE = 0,
+	D3D12_HEAP_FLAG_DENY_BUFFERS = 0x4,
+	D3D12_HEAP_FLAG_DENY_RT_DS_TEXTURES = 0x40,
+	D3D12_HEAP_FLAG_DENY_NON_RT_DS_TEXTURES = 0x80,
+	D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS = 0xc0,
+	D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES = 0x44,
+	D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES = 0x84
+};
+
+enum D3D12_CPU_PAGE_PROPERTY
+{
+	D3D12_CPU_PAGE_PROPERTY_UNKNOWN = 0
+};
+
+enum D3D12_MEMORY_POOL
+{
+	D3D12_MEMORY_POOL_UNKNOWN = 0
+};
+
+struct D3D12_RESOURCE_DESC
+{
+	D3D12_RESOURCE_DIMENSION Dimension;
+	UINT64 Alignment;
+	UINT64 Width;
+	UINT Height;
+	uint16_t DepthOrArraySize;
+	uint16_t MipLevels;
+	DXGI_FORMAT Format;
+	DXGI_SAMPLE_DESC SampleDesc;
+	D3D12_TEXTURE_LAYOUT Layout;
+	D3D12_RESOURCE_FLAGS Flags;
+};
+
+struct D3D12_CLEAR_VALUE
+{
+	DXGI_FORMAT Format;
+	float Color[4];
+};
+
+struct D3D12_RESOURCE_ALLOCATION_INFO
+{
+	UINT64 SizeInBytes;
+	UINT64 Alignment;
+};
+
+struct D3D12_HEAP_PROPERTIES
+{
+	D3D12_HEAP_TYPE Type;
+	D3D12_CPU_PAGE_PROPERTY CPUPageProperty;
+	D3D12_MEMORY_POOL MemoryPoolPreference;
+	UINT CreationNodeMask;
+	UINT VisibleNodeMask;
+};
+
+struct D3D12_HEAP_DESC
+{
+	UINT64 SizeInBytes;
+	D3D12_HEAP_PROPERTIES Properties;
+	UINT64 Alignment;
+	D3D12_HEAP_FLAGS Flags;
+};
+
+// The methods of the device the modules call
+struct ID3D12Device : public ID3D12Object
+{
+	virtual D3D12_RESOURCE_ALLOCATION_INFO GetResourceAllocationInfo(UINT visibleMask, UINT numResourceDescs, const D3D12_RESOURCE_DESC* pResourceDescs) = 0;
+	virtual HRESULT CreateHeap(const D3D12_HEAP_DESC* pDesc, REFIID riid, void** ppvHeap) = 0;
+	virtual HRESULT CreatePlacedResource(ID3D12Heap* pHeap, UINT64 heapOffset, const D3D12_RESOURCE_DESC* pDesc, D3D12_RESOURCE_STATES initialState,
+		const D3D12_CLEAR_VALUE* pOptimizedClearValue, REFIID riid, void** ppvResource) = 0;
+};
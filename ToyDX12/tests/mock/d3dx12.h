@@ -0,0 +1,49 @@
+#pragma once
+
+// Stand-in of the D3DX12 helpers for the tests
+
+#include "d3d12.h"
+
+struct CD3DX12_RESOURCE_DESC : public D3D12_RESOURCE_DESC
+{
+	CD3DX12_RESOURCE_DESC() = default;
+	explicit CD3DX12_RESOURCE_DESC(const D3D12_RESOURCE_DESC& o) : D3D12_RESOURCE_DESC(o) {}
+
+	CD3DX12_RESOURCE_DESC(D3D12_RESOURCE_DIMENSION dimension, UINT64 alignment, UINT64 width, UINT height, uint16_t depthOrArraySize, uint16_t mipLevels,
+		DXGI_FORMAT format, UINT sampleCount, UINT sampleQuality, D3D12_TEXTURE_LAYOUT layout, D3D12_RESOURCE_FLAGS flags)
+	{
+		Dimension = dimension;
+		Alignment = alignment;
+		Width = width;
+		Height = height;
+		DepthOrArraySize = depthOrArraySize;
+		MipLevels = mipLevels;
+		Format = format;
+		SampleDesc.Count = sampleCount;
+		SampleDesc.Quality = sampleQuality;
+		Layout = layout;
+		Flags = flags;
+	}
+
+	static CD3DX12_RESOURCE_DESC Buffer(UINT64 width, D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE, UINT64 alignment = 0)
+	{
+		return CD3DX12_RESOURCE_DESC(D3D12_RESOURCE_DIMENSION_BUFFER, alignment, width, 1, 1, 1, DXGI_FORMAT_UNKNOWN, 1, 0, D3D12_TEXTURE_LAYOUT_ROW_MAJOR, flags);
+	}
+
+	static CD3DX12_RESOURCE_DESC Tex2D(DXGI_FORMAT format, UINT64 width, UINT height, uint16_t arraySize = 1, uint16_t mipLevels = 0, UINT sampleCount = 1,
+		UINT sampleQuality = 0, D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE, D3D12_TEXTURE_LAYOUT layout = D3D12_TEXTURE_LAYOUT_UNKNOWN, UINT64 alignment = 0)
+	{
+		return CD3DX12_RESOURCE_DESC(D3D12_RESOURCE_DIMENSION_TEXTURE2D, alignment, width, height, arraySize, mipLevels, format, sampleCount, sampleQuality, layout, flags);
+	}
+};
+
+struct CD3DX12_HEAP_DESC : public D3D12_HEAP_DESC
+{
+	CD3DX12_HEAP_DESC(UINT64 size, D3D12_HEAP_TYPE type, UINT64 alignment = 0, D3D12_HEAP_FLAGS flags = D3D12_HEAP_FLAG_NONE)
+	{
+		SizeInBytes = size;
+		Properties = { type, D3D12_CPU_PAGE_PROPERTY_UNKNOWN, D3D12_MEMORY_POOL_UNKNOWN, 1, 1 };
+		Alignment = alignment;
+		Flags = flags;
+	}
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+// Stand-in of src/core/pch.h for the tests : no Windows headers, no logger, the D3D12 headers of tests/mock
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include <wrl/client.h>
+#include <d3d12.h>
+#include <d3dx12.h>
+#include <DirectXMath.h>
+
+#define LOG_INFO(...)
+#define LOG_WARN(...)
+#define LOG_ERROR(...)
+#define LOG_DEBUG(...)
+
+inline void ThrowIfFailed(HRESULT hr)
+{
+	if (FAILED(hr))
+	{
+		throw std::exception();
+	}
+}
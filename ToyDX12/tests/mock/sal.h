@@ -0,0 +1,20 @@
+#pragma once
+
+// Source annotations of the Microsoft compiler used by DirectXMath, they have no effect on other compilers
+
+#define _In_
+#define _In_opt_
+#define _In_reads_(x)
+#define _In_reads_opt_(x)
+#define _In_reads_bytes_(x)
+#define _Out_
+#define _Out_opt_
+#define _Out_writes_(x)
+#define _Out_writes_opt_(x)
+#define _Out_writes_all_(x)
+#define _Out_writes_bytes_(x)
+#define _Inout_
+#define _Inout_updates_(x)
+#define _Success_(x)
+#define _Use_decl_annotations_
+#define _Analysis_assume_(x)
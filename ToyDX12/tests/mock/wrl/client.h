@@ -0,0 +1,64 @@
+#pragma once
+
+// Stand-in of Microsoft::WRL::ComPtr for the tests, on the reference counting of the IUnknown of tests/mock/d3d12.h
+
+#include <cstddef>
+#include <utility>
+
+namespace Microsoft::WRL
+{
+	template<typename T>
+	class ComPtr
+	{
+	public:
+		ComPtr() = default;
+		ComPtr(std::nullptr_t) {}
+		ComPtr(T* p) : m_Ptr(p) { InternalAddRef(); }
+		ComPtr(const ComPtr& other) : m_Ptr(other.m_Ptr) { InternalAddRef(); }
+		ComPtr(ComPtr&& other) noexcept : m_Ptr(std::exchange(other.m_Ptr, nullptr)) {}
+		~ComPtr() { InternalRelease(); }
+
+		ComPtr& operator=(ComPtr other)
+		{
+			std::swap(m_Ptr, other.m_Ptr);
+			return *this;
+		}
+
+		T* Get() const { return m_Ptr; }
+		T* operator->() const { return m_Ptr; }
+		explicit operator bool() const { return m_Ptr != nullptr; }
+
+		// Like WRL, doesn't release the current interface
+		T** GetAddressOf() { return &m_Ptr; }
+
+		T** ReleaseAndGetAddressOf()
+		{
+			InternalRelease();
+			return &m_Ptr;
+		}
+
+		void Reset() { InternalRelease(); }
+
+		friend bool operator==(const ComPtr& a, std::nullptr_t) { return a.m_Ptr == nullptr; }
+		friend bool operator==(const ComPtr& a, const ComPtr& b) { return a.m_Ptr == b.m_Ptr; }
+
+	private:
+		void InternalAddRef()
+		{
+			if (m_Ptr != nullptr)
+			{
+				m_Ptr->AddRef();
+			}
+		}
+
+		void InternalRelease()
+		{
+			if (m_Ptr != nullptr)
+			{
+				std::exchange(m_Ptr, nullptr)->Release();
+			}
+		}
+
+		T* m_Ptr = nullptr;
+	};
+}
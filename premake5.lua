@@ -58,6 +58,14 @@ for i, name in ipairs(projects) do
 			FilePaths.Projects .. name .. "/**.h",
 			FilePaths.Projects .. name .. "/**.cpp",
 			LibPaths["DirectXTex"] .. "/DirectXTexUtil.cpp",
+			LibPaths["DirectXTex"] .. "/DirectXTexImage.cpp",
+			LibPaths["DirectXTex"] .. "/DirectXTexConvert.cpp",
+			LibPaths["DirectXTex"] .. "/DirectXTexCompress.cpp",
+			LibPaths["DirectXTex"] .. "/DirectXTexDDS.cpp",
+			LibPaths["DirectXTex"] .. "/DirectXTexMipmaps.cpp",
+			LibPaths["DirectXTex"] .. "/BC.cpp",
+			LibPaths["DirectXTex"] .. "/BC4BC5.cpp",
+			LibPaths["DirectXTex"] .. "/BC6HBC7.cpp",
 			LibPaths["DXRHelpers"] .. "/*.cpp"
 		}
 